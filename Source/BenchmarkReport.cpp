@@ -0,0 +1,175 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarkreport.cpp
+// ============
+// collect the frame times of a benchmark run and report the percentiles
+///////////////////////////////////////////////////////////////////////////////
+
+#include "BenchmarkReport.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	/***********************************************************
+	 *  Percentile()
+	 *
+	 *  This function is used for getting the nearest rank
+	 *  percentile of the sorted values.
+	 ***********************************************************/
+	double Percentile(const std::vector<double>& sorted, int percent)
+	{
+		size_t rank = (sorted.size() * percent + 99) / 100;
+
+		rank = std::max((size_t)1, std::min(rank, sorted.size()));
+
+		return(sorted[rank - 1]);
+	}
+}
+
+/***********************************************************
+ *  BenchmarkReport()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+BenchmarkReport::BenchmarkReport()
+{
+}
+
+/***********************************************************
+ *  AddFrame()
+ *
+ *  This method is used for recording the time of one frame.
+ ***********************************************************/
+void BenchmarkReport::AddFrame(double frameMs)
+{
+	m_frameTimes.push_back(frameMs);
+}
+
+/***********************************************************
+ *  SetValue()
+ *
+ *  This method is used for recording a named value that is
+ *  written into the summary.  Setting a name again replaces
+ *  its value.
+ ***********************************************************/
+void BenchmarkReport::SetValue(const std::string& name, double value)
+{
+	for (std::pair<std::string, double>& entry : m_values)
+	{
+		if (entry.first == name)
+		{
+			entry.second = value;
+			return;
+		}
+	}
+	m_values.push_back(std::make_pair(name, value));
+}
+
+/***********************************************************
+ *  GetStats()
+ *
+ *  This method is used for getting the min, avg, max and
+ *  percentiles of the recorded frame times.
+ ***********************************************************/
+BenchmarkReport::FRAME_TIME_STATS BenchmarkReport::GetStats() const
+{
+	FRAME_TIME_STATS stats = {};
+
+	if (m_frameTimes.empty())
+	{
+		return(stats);
+	}
+
+	std::vector<double> sorted(m_frameTimes);
+	std::sort(sorted.begin(), sorted.end());
+
+	for (double frameMs : sorted)
+	{
+		stats.totalMs += frameMs;
+	}
+	stats.frames = (int)sorted.size();
+	stats.minMs = sorted.front();
+	stats.maxMs = sorted.back();
+	stats.avgMs = stats.totalMs / (double)stats.frames;
+	stats.p50Ms = Percentile(sorted, 50);
+	stats.p90Ms = Percentile(sorted, 90);
+	stats.p95Ms = Percentile(sorted, 95);
+	stats.p99Ms = Percentile(sorted, 99);
+
+	return(stats);
+}
+
+/***********************************************************
+ *  PrintSummary()
+ *
+ *  This method is used for printing the frame time
+ *  percentiles to the console.
+ ***********************************************************/
+void BenchmarkReport::PrintSummary() const
+{
+	FRAME_TIME_STATS stats = GetStats();
+
+	std::cout << std::fixed << std::setprecision(3);
+	std::cout << "INFO: Benchmark frames: " << stats.frames
+		<< ", total: " << stats.totalMs << " ms" << std::endl;
+	std::cout << "INFO: Frame time ms - min: " << stats.minMs
+		<< ", avg: " << stats.avgMs
+		<< ", p50: " << stats.p50Ms
+		<< ", p90: " << stats.p90Ms
+		<< ", p95: " << stats.p95Ms
+		<< ", p99: " << stats.p99Ms
+		<< ", max: " << stats.maxMs << std::endl;
+	for (const std::pair<std::string, double>& entry : m_values)
+	{
+		std::cout << "INFO: " << entry.first << ": " << entry.second << std::endl;
+	}
+	std::cout << std::defaultfloat;
+}
+
+/***********************************************************
+ *  WriteJSON()
+ *
+ *  This method is used for writing the frame time summary
+ *  and the named values to a JSON file.
+ ***********************************************************/
+bool BenchmarkReport::WriteJSON(const std::string& filename) const
+{
+	FRAME_TIME_STATS stats = GetStats();
+	std::ofstream file(filename);
+
+	if (!file.is_open())
+	{
+		std::cout << "Could not write benchmark summary:" << filename << std::endl;
+		return(false);
+	}
+
+	file << std::fixed << std::setprecision(4);
+	file << "{\n";
+	file << "  \"frames\": " << stats.frames << ",\n";
+	file << "  \"total_ms\": " << stats.totalMs << ",\n";
+	file << "  \"frame_ms\": {\n";
+	file << "    \"min\": " << stats.minMs << ",\n";
+	file << "    \"avg\": " << stats.avgMs << ",\n";
+	file << "    \"p50\": " << stats.p50Ms << ",\n";
+	file << "    \"p90\": " << stats.p90Ms << ",\n";
+	file << "    \"p95\": " << stats.p95Ms << ",\n";
+	file << "    \"p99\": " << stats.p99Ms << ",\n";
+	file << "    \"max\": " << stats.maxMs << "\n";
+	file << "  },\n";
+	file << "  \"values\": {";
+	for (size_t i = 0; i < m_values.size(); i++)
+	{
+		file << ((i == 0) ? "\n" : ",\n");
+		file << "    \"" << m_values[i].first << "\": " << m_values[i].second;
+	}
+	file << (m_values.empty() ? "}\n" : "\n  }\n");
+	file << "}\n";
+
+	std::cout << "INFO: Wrote benchmark summary to " << filename << std::endl;
+
+	return(true);
+}
@@ -0,0 +1,59 @@
+///////////////////////////////////////////////////////////////////////////////
+// benchmarkreport.h
+// ============
+// collect the frame times of a benchmark run and report the percentiles
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <string>
+#include <utility>
+#include <vector>
+
+/***********************************************************
+ *  BenchmarkReport
+ *
+ *  This class contains the code for recording the time of
+ *  every benchmarked frame and for printing the frame time
+ *  percentiles, and writing them with the named scene
+ *  values to a JSON summary file.
+ ***********************************************************/
+class BenchmarkReport
+{
+public:
+	// constructor
+	BenchmarkReport();
+
+	// frame time percentiles of the run in milliseconds
+	struct FRAME_TIME_STATS
+	{
+		double minMs;
+		double avgMs;
+		double p50Ms;
+		double p90Ms;
+		double p95Ms;
+		double p99Ms;
+		double maxMs;
+		double totalMs;
+		int frames;
+	};
+
+	// record the time of one frame
+	void AddFrame(double frameMs);
+	// record a named value, for example the draw calls per frame
+	void SetValue(const std::string& name, double value);
+
+	// get the percentiles of the recorded frames
+	FRAME_TIME_STATS GetStats() const;
+
+	// print the percentiles to the console
+	void PrintSummary() const;
+	// write the percentiles and values to a JSON file
+	bool WriteJSON(const std::string& filename) const;
+
+private:
+	// time of each recorded frame
+	std::vector<double> m_frameTimes;
+	// named values in the order they were first set
+	std::vector<std::pair<std::string, double>> m_values;
+};
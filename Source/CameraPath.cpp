@@ -0,0 +1,181 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.cpp
+// ============
+// scripted camera spline used for replaying the same view every run
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CameraPath.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// zoom used by keys that do not set one, same as the view manager
+	const float g_DefaultZoom = 80.0f;
+	// keys and length of the default orbit around the desk
+	const int g_OrbitKeys = 8;
+	const float g_OrbitSeconds = 20.0f;
+
+	/***********************************************************
+	 *  CatmullRom()
+	 *
+	 *  This function is used for interpolating between p1 and
+	 *  p2 along a uniform Catmull-Rom spline.
+	 ***********************************************************/
+	template <typename T>
+	T CatmullRom(const T& p0, const T& p1, const T& p2, const T& p3, float t)
+	{
+		float t2 = t * t;
+		float t3 = t2 * t;
+
+		return(0.5f * ((2.0f * p1) +
+			(p2 - p0) * t +
+			(2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2 +
+			(3.0f * p1 - p0 - 3.0f * p2 + p3) * t3));
+	}
+}
+
+/***********************************************************
+ *  CameraPath()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+CameraPath::CameraPath()
+{
+	SetDefaultOrbit();
+}
+
+/***********************************************************
+ *  LoadFromFile()
+ *
+ *  This method is used for reading the keys of the path
+ *  from a text file.  The current keys are kept when the
+ *  file cannot be read or holds fewer than two keys.
+ ***********************************************************/
+bool CameraPath::LoadFromFile(const std::string& filename)
+{
+	std::ifstream file(filename);
+	std::vector<CAMERA_KEY> keys;
+	std::string line;
+
+	if (!file.is_open())
+	{
+		std::cout << "Could not open camera path file:" << filename << std::endl;
+		return(false);
+	}
+
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		CAMERA_KEY key;
+
+		if (line.empty() || (line[0] == '#'))
+		{
+			continue;
+		}
+
+		stream >> key.time
+			>> key.position.x >> key.position.y >> key.position.z
+			>> key.target.x >> key.target.y >> key.target.z;
+		if (stream.fail())
+		{
+			continue;
+		}
+		if (!(stream >> key.zoom))
+		{
+			key.zoom = g_DefaultZoom;
+		}
+		keys.push_back(key);
+	}
+
+	if (keys.size() < 2)
+	{
+		std::cout << "Camera path needs at least two keys:" << filename << std::endl;
+		return(false);
+	}
+
+	std::stable_sort(keys.begin(), keys.end(),
+		[](const CAMERA_KEY& a, const CAMERA_KEY& b) { return a.time < b.time; });
+	m_keys = keys;
+
+	std::cout << "INFO: Loaded " << m_keys.size() << " camera path keys from " << filename << std::endl;
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetDefaultOrbit()
+ *
+ *  This method is used for setting a closed circle of keys
+ *  around the center of the desk scene.
+ ***********************************************************/
+void CameraPath::SetDefaultOrbit(float radius, float height)
+{
+	m_keys.clear();
+
+	for (int i = 0; i <= g_OrbitKeys; i++)
+	{
+		float angle = glm::radians(360.0f) * (float)i / (float)g_OrbitKeys;
+		CAMERA_KEY key;
+
+		key.time = g_OrbitSeconds * (float)i / (float)g_OrbitKeys;
+		key.position = glm::vec3(
+			radius * std::sin(angle),
+			height,
+			radius * std::cos(angle));
+		key.target = glm::vec3(0.0f, 0.0f, 0.0f);
+		key.zoom = g_DefaultZoom;
+		m_keys.push_back(key);
+	}
+}
+
+/***********************************************************
+ *  GetDuration()
+ *
+ *  This method is used for getting the time of the last key.
+ ***********************************************************/
+float CameraPath::GetDuration() const
+{
+	if (m_keys.empty())
+	{
+		return(0.0f);
+	}
+
+	return(m_keys.back().time);
+}
+
+/***********************************************************
+ *  Evaluate()
+ *
+ *  This method is used for getting the camera at the passed
+ *  in time.  The end keys are repeated so that the spline
+ *  passes through the first and the last key.
+ ***********************************************************/
+void CameraPath::Evaluate(float time, glm::vec3& position, glm::vec3& target, float& zoom) const
+{
+	int lastKey = (int)m_keys.size() - 1;
+	int segment = 0;
+
+	time = std::max(m_keys.front().time, std::min(time, m_keys.back().time));
+	while ((segment < lastKey - 1) && (time > m_keys[segment + 1].time))
+	{
+		segment++;
+	}
+
+	const CAMERA_KEY& k0 = m_keys[std::max(segment - 1, 0)];
+	const CAMERA_KEY& k1 = m_keys[segment];
+	const CAMERA_KEY& k2 = m_keys[std::min(segment + 1, lastKey)];
+	const CAMERA_KEY& k3 = m_keys[std::min(segment + 2, lastKey)];
+
+	float span = k2.time - k1.time;
+	float t = (span > 0.0f) ? (time - k1.time) / span : 0.0f;
+
+	position = CatmullRom(k0.position, k1.position, k2.position, k3.position, t);
+	target = CatmullRom(k0.target, k1.target, k2.target, k3.target, t);
+	zoom = CatmullRom(k0.zoom, k1.zoom, k2.zoom, k3.zoom, t);
+}
@@ -0,0 +1,54 @@
+///////////////////////////////////////////////////////////////////////////////
+// camerapath.h
+// ============
+// scripted camera spline used for replaying the same view every run
+//
+//  The path file holds one key per line, blank lines and lines starting
+//  with '#' are skipped:
+//    time  posX posY posZ  targetX targetY targetZ  [zoom]
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  CameraPath
+ *
+ *  This class contains the code for reading the keys of a
+ *  camera path and for evaluating the camera position, look
+ *  at target and zoom at any time along the path, with a
+ *  Catmull-Rom spline through the keys.
+ ***********************************************************/
+class CameraPath
+{
+public:
+	// constructor
+	CameraPath();
+
+	// one key of the path
+	struct CAMERA_KEY
+	{
+		float time;
+		glm::vec3 position;
+		glm::vec3 target;
+		float zoom;
+	};
+
+	// read the keys from a path file
+	bool LoadFromFile(const std::string& filename);
+	// use a circle around the desk when no path file is given
+	void SetDefaultOrbit(float radius = 12.0f, float height = 5.0f);
+
+	// get the time of the last key
+	float GetDuration() const;
+	// get the camera at the passed in time along the path
+	void Evaluate(float time, glm::vec3& position, glm::vec3& target, float& zoom) const;
+
+private:
+	// keys sorted by time
+	std::vector<CAMERA_KEY> m_keys;
+};
@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthprepass.cpp
+// ============
+// depth only drawing of the opaque scene before it is shaded
+///////////////////////////////////////////////////////////////////////////////
+
+#include "DepthPrepass.h"
+#include "GpuResources.h"
+#include "ShaderVariants.h"
+#include "UniformCache.h"
+
+/***********************************************************
+ *  DepthPrepass()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+DepthPrepass::DepthPrepass()
+{
+	m_program = 0;
+	m_useInstancingLocation = -1;
+	m_useDrawDataLocation = -1;
+}
+
+/***********************************************************
+ *  ~DepthPrepass()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+DepthPrepass::~DepthPrepass()
+{
+	if (0 != m_program)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_PROGRAM, m_program);
+		glDeleteProgram(m_program);
+		m_program = 0;
+	}
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for building the depth only program
+ *  and reading its uniform locations.  The draw data buffer
+ *  texture stays bound to its unit, so the sampler is set
+ *  once here, and the camera and object blocks read the
+ *  same bindings as the shading program.  It is called
+ *  again to reload the shaders, and the current program is
+ *  kept when the new one fails.
+ ***********************************************************/
+bool DepthPrepass::Initialize(const char* vertexFile, const char* fragmentFile, GLint drawDataUnit)
+{
+	GLint currentProgram = 0;
+
+	GLuint program = ShaderVariants::LoadProgram(vertexFile, fragmentFile);
+	if (0 == program)
+	{
+		return(false);
+	}
+	if (0 != m_program)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_PROGRAM, m_program);
+		glDeleteProgram(m_program);
+	}
+	m_program = program;
+
+	m_useInstancingLocation = glGetUniformLocation(m_program, "bUseInstancing");
+	m_useDrawDataLocation = glGetUniformLocation(m_program, "bUseDrawData");
+
+	glGetIntegerv(GL_CURRENT_PROGRAM, &currentProgram);
+	glUseProgram(m_program);
+	glUniform1i(glGetUniformLocation(m_program, "drawData"), drawDataUnit);
+	glUseProgram((GLuint)currentProgram);
+
+	glUniformBlockBinding(
+		m_program,
+		glGetUniformBlockIndex(m_program, "CameraBlock"),
+		UniformCache::CAMERA_BLOCK_BINDING);
+	glUniformBlockBinding(
+		m_program,
+		glGetUniformBlockIndex(m_program, "ObjectBlock"),
+		UniformCache::OBJECT_BLOCK_BINDING);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetUseInstancing()
+ *
+ *  This method is used for reading the model matrix from the
+ *  per instance attribute.
+ ***********************************************************/
+void DepthPrepass::SetUseInstancing(bool bUseInstancing)
+{
+	glUniform1i(m_useInstancingLocation, bUseInstancing);
+}
+
+/***********************************************************
+ *  SetUseDrawData()
+ *
+ *  This method is used for reading the model matrix from the
+ *  draw data of the indirect draws.
+ ***********************************************************/
+void DepthPrepass::SetUseDrawData(bool bUseDrawData)
+{
+	glUniform1i(m_useDrawDataLocation, bUseDrawData);
+}
@@ -0,0 +1,49 @@
+///////////////////////////////////////////////////////////////////////////////
+// depthprepass.h
+// ============
+// depth only drawing of the opaque scene before it is shaded
+//
+//  The pre-pass fills the depth buffer with a position only program, so that
+//  the shading pass can test with GL_EQUAL and every pixel runs the lighting
+//  for the closest surface only.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+/***********************************************************
+ *  DepthPrepass
+ *
+ *  This class contains the code for the position only
+ *  program of the depth pre-pass and for setting its
+ *  uniforms.  The program reads the model matrix from the
+ *  same object block, instance attribute or draw data as
+ *  the shading program, so both end up with the same depth.
+ ***********************************************************/
+class DepthPrepass
+{
+public:
+	// constructor
+	DepthPrepass();
+	// destructor
+	~DepthPrepass();
+
+	// build the depth only program, false when it cannot be built
+	bool Initialize(const char* vertexFile, const char* fragmentFile, GLint drawDataUnit);
+	// check if the depth only program is available
+	bool IsReady() const { return 0 != m_program; }
+	// get the depth only program
+	GLuint GetProgram() const { return m_program; }
+
+	// the following are set with the depth only program current
+	void SetUseInstancing(bool bUseInstancing);
+	void SetUseDrawData(bool bUseDrawData);
+
+private:
+	GLuint m_program;
+
+	// uniform locations of the depth only program
+	GLint m_useInstancingLocation;
+	GLint m_useDrawDataLocation;
+};
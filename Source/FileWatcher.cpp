@@ -0,0 +1,137 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.cpp
+// ============
+// watch the shader, texture and scene files for changes while running
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FileWatcher.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+/***********************************************************
+ *  FileWatcher()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FileWatcher::FileWatcher(double intervalSeconds)
+{
+	m_interval = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+		std::chrono::duration<double>(intervalSeconds));
+	m_lastPoll = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  AddFile()
+ *
+ *  This method is used for starting to watch a file.  The
+ *  current stamp of the file is taken as unchanged.
+ ***********************************************************/
+void FileWatcher::AddFile(const std::string& filename, int id)
+{
+	WATCHED_FILE file;
+
+	file.filename = filename;
+	file.id = id;
+	GetFileStamp(filename, file.modifiedTime, file.size);
+	file.pendingTime = file.modifiedTime;
+	file.pendingSize = file.size;
+	file.bPending = false;
+
+	m_files.push_back(file);
+}
+
+/***********************************************************
+ *  RemoveFiles()
+ *
+ *  This method is used for no longer watching the files
+ *  with an ID from firstID to lastID.
+ ***********************************************************/
+void FileWatcher::RemoveFiles(int firstID, int lastID)
+{
+	size_t kept = 0;
+
+	for (size_t i = 0; i < m_files.size(); i++)
+	{
+		if ((m_files[i].id < firstID) || (m_files[i].id > lastID))
+		{
+			m_files[kept++] = m_files[i];
+		}
+	}
+	m_files.resize(kept);
+}
+
+/***********************************************************
+ *  Poll()
+ *
+ *  This method is used for checking the watched files.  A
+ *  new stamp is first kept as pending, and is reported on
+ *  the following check if the file has not changed again.
+ ***********************************************************/
+int FileWatcher::Poll(std::vector<int>& changedIDs)
+{
+	std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+	int changed = 0;
+
+	if (now - m_lastPoll < m_interval)
+	{
+		return(0);
+	}
+	m_lastPoll = now;
+
+	for (WATCHED_FILE& file : m_files)
+	{
+		long long modifiedTime = 0;
+		long long size = 0;
+
+		GetFileStamp(file.filename, modifiedTime, size);
+
+		// a file that is missing for a moment while it is saved
+		// is reported once it is back
+		if ((0 == modifiedTime) && (0 == size))
+		{
+			continue;
+		}
+		if ((modifiedTime == file.modifiedTime) && (size == file.size))
+		{
+			file.bPending = false;
+			continue;
+		}
+
+		if (file.bPending && (modifiedTime == file.pendingTime) && (size == file.pendingSize))
+		{
+			file.modifiedTime = modifiedTime;
+			file.size = size;
+			file.bPending = false;
+			changedIDs.push_back(file.id);
+			changed++;
+		}
+		else
+		{
+			file.pendingTime = modifiedTime;
+			file.pendingSize = size;
+			file.bPending = true;
+		}
+	}
+
+	return(changed);
+}
+
+/***********************************************************
+ *  GetFileStamp()
+ *
+ *  This method is used for getting the modification time
+ *  and the size of a file.
+ ***********************************************************/
+void FileWatcher::GetFileStamp(const std::string& filename, long long& modifiedTime, long long& size)
+{
+	struct stat status;
+
+	modifiedTime = 0;
+	size = 0;
+	if (0 == stat(filename.c_str(), &status))
+	{
+		modifiedTime = (long long)status.st_mtime;
+		size = (long long)status.st_size;
+	}
+}
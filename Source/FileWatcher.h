@@ -0,0 +1,60 @@
+///////////////////////////////////////////////////////////////////////////////
+// filewatcher.h
+// ============
+// watch the shader, texture and scene files for changes while running
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FileWatcher
+ *
+ *  This class contains the code for checking a list of
+ *  files for a new modification time or size.  The files
+ *  are checked on the GL thread between frames, at most
+ *  once per interval, and a change is only reported once
+ *  the file has stayed the same for a whole interval, so
+ *  that a file is not read while an editor is writing it.
+ ***********************************************************/
+class FileWatcher
+{
+public:
+	// constructor
+	FileWatcher(double intervalSeconds = 0.5);
+
+	// start watching a file, the passed in ID is reported when it
+	// changes - a file can be watched under several IDs
+	void AddFile(const std::string& filename, int id);
+	// stop watching every file with an ID in the passed in range
+	void RemoveFiles(int firstID, int lastID);
+
+	// check the files once the interval has passed, the IDs of the
+	// changed files are appended and their number is returned
+	int Poll(std::vector<int>& changedIDs);
+
+private:
+	// a watched file with the stamp it was last reported with, and
+	// the new stamp that is waiting to settle
+	struct WATCHED_FILE
+	{
+		std::string filename;
+		int id;
+		long long modifiedTime;
+		long long size;
+		long long pendingTime;
+		long long pendingSize;
+		bool bPending;
+	};
+
+	std::vector<WATCHED_FILE> m_files;
+	std::chrono::steady_clock::duration m_interval;
+	std::chrono::steady_clock::time_point m_lastPoll;
+
+	// get the modification time and the size of a file, zero for
+	// both when the file cannot be found
+	static void GetFileStamp(const std::string& filename, long long& modifiedTime, long long& size);
+};
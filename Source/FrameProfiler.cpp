@@ -0,0 +1,347 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.cpp
+// ============
+// measure the CPU and GPU time of the frame sections and count the work
+///////////////////////////////////////////////////////////////////////////////
+
+#include "FrameProfiler.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+/***********************************************************
+ *  FrameProfiler()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+FrameProfiler::FrameProfiler()
+{
+	m_frameSet = 0;
+	m_frameCount = 0;
+}
+
+/***********************************************************
+ *  ~FrameProfiler()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+FrameProfiler::~FrameProfiler()
+{
+	for (TIMER_SCOPE& scope : m_scopes)
+	{
+		if (scope.bGpuTimer)
+		{
+			glDeleteQueries(4, &scope.queries[0][0]);
+		}
+	}
+	m_scopes.clear();
+}
+
+/***********************************************************
+ *  VALUE_HISTORY::Add()
+ *
+ *  This method is used for adding a value to the history,
+ *  the oldest value is dropped once the history is full.
+ ***********************************************************/
+void FrameProfiler::VALUE_HISTORY::Add(float value)
+{
+	values.push_back(value);
+	if ((int)values.size() > HISTORY_SIZE)
+	{
+		values.pop_front();
+	}
+}
+
+/***********************************************************
+ *  VALUE_HISTORY::GetStats()
+ *
+ *  This method is used for getting the min, avg and p99 of
+ *  the values in the history.
+ ***********************************************************/
+FrameProfiler::VALUE_STATS FrameProfiler::VALUE_HISTORY::GetStats() const
+{
+	VALUE_STATS stats = {};
+
+	if (values.empty())
+	{
+		return(stats);
+	}
+
+	std::vector<float> sorted(values.begin(), values.end());
+	std::sort(sorted.begin(), sorted.end());
+
+	float sum = 0.0f;
+	for (float value : sorted)
+	{
+		sum += value;
+	}
+
+	size_t p99Index = std::min(sorted.size() - 1, (sorted.size() * 99) / 100);
+	stats.minValue = sorted.front();
+	stats.avgValue = sum / (float)sorted.size();
+	stats.p99Value = sorted[p99Index];
+	stats.samples = (int)sorted.size();
+
+	return(stats);
+}
+
+/***********************************************************
+ *  FindScope()
+ *
+ *  This method is used for finding a scope by its name.  A
+ *  scope that is used for the first time is added, with its
+ *  GPU timestamp queries when it asks for GPU timing.
+ ***********************************************************/
+int FrameProfiler::FindScope(const char* name, bool bGpuTimer)
+{
+	for (int i = 0; i < (int)m_scopes.size(); i++)
+	{
+		if (m_scopes[i].name == name)
+		{
+			return(i);
+		}
+	}
+
+	TIMER_SCOPE scope;
+	scope.name = name;
+	scope.depth = (int)m_scopeStack.size();
+	scope.bGpuTimer = bGpuTimer;
+	scope.bIssued[0] = false;
+	scope.bIssued[1] = false;
+	std::memset(scope.queries, 0, sizeof(scope.queries));
+	if (bGpuTimer)
+	{
+		glGenQueries(4, &scope.queries[0][0]);
+	}
+	m_scopes.push_back(scope);
+
+	return((int)m_scopes.size() - 1);
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting a new profiled frame.
+ ***********************************************************/
+void FrameProfiler::BeginFrame()
+{
+	m_scopeStack.clear();
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for finishing the profiled frame.
+ *  The other set of queries, written on the last frame, is
+ *  read now so that it can be written again next frame.
+ ***********************************************************/
+void FrameProfiler::EndFrame()
+{
+	m_frameSet ^= 1;
+	CollectQueries(m_frameSet);
+	m_frameCount++;
+}
+
+/***********************************************************
+ *  CollectQueries()
+ *
+ *  This method is used for reading the GPU timestamps of a
+ *  query set.  A result that is not ready yet is dropped
+ *  instead of being waited for.
+ ***********************************************************/
+void FrameProfiler::CollectQueries(int frameSet)
+{
+	for (TIMER_SCOPE& scope : m_scopes)
+	{
+		if (false == scope.bIssued[frameSet])
+		{
+			continue;
+		}
+		scope.bIssued[frameSet] = false;
+
+		GLint available = 0;
+		glGetQueryObjectiv(scope.queries[frameSet][1], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (0 == available)
+		{
+			continue;
+		}
+
+		GLuint64 beginTime = 0;
+		GLuint64 endTime = 0;
+		glGetQueryObjectui64v(scope.queries[frameSet][0], GL_QUERY_RESULT, &beginTime);
+		glGetQueryObjectui64v(scope.queries[frameSet][1], GL_QUERY_RESULT, &endTime);
+		scope.gpuHistory.Add((float)((double)(endTime - beginTime) / 1000000.0));
+	}
+}
+
+/***********************************************************
+ *  BeginScope()
+ *
+ *  This method is used for starting the timers of a scope.
+ *  Timestamps are used for the GPU time instead of elapsed
+ *  time queries, since those cannot be nested.
+ ***********************************************************/
+void FrameProfiler::BeginScope(const char* name, bool bGpuTimer)
+{
+	int index = FindScope(name, bGpuTimer);
+	TIMER_SCOPE& scope = m_scopes[index];
+
+	m_scopeStack.push_back(index);
+	if (scope.bGpuTimer)
+	{
+		glQueryCounter(scope.queries[m_frameSet][0], GL_TIMESTAMP);
+	}
+	scope.cpuStart = std::chrono::steady_clock::now();
+}
+
+/***********************************************************
+ *  EndScope()
+ *
+ *  This method is used for stopping the timers of the scope
+ *  that was begun last.
+ ***********************************************************/
+void FrameProfiler::EndScope()
+{
+	if (m_scopeStack.empty())
+	{
+		return;
+	}
+
+	TIMER_SCOPE& scope = m_scopes[m_scopeStack.back()];
+	m_scopeStack.pop_back();
+
+	scope.cpuHistory.Add(std::chrono::duration<float, std::milli>(
+		std::chrono::steady_clock::now() - scope.cpuStart).count());
+	if (scope.bGpuTimer)
+	{
+		glQueryCounter(scope.queries[m_frameSet][1], GL_TIMESTAMP);
+		scope.bIssued[m_frameSet] = true;
+	}
+}
+
+/***********************************************************
+ *  SetCounter()
+ *
+ *  This method is used for recording the value of a counter
+ *  for the current frame.
+ ***********************************************************/
+void FrameProfiler::SetCounter(const char* name, int value)
+{
+	for (FRAME_COUNTER& counter : m_counters)
+	{
+		if (counter.name == name)
+		{
+			counter.history.Add((float)value);
+			return;
+		}
+	}
+
+	FRAME_COUNTER counter;
+	counter.name = name;
+	counter.history.Add((float)value);
+	m_counters.push_back(counter);
+}
+
+/***********************************************************
+ *  GetOverlayText()
+ *
+ *  This method is used for getting the average CPU and GPU
+ *  time of the top level scopes and the average counters as
+ *  one line of text.
+ ***********************************************************/
+std::string FrameProfiler::GetOverlayText() const
+{
+	std::ostringstream oss;
+
+	oss << std::fixed << std::setprecision(2);
+	for (const TIMER_SCOPE& scope : m_scopes)
+	{
+		if (scope.depth > 0)
+		{
+			continue;
+		}
+
+		VALUE_STATS cpu = scope.cpuHistory.GetStats();
+		oss << scope.name << " " << cpu.avgValue;
+		if (scope.bGpuTimer)
+		{
+			VALUE_STATS gpu = scope.gpuHistory.GetStats();
+			oss << "/" << gpu.avgValue;
+		}
+		oss << "ms  ";
+	}
+	oss << std::setprecision(0);
+	for (const FRAME_COUNTER& counter : m_counters)
+	{
+		oss << "| " << counter.name << " " << counter.history.GetStats().avgValue << "  ";
+	}
+
+	return(oss.str());
+}
+
+/***********************************************************
+ *  GetScopeStats()
+ *
+ *  This method is used for getting the rolling CPU and GPU
+ *  statistics of a named scope.
+ ***********************************************************/
+bool FrameProfiler::GetScopeStats(const char* name, VALUE_STATS& cpuStats, VALUE_STATS& gpuStats) const
+{
+	for (const TIMER_SCOPE& scope : m_scopes)
+	{
+		if (scope.name == name)
+		{
+			cpuStats = scope.cpuHistory.GetStats();
+			gpuStats = scope.gpuHistory.GetStats();
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  WriteCSV()
+ *
+ *  This method is used for writing the rolling statistics of
+ *  every scope and counter to a CSV file, one row each.
+ ***********************************************************/
+bool FrameProfiler::WriteCSV(const std::string& filename) const
+{
+	std::ofstream file(filename.c_str());
+
+	if (!file.is_open())
+	{
+		std::cout << "Could not write profile:" << filename << std::endl;
+		return(false);
+	}
+
+	file << "name,kind,depth,min,avg,p99,samples\n";
+	file << std::fixed << std::setprecision(4);
+	for (const TIMER_SCOPE& scope : m_scopes)
+	{
+		VALUE_STATS cpu = scope.cpuHistory.GetStats();
+		file << scope.name << ",cpu_ms," << scope.depth << "," << cpu.minValue << ","
+			<< cpu.avgValue << "," << cpu.p99Value << "," << cpu.samples << "\n";
+		if (scope.bGpuTimer)
+		{
+			VALUE_STATS gpu = scope.gpuHistory.GetStats();
+			file << scope.name << ",gpu_ms," << scope.depth << "," << gpu.minValue << ","
+				<< gpu.avgValue << "," << gpu.p99Value << "," << gpu.samples << "\n";
+		}
+	}
+	for (const FRAME_COUNTER& counter : m_counters)
+	{
+		VALUE_STATS stats = counter.history.GetStats();
+		file << counter.name << ",count,0," << stats.minValue << ","
+			<< stats.avgValue << "," << stats.p99Value << "," << stats.samples << "\n";
+	}
+
+	std::cout << "INFO: Wrote profile:" << filename << std::endl;
+
+	return(true);
+}
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// frameprofiler.h
+// ============
+// measure the CPU and GPU time of the frame sections and count the work
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  FrameProfiler
+ *
+ *  This class contains the code for timing named scopes of
+ *  each frame on the CPU and on the GPU, and for recording
+ *  per frame counters.  The GPU timestamps are double
+ *  buffered, so a result is read one frame after it was
+ *  issued and the CPU never waits for the GPU.  The rolling
+ *  min, avg and p99 of each scope can be shown as a text
+ *  overlay or written to a CSV file.
+ ***********************************************************/
+class FrameProfiler
+{
+public:
+	// constructor
+	FrameProfiler();
+	// destructor
+	~FrameProfiler();
+
+	// number of frames the rolling statistics are taken over
+	static const int HISTORY_SIZE = 240;
+
+	// rolling statistics of one measured value
+	struct VALUE_STATS
+	{
+		float minValue;
+		float avgValue;
+		float p99Value;
+		int samples;
+	};
+
+	// start and finish a frame
+	void BeginFrame();
+	void EndFrame();
+
+	// time the code between the calls, scopes can be nested,
+	// the GPU time is only measured for the scopes that ask for it
+	void BeginScope(const char* name, bool bGpuTimer = true);
+	void EndScope();
+
+	// record the value of a per frame counter
+	void SetCounter(const char* name, int value);
+
+	// get the statistics as one line of text for the overlay
+	std::string GetOverlayText() const;
+	// write the statistics of every scope and counter to a file
+	bool WriteCSV(const std::string& filename) const;
+	// get the statistics of a named scope, false if it was never timed
+	bool GetScopeStats(const char* name, VALUE_STATS& cpuStats, VALUE_STATS& gpuStats) const;
+
+	// get the number of frames that were profiled
+	int GetFrameCount() const { return m_frameCount; }
+
+private:
+	// rolling history of one measured value
+	struct VALUE_HISTORY
+	{
+		std::deque<float> values;
+
+		void Add(float value);
+		VALUE_STATS GetStats() const;
+	};
+
+	// one named scope and its double buffered GPU timestamps
+	struct TIMER_SCOPE
+	{
+		std::string name;
+		int depth;
+		bool bGpuTimer;
+		GLuint queries[2][2];		// [frame set][begin, end]
+		bool bIssued[2];
+		std::chrono::steady_clock::time_point cpuStart;
+		VALUE_HISTORY cpuHistory;
+		VALUE_HISTORY gpuHistory;
+	};
+
+	// one named per frame counter
+	struct FRAME_COUNTER
+	{
+		std::string name;
+		VALUE_HISTORY history;
+	};
+
+	// scopes in the order they were first begun
+	std::vector<TIMER_SCOPE> m_scopes;
+	// indices of the scopes that are currently open
+	std::vector<int> m_scopeStack;
+	std::vector<FRAME_COUNTER> m_counters;
+
+	// set of GPU queries written this frame, 0 or 1
+	int m_frameSet;
+	int m_frameCount;
+
+	// find a scope by name, adding it on first use
+	int FindScope(const char* name, bool bGpuTimer);
+	// read the GPU results of the frame set that is reused next
+	void CollectQueries(int frameSet);
+};
@@ -0,0 +1,198 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuresources.cpp
+// ============
+// registry of the live OpenGL objects and the video memory they hold
+///////////////////////////////////////////////////////////////////////////////
+
+#include "GpuResources.h"
+
+#include <iostream>
+#include <map>
+#include <string>
+
+// declaration of the global variables and defines
+namespace
+{
+	// one recorded object
+	struct RESOURCE
+	{
+		std::string owner;
+		size_t bytes;
+	};
+
+	// the objects by their type and name, packed into one key
+	std::map<unsigned long long, RESOURCE> g_Resources;
+	GpuResources::RESOURCE_TOTALS g_Totals[GpuResources::RESOURCE_TYPE_COUNT] = {};
+
+	const char* g_TypeNames[GpuResources::RESOURCE_TYPE_COUNT] =
+	{
+		"texture",
+		"buffer",
+		"vertex array",
+		"program",
+		"framebuffer"
+	};
+
+	unsigned long long MakeKey(GpuResources::RESOURCE_TYPE type, GLuint id)
+	{
+		return(((unsigned long long)type << 32) | id);
+	}
+}
+
+/***********************************************************
+ *  Add()
+ *
+ *  This method is used for recording a created object.  A
+ *  name that is already recorded is replaced, which happens
+ *  when the driver hands out the name of an object that was
+ *  deleted without being removed.
+ ***********************************************************/
+void GpuResources::Add(RESOURCE_TYPE type, GLuint id, const char* owner, size_t bytes)
+{
+	if (0 == id)
+	{
+		return;
+	}
+
+	Remove(type, id);
+
+	RESOURCE resource;
+	resource.owner = owner;
+	resource.bytes = bytes;
+	g_Resources[MakeKey(type, id)] = resource;
+
+	g_Totals[type].count++;
+	g_Totals[type].bytes += bytes;
+}
+
+/***********************************************************
+ *  SetSize()
+ *
+ *  This method is used for setting the bytes of storage of
+ *  an object, after its storage was created or replaced.
+ ***********************************************************/
+void GpuResources::SetSize(RESOURCE_TYPE type, GLuint id, size_t bytes)
+{
+	std::map<unsigned long long, RESOURCE>::iterator it = g_Resources.find(MakeKey(type, id));
+
+	if (it == g_Resources.end())
+	{
+		return;
+	}
+
+	g_Totals[type].bytes -= it->second.bytes;
+	g_Totals[type].bytes += bytes;
+	it->second.bytes = bytes;
+}
+
+/***********************************************************
+ *  Remove()
+ *
+ *  This method is used for forgetting an object, right
+ *  before it is deleted.
+ ***********************************************************/
+void GpuResources::Remove(RESOURCE_TYPE type, GLuint id)
+{
+	std::map<unsigned long long, RESOURCE>::iterator it = g_Resources.find(MakeKey(type, id));
+
+	if (it == g_Resources.end())
+	{
+		return;
+	}
+
+	g_Totals[type].count--;
+	g_Totals[type].bytes -= it->second.bytes;
+	g_Resources.erase(it);
+}
+
+/***********************************************************
+ *  GetTotals()
+ *
+ *  This method is used for getting the number of live
+ *  objects of a type and the bytes they hold.
+ ***********************************************************/
+GpuResources::RESOURCE_TOTALS GpuResources::GetTotals(RESOURCE_TYPE type)
+{
+	return(g_Totals[type]);
+}
+
+/***********************************************************
+ *  GetTypeName()
+ *
+ *  This method is used for getting the name of a type.
+ ***********************************************************/
+const char* GpuResources::GetTypeName(RESOURCE_TYPE type)
+{
+	return(g_TypeNames[type]);
+}
+
+/***********************************************************
+ *  GetTexelSize()
+ *
+ *  This method is used for getting the bytes of one texel
+ *  of the internal formats used by the scene.  The drivers
+ *  store the three channel formats with a fourth channel,
+ *  so they are counted the same as the four channel ones.
+ ***********************************************************/
+size_t GpuResources::GetTexelSize(GLenum internalFormat)
+{
+	switch (internalFormat)
+	{
+	case GL_R8:
+		return(1);
+	case GL_RGB8:
+	case GL_RGBA8:
+	case GL_R32F:
+	case GL_R32I:
+	case GL_R32UI:
+	case GL_DEPTH_COMPONENT24:
+	case GL_DEPTH_COMPONENT32F:
+		return(4);
+	case GL_RGBA16F:
+		return(8);
+	case GL_RGB32F:
+	case GL_RGBA32F:
+		return(16);
+	default:
+		return(4);
+	}
+}
+
+/***********************************************************
+ *  ReportLeaks()
+ *
+ *  This method is used for printing each object that was
+ *  not deleted, with its owner and size, followed by the
+ *  totals of each type.  It should be called after all the
+ *  owners of OpenGL objects have been deleted.
+ ***********************************************************/
+int GpuResources::ReportLeaks()
+{
+	int leakCount = (int)g_Resources.size();
+
+	if (0 == leakCount)
+	{
+		std::cout << "All the recorded OpenGL objects were deleted" << std::endl;
+		return(0);
+	}
+
+	std::map<unsigned long long, RESOURCE>::const_iterator it;
+	for (it = g_Resources.begin(); it != g_Resources.end(); ++it)
+	{
+		RESOURCE_TYPE type = (RESOURCE_TYPE)(it->first >> 32);
+		GLuint id = (GLuint)(it->first & 0xFFFFFFFFull);
+
+		std::cout << "LEAK: " << g_TypeNames[type] << " " << id << " of " << it->second.owner
+			<< ", " << it->second.bytes << " bytes" << std::endl;
+	}
+	for (int type = 0; type < RESOURCE_TYPE_COUNT; type++)
+	{
+		if (g_Totals[type].count > 0)
+		{
+			std::cout << "LEAK: " << g_Totals[type].count << " " << g_TypeNames[type] << " objects, "
+				<< (g_Totals[type].bytes / 1024) << " KB" << std::endl;
+		}
+	}
+
+	return(leakCount);
+}
@@ -0,0 +1,61 @@
+///////////////////////////////////////////////////////////////////////////////
+// gpuresources.h
+// ============
+// registry of the live OpenGL objects and the video memory they hold
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+
+/***********************************************************
+ *  GpuResources
+ *
+ *  This class contains the code for recording each OpenGL
+ *  texture, buffer, vertex array, program and framebuffer
+ *  when it is created and deleted, with the name of its
+ *  owner and the bytes of storage it was given.  The totals
+ *  of each type are shown on the profiler overlay, and the
+ *  objects still alive at exit are reported as leaks.  It is
+ *  only used from the thread that owns the OpenGL context.
+ ***********************************************************/
+class GpuResources
+{
+public:
+	// types of the recorded objects
+	enum RESOURCE_TYPE
+	{
+		RESOURCE_TEXTURE = 0,
+		RESOURCE_BUFFER,
+		RESOURCE_VERTEX_ARRAY,
+		RESOURCE_PROGRAM,
+		RESOURCE_FRAMEBUFFER,
+		RESOURCE_TYPE_COUNT
+	};
+
+	// number of live objects of a type and the bytes they hold
+	struct RESOURCE_TOTALS
+	{
+		int count;
+		size_t bytes;
+	};
+
+	// record a created object, the owner names it in the leak report
+	static void Add(RESOURCE_TYPE type, GLuint id, const char* owner, size_t bytes = 0);
+	// set the bytes of storage of a recorded object
+	static void SetSize(RESOURCE_TYPE type, GLuint id, size_t bytes);
+	// forget an object before it is deleted
+	static void Remove(RESOURCE_TYPE type, GLuint id);
+
+	// get the totals of one type of object
+	static RESOURCE_TOTALS GetTotals(RESOURCE_TYPE type);
+	// get the name of a type for the overlay and the report
+	static const char* GetTypeName(RESOURCE_TYPE type);
+	// get the bytes of one texel of an uncompressed internal format
+	static size_t GetTexelSize(GLenum internalFormat);
+
+	// print the objects that are still alive, returns their number
+	static int ReportLeaks();
+};
@@ -0,0 +1,441 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectrenderer.cpp
+// ============
+// GPU driven drawing of the static scene with multi draw indirect
+///////////////////////////////////////////////////////////////////////////////
+
+#include "IndirectRenderer.h"
+#include "GpuResources.h"
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// invocations of one culling work group, same as the shader
+	const int CULL_GROUP_SIZE = 64;
+	// storage buffer binding points used by the culling shader
+	const GLuint COMMAND_BUFFER_BINDING = 0;
+	const GLuint BOUNDS_BUFFER_BINDING = 1;
+	// RGBA32F texels of one object in the draw data buffer
+	const int TEXELS_PER_OBJECT = sizeof(IndirectRenderer::INDIRECT_OBJECT) / sizeof(glm::vec4);
+}
+
+/***********************************************************
+ *  IndirectRenderer()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+IndirectRenderer::IndirectRenderer()
+{
+	GLint maxUnits = 0;
+
+	m_bSupported = false;
+	m_objectCount = 0;
+	m_cullProgram = 0;
+	m_frustumPlanesLocation = -1;
+	m_objectCountLocation = -1;
+	m_cullObjectsLocation = -1;
+	m_commandBuffer = 0;
+	m_firstDirtyCommand = -1;
+	m_lastDirtyCommand = -1;
+	m_casterCommandBuffer = 0;
+	m_boundsBuffer = 0;
+	m_drawDataBuffer = 0;
+	m_drawDataTexture = 0;
+	m_materialDataBuffer = 0;
+	m_materialDataTexture = 0;
+
+	// the last unit is used by the texture loader, the buffer
+	// textures take the two below it so they are never rebound
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+	m_drawDataUnit = std::max(0, maxUnits - 2);
+	m_materialDataUnit = std::max(0, maxUnits - 3);
+}
+
+/***********************************************************
+ *  ~IndirectRenderer()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+IndirectRenderer::~IndirectRenderer()
+{
+	if (0 != m_cullProgram)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_PROGRAM, m_cullProgram);
+		glDeleteProgram(m_cullProgram);
+		m_cullProgram = 0;
+	}
+
+	GLuint buffers[] = { m_commandBuffer, m_casterCommandBuffer, m_boundsBuffer, m_drawDataBuffer, m_materialDataBuffer };
+	for (GLuint buffer : buffers)
+	{
+		if (0 != buffer)
+		{
+			GpuResources::Remove(GpuResources::RESOURCE_BUFFER, buffer);
+			glDeleteBuffers(1, &buffer);
+		}
+	}
+	m_commandBuffer = 0;
+	m_casterCommandBuffer = 0;
+	m_boundsBuffer = 0;
+	m_drawDataBuffer = 0;
+	m_materialDataBuffer = 0;
+
+	GLuint textures[] = { m_drawDataTexture, m_materialDataTexture };
+	for (GLuint texture : textures)
+	{
+		if (0 != texture)
+		{
+			GpuResources::Remove(GpuResources::RESOURCE_TEXTURE, texture);
+			glDeleteTextures(1, &texture);
+		}
+	}
+	m_drawDataTexture = 0;
+	m_materialDataTexture = 0;
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for compiling the culling compute
+ *  shader and creating the buffers.  The compute shaders
+ *  and the indirect draws need OpenGL 4.3, without it the
+ *  scene is drawn by the CPU path only.
+ ***********************************************************/
+bool IndirectRenderer::Initialize(const char* computeShaderFile)
+{
+	if (GLEW_VERSION_4_3 == GL_FALSE)
+	{
+		std::cout << "INFO: OpenGL 4.3 is not available, multi draw indirect is disabled" << std::endl;
+		return(false);
+	}
+
+	m_cullProgram = LoadComputeProgram(computeShaderFile);
+	if (0 == m_cullProgram)
+	{
+		return(false);
+	}
+
+	m_frustumPlanesLocation = glGetUniformLocation(m_cullProgram, "frustumPlanes");
+	m_objectCountLocation = glGetUniformLocation(m_cullProgram, "objectCount");
+	m_cullObjectsLocation = glGetUniformLocation(m_cullProgram, "bCullObjects");
+
+	glGenBuffers(1, &m_commandBuffer);
+	glGenBuffers(1, &m_casterCommandBuffer);
+	glGenBuffers(1, &m_boundsBuffer);
+	glGenBuffers(1, &m_drawDataBuffer);
+	glGenBuffers(1, &m_materialDataBuffer);
+	glGenTextures(1, &m_drawDataTexture);
+	glGenTextures(1, &m_materialDataTexture);
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_commandBuffer, "IndirectRenderer");
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_casterCommandBuffer, "IndirectRenderer");
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_boundsBuffer, "IndirectRenderer");
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_drawDataBuffer, "IndirectRenderer");
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_materialDataBuffer, "IndirectRenderer");
+	// the buffer textures only view the storage of their buffers
+	GpuResources::Add(GpuResources::RESOURCE_TEXTURE, m_drawDataTexture, "IndirectRenderer");
+	GpuResources::Add(GpuResources::RESOURCE_TEXTURE, m_materialDataTexture, "IndirectRenderer");
+
+	m_bSupported = true;
+
+	return(true);
+}
+
+/***********************************************************
+ *  ReloadCullProgram()
+ *
+ *  This method is used for building the culling compute
+ *  shader again after its file changed.  The new program
+ *  only replaces the current one once it has linked.
+ ***********************************************************/
+bool IndirectRenderer::ReloadCullProgram(const char* computeShaderFile)
+{
+	if (false == m_bSupported)
+	{
+		return(false);
+	}
+
+	GLuint program = LoadComputeProgram(computeShaderFile);
+	if (0 == program)
+	{
+		return(false);
+	}
+
+	GpuResources::Remove(GpuResources::RESOURCE_PROGRAM, m_cullProgram);
+	glDeleteProgram(m_cullProgram);
+	m_cullProgram = program;
+	m_frustumPlanesLocation = glGetUniformLocation(m_cullProgram, "frustumPlanes");
+	m_objectCountLocation = glGetUniformLocation(m_cullProgram, "objectCount");
+	m_cullObjectsLocation = glGetUniformLocation(m_cullProgram, "bCullObjects");
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadComputeProgram()
+ *
+ *  This method is used for reading the compute shader from
+ *  a file and linking it into its own program.  Zero is
+ *  returned when the shader cannot be built.
+ ***********************************************************/
+GLuint IndirectRenderer::LoadComputeProgram(const char* filename)
+{
+	std::ifstream file(filename);
+	std::stringstream source;
+	GLint success = 0;
+	GLchar infoLog[512];
+
+	if (!file.is_open())
+	{
+		std::cout << "Could not open compute shader:" << filename << std::endl;
+		return(0);
+	}
+	source << file.rdbuf();
+
+	std::string code = source.str();
+	const GLchar* codeText = code.c_str();
+	GLuint shader = glCreateShader(GL_COMPUTE_SHADER);
+	glShaderSource(shader, 1, &codeText, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR: compute shader compilation failed:" << filename << "\n" << infoLog << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, shader);
+	glLinkProgram(program);
+	glDeleteShader(shader);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR: compute program linking failed:" << filename << "\n" << infoLog << std::endl;
+		glDeleteProgram(program);
+		return(0);
+	}
+	GpuResources::Add(GpuResources::RESOURCE_PROGRAM, program, filename);
+
+	return(program);
+}
+
+/***********************************************************
+ *  BindBufferTexture()
+ *
+ *  This method is used for pointing a buffer texture at the
+ *  RGBA32F texels of a buffer and binding it to its unit.
+ ***********************************************************/
+void IndirectRenderer::BindBufferTexture(GLuint texture, GLuint buffer, GLint unit)
+{
+	glActiveTexture(GL_TEXTURE0 + unit);
+	glBindTexture(GL_TEXTURE_BUFFER, texture);
+	glTexBuffer(GL_TEXTURE_BUFFER, GL_RGBA32F, buffer);
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  SetMaterials()
+ *
+ *  This method is used for copying the materials into the
+ *  material data buffer.  The objects refer to them by
+ *  their index.
+ ***********************************************************/
+void IndirectRenderer::SetMaterials(const std::vector<INDIRECT_MATERIAL>& materials)
+{
+	if ((false == m_bSupported) || materials.empty())
+	{
+		return;
+	}
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_materialDataBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, materials.size() * sizeof(INDIRECT_MATERIAL), materials.data(), GL_STATIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_materialDataBuffer, materials.size() * sizeof(INDIRECT_MATERIAL));
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	BindBufferTexture(m_materialDataTexture, m_materialDataBuffer, m_materialDataUnit);
+}
+
+/***********************************************************
+ *  SetObjects()
+ *
+ *  This method is used for replacing all of the objects.
+ *  The command of object i must have the base instance i,
+ *  which is how the vertex shader finds its draw data.
+ *  False is returned when the objects do not fit in the
+ *  largest buffer texture.
+ ***********************************************************/
+bool IndirectRenderer::SetObjects(
+	const std::vector<INDIRECT_OBJECT>& objects,
+	const std::vector<MeshLibrary::DRAW_COMMAND>& commands,
+	const std::vector<SceneBVH::BOUNDING_BOX>& bounds)
+{
+	GLint maxTexels = 0;
+	std::vector<GPU_BOUNDS> gpuBounds(bounds.size());
+
+	m_objectCount = 0;
+	if ((false == m_bSupported) || objects.empty())
+	{
+		return(false);
+	}
+
+	glGetIntegerv(GL_MAX_TEXTURE_BUFFER_SIZE, &maxTexels);
+	if ((GLint64)objects.size() * TEXELS_PER_OBJECT > (GLint64)maxTexels)
+	{
+		std::cout << "INFO: " << objects.size() << " objects do not fit in a buffer texture, "
+			<< "multi draw indirect is disabled" << std::endl;
+		return(false);
+	}
+
+	for (size_t i = 0; i < bounds.size(); i++)
+	{
+		gpuBounds[i].minCorner = glm::vec4(bounds[i].minCorner, 1.0f);
+		gpuBounds[i].maxCorner = glm::vec4(bounds[i].maxCorner, 1.0f);
+	}
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, commands.size() * sizeof(MeshLibrary::DRAW_COMMAND), commands.data(), GL_DYNAMIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_commandBuffer, commands.size() * sizeof(MeshLibrary::DRAW_COMMAND));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boundsBuffer);
+	glBufferData(GL_SHADER_STORAGE_BUFFER, gpuBounds.size() * sizeof(GPU_BOUNDS), gpuBounds.data(), GL_DYNAMIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_boundsBuffer, gpuBounds.size() * sizeof(GPU_BOUNDS));
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_drawDataBuffer);
+	glBufferData(GL_TEXTURE_BUFFER, objects.size() * sizeof(INDIRECT_OBJECT), objects.data(), GL_DYNAMIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_drawDataBuffer, objects.size() * sizeof(INDIRECT_OBJECT));
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+
+	BindBufferTexture(m_drawDataTexture, m_drawDataBuffer, m_drawDataUnit);
+	m_objectCount = (int)objects.size();
+	m_commands = commands;
+	m_firstDirtyCommand = -1;
+	m_lastDirtyCommand = -1;
+
+	return(true);
+}
+
+/***********************************************************
+ *  UpdateObject()
+ *
+ *  This method is used for changing the values and the box
+ *  of one object, for when it has been moved.
+ ***********************************************************/
+void IndirectRenderer::UpdateObject(int drawIndex, const INDIRECT_OBJECT& object, const SceneBVH::BOUNDING_BOX& bounds)
+{
+	if ((drawIndex < 0) || (drawIndex >= m_objectCount))
+	{
+		return;
+	}
+
+	GPU_BOUNDS gpuBounds;
+	gpuBounds.minCorner = glm::vec4(bounds.minCorner, 1.0f);
+	gpuBounds.maxCorner = glm::vec4(bounds.maxCorner, 1.0f);
+
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_boundsBuffer);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, drawIndex * sizeof(GPU_BOUNDS), sizeof(GPU_BOUNDS), &gpuBounds);
+	glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+
+	glBindBuffer(GL_TEXTURE_BUFFER, m_drawDataBuffer);
+	glBufferSubData(GL_TEXTURE_BUFFER, drawIndex * sizeof(INDIRECT_OBJECT), sizeof(INDIRECT_OBJECT), &object);
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetCommandRange()
+ *
+ *  This method is used for pointing the command of one
+ *  object at another range of the shared mesh buffers.  The
+ *  changed commands are uploaded together before the next
+ *  culling pass.
+ ***********************************************************/
+void IndirectRenderer::SetCommandRange(int drawIndex, const MeshLibrary::MESH_RANGE& range)
+{
+	if ((drawIndex < 0) || (drawIndex >= m_objectCount))
+	{
+		return;
+	}
+
+	MeshLibrary::DRAW_COMMAND& command = m_commands[drawIndex];
+	command.count = (GLuint)range.indexCount;
+	command.firstIndex = range.firstIndex;
+	command.baseVertex = range.baseVertex;
+
+	if (m_firstDirtyCommand < 0)
+	{
+		m_firstDirtyCommand = drawIndex;
+		m_lastDirtyCommand = drawIndex;
+	}
+	m_firstDirtyCommand = std::min(m_firstDirtyCommand, drawIndex);
+	m_lastDirtyCommand = std::max(m_lastDirtyCommand, drawIndex);
+}
+
+/***********************************************************
+ *  SetCasterCommands()
+ *
+ *  This method is used for replacing the commands that draw
+ *  the shadow casters of a light.  Only the casters inside
+ *  the light frustum have a command, and each one reads the
+ *  draw data of its object through its base instance.
+ ***********************************************************/
+void IndirectRenderer::SetCasterCommands(const std::vector<MeshLibrary::DRAW_COMMAND>& commands)
+{
+	if ((false == m_bSupported) || commands.empty())
+	{
+		return;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, m_casterCommandBuffer);
+	glBufferData(GL_DRAW_INDIRECT_BUFFER, commands.size() * sizeof(MeshLibrary::DRAW_COMMAND), commands.data(), GL_STREAM_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_casterCommandBuffer, commands.size() * sizeof(MeshLibrary::DRAW_COMMAND));
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+/***********************************************************
+ *  CullObjects()
+ *
+ *  This method is used for running the compute pass that
+ *  sets the instance count of each command to one when its
+ *  object is inside of the frustum and to zero otherwise.
+ *  The barrier makes the commands visible to the draws.
+ ***********************************************************/
+void IndirectRenderer::CullObjects(const SceneBVH::FRUSTUM& frustum, bool bCullObjects, GLuint restoreProgram)
+{
+	if ((false == m_bSupported) || (m_objectCount <= 0))
+	{
+		return;
+	}
+
+	// the instance counts written by the last pass are replaced
+	// below, so the changed commands can be copied over whole
+	if (m_firstDirtyCommand >= 0)
+	{
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, m_commandBuffer);
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER,
+			m_firstDirtyCommand * sizeof(MeshLibrary::DRAW_COMMAND),
+			(m_lastDirtyCommand - m_firstDirtyCommand + 1) * sizeof(MeshLibrary::DRAW_COMMAND),
+			&m_commands[m_firstDirtyCommand]);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+		m_firstDirtyCommand = -1;
+		m_lastDirtyCommand = -1;
+	}
+
+	glUseProgram(m_cullProgram);
+	glUniform4fv(m_frustumPlanesLocation, 6, &frustum.planes[0][0]);
+	glUniform1i(m_objectCountLocation, m_objectCount);
+	glUniform1i(m_cullObjectsLocation, bCullObjects ? 1 : 0);
+
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, COMMAND_BUFFER_BINDING, m_commandBuffer);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, BOUNDS_BUFFER_BINDING, m_boundsBuffer);
+	glDispatchCompute((m_objectCount + CULL_GROUP_SIZE - 1) / CULL_GROUP_SIZE, 1, 1);
+	glMemoryBarrier(GL_COMMAND_BARRIER_BIT);
+
+	glUseProgram(restoreProgram);
+}
@@ -0,0 +1,144 @@
+///////////////////////////////////////////////////////////////////////////////
+// indirectrenderer.h
+// ============
+// GPU driven drawing of the static scene with multi draw indirect
+//
+//  Every object gets one command in the indirect buffer, and its base
+//  instance is its index into the per draw data buffer.  A compute pass
+//  culls the objects against the view frustum by setting the instance
+//  count of their command, so the culling never goes back to the CPU.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "MeshLibrary.h"
+#include "SceneBVH.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  IndirectRenderer
+ *
+ *  This class contains the code for keeping the indirect
+ *  command buffer, the per draw object data and the object
+ *  bounds on the GPU, and for the compute pass that culls
+ *  the commands before they are drawn.  The per draw data
+ *  and the materials are read by the vertex shader from
+ *  buffer textures.
+ ***********************************************************/
+class IndirectRenderer
+{
+public:
+	// constructor
+	IndirectRenderer();
+	// destructor
+	~IndirectRenderer();
+
+	// values of one object as read by the vertex shader, nine
+	// RGBA32F texels of the draw data buffer texture
+	struct INDIRECT_OBJECT
+	{
+		glm::mat4 modelMatrix;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		float textureLayer;
+		float materialIndex;
+		glm::vec4 normalMatrix[3];
+	};
+
+	// values of one material, three RGBA32F texels of the
+	// material data buffer texture
+	struct INDIRECT_MATERIAL
+	{
+		glm::vec3 diffuseColor; float shininess;
+		glm::vec3 specularColor; float ambientStrength;
+		glm::vec3 ambientColor; float pad0;
+	};
+
+	// compile the culling compute shader, false when the GPU
+	// cannot run the indirect path
+	bool Initialize(const char* computeShaderFile);
+	// check if the indirect path can be used
+	bool IsSupported() const { return m_bSupported; }
+	// build the culling compute shader again, the current program is
+	// kept when the new one fails
+	bool ReloadCullProgram(const char* computeShaderFile);
+
+	// replace the materials the objects refer to by index
+	void SetMaterials(const std::vector<INDIRECT_MATERIAL>& materials);
+	// replace all of the objects, with one command and one box each
+	bool SetObjects(
+		const std::vector<INDIRECT_OBJECT>& objects,
+		const std::vector<MeshLibrary::DRAW_COMMAND>& commands,
+		const std::vector<SceneBVH::BOUNDING_BOX>& bounds);
+	// change the values and the box of one object after it moved
+	void UpdateObject(int drawIndex, const INDIRECT_OBJECT& object, const SceneBVH::BOUNDING_BOX& bounds);
+	// point the command of one object at another mesh range, for
+	// when its level of detail changed
+	void SetCommandRange(int drawIndex, const MeshLibrary::MESH_RANGE& range);
+
+	// set the instance count of every command by the frustum, the
+	// passed in program is made current again afterwards
+	void CullObjects(const SceneBVH::FRUSTUM& frustum, bool bCullObjects, GLuint restoreProgram);
+
+	// get the buffer holding the culled commands
+	GLuint GetCommandBuffer() const { return m_commandBuffer; }
+
+	// replace the commands of the shadow casters of a light, culled on
+	// the CPU, with the object index as the base instance of each
+	void SetCasterCommands(const std::vector<MeshLibrary::DRAW_COMMAND>& commands);
+	// get the buffer holding the shadow caster commands
+	GLuint GetCasterCommandBuffer() const { return m_casterCommandBuffer; }
+	// get the number of objects with a command
+	int GetObjectCount() const { return m_objectCount; }
+
+	// get the texture units the buffer textures stay bound to
+	GLint GetDrawDataUnit() const { return m_drawDataUnit; }
+	GLint GetMaterialDataUnit() const { return m_materialDataUnit; }
+
+private:
+	// bounds of one object as laid out in the std430 bounds buffer
+	struct GPU_BOUNDS
+	{
+		glm::vec4 minCorner;
+		glm::vec4 maxCorner;
+	};
+
+	bool m_bSupported;
+	int m_objectCount;
+
+	// culling compute program and its uniform locations
+	GLuint m_cullProgram;
+	GLint m_frustumPlanesLocation;
+	GLint m_objectCountLocation;
+	GLint m_cullObjectsLocation;
+
+	// indirect commands, written by the culling pass
+	GLuint m_commandBuffer;
+	// copy of the commands and the range of them changed since
+	// the last culling pass, uploaded before the next one
+	std::vector<MeshLibrary::DRAW_COMMAND> m_commands;
+	int m_firstDirtyCommand;
+	int m_lastDirtyCommand;
+	// commands of the shadow casters, which read the same draw data
+	GLuint m_casterCommandBuffer;
+	// world space box of each object, read by the culling pass
+	GLuint m_boundsBuffer;
+	// per draw object data and the buffer texture reading it
+	GLuint m_drawDataBuffer;
+	GLuint m_drawDataTexture;
+	GLint m_drawDataUnit;
+	// material data and the buffer texture reading it
+	GLuint m_materialDataBuffer;
+	GLuint m_materialDataTexture;
+	GLint m_materialDataUnit;
+
+	// read the compute shader source and link it into a program
+	static GLuint LoadComputeProgram(const char* filename);
+	// bind a buffer texture over a buffer to its texture unit
+	static void BindBufferTexture(GLuint texture, GLuint buffer, GLint unit);
+};
@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.cpp
+// ============
+// split loops over the draw items into jobs run on a pool of worker threads
+///////////////////////////////////////////////////////////////////////////////
+
+#include "JobSystem.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  JobSystem()
+ *
+ *  The constructor for the class.  The worker threads are
+ *  started here and sleep until a loop is run.
+ ***********************************************************/
+JobSystem::JobSystem(int workerCount)
+{
+	m_bStopping = false;
+	m_queuedJobs = 0;
+	m_pendingJobs = 0;
+
+	if (workerCount < 0)
+	{
+		// the calling thread runs chunks as well
+		workerCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+	}
+	m_threadCount = workerCount + 1;
+	m_queues = new JOB_QUEUE[m_threadCount];
+
+	for (int i = 1; i < m_threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&JobSystem::WorkerThread, this, i));
+	}
+}
+
+/***********************************************************
+ *  ~JobSystem()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+JobSystem::~JobSystem()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_bStopping = true;
+	}
+	m_wakeCondition.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	delete[] m_queues;
+	m_queues = NULL;
+}
+
+/***********************************************************
+ *  ParallelFor()
+ *
+ *  This method is used for running a function over a range
+ *  of items.  The chunks are dealt out to the queues of the
+ *  threads in turn, and the calling thread runs and steals
+ *  chunks until all of them are done.  A loop that fits in
+ *  one chunk is run on the calling thread directly.
+ ***********************************************************/
+void JobSystem::ParallelFor(int count, int chunkSize, const RANGE_FUNCTION& function)
+{
+	if (count <= 0)
+	{
+		return;
+	}
+	chunkSize = std::max(1, chunkSize);
+	if ((1 == m_threadCount) || (count <= chunkSize))
+	{
+		function(0, count);
+		return;
+	}
+
+	int chunkCount = (count + chunkSize - 1) / chunkSize;
+	m_pendingJobs += chunkCount;
+
+	for (int chunk = 0; chunk < chunkCount; chunk++)
+	{
+		JOB job;
+		job.pFunction = &function;
+		job.first = chunk * chunkSize;
+		job.last = std::min(count, job.first + chunkSize);
+
+		JOB_QUEUE& queue = m_queues[chunk % m_threadCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		queue.jobs.push_back(job);
+	}
+
+	// the count is raised under the wake lock, so that a worker
+	// cannot miss it between its check and its wait
+	{
+		std::lock_guard<std::mutex> lock(m_wakeMutex);
+		m_queuedJobs += chunkCount;
+	}
+	m_wakeCondition.notify_all();
+
+	// the last chunks may still run on the workers once the queues
+	// are empty, they are short so the caller only yields for them
+	while (m_pendingJobs > 0)
+	{
+		JOB job;
+		if (TakeJob(0, job))
+		{
+			RunJob(job);
+		}
+		else
+		{
+			std::this_thread::yield();
+		}
+	}
+}
+
+/***********************************************************
+ *  WorkerThread()
+ *
+ *  This method is run by each worker thread.  It runs the
+ *  queued chunks, and sleeps while there are none.
+ ***********************************************************/
+void JobSystem::WorkerThread(int queueIndex)
+{
+	while (true)
+	{
+		JOB job;
+
+		if (TakeJob(queueIndex, job))
+		{
+			RunJob(job);
+			continue;
+		}
+
+		std::unique_lock<std::mutex> lock(m_wakeMutex);
+		m_wakeCondition.wait(lock, [this]()
+			{
+				return(m_bStopping || (m_queuedJobs > 0));
+			});
+		if (m_bStopping)
+		{
+			return;
+		}
+	}
+}
+
+/***********************************************************
+ *  TakeJob()
+ *
+ *  This method is used for taking the next chunk of a
+ *  thread.  The own queue is used from the back, where the
+ *  chunks were added last, and the other queues are stolen
+ *  from at the front, away from their owners.
+ ***********************************************************/
+bool JobSystem::TakeJob(int queueIndex, JOB& job)
+{
+	{
+		JOB_QUEUE& queue = m_queues[queueIndex];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (false == queue.jobs.empty())
+		{
+			job = queue.jobs.back();
+			queue.jobs.pop_back();
+			m_queuedJobs--;
+			return(true);
+		}
+	}
+
+	for (int i = 1; i < m_threadCount; i++)
+	{
+		JOB_QUEUE& queue = m_queues[(queueIndex + i) % m_threadCount];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		if (false == queue.jobs.empty())
+		{
+			job = queue.jobs.front();
+			queue.jobs.pop_front();
+			m_queuedJobs--;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  RunJob()
+ *
+ *  This method is used for running one chunk of a loop.
+ ***********************************************************/
+void JobSystem::RunJob(const JOB& job)
+{
+	(*job.pFunction)(job.first, job.last);
+	m_pendingJobs--;
+}
@@ -0,0 +1,83 @@
+///////////////////////////////////////////////////////////////////////////////
+// jobsystem.h
+// ============
+// split loops over the draw items into jobs run on a pool of worker threads
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  JobSystem
+ *
+ *  This class contains the code for running a loop in
+ *  chunks on several threads.  Each thread has its own
+ *  queue of chunks, takes its next chunk from the back of
+ *  its queue, and steals from the front of the other queues
+ *  once its own queue is empty, so that chunks of uneven
+ *  cost still keep every thread busy.  The calling thread
+ *  runs chunks as well while it waits for the loop to end.
+ ***********************************************************/
+class JobSystem
+{
+public:
+	// the function a loop runs over the items first to last - 1
+	typedef std::function<void(int first, int last)> RANGE_FUNCTION;
+
+	// constructor - a negative worker count uses the hardware count,
+	// and zero workers runs every loop on the calling thread
+	JobSystem(int workerCount = -1);
+	// destructor
+	~JobSystem();
+
+	// get the number of threads a loop is run on, with the caller
+	int GetThreadCount() const { return m_threadCount; }
+
+	// run the function over the items 0 to count - 1 in chunks of
+	// the passed in size, and return once every chunk is done - the
+	// loops are started from one thread only
+	void ParallelFor(int count, int chunkSize, const RANGE_FUNCTION& function);
+
+private:
+	// one chunk of a loop
+	struct JOB
+	{
+		const RANGE_FUNCTION* pFunction;
+		int first;
+		int last;
+	};
+
+	// the chunks waiting on one thread, queue 0 is the caller's
+	struct JOB_QUEUE
+	{
+		std::mutex mutex;
+		std::deque<JOB> jobs;
+	};
+
+	int m_threadCount;
+	JOB_QUEUE* m_queues;
+	std::vector<std::thread> m_workers;
+
+	// the workers sleep until chunks are queued
+	std::mutex m_wakeMutex;
+	std::condition_variable m_wakeCondition;
+	bool m_bStopping;
+	// chunks that are queued, and chunks that are not finished yet
+	std::atomic<int> m_queuedJobs;
+	std::atomic<int> m_pendingJobs;
+
+	// run chunks until the job system is stopped
+	void WorkerThread(int queueIndex);
+	// take the next chunk of a thread, from its own queue first and
+	// then from the other queues, false when every queue is empty
+	bool TakeJob(int queueIndex, JOB& job);
+	// run a chunk and count it as done
+	void RunJob(const JOB& job);
+};
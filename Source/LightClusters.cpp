@@ -0,0 +1,305 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.cpp
+// ============
+// bin the point lights into view space clusters for clustered forward shading
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightClusters.h"
+#include "GpuResources.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+/***********************************************************
+ *  LightClusters()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightClusters::LightClusters()
+{
+	m_depthScale = 0.0f;
+	m_depthBias = 0.0f;
+	m_lightDataBuffer = 0;
+	m_lightDataTexture = 0;
+	m_lightDataUnit = 0;
+	m_clusterDataBuffer = 0;
+	m_clusterDataTexture = 0;
+	m_clusterDataUnit = 0;
+	m_lightIndexBuffer = 0;
+	m_lightIndexTexture = 0;
+	m_lightIndexUnit = 0;
+}
+
+/***********************************************************
+ *  ~LightClusters()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightClusters::~LightClusters()
+{
+	GLuint buffers[] = { m_lightDataBuffer, m_clusterDataBuffer, m_lightIndexBuffer };
+	for (GLuint buffer : buffers)
+	{
+		if (0 != buffer)
+		{
+			GpuResources::Remove(GpuResources::RESOURCE_BUFFER, buffer);
+			glDeleteBuffers(1, &buffer);
+		}
+	}
+	m_lightDataBuffer = 0;
+	m_clusterDataBuffer = 0;
+	m_lightIndexBuffer = 0;
+
+	GLuint textures[] = { m_lightDataTexture, m_clusterDataTexture, m_lightIndexTexture };
+	for (GLuint texture : textures)
+	{
+		if (0 != texture)
+		{
+			GpuResources::Remove(GpuResources::RESOURCE_TEXTURE, texture);
+			glDeleteTextures(1, &texture);
+		}
+	}
+	m_lightDataTexture = 0;
+	m_clusterDataTexture = 0;
+	m_lightIndexTexture = 0;
+}
+
+/***********************************************************
+ *  CreateBuffers()
+ *
+ *  This method is used for creating the buffers and the
+ *  buffer textures over them.  The buffer textures stay
+ *  bound to their own texture units.
+ ***********************************************************/
+void LightClusters::CreateBuffers()
+{
+	GLint maxUnits = 0;
+
+	// the units below the ones of the indirect draw data
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+	m_lightDataUnit = std::max(0, maxUnits - 4);
+	m_clusterDataUnit = std::max(0, maxUnits - 5);
+	m_lightIndexUnit = std::max(0, maxUnits - 6);
+
+	glGenBuffers(1, &m_lightDataBuffer);
+	glGenBuffers(1, &m_clusterDataBuffer);
+	glGenBuffers(1, &m_lightIndexBuffer);
+	glGenTextures(1, &m_lightDataTexture);
+	glGenTextures(1, &m_clusterDataTexture);
+	glGenTextures(1, &m_lightIndexTexture);
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_lightDataBuffer, "LightClusters");
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_clusterDataBuffer, "LightClusters");
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_lightIndexBuffer, "LightClusters");
+	GpuResources::Add(GpuResources::RESOURCE_TEXTURE, m_lightDataTexture, "LightClusters");
+	GpuResources::Add(GpuResources::RESOURCE_TEXTURE, m_clusterDataTexture, "LightClusters");
+	GpuResources::Add(GpuResources::RESOURCE_TEXTURE, m_lightIndexTexture, "LightClusters");
+
+	struct BUFFER_TEXTURE
+	{
+		GLuint texture;
+		GLuint buffer;
+		GLint unit;
+		GLenum format;
+	};
+	BUFFER_TEXTURE bufferTextures[] = {
+		{ m_lightDataTexture, m_lightDataBuffer, m_lightDataUnit, GL_RGBA32F },
+		{ m_clusterDataTexture, m_clusterDataBuffer, m_clusterDataUnit, GL_RG32UI },
+		{ m_lightIndexTexture, m_lightIndexBuffer, m_lightIndexUnit, GL_R32UI } };
+	for (const BUFFER_TEXTURE& bufferTexture : bufferTextures)
+	{
+		UploadBuffer(bufferTexture.buffer, 0, NULL);
+		glActiveTexture(GL_TEXTURE0 + bufferTexture.unit);
+		glBindTexture(GL_TEXTURE_BUFFER, bufferTexture.texture);
+		glTexBuffer(GL_TEXTURE_BUFFER, bufferTexture.format, bufferTexture.buffer);
+	}
+	glActiveTexture(GL_TEXTURE0);
+}
+
+/***********************************************************
+ *  BuildClusters()
+ *
+ *  This method is used for binning the lights into the
+ *  clusters of the passed in view.  The lights are counted
+ *  per cluster first, so that the index lists can be
+ *  written into one array without reallocating.
+ ***********************************************************/
+void LightClusters::BuildClusters(
+	const std::vector<CLUSTER_LIGHT>& lights,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	float nearPlane,
+	float farPlane)
+{
+	if (0 == m_lightDataBuffer)
+	{
+		CreateBuffers();
+	}
+
+	// the depth slices are spaced exponentially from the near plane
+	float logDepthRange = std::log(farPlane / nearPlane);
+	m_depthScale = (float)DEPTH_SLICES / logDepthRange;
+	m_depthBias = -(float)DEPTH_SLICES * std::log(nearPlane) / logDepthRange;
+
+	m_lightRanges.resize(lights.size());
+	m_clusterRanges.assign(CLUSTER_COUNT, glm::uvec2(0));
+
+	// count the lights of each cluster
+	for (size_t i = 0; i < lights.size(); ++i)
+	{
+		CLUSTER_RANGE& range = m_lightRanges[i];
+		if (false == FindClusterRange(lights[i], view, projection, nearPlane, farPlane, range))
+		{
+			// an empty range for the lights outside of the view
+			range.minSlice = 1;
+			range.maxSlice = 0;
+			continue;
+		}
+		for (int slice = range.minSlice; slice <= range.maxSlice; ++slice)
+		{
+			for (int y = range.minY; y <= range.maxY; ++y)
+			{
+				for (int x = range.minX; x <= range.maxX; ++x)
+				{
+					m_clusterRanges[(((slice * TILES_Y) + y) * TILES_X) + x].y++;
+				}
+			}
+		}
+	}
+
+	// turn the counts into the start of each list
+	GLuint indexCount = 0;
+	for (glm::uvec2& clusterRange : m_clusterRanges)
+	{
+		clusterRange.x = indexCount;
+		indexCount += clusterRange.y;
+		clusterRange.y = 0;
+	}
+
+	// write the light indices, the counts are rebuilt on the way
+	m_lightIndices.resize(indexCount);
+	for (size_t i = 0; i < lights.size(); ++i)
+	{
+		const CLUSTER_RANGE& range = m_lightRanges[i];
+		for (int slice = range.minSlice; slice <= range.maxSlice; ++slice)
+		{
+			for (int y = range.minY; y <= range.maxY; ++y)
+			{
+				for (int x = range.minX; x <= range.maxX; ++x)
+				{
+					glm::uvec2& clusterRange = m_clusterRanges[(((slice * TILES_Y) + y) * TILES_X) + x];
+					m_lightIndices[clusterRange.x + clusterRange.y] = (GLuint)i;
+					clusterRange.y++;
+				}
+			}
+		}
+	}
+
+	UploadBuffer(m_lightDataBuffer, lights.size() * sizeof(CLUSTER_LIGHT), lights.data());
+	UploadBuffer(m_clusterDataBuffer, m_clusterRanges.size() * sizeof(glm::uvec2), m_clusterRanges.data());
+	UploadBuffer(m_lightIndexBuffer, m_lightIndices.size() * sizeof(GLuint), m_lightIndices.data());
+}
+
+/***********************************************************
+ *  FindClusterRange()
+ *
+ *  This method is used for finding the clusters a light can
+ *  reach.  The view space box around the light sphere is cut
+ *  to the near and far planes and its corners are projected
+ *  to find the screen tiles, the depth range gives the
+ *  slices.  False is returned when the light is not in view.
+ ***********************************************************/
+bool LightClusters::FindClusterRange(
+	const CLUSTER_LIGHT& light,
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	float nearPlane,
+	float farPlane,
+	CLUSTER_RANGE& range) const
+{
+	// the lights without falloff reach every cluster
+	if (light.radius <= 0.0f)
+	{
+		range.minX = 0;
+		range.maxX = TILES_X - 1;
+		range.minY = 0;
+		range.maxY = TILES_Y - 1;
+		range.minSlice = 0;
+		range.maxSlice = DEPTH_SLICES - 1;
+		return(true);
+	}
+
+	// the view looks down the negative Z axis
+	glm::vec3 center = glm::vec3(view * glm::vec4(light.position, 1.0f));
+	float nearDepth = std::max(-center.z - light.radius, nearPlane);
+	float farDepth = std::min(-center.z + light.radius, farPlane);
+	if (nearDepth > farDepth)
+	{
+		return(false);
+	}
+
+	glm::vec2 ndcMin(FLT_MAX);
+	glm::vec2 ndcMax(-FLT_MAX);
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		glm::vec4 viewCorner(
+			center.x + ((corner & 1) ? light.radius : -light.radius),
+			center.y + ((corner & 2) ? light.radius : -light.radius),
+			(corner & 4) ? -farDepth : -nearDepth,
+			1.0f);
+		glm::vec4 clip = projection * viewCorner;
+		glm::vec2 ndc = glm::vec2(clip) / clip.w;
+		ndcMin = glm::min(ndcMin, ndc);
+		ndcMax = glm::max(ndcMax, ndc);
+	}
+	if ((ndcMax.x < -1.0f) || (ndcMin.x > 1.0f) ||
+		(ndcMax.y < -1.0f) || (ndcMin.y > 1.0f))
+	{
+		return(false);
+	}
+
+	range.minX = std::max(0, (int)std::floor(((ndcMin.x * 0.5f) + 0.5f) * TILES_X));
+	range.maxX = std::min(TILES_X - 1, (int)std::floor(((ndcMax.x * 0.5f) + 0.5f) * TILES_X));
+	range.minY = std::max(0, (int)std::floor(((ndcMin.y * 0.5f) + 0.5f) * TILES_Y));
+	range.maxY = std::min(TILES_Y - 1, (int)std::floor(((ndcMax.y * 0.5f) + 0.5f) * TILES_Y));
+	range.minSlice = DepthSlice(nearDepth);
+	range.maxSlice = DepthSlice(farDepth);
+
+	return(true);
+}
+
+/***********************************************************
+ *  DepthSlice()
+ *
+ *  This method is used for getting the depth slice of a
+ *  view depth, the same way as the fragment shader does.
+ ***********************************************************/
+int LightClusters::DepthSlice(float depth) const
+{
+	int slice = (int)std::floor((std::log(depth) * m_depthScale) + m_depthBias);
+
+	return(std::max(0, std::min(slice, DEPTH_SLICES - 1)));
+}
+
+/***********************************************************
+ *  UploadBuffer()
+ *
+ *  This method is used for replacing the contents of one of
+ *  the buffers.  A buffer texture over an empty buffer
+ *  cannot be read, so one texel is kept at the least.
+ ***********************************************************/
+void LightClusters::UploadBuffer(GLuint buffer, GLsizeiptr size, const void* data)
+{
+	glBindBuffer(GL_TEXTURE_BUFFER, buffer);
+	if (size > 0)
+	{
+		glBufferData(GL_TEXTURE_BUFFER, size, data, GL_STREAM_DRAW);
+		GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, buffer, (size_t)size);
+	}
+	else
+	{
+		glBufferData(GL_TEXTURE_BUFFER, sizeof(glm::vec4), NULL, GL_STREAM_DRAW);
+		GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, buffer, sizeof(glm::vec4));
+	}
+	glBindBuffer(GL_TEXTURE_BUFFER, 0);
+}
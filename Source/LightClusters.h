@@ -0,0 +1,118 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightclusters.h
+// ============
+// bin the point lights into view space clusters for clustered forward shading
+//
+//  The view frustum is split into a grid of screen tiles and exponential
+//  depth slices.  Every frame the lights are binned on the CPU into the
+//  clusters their sphere of influence touches, and the per cluster light
+//  lists are read by the fragment shader from buffer textures, so that a
+//  fragment only evaluates the lights that can reach it.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  LightClusters
+ *
+ *  This class contains the code for assigning the point
+ *  lights to the clusters of the view frustum and for
+ *  keeping the light data, the cluster ranges and the light
+ *  index lists in buffer textures for the fragment shader.
+ ***********************************************************/
+class LightClusters
+{
+public:
+	// constructor
+	LightClusters();
+	// destructor
+	~LightClusters();
+
+	// size of the cluster grid, same layout as the fragment shader
+	static const int TILES_X = 16;
+	static const int TILES_Y = 9;
+	static const int DEPTH_SLICES = 24;
+	static const int CLUSTER_COUNT = TILES_X * TILES_Y * DEPTH_SLICES;
+
+	// values of one light as read by the fragment shader, four RGBA32F
+	// texels of the light data buffer texture.  A radius of zero is a
+	// light without falloff that is added to every cluster.
+	struct CLUSTER_LIGHT
+	{
+		glm::vec3 position; float radius;
+		glm::vec3 ambient; float pad0;
+		glm::vec3 diffuse; float pad1;
+		glm::vec3 specular; float pad2;
+	};
+
+	// bin the lights into the clusters of the passed in view and
+	// upload the results for the next draws
+	void BuildClusters(
+		const std::vector<CLUSTER_LIGHT>& lights,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		float nearPlane,
+		float farPlane);
+
+	// get the values that turn a view depth into a depth slice, the
+	// slice is log(depth) * scale + bias
+	float GetDepthScale() const { return m_depthScale; }
+	float GetDepthBias() const { return m_depthBias; }
+	// get the number of light indices written by the last binning
+	int GetIndexCount() const { return (int)m_lightIndices.size(); }
+
+	// get the texture units the buffer textures stay bound to
+	GLint GetLightDataUnit() const { return m_lightDataUnit; }
+	GLint GetClusterDataUnit() const { return m_clusterDataUnit; }
+	GLint GetLightIndexUnit() const { return m_lightIndexUnit; }
+
+private:
+	// range of the clusters touched by one light
+	struct CLUSTER_RANGE
+	{
+		int minX, maxX;
+		int minY, maxY;
+		int minSlice, maxSlice;
+	};
+
+	float m_depthScale;
+	float m_depthBias;
+
+	// start and count of the light indices of each cluster
+	std::vector<glm::uvec2> m_clusterRanges;
+	// light indices of all the clusters, one list after the other
+	std::vector<GLuint> m_lightIndices;
+	// clusters touched by each light of the current binning
+	std::vector<CLUSTER_RANGE> m_lightRanges;
+
+	// buffers and the buffer textures reading them
+	GLuint m_lightDataBuffer;
+	GLuint m_lightDataTexture;
+	GLint m_lightDataUnit;
+	GLuint m_clusterDataBuffer;
+	GLuint m_clusterDataTexture;
+	GLint m_clusterDataUnit;
+	GLuint m_lightIndexBuffer;
+	GLuint m_lightIndexTexture;
+	GLint m_lightIndexUnit;
+
+	// create the buffers and the buffer textures on the first use
+	void CreateBuffers();
+	// find the clusters a light sphere touches, false if none
+	bool FindClusterRange(
+		const CLUSTER_LIGHT& light,
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		float nearPlane,
+		float farPlane,
+		CLUSTER_RANGE& range) const;
+	// get the depth slice of a view depth
+	int DepthSlice(float depth) const;
+	// replace the contents of a buffer texture, it is never left empty
+	static void UploadBuffer(GLuint buffer, GLsizeiptr size, const void* data);
+};
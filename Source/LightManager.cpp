@@ -0,0 +1,514 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmanager.cpp
+// ============
+// own the scene lights and upload them to the shader when they change
+///////////////////////////////////////////////////////////////////////////////
+
+#include "LightManager.h"
+#include "GpuResources.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	constexpr UniformID g_LightBlockName("LightBlock");
+	constexpr UniformID g_UseLightClustersName("bUseLightClusters");
+	constexpr UniformID g_PointLightDataName("pointLightData");
+	constexpr UniformID g_LightClusterDataName("lightClusterData");
+	constexpr UniformID g_LightIndexDataName("lightIndexData");
+	constexpr UniformID g_ClusterTileScaleName("clusterTileScale");
+	constexpr UniformID g_ClusterGridName("clusterGrid");
+	constexpr UniformID g_ClusterDepthName("clusterDepthParams");
+
+	// falloff distance of the scattered point lights
+	const float SCATTERED_LIGHT_RADIUS = 3.0f;
+	// angles of the full and the faded part of the flashlight cone
+	const float FLASHLIGHT_INNER_ANGLE = 12.5f;
+	const float FLASHLIGHT_OUTER_ANGLE = 17.5f;
+}
+
+/***********************************************************
+ *  LightManager()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+LightManager::LightManager(UniformCache* pUniformCache)
+{
+	m_pUniformCache = pUniformCache;
+	m_dirLightOn = true;
+	m_dirIntensity = 1.0f;
+	m_dirLightDir = glm::vec3(-0.2f, -1.0f, -0.3f);
+	m_ambientBoost = 0.0f;
+	m_flashlightOn = false;
+	m_spotIntensity = 1.0f;
+	m_spotPosition = glm::vec3(0.0f);
+	m_spotDirection = glm::vec3(0.0f, 0.0f, -1.0f);
+	m_bLightsDirty = true;
+	m_uploadCount = 0;
+	m_lightBuffer = 0;
+	m_pLightClusters = NULL;
+	m_clusterView = glm::mat4(1.0f);
+	m_clusterProjection = glm::mat4(1.0f);
+	m_clusterWidth = 0;
+	m_clusterHeight = 0;
+	m_uploadedClustering = -1;
+	m_useLightClustersLocation = -1;
+	m_clusterTileScaleLocation = -1;
+	m_clusterGridLocation = -1;
+	m_clusterDepthLocation = -1;
+}
+
+/***********************************************************
+ *  ~LightManager()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+LightManager::~LightManager()
+{
+	if (0 != m_lightBuffer)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_lightBuffer);
+		glDeleteBuffers(1, &m_lightBuffer);
+		m_lightBuffer = 0;
+	}
+	if (NULL != m_pLightClusters)
+	{
+		delete m_pLightClusters;
+		m_pLightClusters = NULL;
+	}
+	m_pUniformCache = NULL;
+}
+
+/***********************************************************
+ *  SetDirectionalLight()
+ *
+ *  This method is used for setting the direction and the
+ *  strength of the directional light.
+ ***********************************************************/
+void LightManager::SetDirectionalLight(const glm::vec3& direction, float intensity)
+{
+	if ((direction != m_dirLightDir) || (intensity != m_dirIntensity))
+	{
+		m_dirLightDir = direction;
+		m_dirIntensity = intensity;
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetDirectionalLightActive()
+ *
+ *  This method is used for turning the directional light on
+ *  or off.
+ ***********************************************************/
+void LightManager::SetDirectionalLightActive(bool bActive)
+{
+	if (bActive != m_dirLightOn)
+	{
+		m_dirLightOn = bActive;
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetAmbientBoost()
+ *
+ *  This method is used for setting the strength added to
+ *  the ambient light of the directional light.
+ ***********************************************************/
+void LightManager::SetAmbientBoost(float ambientBoost)
+{
+	if (ambientBoost != m_ambientBoost)
+	{
+		m_ambientBoost = ambientBoost;
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  AddPointLight()
+ *
+ *  This method is used for adding a point light to the light
+ *  list.  The index of the new light is returned.
+ ***********************************************************/
+int LightManager::AddPointLight(const glm::vec3& position, const glm::vec3& color, float intensity, float radius)
+{
+	POINT_LIGHT light;
+	light.position = position;
+	light.color = color;
+	light.intensity = intensity;
+	light.radius = radius;
+	light.bActive = true;
+	m_pointLights.push_back(light);
+	m_bLightsDirty = true;
+
+	return((int)m_pointLights.size() - 1);
+}
+
+/***********************************************************
+ *  AddScatteredPointLights()
+ *
+ *  This method is used for spreading colored point lights
+ *  evenly over a round area of the floor, along a golden
+ *  angle spiral so the layout is the same on every run.
+ ***********************************************************/
+void LightManager::AddScatteredPointLights(int lightCount, float areaRadius)
+{
+	const float goldenAngle = 2.39996323f;
+	const float twoPi = 6.2831853f;
+
+	for (int i = 0; i < lightCount; ++i)
+	{
+		float distance = areaRadius * sqrtf(((float)i + 0.5f) / (float)lightCount);
+		float angle = goldenAngle * (float)i;
+		glm::vec3 position(distance * cosf(angle), 1.0f, distance * sinf(angle));
+
+		// the hues go around the color wheel with the spiral
+		float hue = angle / twoPi;
+		glm::vec3 color(
+			0.5f + (0.5f * cosf(twoPi * hue)),
+			0.5f + (0.5f * cosf(twoPi * (hue - 0.3333333f))),
+			0.5f + (0.5f * cosf(twoPi * (hue - 0.6666667f))));
+
+		AddPointLight(position, color, 2.0f, SCATTERED_LIGHT_RADIUS);
+	}
+}
+
+/***********************************************************
+ *  ClearPointLights()
+ *
+ *  This method is used for removing every point light.
+ ***********************************************************/
+void LightManager::ClearPointLights()
+{
+	if (false == m_pointLights.empty())
+	{
+		m_pointLights.clear();
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetPointLightPosition()
+ *
+ *  This method is used for moving one of the point lights.
+ ***********************************************************/
+void LightManager::SetPointLightPosition(int index, const glm::vec3& position)
+{
+	if (IsPointLight(index) && (position != m_pointLights[index].position))
+	{
+		m_pointLights[index].position = position;
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetPointLightIntensity()
+ *
+ *  This method is used for setting the strength of one of
+ *  the point lights.
+ ***********************************************************/
+void LightManager::SetPointLightIntensity(int index, float intensity)
+{
+	if (IsPointLight(index) && (intensity != m_pointLights[index].intensity))
+	{
+		m_pointLights[index].intensity = intensity;
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetPointLightActive()
+ *
+ *  This method is used for turning one of the point lights
+ *  on or off.
+ ***********************************************************/
+void LightManager::SetPointLightActive(int index, bool bActive)
+{
+	if (IsPointLight(index) && (bActive != m_pointLights[index].bActive))
+	{
+		m_pointLights[index].bActive = bActive;
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetFlashlightActive()
+ *
+ *  This method is used for turning the flashlight on or off.
+ ***********************************************************/
+void LightManager::SetFlashlightActive(bool bActive)
+{
+	if (bActive != m_flashlightOn)
+	{
+		m_flashlightOn = bActive;
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetFlashlightIntensity()
+ *
+ *  This method is used for setting the strength of the
+ *  flashlight.
+ ***********************************************************/
+void LightManager::SetFlashlightIntensity(float intensity)
+{
+	if (intensity != m_spotIntensity)
+	{
+		m_spotIntensity = intensity;
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  SetFlashlightPose()
+ *
+ *  This method is used for placing the flashlight at the
+ *  camera.  The pose of a flashlight that is off is kept
+ *  without an upload, it is sent once the light is on.
+ ***********************************************************/
+void LightManager::SetFlashlightPose(const glm::vec3& position, const glm::vec3& direction)
+{
+	if ((position == m_spotPosition) && (direction == m_spotDirection))
+	{
+		return;
+	}
+
+	m_spotPosition = position;
+	m_spotDirection = direction;
+	if (m_flashlightOn)
+	{
+		m_bLightsDirty = true;
+	}
+}
+
+/***********************************************************
+ *  GetFlashlightConeAngle()
+ *
+ *  This method is used for getting the angle of the edge of
+ *  the flashlight cone, which its shadow map has to cover.
+ ***********************************************************/
+float LightManager::GetFlashlightConeAngle() const
+{
+	return(FLASHLIGHT_OUTER_ANGLE);
+}
+
+/***********************************************************
+ *  UploadLights()
+ *
+ *  This method is used for sending the lights to the shader.
+ *  The light block is only written after a setting changed,
+ *  and the light clusters are only binned again when the
+ *  lights, the view or the framebuffer size changed.
+ ***********************************************************/
+void LightManager::UploadLights(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	float nearPlane,
+	float farPlane,
+	int framebufferWidth,
+	int framebufferHeight)
+{
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	// the locations are looked up on the first upload, and again
+	// after the program was replaced, along with the one time
+	// settings of the program
+	if (m_uploadedClustering < 0)
+	{
+		m_useLightClustersLocation = m_pUniformCache->GetLocation(g_UseLightClustersName);
+		m_clusterTileScaleLocation = m_pUniformCache->GetLocation(g_ClusterTileScaleName);
+		m_clusterGridLocation = m_pUniformCache->GetLocation(g_ClusterGridName);
+		m_clusterDepthLocation = m_pUniformCache->GetLocation(g_ClusterDepthName);
+
+		if (0 != m_lightBuffer)
+		{
+			m_pUniformCache->BindUniformBlock(g_LightBlockName, UniformCache::LIGHT_BLOCK_BINDING);
+		}
+		if (NULL != m_pLightClusters)
+		{
+			BindClusterSamplers();
+		}
+	}
+
+	int bClustering = IsLightClustering() ? 1 : 0;
+	if (bClustering != m_uploadedClustering)
+	{
+		m_pUniformCache->SetInt(m_useLightClustersLocation, bClustering);
+		m_uploadedClustering = bClustering;
+		m_bLightsDirty = true;
+	}
+
+	if (bClustering && (m_bLightsDirty ||
+		(view != m_clusterView) ||
+		(projection != m_clusterProjection) ||
+		(framebufferWidth != m_clusterWidth) ||
+		(framebufferHeight != m_clusterHeight)))
+	{
+		UploadLightClusters(view, projection, nearPlane, farPlane, framebufferWidth, framebufferHeight);
+	}
+
+	if (m_bLightsDirty)
+	{
+		UploadLightBlock();
+		m_bLightsDirty = false;
+	}
+}
+
+/***********************************************************
+ *  ReloadLocations()
+ *
+ *  This method is used for forgetting the uniform locations
+ *  and the uploaded cluster mode.  The next upload looks
+ *  them up in the new program and sends all of the lights.
+ ***********************************************************/
+void LightManager::ReloadLocations()
+{
+	m_uploadedClustering = -1;
+	m_bLightsDirty = true;
+}
+
+/***********************************************************
+ *  BindClusterSamplers()
+ *
+ *  This method is used for pointing the samplers of the
+ *  light cluster buffers at their texture units, and for
+ *  setting the size of the cluster grid.
+ ***********************************************************/
+void LightManager::BindClusterSamplers()
+{
+	m_pUniformCache->SetInt(m_pUniformCache->GetLocation(g_PointLightDataName), m_pLightClusters->GetLightDataUnit());
+	m_pUniformCache->SetInt(m_pUniformCache->GetLocation(g_LightClusterDataName), m_pLightClusters->GetClusterDataUnit());
+	m_pUniformCache->SetInt(m_pUniformCache->GetLocation(g_LightIndexDataName), m_pLightClusters->GetLightIndexUnit());
+	m_pUniformCache->SetVec3(m_clusterGridLocation, glm::vec3(
+		(float)LightClusters::TILES_X,
+		(float)LightClusters::TILES_Y,
+		(float)LightClusters::DEPTH_SLICES));
+}
+
+/***********************************************************
+ *  UploadLightBlock()
+ *
+ *  This method is used for writing all of the lights into
+ *  the LightBlock uniform buffer with one upload.
+ ***********************************************************/
+void LightManager::UploadLightBlock()
+{
+	LIGHT_BLOCK lights = {};
+	float ambient = 0.1f + m_ambientBoost;
+
+	// the uniform buffer is created on the first upload
+	if (0 == m_lightBuffer)
+	{
+		glGenBuffers(1, &m_lightBuffer);
+		GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_lightBuffer, "LightManager", sizeof(LIGHT_BLOCK));
+		glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(LIGHT_BLOCK), NULL, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, UniformCache::LIGHT_BLOCK_BINDING, m_lightBuffer);
+		m_pUniformCache->BindUniformBlock(g_LightBlockName, UniformCache::LIGHT_BLOCK_BINDING);
+	}
+
+	// directional light
+	lights.directionalLight.direction = glm::normalize(m_dirLightDir);
+	lights.directionalLight.ambient = glm::vec3(ambient);
+	lights.directionalLight.diffuse = glm::vec3(0.6f * m_dirIntensity);
+	lights.directionalLight.specular = glm::vec3(0.4f * m_dirIntensity);
+	lights.directionalLight.bActive = m_dirLightOn;
+
+	// point lights - a short light list is evaluated from the light
+	// block, and the ones that are not driven stay inactive
+	if (false == IsLightClustering())
+	{
+		for (size_t i = 0; i < m_pointLights.size(); ++i)
+		{
+			const POINT_LIGHT& light = m_pointLights[i];
+			lights.pointLights[i].position = light.position;
+			lights.pointLights[i].ambient = 0.05f * light.intensity * light.color;
+			lights.pointLights[i].diffuse = 0.5f * light.intensity * light.color;
+			lights.pointLights[i].specular = 0.3f * light.intensity * light.color;
+			lights.pointLights[i].bActive = light.bActive;
+		}
+	}
+
+	// spot light used as a flashlight from the camera
+	lights.spotLight.position = m_spotPosition;
+	lights.spotLight.direction = glm::normalize(m_spotDirection);
+	lights.spotLight.cutOff = cosf(glm::radians(FLASHLIGHT_INNER_ANGLE));
+	lights.spotLight.outerCutOff = cosf(glm::radians(FLASHLIGHT_OUTER_ANGLE));
+	lights.spotLight.constant = 1.0f;
+	lights.spotLight.linear = 0.09f;
+	lights.spotLight.quadratic = 0.032f;
+	lights.spotLight.diffuse = glm::vec3(m_spotIntensity);
+	lights.spotLight.specular = glm::vec3(m_spotIntensity);
+	lights.spotLight.bActive = m_flashlightOn;
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_lightBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LIGHT_BLOCK), &lights);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	m_uploadCount++;
+}
+
+/***********************************************************
+ *  UploadLightClusters()
+ *
+ *  This method is used for binning the active point lights
+ *  into the clusters of the passed in view.  The fragment
+ *  shader then only loops over the lights of its cluster.
+ ***********************************************************/
+void LightManager::UploadLightClusters(
+	const glm::mat4& view,
+	const glm::mat4& projection,
+	float nearPlane,
+	float farPlane,
+	int framebufferWidth,
+	int framebufferHeight)
+{
+	bool bCreated = (NULL == m_pLightClusters);
+	if (bCreated)
+	{
+		m_pLightClusters = new LightClusters();
+	}
+
+	m_clusterLights.clear();
+	for (const POINT_LIGHT& light : m_pointLights)
+	{
+		if (false == light.bActive)
+		{
+			continue;
+		}
+		LightClusters::CLUSTER_LIGHT clusterLight = {};
+		clusterLight.position = light.position;
+		clusterLight.radius = light.radius;
+		clusterLight.ambient = 0.05f * light.intensity * light.color;
+		clusterLight.diffuse = 0.5f * light.intensity * light.color;
+		clusterLight.specular = 0.3f * light.intensity * light.color;
+		m_clusterLights.push_back(clusterLight);
+	}
+	m_pLightClusters->BuildClusters(m_clusterLights, view, projection, nearPlane, farPlane);
+
+	// the buffer textures keep their units, so the samplers are
+	// only pointed at them once
+	if (bCreated)
+	{
+		BindClusterSamplers();
+	}
+
+	// the tiles follow the size of the framebuffer
+	m_pUniformCache->SetVec2(m_clusterTileScaleLocation, glm::vec2(
+		(float)LightClusters::TILES_X / (float)std::max(framebufferWidth, 1),
+		(float)LightClusters::TILES_Y / (float)std::max(framebufferHeight, 1)));
+	m_pUniformCache->SetVec2(m_clusterDepthLocation, glm::vec2(
+		m_pLightClusters->GetDepthScale(),
+		m_pLightClusters->GetDepthBias()));
+
+	m_clusterView = view;
+	m_clusterProjection = projection;
+	m_clusterWidth = framebufferWidth;
+	m_clusterHeight = framebufferHeight;
+}
@@ -0,0 +1,196 @@
+///////////////////////////////////////////////////////////////////////////////
+// lightmanager.h
+// ============
+// own the scene lights and upload them to the shader when they change
+//
+//  The directional light, the point light list and the flashlight are kept
+//  here and written into the LightBlock uniform buffer, or into the light
+//  clusters for a long point light list.  Every setter marks the lights as
+//  changed, and nothing is sent to OpenGL for a frame without a change.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformCache.h"
+#include "LightClusters.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  LightManager
+ *
+ *  This class contains the code for keeping the settings of
+ *  all the scene lights and for uploading them to the shader
+ *  light block and light clusters only when a setting, or
+ *  the view the clusters were binned for, has changed.
+ ***********************************************************/
+class LightManager
+{
+public:
+	// constructor
+	LightManager(UniformCache* pUniformCache);
+	// destructor
+	~LightManager();
+
+	// number of point lights evaluated from the light block, the
+	// shader program is specialized for this many lights and a
+	// longer light list is shaded through the light clusters
+	static const int NUM_POINT_LIGHTS = 4;
+	// number of point lights declared in the fragment shader
+	static const int TOTAL_POINT_LIGHTS = 5;
+
+	// one point light of the light list, a radius of zero is a
+	// light without falloff that reaches the whole scene
+	struct POINT_LIGHT
+	{
+		glm::vec3 position;
+		glm::vec3 color;
+		float intensity;
+		float radius;
+		bool bActive;
+	};
+
+	// directional light settings
+	void SetDirectionalLight(const glm::vec3& direction, float intensity);
+	void SetDirectionalLightActive(bool bActive);
+	bool IsDirectionalLightActive() const { return m_dirLightOn; }
+	const glm::vec3& GetDirectionalLightDirection() const { return m_dirLightDir; }
+	// strength added to the ambient light of the directional light
+	void SetAmbientBoost(float ambientBoost);
+	float GetAmbientBoost() const { return m_ambientBoost; }
+
+	// add a point light to the light list, a radius of zero has no falloff
+	int AddPointLight(const glm::vec3& position, const glm::vec3& color, float intensity, float radius);
+	// spread a number of colored point lights over a round area of the floor
+	void AddScatteredPointLights(int lightCount, float areaRadius);
+	// remove every point light from the light list
+	void ClearPointLights();
+	// change one of the point lights of the light list
+	void SetPointLightPosition(int index, const glm::vec3& position);
+	void SetPointLightIntensity(int index, float intensity);
+	void SetPointLightActive(int index, bool bActive);
+	// get one point light of the light list
+	const POINT_LIGHT& GetPointLight(int index) const { return m_pointLights[index]; }
+	// get the number of point lights in the light list
+	int GetPointLightCount() const { return (int)m_pointLights.size(); }
+	// check if the point lights are shaded through the light clusters
+	bool IsLightClustering() const { return (int)m_pointLights.size() > NUM_POINT_LIGHTS; }
+
+	// flashlight settings, the flashlight follows the camera
+	void SetFlashlightActive(bool bActive);
+	bool IsFlashlightActive() const { return m_flashlightOn; }
+	void SetFlashlightIntensity(float intensity);
+	void SetFlashlightPose(const glm::vec3& position, const glm::vec3& direction);
+	const glm::vec3& GetFlashlightPosition() const { return m_spotPosition; }
+	const glm::vec3& GetFlashlightDirection() const { return m_spotDirection; }
+	// get the angle between the flashlight direction and the edge
+	// of its light cone, in degrees
+	float GetFlashlightConeAngle() const;
+
+	// send the changed lights to the shader, the light clusters are
+	// binned again when the lights or the view have changed
+	void UploadLights(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		float nearPlane,
+		float farPlane,
+		int framebufferWidth,
+		int framebufferHeight);
+	// get the number of light block uploads since the start
+	int GetUploadCount() const { return m_uploadCount; }
+	// check if a setting changed since the last upload
+	bool IsDirty() const { return m_bLightsDirty; }
+	// look up the uniform locations again and send every light on
+	// the next upload, after the shader program was replaced
+	void ReloadLocations();
+
+private:
+	// pointer to the cached shader uniform locations
+	UniformCache* m_pUniformCache;
+
+	// std140 layout of the light structs in the shader LightBlock,
+	// the bool members take four bytes in a uniform block
+	struct DIRECTIONAL_LIGHT_BLOCK
+	{
+		glm::vec3 direction; float pad0;
+		glm::vec3 ambient; float pad1;
+		glm::vec3 diffuse; float pad2;
+		glm::vec3 specular; GLint bActive;
+	};
+	struct POINT_LIGHT_BLOCK
+	{
+		glm::vec3 position; float pad0;
+		glm::vec3 ambient; float pad1;
+		glm::vec3 diffuse; float pad2;
+		glm::vec3 specular; GLint bActive;
+	};
+	struct SPOT_LIGHT_BLOCK
+	{
+		glm::vec3 position; float pad0;
+		glm::vec3 direction; float cutOff;
+		float outerCutOff; float constant; float linear; float quadratic;
+		glm::vec3 ambient; float pad1;
+		glm::vec3 diffuse; float pad2;
+		glm::vec3 specular; GLint bActive;
+	};
+	struct LIGHT_BLOCK
+	{
+		DIRECTIONAL_LIGHT_BLOCK directionalLight;
+		POINT_LIGHT_BLOCK pointLights[TOTAL_POINT_LIGHTS];
+		SPOT_LIGHT_BLOCK spotLight;
+	};
+
+	// light settings
+	bool m_dirLightOn;
+	float m_dirIntensity;
+	glm::vec3 m_dirLightDir;
+	float m_ambientBoost;
+	std::vector<POINT_LIGHT> m_pointLights;
+	bool m_flashlightOn;
+	float m_spotIntensity;
+	glm::vec3 m_spotPosition;
+	glm::vec3 m_spotDirection;
+
+	// set when a setting changed since the last upload
+	bool m_bLightsDirty;
+	int m_uploadCount;
+
+	// uniform buffer holding the LightBlock contents
+	GLuint m_lightBuffer;
+
+	// point lights binned into view clusters, created when the
+	// light list first grows past the light block
+	LightClusters* m_pLightClusters;
+	std::vector<LightClusters::CLUSTER_LIGHT> m_clusterLights;
+	// view and framebuffer size that the clusters were binned for
+	glm::mat4 m_clusterView;
+	glm::mat4 m_clusterProjection;
+	int m_clusterWidth;
+	int m_clusterHeight;
+	// cluster mode last set in the shader, -1 before the first upload
+	int m_uploadedClustering;
+
+	// cached uniform locations of the cluster settings
+	GLint m_useLightClustersLocation;
+	GLint m_clusterTileScaleLocation;
+	GLint m_clusterGridLocation;
+	GLint m_clusterDepthLocation;
+
+	// write the settings into the light block uniform buffer
+	void UploadLightBlock();
+	// point the cluster samplers at the units of their buffers
+	void BindClusterSamplers();
+	// bin the point lights into the clusters of the passed in view
+	void UploadLightClusters(
+		const glm::mat4& view,
+		const glm::mat4& projection,
+		float nearPlane,
+		float farPlane,
+		int framebufferWidth,
+		int framebufferHeight);
+	// check if a point light index is in the light list
+	bool IsPointLight(int index) const { return (index >= 0) && (index < (int)m_pointLights.size()); }
+};
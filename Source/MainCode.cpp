@@ -9,6 +9,11 @@
 
 #include <iostream>         // error handling and output
 #include <cstdlib>          // EXIT_FAILURE
+#include <algorithm>        // std::max
+#include <chrono>           // startup timing
+#include <thread>           // frame rate cap
+#include <cstring>          // command line parsing
+#include <string>
 
 #include <GL/glew.h>        // GLEW library
 #include "GLFW/glfw3.h"     // GLFW library
@@ -22,6 +27,13 @@
 #include "ViewManager.h"
 #include "ShapeMeshes.h"
 #include "ShaderManager.h"
+#include "ShaderVariants.h"
+#include "UniformCache.h"
+#include "FrameProfiler.h"
+#include "CameraPath.h"
+#include "BenchmarkReport.h"
+#include "FileWatcher.h"
+#include "GpuResources.h"
 
 //This is the mouse function 
 
@@ -49,6 +61,15 @@ void Mouse_Position_Callback(GLFWwindow* window, double xpos, double ypos)
 
 	camera.ProcessMouseMovement(xoffset, yoffset);
 }
+
+// set when the window needs to be drawn again without a change in
+// the scene, after it was uncovered or resized
+bool g_bRedrawRequested = true;
+
+void Window_Refresh_Callback(GLFWwindow* window)
+{
+	g_bRedrawRequested = true;
+}
 // Namespace for declaring global variables
 namespace
 {
@@ -62,14 +83,74 @@ namespace
 	SceneManager* g_SceneManager = nullptr;
 	// shader manager object for dynamic interaction with the shader code
 	ShaderManager* g_ShaderManager = nullptr;
+	// shader programs specialized for the number of lights
+	ShaderVariants* g_ShaderVariants = nullptr;
+	// cached shader uniform locations shared by the managers
+	UniformCache* g_UniformCache = nullptr;
+	// frame profiler for the CPU and GPU timing of the frame
+	FrameProfiler* g_Profiler = nullptr;
+	// watches the shader, texture and scene files for changes
+	FileWatcher* g_FileWatcher = nullptr;
+
+	// file the profiler statistics are written to with F2
+	const char* const PROFILE_FILENAME = "profile.csv";
 	// view manager object for managing the 3D view setup and projection to 2D
 	ViewManager* g_ViewManager = nullptr;
+
+	// number of frames to benchmark, 0 runs the interactive scene
+	int g_BenchFrames = 0;
+	// camera path file replayed by the benchmark, empty for the default orbit
+	std::string g_CameraPathFile;
+	// file the benchmark summary is written to
+	std::string g_BenchJsonFile = "benchmark.json";
+	// number of draw items the stress scene is filled up to, 0 for the desk only
+	int g_StressObjects = 0;
+	// draw the static scene with multi draw indirect when it is supported
+	bool g_bIndirectDrawing = true;
+	// pick the level of detail of the objects by their size on the screen
+	bool g_bLodSelection = true;
+	// colored point lights added to the desk lights, shaded through
+	// the light clusters
+	int g_ExtraPointLights = 0;
+	// how the opaque draws avoid shading the hidden surfaces
+	SceneManager::DEPTH_MODE g_DepthMode = SceneManager::DEPTH_MODE_STATE_SORT;
+	// only draw a frame when the camera, the lights or the scene changed,
+	// and sleep until the next input event otherwise
+	bool g_bOnDemandRendering = false;
+	// longest time the on demand loop sleeps before checking the scene
+	const double ON_DEMAND_WAIT_SECONDS = 0.25;
+	// the input moves the camera and the lights in steps of this
+	// length, however long the frames take to draw
+	const double INPUT_STEP_SECONDS = 1.0 / 120.0;
+	// longest frame time the input steps catch up with, a longer
+	// stall such as a window drag is not played back afterwards
+	const double MAX_FRAME_SECONDS = 0.25;
+	// frames per second the loop is limited to, 0 draws as fast as
+	// possible and -1 waits for vsync
+	int g_FrameRateCap = -1;
+	// scene description file, the built in scene is drawn when it is
+	// empty or cannot be read
+	std::string g_SceneFile = "scenes/desk.txt";
+	// shader files of the scene program, and the ID they are watched with
+	const char* const g_VertexShaderFile = "shaders/vertexShader.glsl";
+	const char* const g_FragmentShaderFile = "shaders/fragmentShader.glsl";
+	const int WATCH_SCENE_SHADERS = 0;
+	// smallest floor area the extra point lights are spread over
+	const float POINT_LIGHT_AREA_RADIUS = 6.0f;
+	// untimed frames rendered before the benchmark starts measuring
+	const int BENCH_WARMUP_FRAMES = 30;
+	// longest time the benchmark waits for the textures to finish loading
+	const double BENCH_TEXTURE_TIMEOUT = 30.0;
 }
 
 // Function declarations - all functions that are called manually
 // need to be pre-declared at the beginning of the source code.
 bool InitializeGLFW();
 bool InitializeGLEW();
+bool ParseArguments(int argc, char* argv[]);
+void RenderFrame();
+void RunBenchmark();
+void ReloadChangedFiles();
 
 
 /***********************************************************
@@ -80,20 +161,53 @@ bool InitializeGLEW();
  ***********************************************************/
 int main(int argc, char* argv[])
 {
+	// the startup metrics are measured from the application launch
+	std::chrono::steady_clock::time_point launchTime = std::chrono::steady_clock::now();
+	bool bFirstFrame = true;
+	bool bTexturesReported = false;
+
+	// read the benchmark options from the command line
+	if (ParseArguments(argc, argv) == false)
+	{
+		return(EXIT_FAILURE);
+	}
+
 	// if GLFW fails initialization, then terminate the application
 	if (InitializeGLFW() == false)
 	{
 		return(EXIT_FAILURE);
 	}
 
+	// the benchmark renders into a hidden window
+	if (g_BenchFrames > 0)
+	{
+		glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+	}
+
 	// try to create a new shader manager object
 	g_ShaderManager = new ShaderManager();
+	// create the uniform location cache
+	g_UniformCache = new UniformCache();
 	// try to create a new view manager object
 	g_ViewManager = new ViewManager(
-		g_ShaderManager);
+		g_ShaderManager, g_UniformCache);
 
 	// try to create the main display window
 	g_Window = g_ViewManager->CreateDisplayWindow(WINDOW_TITLE);
+	if (NULL == g_Window)
+	{
+		return(EXIT_FAILURE);
+	}
+
+	// the benchmark measures the frame time without waiting for vsync,
+	// and the frame rate cap replaces it when one is given
+	if ((g_BenchFrames > 0) || (g_FrameRateCap >= 0))
+	{
+		glfwSwapInterval(0);
+	}
+
+	// the on demand loop draws again once the window was uncovered
+	glfwSetWindowRefreshCallback(g_Window, Window_Refresh_Callback);
 
 	// if GLEW fails initialization, then terminate the application
 	if (InitializeGLEW() == false)
@@ -101,45 +215,248 @@ int main(int argc, char* argv[])
 		return(EXIT_FAILURE);
 	}
 
-	// load the shader code from the external GLSL files
-	g_ShaderManager->LoadShaders(
-		"shaders/vertexShader.glsl",
-		"shaders/fragmentShader.glsl");
+	// the depth test and the clear color stay the same for every frame
+	glEnable(GL_DEPTH_TEST);
+	glClearColor(0.95f, 0.89f, 0.75f, 1.0f);
+
+	// load the shader code from the external GLSL files, built for
+	// the number of point lights the view manager drives
+	GLuint programID = 0;
+	g_ShaderVariants = new ShaderVariants();
+	if (g_ShaderVariants->LoadSources(
+		g_VertexShaderFile,
+		g_FragmentShaderFile))
+	{
+		programID = g_ShaderVariants->GetProgram(LightManager::NUM_POINT_LIGHTS);
+	}
+	if (0 != programID)
+	{
+		g_ShaderManager->m_programID = programID;
+	}
+	else
+	{
+		// the generic program evaluates every declared light
+		programID = g_ShaderManager->LoadShaders(
+			g_VertexShaderFile,
+			g_FragmentShaderFile);
+	}
 	g_ShaderManager->use();
 
+	// query the uniform locations once, after the program is linked
+	g_UniformCache->LoadLocations(programID);
+
 	// try to create a new scene manager object and prepare the 3D scene
-	g_SceneManager = new SceneManager(g_ShaderManager);
+	g_SceneManager = new SceneManager(g_ShaderManager, g_UniformCache);
+	g_SceneManager->SetStressObjectCount(g_StressObjects);
+	g_SceneManager->SetIndirectDrawing(g_bIndirectDrawing);
+	g_SceneManager->SetLodSelection(g_bLodSelection);
+	g_SceneManager->SetDepthMode(g_DepthMode);
+	if (!g_SceneFile.empty() && !g_SceneManager->LoadSceneFile(g_SceneFile))
+	{
+		std::cout << "Drawing the built in scene" << std::endl;
+	}
 	g_SceneManager->LoadSceneTextures();
 	g_SceneManager->PrepareScene();
+	g_SceneManager->SetupSceneLights(g_ViewManager->GetLightManager());
 
+	// the shaders, textures and the scene file are loaded again
+	// when they are saved while the scene is running
+	g_FileWatcher = new FileWatcher();
+	g_FileWatcher->AddFile(g_VertexShaderFile, WATCH_SCENE_SHADERS);
+	g_FileWatcher->AddFile(g_FragmentShaderFile, WATCH_SCENE_SHADERS);
+	g_SceneManager->WatchFiles(g_FileWatcher);
+
+	// the extra lights cover the stress scene when there is one
+	if (g_ExtraPointLights > 0)
+	{
+		g_ViewManager->GetLightManager()->AddScatteredPointLights(g_ExtraPointLights,
+			std::max(POINT_LIGHT_AREA_RADIUS, g_SceneManager->GetStressRadius()));
+	}
+
+	// the profiler is toggled with F1 for the overlay, F2 writes
+	// the statistics to a file and F3 times each scene section,
+	// F4 turns the frustum culling on and off, F5 switches
+	// between the multi draw indirect and the CPU draw paths,
+	// F6 turns the level of detail selection on and off and F7
+	// steps through the state sorted, front to back and depth
+	// pre-pass orderings of the opaque draws, F8 turns the on
+	// demand rendering on and off
+	g_Profiler = new FrameProfiler();
+	g_SceneManager->SetProfiler(g_Profiler);
+	bool bShowProfiler = false;
+	double lastOverlayTime = glfwGetTime();
+	int renderedFrames = 0;
+	int skippedFrames = 0;
+
+	// the benchmark replaces the interactive loop
+	if (g_BenchFrames > 0)
+	{
+		RunBenchmark();
+		glfwSetWindowShouldClose(g_Window, true);
+	}
 
+	// the input runs in fixed steps on the time that passed since
+	// the last frame, and the view is drawn between the last two steps
+	double lastLoopTime = glfwGetTime();
+	double stepAccumulator = 0.0;
+	std::chrono::steady_clock::time_point nextFrameTime = std::chrono::steady_clock::now();
 
 	// loop will keep running until the application is closed 
 	// or until an error has occurred
 	while (!glfwWindowShouldClose(g_Window))
 	{
-		// Enable z-depth
-		glEnable(GL_DEPTH_TEST);
-
-		// Clear the frame and z buffers
-		glClearColor(0.95f, 0.89f, 0.75f, 1.0f);
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		// convert from 3D object space to 2D view
-		g_ViewManager->PrepareSceneView();
-
-		// refresh the 3D scene
-		g_SceneManager->RenderScene();
-
-
-		// Flips the the back buffer with the front buffer every frame.
-		glfwSwapBuffers(g_Window);
-
-		// query the latest GLFW events
-		glfwPollEvents();
+		double loopTime = glfwGetTime();
+		stepAccumulator += std::min(loopTime - lastLoopTime, MAX_FRAME_SECONDS);
+		lastLoopTime = loopTime;
+		while (stepAccumulator >= INPUT_STEP_SECONDS)
+		{
+			g_ViewManager->StepInput((float)INPUT_STEP_SECONDS);
+			stepAccumulator -= INPUT_STEP_SECONDS;
+		}
+		g_ViewManager->UpdateView((float)(stepAccumulator / INPUT_STEP_SECONDS));
+
+		// the on demand mode only draws the frame when something has
+		// changed since the last one
+		bool bDrawFrame = true;
+		if (g_bOnDemandRendering)
+		{
+			bDrawFrame = g_bRedrawRequested ||
+				g_ViewManager->IsViewDirty() ||
+				g_SceneManager->IsRedrawNeeded();
+		}
+
+		if (bDrawFrame)
+		{
+			RenderFrame();
+			g_bRedrawRequested = false;
+			renderedFrames++;
+		}
+		else
+		{
+			skippedFrames++;
+		}
+
+		if (g_ViewManager->KeyPressedOnce(GLFW_KEY_F1))
+		{
+			bShowProfiler = !bShowProfiler;
+			if (!bShowProfiler)
+			{
+				glfwSetWindowTitle(g_Window, WINDOW_TITLE);
+			}
+		}
+		if (g_ViewManager->KeyPressedOnce(GLFW_KEY_F2))
+		{
+			g_Profiler->WriteCSV(PROFILE_FILENAME);
+		}
+		if (g_ViewManager->KeyPressedOnce(GLFW_KEY_F3))
+		{
+			g_SceneManager->SetSectionProfiling(!g_SceneManager->IsSectionProfiling());
+			g_bRedrawRequested = true;
+		}
+		if (g_ViewManager->KeyPressedOnce(GLFW_KEY_F4))
+		{
+			g_SceneManager->SetFrustumCulling(!g_SceneManager->IsFrustumCulling());
+			g_bRedrawRequested = true;
+		}
+		if (g_ViewManager->KeyPressedOnce(GLFW_KEY_F5))
+		{
+			g_SceneManager->SetIndirectDrawing(!g_SceneManager->IsIndirectDrawing());
+			g_bRedrawRequested = true;
+		}
+		if (g_ViewManager->KeyPressedOnce(GLFW_KEY_F6))
+		{
+			g_SceneManager->SetLodSelection(!g_SceneManager->IsLodSelection());
+			g_bRedrawRequested = true;
+		}
+		if (g_ViewManager->KeyPressedOnce(GLFW_KEY_F7))
+		{
+			SceneManager::DEPTH_MODE mode = (SceneManager::DEPTH_MODE)
+				((g_SceneManager->GetDepthMode() + 1) % SceneManager::DEPTH_MODE_COUNT);
+			g_SceneManager->SetDepthMode(mode);
+			std::cout << "Opaque ordering: " << SceneManager::GetDepthModeName(mode) << std::endl;
+			g_bRedrawRequested = true;
+		}
+		if (g_ViewManager->KeyPressedOnce(GLFW_KEY_F8))
+		{
+			g_bOnDemandRendering = !g_bOnDemandRendering;
+			std::cout << "On demand rendering " << (g_bOnDemandRendering ? "enabled" : "disabled") << std::endl;
+		}
+
+		ReloadChangedFiles();
+
+		// the overlay is shown in the window title, refreshed twice
+		// per second so that it stays readable
+		if (bShowProfiler && (glfwGetTime() - lastOverlayTime >= 0.5))
+		{
+			glfwSetWindowTitle(g_Window, g_Profiler->GetOverlayText().c_str());
+			lastOverlayTime = glfwGetTime();
+		}
+
+		// report how long the launch took until the first frame was
+		// shown, and until the textures replaced their placeholders
+		if (bFirstFrame || !bTexturesReported)
+		{
+			double elapsedMs = std::chrono::duration<double, std::milli>(
+				std::chrono::steady_clock::now() - launchTime).count();
+
+			if (bFirstFrame)
+			{
+				std::cout << "INFO: Time to first frame: " << elapsedMs << " ms" << std::endl;
+				bFirstFrame = false;
+			}
+			if (g_SceneManager->AreTexturesLoaded())
+			{
+				std::cout << "INFO: Time to fully textured frame: " << elapsedMs << " ms" << std::endl;
+				bTexturesReported = true;
+			}
+		}
+
+		// the capped loop sleeps off the rest of the frame before the
+		// events are read, so the next input step sees the newest keys
+		if ((g_FrameRateCap > 0) && bDrawFrame)
+		{
+			std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+			nextFrameTime += std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+				std::chrono::duration<double>(1.0 / g_FrameRateCap));
+			if (nextFrameTime < now)
+			{
+				nextFrameTime = now;
+			}
+			std::this_thread::sleep_until(nextFrameTime);
+		}
+
+		// query the latest GLFW events, after a frame without any
+		// change the on demand mode sleeps until the next event, and
+		// the time it slept is not stepped through afterwards
+		if (g_bOnDemandRendering && (false == bDrawFrame))
+		{
+			glfwWaitEventsTimeout(ON_DEMAND_WAIT_SECONDS);
+			lastLoopTime = glfwGetTime();
+			nextFrameTime = std::chrono::steady_clock::now();
+		}
+		else
+		{
+			glfwPollEvents();
+		}
 	}
 
+	// report how many of the loop passes had to draw a frame
+	std::cout << "INFO: Frames rendered: " << renderedFrames
+		<< ", frames skipped: " << skippedFrames << std::endl;
+
 	// clear the allocated manager objects from memory
+	if (NULL != g_FileWatcher)
+	{
+		delete g_FileWatcher;
+		g_FileWatcher = NULL;
+	}
+	if (NULL != g_Profiler)
+	{
+		g_SceneManager->SetProfiler(NULL);
+		delete g_Profiler;
+		g_Profiler = NULL;
+	}
 	if (NULL != g_SceneManager)
 	{
 		delete g_SceneManager;
@@ -150,16 +467,331 @@ int main(int argc, char* argv[])
 		delete g_ViewManager;
 		g_ViewManager = NULL;
 	}
+	if (NULL != g_UniformCache)
+	{
+		delete g_UniformCache;
+		g_UniformCache = NULL;
+	}
 	if (NULL != g_ShaderManager)
 	{
 		delete g_ShaderManager;
 		g_ShaderManager = NULL;
 	}
+	if (NULL != g_ShaderVariants)
+	{
+		delete g_ShaderVariants;
+		g_ShaderVariants = NULL;
+	}
+
+	// every recorded OpenGL object should be deleted by its owner now
+	GpuResources::ReportLeaks();
 
 	// Terminates the program successfully
 	exit(EXIT_SUCCESS); 
 }
 
+/***********************************************************
+ *	ReloadChangedFiles()
+ *
+ *  This function is used to load the watched files again
+ *  after they were saved.  The programs are rebuilt on this
+ *  thread between two frames, and a file that does not
+ *  compile or load keeps the last working version in use.
+ ***********************************************************/
+void ReloadChangedFiles()
+{
+	std::vector<int> changedIDs;
+
+	if (0 == g_FileWatcher->Poll(changedIDs))
+	{
+		return;
+	}
+
+	// a file watched under one ID several times is reloaded once
+	std::sort(changedIDs.begin(), changedIDs.end());
+	changedIDs.erase(std::unique(changedIDs.begin(), changedIDs.end()), changedIDs.end());
+
+	for (int id : changedIDs)
+	{
+		bool bReloaded = false;
+
+		if (WATCH_SCENE_SHADERS == id)
+		{
+			GLuint programID = 0;
+			if (g_ShaderVariants->ReloadSources())
+			{
+				programID = g_ShaderVariants->GetProgram(LightManager::NUM_POINT_LIGHTS);
+			}
+			if (0 != programID)
+			{
+				g_ShaderManager->m_programID = programID;
+				g_ShaderManager->use();
+				g_UniformCache->LoadLocations(programID);
+				g_SceneManager->ReloadUniformLocations();
+				g_ViewManager->ReloadUniformLocations();
+				bReloaded = true;
+			}
+		}
+		else
+		{
+			bReloaded = g_SceneManager->ReloadFile(id);
+		}
+
+		std::cout << "INFO: Reload of watched file " << id
+			<< (bReloaded ? " done" : " failed, keeping the last version") << std::endl;
+	}
+	g_bRedrawRequested = true;
+}
+
+/***********************************************************
+ *	ParseArguments()
+ *
+ *  This function is used to read the benchmark options from
+ *  the command line:
+ *    --bench=N             render N frames and report the times
+ *    --camera-path=file    camera path replayed by the benchmark
+ *    --bench-json=file     file the benchmark summary is written to
+ *    --stress=N            tile the scene composites up to N objects
+ *    --no-indirect         draw the whole scene from the CPU
+ *    --no-lod              draw every object at the finest level of detail
+ *    --point-lights=N      add N colored point lights to the scene
+ *    --depth-mode=name     order the opaque draws by state_sort,
+ *                          front_to_back or prepass
+ *    --on-demand           only draw a frame when something changed
+ *    --fps=N               limit the frame rate to N without vsync,
+ *                          0 draws as fast as possible
+ *    --scene=file          scene description file, empty for the
+ *                          built in scene
+ ***********************************************************/
+bool ParseArguments(int argc, char* argv[])
+{
+	for (int i = 1; i < argc; i++)
+	{
+		const char* argument = argv[i];
+
+		if (0 == std::strncmp(argument, "--bench=", 8))
+		{
+			g_BenchFrames = std::atoi(argument + 8);
+			if (g_BenchFrames <= 0)
+			{
+				std::cerr << "The benchmark needs a frame count above zero: " << argument << std::endl;
+				return(false);
+			}
+		}
+		else if (0 == std::strncmp(argument, "--camera-path=", 14))
+		{
+			g_CameraPathFile = argument + 14;
+		}
+		else if (0 == std::strncmp(argument, "--bench-json=", 13))
+		{
+			g_BenchJsonFile = argument + 13;
+		}
+		else if (0 == std::strncmp(argument, "--stress=", 9))
+		{
+			g_StressObjects = std::atoi(argument + 9);
+		}
+		else if (0 == std::strcmp(argument, "--no-indirect"))
+		{
+			g_bIndirectDrawing = false;
+		}
+		else if (0 == std::strcmp(argument, "--no-lod"))
+		{
+			g_bLodSelection = false;
+		}
+		else if (0 == std::strncmp(argument, "--point-lights=", 15))
+		{
+			g_ExtraPointLights = std::max(0, std::atoi(argument + 15));
+		}
+		else if (0 == std::strncmp(argument, "--scene=", 8))
+		{
+			g_SceneFile = argument + 8;
+		}
+		else if (0 == std::strcmp(argument, "--on-demand"))
+		{
+			g_bOnDemandRendering = true;
+		}
+		else if (0 == std::strncmp(argument, "--fps=", 6))
+		{
+			g_FrameRateCap = std::max(0, std::atoi(argument + 6));
+		}
+		else if (0 == std::strncmp(argument, "--depth-mode=", 13))
+		{
+			bool bFound = false;
+			for (int mode = 0; mode < SceneManager::DEPTH_MODE_COUNT; mode++)
+			{
+				if (0 == std::strcmp(argument + 13, SceneManager::GetDepthModeName((SceneManager::DEPTH_MODE)mode)))
+				{
+					g_DepthMode = (SceneManager::DEPTH_MODE)mode;
+					bFound = true;
+				}
+			}
+			if (false == bFound)
+			{
+				std::cerr << "Unknown depth mode: " << argument << std::endl;
+				return(false);
+			}
+		}
+		else
+		{
+			std::cerr << "Unknown argument: " << argument << std::endl;
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *	RenderFrame()
+ *
+ *  This function is used to render and show one frame of the
+ *  3D scene, with the frame profiler timing each part.
+ ***********************************************************/
+void RenderFrame()
+{
+	g_Profiler->BeginFrame();
+
+	// Clear the frame and z buffers
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// convert from 3D object space to 2D view
+	g_Profiler->BeginScope("PrepareSceneView");
+	g_ViewManager->PrepareSceneView();
+	g_Profiler->EndScope();
+
+	// refresh the 3D scene, the transparent objects are
+	// sorted with the view matrix of this frame
+	g_Profiler->BeginScope("RenderScene");
+	g_SceneManager->SetViewMatrix(g_ViewManager->GetViewMatrix());
+	g_SceneManager->SetProjectionMatrix(g_ViewManager->GetProjectionMatrix());
+	g_SceneManager->SetViewPosition(g_ViewManager->GetViewPosition());
+	g_SceneManager->RenderScene();
+	g_Profiler->EndScope();
+
+	// Flips the the back buffer with the front buffer every frame.
+	g_Profiler->BeginScope("SwapBuffers", false);
+	glfwSwapBuffers(g_Window);
+	g_Profiler->EndScope();
+
+	RenderStateFilter::STATE_COUNTERS counters = g_SceneManager->GetStateCounters();
+	g_Profiler->SetCounter("draws", g_SceneManager->GetDrawCallCount());
+	g_Profiler->SetCounter("states", counters.issued);
+	g_Profiler->SetCounter("dropped", counters.dropped);
+	SceneBVH::CULL_COUNTERS cullCounters = g_SceneManager->GetCullCounters();
+	g_Profiler->SetCounter("visible", cullCounters.visible);
+	g_Profiler->SetCounter("culled", cullCounters.culled);
+	// the video memory of the objects created by the scene
+	g_Profiler->SetCounter("tex_kb", (int)(GpuResources::GetTotals(GpuResources::RESOURCE_TEXTURE).bytes / 1024));
+	g_Profiler->SetCounter("buf_kb", (int)(GpuResources::GetTotals(GpuResources::RESOURCE_BUFFER).bytes / 1024));
+	g_Profiler->SetCounter("vaos", GpuResources::GetTotals(GpuResources::RESOURCE_VERTEX_ARRAY).count);
+	g_Profiler->SetCounter("programs", GpuResources::GetTotals(GpuResources::RESOURCE_PROGRAM).count);
+	g_Profiler->EndFrame();
+}
+
+/***********************************************************
+ *	RunBenchmark()
+ *
+ *  This function is used to render the benchmark frames
+ *  along the camera path and report their times.  The path
+ *  is sampled by frame number, not by the clock, so every
+ *  run renders exactly the same views.
+ ***********************************************************/
+void RunBenchmark()
+{
+	CameraPath cameraPath;
+	BenchmarkReport report;
+	glm::vec3 position;
+	glm::vec3 target;
+	float zoom = 0.0f;
+
+	if (!g_CameraPathFile.empty())
+	{
+		cameraPath.LoadFromFile(g_CameraPathFile);
+	}
+	else if (g_SceneManager->GetStressRadius() > 0.0f)
+	{
+		// the default orbit is widened to take in the stress grid
+		float radius = g_SceneManager->GetStressRadius();
+		cameraPath.SetDefaultOrbit(radius, 0.4f * radius);
+	}
+
+	// the textures are streamed in, so the timing starts once every
+	// texture is uploaded and a few frames have settled
+	cameraPath.Evaluate(0.0f, position, target, zoom);
+	g_ViewManager->SetCameraPose(position, target, zoom);
+	double waitStart = glfwGetTime();
+	while (!g_SceneManager->AreTexturesLoaded() &&
+		(glfwGetTime() - waitStart < BENCH_TEXTURE_TIMEOUT))
+	{
+		RenderFrame();
+		glfwPollEvents();
+	}
+	for (int frame = 0; frame < BENCH_WARMUP_FRAMES; frame++)
+	{
+		RenderFrame();
+		glfwPollEvents();
+	}
+	glFinish();
+
+	float duration = cameraPath.GetDuration();
+	int draws = 0;
+	int states = 0;
+	int visible = 0;
+	std::chrono::steady_clock::time_point frameStart = std::chrono::steady_clock::now();
+	for (int frame = 0; frame < g_BenchFrames; frame++)
+	{
+		float pathTime = (g_BenchFrames > 1) ?
+			duration * (float)frame / (float)(g_BenchFrames - 1) : 0.0f;
+
+		cameraPath.Evaluate(pathTime, position, target, zoom);
+		g_ViewManager->SetCameraPose(position, target, zoom);
+		RenderFrame();
+		glfwPollEvents();
+
+		std::chrono::steady_clock::time_point frameEnd = std::chrono::steady_clock::now();
+		report.AddFrame(std::chrono::duration<double, std::milli>(frameEnd - frameStart).count());
+		frameStart = frameEnd;
+
+		draws += g_SceneManager->GetDrawCallCount();
+		states += g_SceneManager->GetStateCounters().issued;
+		visible += g_SceneManager->GetCullCounters().visible;
+	}
+	glFinish();
+
+	// the per object values give the scaling curves of the stress scene
+	BenchmarkReport::FRAME_TIME_STATS frameStats = report.GetStats();
+	double objects = (double)g_SceneManager->GetDrawItemCount();
+	report.SetValue("objects", objects);
+	report.SetValue("lod_selection", g_SceneManager->IsLodSelection() ? 1.0 : 0.0);
+	report.SetValue("point_lights", (double)g_ViewManager->GetLightManager()->GetPointLightCount());
+	report.SetValue("light_clustering", g_ViewManager->GetLightManager()->IsLightClustering() ? 1.0 : 0.0);
+	report.SetValue("depth_mode", (double)g_SceneManager->GetDepthMode());
+	report.SetValue("multi_draw_indirect",
+		(g_SceneManager->IsIndirectDrawing() && g_SceneManager->IsIndirectSupported()) ? 1.0 : 0.0);
+	report.SetValue("visible_objects_per_frame", (double)visible / (double)g_BenchFrames);
+	report.SetValue("draw_calls_per_frame", (double)draws / (double)g_BenchFrames);
+	report.SetValue("draw_calls_per_second", (double)draws * 1000.0 / frameStats.totalMs);
+	report.SetValue("state_changes_per_frame", (double)states / (double)g_BenchFrames);
+	report.SetValue("frame_ms_per_1k_objects", frameStats.avgMs * 1000.0 / objects);
+	report.SetValue("texture_mb", (double)GpuResources::GetTotals(GpuResources::RESOURCE_TEXTURE).bytes / (1024.0 * 1024.0));
+	report.SetValue("buffer_mb", (double)GpuResources::GetTotals(GpuResources::RESOURCE_BUFFER).bytes / (1024.0 * 1024.0));
+
+	// the GPU times are the rolling statistics of the last frames
+	FrameProfiler::VALUE_STATS cpuStats;
+	FrameProfiler::VALUE_STATS gpuStats;
+	if (g_Profiler->GetScopeStats("RenderScene", cpuStats, gpuStats))
+	{
+		report.SetValue("render_scene_cpu_avg_ms", cpuStats.avgValue);
+		report.SetValue("render_scene_cpu_ms_per_1k_objects", cpuStats.avgValue * 1000.0 / objects);
+		report.SetValue("render_scene_cpu_p99_ms", cpuStats.p99Value);
+		report.SetValue("render_scene_gpu_avg_ms", gpuStats.avgValue);
+		report.SetValue("render_scene_gpu_p99_ms", gpuStats.p99Value);
+	}
+
+	report.PrintSummary();
+	report.WriteJSON(g_BenchJsonFile);
+}
+
 /***********************************************************
  *	InitializeGLFW()
  * 
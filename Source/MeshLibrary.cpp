@@ -0,0 +1,798 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshlibrary.cpp
+// ============
+// shared geometry for the basic shapes - supports instanced drawing
+//
+//  The generated shapes follow the same conventions as ShapeMeshes so that
+//  the same transformations can be used with either of them.
+///////////////////////////////////////////////////////////////////////////////
+
+#include "MeshLibrary.h"
+#include "GpuResources.h"
+
+#include <algorithm>
+#include <cmath>
+
+// declaration of global variables
+namespace
+{
+	// position, normal and texture coordinate floats per vertex
+	const int FLOATS_PER_VERTEX = 8;
+	const float PI = 3.14159265358979f;
+}
+
+/***********************************************************
+ *  MeshLibrary()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+MeshLibrary::MeshLibrary()
+{
+	m_vao = 0;
+	m_vertexBuffer = 0;
+	m_indexBuffer = 0;
+	m_instanceBuffer = 0;
+	m_instanceCapacity = 0;
+	m_indirectVao = 0;
+	m_drawIndexBuffer = 0;
+	m_firstVertex = 0;
+	m_currentRange = 0;
+}
+
+/***********************************************************
+ *  ~MeshLibrary()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+MeshLibrary::~MeshLibrary()
+{
+	if (0 != m_vao)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_VERTEX_ARRAY, m_vao);
+		glDeleteVertexArrays(1, &m_vao);
+		m_vao = 0;
+	}
+	if (0 != m_vertexBuffer)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_vertexBuffer);
+		glDeleteBuffers(1, &m_vertexBuffer);
+		m_vertexBuffer = 0;
+	}
+	if (0 != m_indexBuffer)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_indexBuffer);
+		glDeleteBuffers(1, &m_indexBuffer);
+		m_indexBuffer = 0;
+	}
+	if (0 != m_instanceBuffer)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_instanceBuffer);
+		glDeleteBuffers(1, &m_instanceBuffer);
+		m_instanceBuffer = 0;
+	}
+	if (0 != m_indirectVao)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_VERTEX_ARRAY, m_indirectVao);
+		glDeleteVertexArrays(1, &m_indirectVao);
+		m_indirectVao = 0;
+	}
+	if (0 != m_drawIndexBuffer)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_drawIndexBuffer);
+		glDeleteBuffers(1, &m_drawIndexBuffer);
+		m_drawIndexBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  BeginMesh()
+ *
+ *  This method is used for starting the generation of the
+ *  geometry for the passed in mesh ID and level of detail.
+ ***********************************************************/
+void MeshLibrary::BeginMesh(int meshID, int lod)
+{
+	m_currentRange = (meshID * MAX_LOD_LEVELS) + lod;
+	if (m_currentRange >= (int)m_meshRanges.size())
+	{
+		MESH_RANGE emptyRange = { 0, 0, 0 };
+		m_meshRanges.resize((meshID + 1) * MAX_LOD_LEVELS, emptyRange);
+	}
+
+	m_firstVertex = (GLuint)(m_vertices.size() / FLOATS_PER_VERTEX);
+	m_meshRanges[m_currentRange].baseVertex = (GLint)m_firstVertex;
+	m_meshRanges[m_currentRange].firstIndex = (GLuint)m_indices.size();
+}
+
+/***********************************************************
+ *  EndMesh()
+ *
+ *  This method is used for finishing the generation of the
+ *  geometry of the current mesh.
+ ***********************************************************/
+void MeshLibrary::EndMesh()
+{
+	m_meshRanges[m_currentRange].indexCount =
+		(GLsizei)(m_indices.size() - m_meshRanges[m_currentRange].firstIndex);
+}
+
+/***********************************************************
+ *  AddVertex()
+ *
+ *  This method is used for appending one vertex to the
+ *  geometry of the mesh that is being generated.
+ ***********************************************************/
+void MeshLibrary::AddVertex(glm::vec3 position, glm::vec3 normal, glm::vec2 uv)
+{
+	m_vertices.push_back(position.x);
+	m_vertices.push_back(position.y);
+	m_vertices.push_back(position.z);
+	m_vertices.push_back(normal.x);
+	m_vertices.push_back(normal.y);
+	m_vertices.push_back(normal.z);
+	m_vertices.push_back(uv.x);
+	m_vertices.push_back(uv.y);
+}
+
+/***********************************************************
+ *  CurrentVertex()
+ *
+ *  This method is used for getting the index, relative to
+ *  the start of the current mesh, of the next vertex.
+ ***********************************************************/
+GLuint MeshLibrary::CurrentVertex() const
+{
+	return((GLuint)(m_vertices.size() / FLOATS_PER_VERTEX) - m_firstVertex);
+}
+
+/***********************************************************
+ *  AddPlaneMesh()
+ *
+ *  This method is used for generating a flat plane in the
+ *  XZ plane that faces up the Y axis.
+ ***********************************************************/
+void MeshLibrary::AddPlaneMesh(int meshID)
+{
+	BeginMesh(meshID, 0);
+
+	glm::vec3 normal(0.0f, 1.0f, 0.0f);
+	AddVertex(glm::vec3(-1.0f, 0.0f, -1.0f), normal, glm::vec2(0.0f, 1.0f));
+	AddVertex(glm::vec3(1.0f, 0.0f, -1.0f), normal, glm::vec2(1.0f, 1.0f));
+	AddVertex(glm::vec3(1.0f, 0.0f, 1.0f), normal, glm::vec2(1.0f, 0.0f));
+	AddVertex(glm::vec3(-1.0f, 0.0f, 1.0f), normal, glm::vec2(0.0f, 0.0f));
+
+	GLuint indices[] = { 0, 3, 2, 0, 2, 1 };
+	m_indices.insert(m_indices.end(), indices, indices + 6);
+
+	EndMesh();
+}
+
+/***********************************************************
+ *  AddBoxMesh()
+ *
+ *  This method is used for generating a unit cube with its
+ *  own normals and texture coordinates on each face.
+ ***********************************************************/
+void MeshLibrary::AddBoxMesh(int meshID)
+{
+	// face normal and the two axes across each face, the
+	// cross product of the two axes matches the face normal
+	const glm::vec3 faces[6][3] =
+	{
+		{ glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, -1.0f) },
+		{ glm::vec3(0.0f, -1.0f, 0.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 0.0f, 1.0f) },
+		{ glm::vec3(0.0f, 0.0f, 1.0f), glm::vec3(1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) },
+		{ glm::vec3(0.0f, 0.0f, -1.0f), glm::vec3(-1.0f, 0.0f, 0.0f), glm::vec3(0.0f, 1.0f, 0.0f) }
+	};
+
+	BeginMesh(meshID, 0);
+
+	for (int face = 0; face < 6; face++)
+	{
+		glm::vec3 normal = faces[face][0];
+		glm::vec3 uAxis = faces[face][1] * 0.5f;
+		glm::vec3 vAxis = faces[face][2] * 0.5f;
+		glm::vec3 center = normal * 0.5f;
+		GLuint first = CurrentVertex();
+
+		AddVertex(center - uAxis - vAxis, normal, glm::vec2(0.0f, 0.0f));
+		AddVertex(center + uAxis - vAxis, normal, glm::vec2(1.0f, 0.0f));
+		AddVertex(center + uAxis + vAxis, normal, glm::vec2(1.0f, 1.0f));
+		AddVertex(center - uAxis + vAxis, normal, glm::vec2(0.0f, 1.0f));
+
+		GLuint indices[] = { first, first + 1, first + 2, first, first + 2, first + 3 };
+		m_indices.insert(m_indices.end(), indices, indices + 6);
+	}
+
+	EndMesh();
+}
+
+/***********************************************************
+ *  AddCylinderMesh()
+ *
+ *  This method is used for generating a closed cylinder,
+ *  including the top and bottom caps.
+ ***********************************************************/
+void MeshLibrary::AddCylinderMesh(int meshID, int lod, int slices)
+{
+	BeginMesh(meshID, lod);
+
+	// sides of the cylinder
+	GLuint first = CurrentVertex();
+	for (int i = 0; i <= slices; i++)
+	{
+		float u = (float)i / (float)slices;
+		float x = cosf(u * 2.0f * PI);
+		float z = sinf(u * 2.0f * PI);
+
+		AddVertex(glm::vec3(x, 0.0f, z), glm::vec3(x, 0.0f, z), glm::vec2(u, 0.0f));
+		AddVertex(glm::vec3(x, 1.0f, z), glm::vec3(x, 0.0f, z), glm::vec2(u, 1.0f));
+	}
+	for (int i = 0; i < slices; i++)
+	{
+		GLuint bottom = first + (i * 2);
+		GLuint top = bottom + 1;
+		GLuint indices[] = { bottom, top, top + 2, bottom, top + 2, bottom + 2 };
+		m_indices.insert(m_indices.end(), indices, indices + 6);
+	}
+
+	// top and bottom caps of the cylinder
+	for (int cap = 0; cap < 2; cap++)
+	{
+		float y = (cap == 0) ? 1.0f : 0.0f;
+		glm::vec3 normal(0.0f, (cap == 0) ? 1.0f : -1.0f, 0.0f);
+		GLuint center = CurrentVertex();
+
+		AddVertex(glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+		for (int i = 0; i <= slices; i++)
+		{
+			float angle = (float)i / (float)slices * 2.0f * PI;
+			float x = cosf(angle);
+			float z = sinf(angle);
+			AddVertex(glm::vec3(x, y, z), normal, glm::vec2(0.5f + (x * 0.5f), 0.5f + (z * 0.5f)));
+		}
+		for (int i = 0; i < slices; i++)
+		{
+			GLuint ring = center + 1 + i;
+			if (cap == 0)
+			{
+				GLuint indices[] = { center, ring + 1, ring };
+				m_indices.insert(m_indices.end(), indices, indices + 3);
+			}
+			else
+			{
+				GLuint indices[] = { center, ring, ring + 1 };
+				m_indices.insert(m_indices.end(), indices, indices + 3);
+			}
+		}
+	}
+
+	EndMesh();
+}
+
+/***********************************************************
+ *  AddDisc()
+ *
+ *  This method is used for appending a flat disc at the
+ *  passed in height, facing up or down the Y axis.
+ ***********************************************************/
+void MeshLibrary::AddDisc(float y, float radius, bool bFacingUp, int slices)
+{
+	glm::vec3 normal(0.0f, bFacingUp ? 1.0f : -1.0f, 0.0f);
+	GLuint center = CurrentVertex();
+
+	AddVertex(glm::vec3(0.0f, y, 0.0f), normal, glm::vec2(0.5f, 0.5f));
+	for (int i = 0; i <= slices; i++)
+	{
+		float angle = (float)i / (float)slices * 2.0f * PI;
+		float x = cosf(angle);
+		float z = sinf(angle);
+		AddVertex(glm::vec3(x * radius, y, z * radius), normal, glm::vec2(0.5f + (x * 0.5f), 0.5f + (z * 0.5f)));
+	}
+	for (int i = 0; i < slices; i++)
+	{
+		GLuint ring = center + 1 + i;
+		if (bFacingUp)
+		{
+			GLuint indices[] = { center, ring + 1, ring };
+			m_indices.insert(m_indices.end(), indices, indices + 3);
+		}
+		else
+		{
+			GLuint indices[] = { center, ring, ring + 1 };
+			m_indices.insert(m_indices.end(), indices, indices + 3);
+		}
+	}
+}
+
+/***********************************************************
+ *  AddTaperedCylinderMesh()
+ *
+ *  This method is used for generating a closed cylinder
+ *  that narrows to half of its radius at the top.
+ ***********************************************************/
+void MeshLibrary::AddTaperedCylinderMesh(int meshID, int lod, int slices)
+{
+	const float topRadius = 0.5f;
+
+	BeginMesh(meshID, lod);
+
+	// the side normals lean up by the slope of the taper
+	GLuint first = CurrentVertex();
+	for (int i = 0; i <= slices; i++)
+	{
+		float u = (float)i / (float)slices;
+		float x = cosf(u * 2.0f * PI);
+		float z = sinf(u * 2.0f * PI);
+		glm::vec3 normal = glm::normalize(glm::vec3(x, 1.0f - topRadius, z));
+
+		AddVertex(glm::vec3(x, 0.0f, z), normal, glm::vec2(u, 0.0f));
+		AddVertex(glm::vec3(x * topRadius, 1.0f, z * topRadius), normal, glm::vec2(u, 1.0f));
+	}
+	for (int i = 0; i < slices; i++)
+	{
+		GLuint bottom = first + (i * 2);
+		GLuint top = bottom + 1;
+		GLuint indices[] = { bottom, top, top + 2, bottom, top + 2, bottom + 2 };
+		m_indices.insert(m_indices.end(), indices, indices + 6);
+	}
+
+	AddDisc(1.0f, topRadius, true, slices);
+	AddDisc(0.0f, 1.0f, false, slices);
+
+	EndMesh();
+}
+
+/***********************************************************
+ *  AddSphereMesh()
+ *
+ *  This method is used for generating a sphere from rings
+ *  of latitude and longitude.
+ ***********************************************************/
+void MeshLibrary::AddSphereMesh(int meshID, int lod, int slices, int stacks)
+{
+	BeginMesh(meshID, lod);
+
+	for (int i = 0; i <= stacks; i++)
+	{
+		float phi = (float)i / (float)stacks * PI;
+		for (int j = 0; j <= slices; j++)
+		{
+			float theta = (float)j / (float)slices * 2.0f * PI;
+			glm::vec3 position(
+				sinf(phi) * cosf(theta),
+				cosf(phi),
+				sinf(phi) * sinf(theta));
+
+			AddVertex(position, position,
+				glm::vec2((float)j / (float)slices, 1.0f - ((float)i / (float)stacks)));
+		}
+	}
+	for (int i = 0; i < stacks; i++)
+	{
+		for (int j = 0; j < slices; j++)
+		{
+			GLuint upper = (i * (slices + 1)) + j;
+			GLuint lower = upper + slices + 1;
+			GLuint indices[] = { upper, lower + 1, lower, upper, upper + 1, lower + 1 };
+			m_indices.insert(m_indices.end(), indices, indices + 6);
+		}
+	}
+
+	EndMesh();
+}
+
+/***********************************************************
+ *  AddHalfSphereMesh()
+ *
+ *  This method is used for generating the upper half of the
+ *  sphere, closed with a disc at Y = 0.
+ ***********************************************************/
+void MeshLibrary::AddHalfSphereMesh(int meshID, int lod, int slices, int stacks)
+{
+	BeginMesh(meshID, lod);
+
+	for (int i = 0; i <= stacks; i++)
+	{
+		float phi = (float)i / (float)stacks * 0.5f * PI;
+		for (int j = 0; j <= slices; j++)
+		{
+			float theta = (float)j / (float)slices * 2.0f * PI;
+			glm::vec3 position(
+				sinf(phi) * cosf(theta),
+				cosf(phi),
+				sinf(phi) * sinf(theta));
+
+			AddVertex(position, position,
+				glm::vec2((float)j / (float)slices, 1.0f - ((float)i / (float)stacks)));
+		}
+	}
+	for (int i = 0; i < stacks; i++)
+	{
+		for (int j = 0; j < slices; j++)
+		{
+			GLuint upper = (i * (slices + 1)) + j;
+			GLuint lower = upper + slices + 1;
+			GLuint indices[] = { upper, lower + 1, lower, upper, upper + 1, lower + 1 };
+			m_indices.insert(m_indices.end(), indices, indices + 6);
+		}
+	}
+
+	AddDisc(0.0f, 1.0f, false, slices);
+
+	EndMesh();
+}
+
+/***********************************************************
+ *  AddTorusSweep()
+ *
+ *  This method is used for appending the rings of a torus,
+ *  with a ring radius of 1 in the XY plane, swept from the
+ *  +X axis through the passed in angle.
+ ***********************************************************/
+void MeshLibrary::AddTorusSweep(float sweep, float thickness, int rings, int sides)
+{
+	GLuint first = CurrentVertex();
+
+	for (int i = 0; i <= rings; i++)
+	{
+		float u = (float)i / (float)rings;
+		float ringAngle = u * sweep;
+		glm::vec3 ringDirection(cosf(ringAngle), sinf(ringAngle), 0.0f);
+
+		for (int j = 0; j <= sides; j++)
+		{
+			float v = (float)j / (float)sides;
+			float sideAngle = v * 2.0f * PI;
+			glm::vec3 normal = (ringDirection * cosf(sideAngle)) + glm::vec3(0.0f, 0.0f, sinf(sideAngle));
+
+			AddVertex(ringDirection + (normal * thickness), normal, glm::vec2(u, v));
+		}
+	}
+	for (int i = 0; i < rings; i++)
+	{
+		for (int j = 0; j < sides; j++)
+		{
+			GLuint current = first + (i * (sides + 1)) + j;
+			GLuint next = current + sides + 1;
+			GLuint indices[] = { current, next, next + 1, current, next + 1, current + 1 };
+			m_indices.insert(m_indices.end(), indices, indices + 6);
+		}
+	}
+}
+
+/***********************************************************
+ *  AddTorusMesh()
+ *
+ *  This method is used for generating a full torus ring.
+ ***********************************************************/
+void MeshLibrary::AddTorusMesh(int meshID, int lod, float thickness, int rings, int sides)
+{
+	BeginMesh(meshID, lod);
+	AddTorusSweep(2.0f * PI, thickness, rings, sides);
+	EndMesh();
+}
+
+/***********************************************************
+ *  AddHalfTorusMesh()
+ *
+ *  This method is used for generating the upper half of a
+ *  torus ring, as used for handles.
+ ***********************************************************/
+void MeshLibrary::AddHalfTorusMesh(int meshID, int lod, float thickness, int rings, int sides)
+{
+	BeginMesh(meshID, lod);
+	AddTorusSweep(PI, thickness, rings, sides);
+	EndMesh();
+}
+
+/***********************************************************
+ *  HasMesh()
+ *
+ *  This method is used for checking whether geometry has
+ *  been generated for the passed in mesh ID.
+ ***********************************************************/
+bool MeshLibrary::HasMesh(int meshID) const
+{
+	if ((meshID < 0) || ((meshID * MAX_LOD_LEVELS) >= (int)m_meshRanges.size()))
+	{
+		return(false);
+	}
+
+	return(m_meshRanges[meshID * MAX_LOD_LEVELS].indexCount > 0);
+}
+
+/***********************************************************
+ *  GetLodCount()
+ *
+ *  This method is used for getting the number of levels of
+ *  detail, from level 0 on, that were generated for the
+ *  passed in mesh ID.
+ ***********************************************************/
+int MeshLibrary::GetLodCount(int meshID) const
+{
+	int lodCount = 0;
+
+	while (HasMesh(meshID) && (lodCount < MAX_LOD_LEVELS) &&
+		(m_meshRanges[(meshID * MAX_LOD_LEVELS) + lodCount].indexCount > 0))
+	{
+		lodCount++;
+	}
+
+	return(lodCount);
+}
+
+/***********************************************************
+ *  UploadMeshes()
+ *
+ *  This method is used for copying the generated geometry
+ *  into the shared OpenGL vertex and index buffers, and for
+ *  setting up the per instance model matrix attribute.
+ ***********************************************************/
+void MeshLibrary::UploadMeshes()
+{
+	GLsizei stride = sizeof(GLfloat) * FLOATS_PER_VERTEX;
+
+	if (0 == m_vao)
+	{
+		glGenVertexArrays(1, &m_vao);
+		GpuResources::Add(GpuResources::RESOURCE_VERTEX_ARRAY, m_vao, "MeshLibrary");
+		glGenBuffers(1, &m_vertexBuffer);
+		GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_vertexBuffer, "MeshLibrary");
+		glGenBuffers(1, &m_indexBuffer);
+		GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_indexBuffer, "MeshLibrary");
+		glGenBuffers(1, &m_instanceBuffer);
+		GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_instanceBuffer, "MeshLibrary");
+	}
+
+	glBindVertexArray(m_vao);
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, m_vertices.size() * sizeof(GLfloat), m_vertices.data(), GL_STATIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_vertexBuffer, m_vertices.size() * sizeof(GLfloat));
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, m_indices.size() * sizeof(GLuint), m_indices.data(), GL_STATIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_indexBuffer, m_indices.size() * sizeof(GLuint));
+
+	// same vertex attribute locations that are used by ShapeMeshes
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * 3));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * 6));
+
+	// the per instance model and normal matrices take one attribute
+	// location for each column, and advance once per drawn instance.
+	// The buffer is never empty, so the attributes can always be
+	// fetched by the draws that use the object block instead
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	if (0 == m_instanceCapacity)
+	{
+		INSTANCE_TRANSFORM identity;
+		identity.modelMatrix = glm::mat4(1.0f);
+		identity.normalMatrix[0] = glm::vec4(1.0f, 0.0f, 0.0f, 0.0f);
+		identity.normalMatrix[1] = glm::vec4(0.0f, 1.0f, 0.0f, 0.0f);
+		identity.normalMatrix[2] = glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+		glBufferData(GL_ARRAY_BUFFER, sizeof(INSTANCE_TRANSFORM), &identity, GL_DYNAMIC_DRAW);
+		GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_instanceBuffer, sizeof(INSTANCE_TRANSFORM));
+		m_instanceCapacity = 1;
+	}
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glEnableVertexAttribArray(INSTANCE_MATRIX_LOCATION + column);
+		glVertexAttribDivisor(INSTANCE_MATRIX_LOCATION + column, 1);
+	}
+	for (GLuint column = 0; column < 3; column++)
+	{
+		glEnableVertexAttribArray(INSTANCE_NORMAL_LOCATION + column);
+		glVertexAttribDivisor(INSTANCE_NORMAL_LOCATION + column, 1);
+	}
+	SetInstanceAttributes(0);
+
+	// the indirect draws share the geometry, but take their values
+	// from the draw index that each command starts its instances at
+	if (0 == m_indirectVao)
+	{
+		glGenVertexArrays(1, &m_indirectVao);
+		GpuResources::Add(GpuResources::RESOURCE_VERTEX_ARRAY, m_indirectVao, "MeshLibrary");
+		glGenBuffers(1, &m_drawIndexBuffer);
+		GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_drawIndexBuffer, "MeshLibrary");
+	}
+	glBindVertexArray(m_indirectVao);
+	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
+	glEnableVertexAttribArray(1);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * 3));
+	glEnableVertexAttribArray(2);
+	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, stride, (void*)(sizeof(GLfloat) * 6));
+	glBindBuffer(GL_ARRAY_BUFFER, m_drawIndexBuffer);
+	glEnableVertexAttribArray(DRAW_INDEX_LOCATION);
+	glVertexAttribIPointer(DRAW_INDEX_LOCATION, 1, GL_INT, sizeof(GLint), (void*)0);
+	glVertexAttribDivisor(DRAW_INDEX_LOCATION, 1);
+
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	// the CPU side copy of the geometry is no longer needed
+	m_vertices.clear();
+	m_vertices.shrink_to_fit();
+	m_indices.clear();
+	m_indices.shrink_to_fit();
+}
+
+/***********************************************************
+ *  SetInstanceTransforms()
+ *
+ *  This method is used for replacing the contents of the
+ *  per instance model and normal matrix buffer.
+ ***********************************************************/
+void MeshLibrary::SetInstanceTransforms(const std::vector<INSTANCE_TRANSFORM>& transforms)
+{
+	if (transforms.empty())
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferData(GL_ARRAY_BUFFER, transforms.size() * sizeof(INSTANCE_TRANSFORM), transforms.data(), GL_DYNAMIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_instanceBuffer, transforms.size() * sizeof(INSTANCE_TRANSFORM));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	m_instanceCapacity = (int)transforms.size();
+}
+
+/***********************************************************
+ *  UpdateInstanceTransform()
+ *
+ *  This method is used for changing the matrices of a single
+ *  instance in the per instance buffer.
+ ***********************************************************/
+void MeshLibrary::UpdateInstanceTransform(int instanceIndex, const INSTANCE_TRANSFORM& transform)
+{
+	if ((instanceIndex < 0) || (instanceIndex >= m_instanceCapacity))
+	{
+		return;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	glBufferSubData(GL_ARRAY_BUFFER, instanceIndex * sizeof(INSTANCE_TRANSFORM), sizeof(INSTANCE_TRANSFORM), &transform);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  SetInstanceAttributes()
+ *
+ *  This method is used for pointing the columns of the per
+ *  instance model and normal matrices at the transform of
+ *  the passed in instance, in the bound vertex array.
+ ***********************************************************/
+void MeshLibrary::SetInstanceAttributes(int firstInstance)
+{
+	GLsizeiptr first = sizeof(INSTANCE_TRANSFORM) * firstInstance;
+
+	for (GLuint column = 0; column < 4; column++)
+	{
+		glVertexAttribPointer(INSTANCE_MATRIX_LOCATION + column, 4, GL_FLOAT, GL_FALSE,
+			sizeof(INSTANCE_TRANSFORM), (void*)(first + (sizeof(glm::vec4) * column)));
+	}
+	for (GLuint column = 0; column < 3; column++)
+	{
+		glVertexAttribPointer(INSTANCE_NORMAL_LOCATION + column, 4, GL_FLOAT, GL_FALSE,
+			sizeof(INSTANCE_TRANSFORM), (void*)(first + sizeof(glm::mat4) + (sizeof(glm::vec4) * column)));
+	}
+}
+
+/***********************************************************
+ *  Draw()
+ *
+ *  This method is used for drawing one copy of the passed
+ *  in mesh, placed by the model matrix uniform.  The levels
+ *  that were not generated fall back to the coarsest one.
+ ***********************************************************/
+void MeshLibrary::Draw(int meshID, int lod)
+{
+	if (HasMesh(meshID) == false)
+	{
+		return;
+	}
+
+	const MESH_RANGE& range = GetMeshRange(meshID, std::min(lod, GetLodCount(meshID) - 1));
+
+	glBindVertexArray(m_vao);
+	glDrawElementsBaseVertex(
+		GL_TRIANGLES,
+		range.indexCount,
+		GL_UNSIGNED_INT,
+		(void*)(sizeof(GLuint) * range.firstIndex),
+		range.baseVertex);
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  DrawInstanced()
+ *
+ *  This method is used for drawing a range of instances of
+ *  the passed in mesh with one draw call.
+ ***********************************************************/
+void MeshLibrary::DrawInstanced(int meshID, int lod, int firstInstance, int instanceCount)
+{
+	if ((HasMesh(meshID) == false) || (instanceCount <= 0))
+	{
+		return;
+	}
+
+	const MESH_RANGE& range = GetMeshRange(meshID, std::min(lod, GetLodCount(meshID) - 1));
+
+	glBindVertexArray(m_vao);
+
+	// point the instance attributes at the first transform of the range
+	glBindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+	SetInstanceAttributes(firstInstance);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	glDrawElementsInstancedBaseVertex(
+		GL_TRIANGLES,
+		range.indexCount,
+		GL_UNSIGNED_INT,
+		(void*)(sizeof(GLuint) * range.firstIndex),
+		instanceCount,
+		range.baseVertex);
+
+	glBindVertexArray(0);
+}
+
+/***********************************************************
+ *  SetDrawIndexCount()
+ *
+ *  This method is used for filling the draw index buffer
+ *  with the indices of the indirect commands.  A command
+ *  with the base instance i reads the value i, so the shader
+ *  knows which draw it belongs to.
+ ***********************************************************/
+void MeshLibrary::SetDrawIndexCount(int drawCount)
+{
+	std::vector<GLint> drawIndices(drawCount);
+
+	for (int i = 0; i < drawCount; i++)
+	{
+		drawIndices[i] = i;
+	}
+
+	glBindBuffer(GL_ARRAY_BUFFER, m_drawIndexBuffer);
+	glBufferData(GL_ARRAY_BUFFER, drawIndices.size() * sizeof(GLint), drawIndices.data(), GL_STATIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_drawIndexBuffer, drawIndices.size() * sizeof(GLint));
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
+/***********************************************************
+ *  DrawIndirect()
+ *
+ *  This method is used for issuing a range of the commands
+ *  in the passed in indirect buffer with one call.  Each
+ *  command draws one mesh range of the shared buffers.
+ ***********************************************************/
+void MeshLibrary::DrawIndirect(GLuint commandBuffer, int firstCommand, int commandCount)
+{
+	if ((0 == m_indirectVao) || (commandCount <= 0))
+	{
+		return;
+	}
+
+	glBindVertexArray(m_indirectVao);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commandBuffer);
+
+	glMultiDrawElementsIndirect(
+		GL_TRIANGLES,
+		GL_UNSIGNED_INT,
+		(void*)(sizeof(DRAW_COMMAND) * firstCommand),
+		commandCount,
+		0);
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	glBindVertexArray(0);
+}
@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+// meshlibrary.h
+// ============
+// shared geometry for the basic shapes - supports instanced drawing
+//
+//  The generated shapes follow the same conventions as ShapeMeshes so that
+//  the same transformations can be used with either of them:
+//    plane            - XZ plane from -1 to 1, facing +Y
+//    box              - unit cube from -0.5 to 0.5
+//    cylinder         - radius 1, from Y = 0 to Y = 1
+//    tapered cylinder - radius 1 at Y = 0 to radius 0.5 at Y = 1
+//    sphere           - radius 1, centered on the origin
+//    half sphere      - upper half of the sphere, closed at Y = 0
+//    torus            - ring of radius 1 in the XY plane
+//    half torus       - upper half of the torus ring
+//
+//  The curved shapes can be generated at several levels of detail, level 0
+//  being the finest.  The plane and the box only have level 0.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <vector>
+
+/***********************************************************
+ *  MeshLibrary
+ *
+ *  This class contains the code for generating the basic
+ *  shape meshes into one shared vertex and index buffer,
+ *  and for drawing many instances of a mesh with a single
+ *  draw call using a per instance model matrix buffer, or
+ *  many meshes with one multi draw indirect call.
+ ***********************************************************/
+class MeshLibrary
+{
+public:
+	// constructor
+	MeshLibrary();
+	// destructor
+	~MeshLibrary();
+
+	// vertex attribute location of the per instance model matrix,
+	// the matrix uses this location and the three following ones
+	static const GLuint INSTANCE_MATRIX_LOCATION = 3;
+	// vertex attribute location of the draw index used with the
+	// multi draw indirect path, advanced by the base instance
+	static const GLuint DRAW_INDEX_LOCATION = 7;
+	// vertex attribute location of the per instance normal matrix,
+	// the matrix uses this location and the two following ones
+	static const GLuint INSTANCE_NORMAL_LOCATION = 8;
+	// most levels of detail a mesh can be generated at
+	static const int MAX_LOD_LEVELS = 4;
+
+	// values of one instance, the normal matrix columns are padded
+	// to four floats like the columns of the model matrix
+	struct INSTANCE_TRANSFORM
+	{
+		glm::mat4 modelMatrix;
+		glm::vec4 normalMatrix[3];
+	};
+
+	// location of a generated mesh in the shared buffers
+	struct MESH_RANGE
+	{
+		GLint baseVertex;
+		GLuint firstIndex;
+		GLsizei indexCount;
+	};
+
+	// layout of one command in an indirect draw buffer, as read by
+	// glMultiDrawElementsIndirect()
+	struct DRAW_COMMAND
+	{
+		GLuint count;
+		GLuint instanceCount;
+		GLuint firstIndex;
+		GLint baseVertex;
+		GLuint baseInstance;
+	};
+
+	// generate the basic shapes for the passed in mesh ID, the curved
+	// shapes at the passed in level of detail
+	void AddPlaneMesh(int meshID);
+	void AddBoxMesh(int meshID);
+	void AddCylinderMesh(int meshID, int lod, int slices = 36);
+	void AddTaperedCylinderMesh(int meshID, int lod, int slices = 36);
+	void AddSphereMesh(int meshID, int lod, int slices = 36, int stacks = 18);
+	void AddHalfSphereMesh(int meshID, int lod, int slices = 36, int stacks = 9);
+	void AddTorusMesh(int meshID, int lod, float thickness = 0.1f, int rings = 36, int sides = 12);
+	void AddHalfTorusMesh(int meshID, int lod, float thickness = 0.1f, int rings = 18, int sides = 12);
+
+	// check if geometry was generated for the passed in mesh ID
+	bool HasMesh(int meshID) const;
+	// get the number of levels of detail generated for a mesh
+	int GetLodCount(int meshID) const;
+	// get the location of a generated mesh in the shared buffers
+	const MESH_RANGE& GetMeshRange(int meshID, int lod = 0) const { return m_meshRanges[(meshID * MAX_LOD_LEVELS) + lod]; }
+
+	// copy the generated geometry into the OpenGL buffers
+	void UploadMeshes();
+
+	// replace the contents of the per instance matrix buffer
+	void SetInstanceTransforms(const std::vector<INSTANCE_TRANSFORM>& transforms);
+	// change a single entry of the per instance matrix buffer
+	void UpdateInstanceTransform(int instanceIndex, const INSTANCE_TRANSFORM& transform);
+
+	// draw one copy of the passed in mesh with the model uniform
+	void Draw(int meshID, int lod);
+	// draw a range of instances of the passed in mesh
+	void DrawInstanced(int meshID, int lod, int firstInstance, int instanceCount);
+
+	// fill the draw index buffer with the indices 0 to drawCount - 1
+	void SetDrawIndexCount(int drawCount);
+	// issue a range of the indirect commands in one call
+	void DrawIndirect(GLuint commandBuffer, int firstCommand, int commandCount);
+
+private:
+	// OpenGL objects for the shared geometry
+	GLuint m_vao;
+	GLuint m_vertexBuffer;
+	GLuint m_indexBuffer;
+	GLuint m_instanceBuffer;
+	// number of instances the instance buffer can hold
+	int m_instanceCapacity;
+	// vertex array of the indirect draws and the buffer holding
+	// the draw index for each indirect command
+	GLuint m_indirectVao;
+	GLuint m_drawIndexBuffer;
+
+	// interleaved position, normal and texture coordinates
+	std::vector<GLfloat> m_vertices;
+	std::vector<GLuint> m_indices;
+	// generated meshes indexed by mesh ID * MAX_LOD_LEVELS + level
+	std::vector<MESH_RANGE> m_meshRanges;
+	// range of the mesh that is being generated
+	int m_currentRange;
+
+	// point the per instance attributes at the transform of the
+	// first instance, with the instance buffer bound
+	void SetInstanceAttributes(int firstInstance);
+	// begin and end the generation of a mesh
+	void BeginMesh(int meshID, int lod);
+	void EndMesh();
+	// append a vertex to the geometry of the current mesh
+	void AddVertex(glm::vec3 position, glm::vec3 normal, glm::vec2 uv);
+	// append a flat disc facing up or down the Y axis
+	void AddDisc(float y, float radius, bool bFacingUp, int slices);
+	// append the rings of a torus swept through the passed in angle
+	void AddTorusSweep(float sweep, float thickness, int rings, int sides);
+	// number of vertices in the geometry of the current mesh
+	GLuint m_firstVertex;
+	GLuint CurrentVertex() const;
+};
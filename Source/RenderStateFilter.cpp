@@ -0,0 +1,220 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstatefilter.cpp
+// ============
+// track the current render state and drop redundant state changes
+///////////////////////////////////////////////////////////////////////////////
+
+#include "RenderStateFilter.h"
+
+// declaration of the global variables and defines
+namespace
+{
+	constexpr UniformID g_TextureValueName("objectTexture");
+	constexpr UniformID g_UseTextureName("bUseTexture");
+	constexpr UniformID g_UseInstancingName("bUseInstancing");
+	constexpr UniformID g_UseDrawDataName("bUseDrawData");
+}
+
+/***********************************************************
+ *  RenderStateFilter()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+RenderStateFilter::RenderStateFilter(UniformCache* pUniformCache)
+{
+	m_pUniformCache = pUniformCache;
+	m_textureLocation = -1;
+	m_useTextureLocation = -1;
+	m_useInstancingLocation = -1;
+	m_useDrawDataLocation = -1;
+	m_state = {};
+	m_validBits = 0;
+	m_frame = {};
+	m_lastFrame = {};
+}
+
+/***********************************************************
+ *  LoadLocations()
+ *
+ *  This method is used for looking up the locations of the
+ *  uniforms that are filtered.  The remembered state is
+ *  cleared since it may belong to another program.
+ ***********************************************************/
+void RenderStateFilter::LoadLocations()
+{
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	m_textureLocation = m_pUniformCache->GetLocation(g_TextureValueName);
+	m_useTextureLocation = m_pUniformCache->GetLocation(g_UseTextureName);
+	m_useInstancingLocation = m_pUniformCache->GetLocation(g_UseInstancingName);
+	m_useDrawDataLocation = m_pUniformCache->GetLocation(g_UseDrawDataName);
+
+	Invalidate();
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for forgetting the remembered state,
+ *  for when OpenGL state was changed outside of the filter.
+ ***********************************************************/
+void RenderStateFilter::Invalidate()
+{
+	m_validBits = 0;
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for starting the counters of a new
+ *  frame.  The state itself stays valid between frames.
+ ***********************************************************/
+void RenderStateFilter::BeginFrame()
+{
+	m_lastFrame = m_frame;
+	m_frame.issued = 0;
+	m_frame.dropped = 0;
+}
+
+/***********************************************************
+ *  IsRedundant()
+ *
+ *  This method is used for checking if a state change can be
+ *  dropped, and for counting it as issued or dropped.
+ ***********************************************************/
+bool RenderStateFilter::IsRedundant(unsigned int stateBit, bool bSameValue)
+{
+	if ((0 != (m_validBits & stateBit)) && (true == bSameValue))
+	{
+		m_frame.dropped++;
+		return(true);
+	}
+
+	m_validBits |= stateBit;
+	m_frame.issued++;
+	return(false);
+}
+
+/***********************************************************
+ *  UseProgram()
+ *
+ *  This method is used for making the passed in program the
+ *  current shader program.
+ ***********************************************************/
+void RenderStateFilter::UseProgram(GLuint program)
+{
+	if (IsRedundant(STATE_PROGRAM, m_state.program == program))
+	{
+		return;
+	}
+
+	m_state.program = program;
+	glUseProgram(program);
+}
+
+/***********************************************************
+ *  SetTextureSlot()
+ *
+ *  This method is used for pointing the object texture
+ *  sampler at the passed in texture unit.
+ ***********************************************************/
+void RenderStateFilter::SetTextureSlot(int slot)
+{
+	if (IsRedundant(STATE_TEXTURE_SLOT, m_state.textureSlot == slot))
+	{
+		return;
+	}
+
+	m_state.textureSlot = slot;
+	m_pUniformCache->SetInt(m_textureLocation, slot);
+}
+
+/***********************************************************
+ *  SetUseTexture()
+ *
+ *  This method is used for setting whether the object is
+ *  drawn with its texture or with its color.
+ ***********************************************************/
+void RenderStateFilter::SetUseTexture(bool useTexture)
+{
+	int value = useTexture ? 1 : 0;
+
+	if (IsRedundant(STATE_USE_TEXTURE, m_state.useTexture == value))
+	{
+		return;
+	}
+
+	m_state.useTexture = value;
+	m_pUniformCache->SetInt(m_useTextureLocation, value);
+}
+
+/***********************************************************
+ *  SetUseInstancing()
+ *
+ *  This method is used for setting whether the model matrix
+ *  comes from the instance buffer or from the uniform.
+ ***********************************************************/
+void RenderStateFilter::SetUseInstancing(bool useInstancing)
+{
+	int value = useInstancing ? 1 : 0;
+
+	if (IsRedundant(STATE_USE_INSTANCING, m_state.useInstancing == value))
+	{
+		return;
+	}
+
+	m_state.useInstancing = value;
+	m_pUniformCache->SetInt(m_useInstancingLocation, value);
+}
+
+/***********************************************************
+ *  SetUseDrawData()
+ *
+ *  This method is used for setting whether the values of
+ *  each draw are read from the per draw data buffers, for
+ *  the multi draw indirect path.
+ ***********************************************************/
+void RenderStateFilter::SetUseDrawData(bool useDrawData)
+{
+	int value = useDrawData ? 1 : 0;
+
+	if (IsRedundant(STATE_USE_DRAW_DATA, m_state.useDrawData == value))
+	{
+		return;
+	}
+
+	m_state.useDrawData = value;
+	m_pUniformCache->SetInt(m_useDrawDataLocation, value);
+}
+
+/***********************************************************
+ *  SetMaterial()
+ *
+ *  This method is used for pointing the material block at
+ *  the range of the material buffer holding the material.
+ ***********************************************************/
+void RenderStateFilter::SetMaterial(
+	GLuint buffer,
+	int material,
+	GLintptr offset,
+	GLsizeiptr size)
+{
+	bool bSameValue = (m_state.materialBuffer == buffer) && (m_state.material == material);
+
+	if (IsRedundant(STATE_MATERIAL, bSameValue))
+	{
+		return;
+	}
+
+	m_state.materialBuffer = buffer;
+	m_state.material = material;
+	glBindBufferRange(
+		GL_UNIFORM_BUFFER,
+		UniformCache::MATERIAL_BLOCK_BINDING,
+		buffer,
+		offset,
+		size);
+}
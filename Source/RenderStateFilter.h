@@ -0,0 +1,95 @@
+///////////////////////////////////////////////////////////////////////////////
+// renderstatefilter.h
+// ============
+// track the current render state and drop redundant state changes
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "UniformCache.h"
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  RenderStateFilter
+ *
+ *  This class contains the code for remembering the shader
+ *  state that was last set for drawing - program, sampler
+ *  slot, material and the texture, instancing and draw data
+ *  flags - so that a change to the same value is dropped
+ *  instead of being sent to OpenGL.  The values of each
+ *  draw are written to the object block instead.
+ ***********************************************************/
+class RenderStateFilter
+{
+public:
+	// constructor
+	RenderStateFilter(UniformCache* pUniformCache);
+
+	// number of state changes sent to OpenGL and dropped
+	struct STATE_COUNTERS
+	{
+		int issued;
+		int dropped;
+	};
+
+	// look up the locations of the filtered uniforms
+	void LoadLocations();
+	// forget the remembered state so every value is sent again
+	void Invalidate();
+
+	// start counting the state changes for a new frame
+	void BeginFrame();
+	// get the counters of the last completed frame
+	STATE_COUNTERS GetFrameCounters() const { return m_lastFrame; }
+
+	// state changes, each is dropped if the value is already set
+	void UseProgram(GLuint program);
+	void SetTextureSlot(int slot);
+	void SetUseTexture(bool useTexture);
+	void SetUseInstancing(bool useInstancing);
+	void SetUseDrawData(bool useDrawData);
+	void SetMaterial(GLuint buffer, int material, GLintptr offset, GLsizeiptr size);
+
+private:
+	// pointer to the cached shader uniform locations
+	UniformCache* m_pUniformCache;
+
+	// locations of the filtered uniforms
+	GLint m_textureLocation;
+	GLint m_useTextureLocation;
+	GLint m_useInstancingLocation;
+	GLint m_useDrawDataLocation;
+
+	// currently set state, each value is valid once its bit is set
+	struct CURRENT_STATE
+	{
+		GLuint program;
+		int textureSlot;
+		int useTexture;
+		int useInstancing;
+		int useDrawData;
+		GLuint materialBuffer;
+		int material;
+	};
+	CURRENT_STATE m_state;
+	// flags for each remembered value that has been set
+	enum STATE_BITS
+	{
+		STATE_PROGRAM = 1,
+		STATE_TEXTURE_SLOT = 2,
+		STATE_USE_TEXTURE = 4,
+		STATE_USE_INSTANCING = 8,
+		STATE_MATERIAL = 16,
+		STATE_USE_DRAW_DATA = 32
+	};
+	unsigned int m_validBits;
+
+	// counters of the current and the last completed frame
+	STATE_COUNTERS m_frame;
+	STATE_COUNTERS m_lastFrame;
+
+	// check and record a change of a remembered value
+	bool IsRedundant(unsigned int stateBit, bool bSameValue);
+};
@@ -0,0 +1,282 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.cpp
+// ============
+// bounding volume hierarchy over the scene objects for frustum culling
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneBVH.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+// declaration of the global variables and defines
+namespace
+{
+	// most objects kept in a leaf node
+	const int MAX_LEAF_OBJECTS = 4;
+	// deepest node stack needed while walking the hierarchy
+	const int MAX_CULL_STACK = 64;
+}
+
+/***********************************************************
+ *  SceneBVH()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneBVH::SceneBVH()
+{
+}
+
+/***********************************************************
+ *  ExtractFrustum()
+ *
+ *  This method is used for getting the six frustum planes
+ *  from the rows of the combined projection * view matrix.
+ *  A point is inside of a plane when dot(plane, point) >= 0.
+ ***********************************************************/
+SceneBVH::FRUSTUM SceneBVH::ExtractFrustum(const glm::mat4& viewProjection)
+{
+	FRUSTUM frustum;
+	glm::vec4 rows[4];
+
+	for (int row = 0; row < 4; row++)
+	{
+		rows[row] = glm::vec4(
+			viewProjection[0][row],
+			viewProjection[1][row],
+			viewProjection[2][row],
+			viewProjection[3][row]);
+	}
+
+	frustum.planes[0] = rows[3] + rows[0];		// left
+	frustum.planes[1] = rows[3] - rows[0];		// right
+	frustum.planes[2] = rows[3] + rows[1];		// bottom
+	frustum.planes[3] = rows[3] - rows[1];		// top
+	frustum.planes[4] = rows[3] + rows[2];		// near
+	frustum.planes[5] = rows[3] - rows[2];		// far
+
+	return(frustum);
+}
+
+/***********************************************************
+ *  TransformBox()
+ *
+ *  This method is used for getting the world space box that
+ *  holds the passed in local box after it is transformed,
+ *  by transforming its center and its extents.
+ ***********************************************************/
+SceneBVH::BOUNDING_BOX SceneBVH::TransformBox(const BOUNDING_BOX& box, const glm::mat4& matrix)
+{
+	glm::vec3 center = 0.5f * (box.minCorner + box.maxCorner);
+	glm::vec3 extents = 0.5f * (box.maxCorner - box.minCorner);
+	glm::vec3 worldCenter = glm::vec3(matrix * glm::vec4(center, 1.0f));
+	glm::vec3 worldExtents(0.0f);
+
+	for (int axis = 0; axis < 3; axis++)
+	{
+		for (int column = 0; column < 3; column++)
+		{
+			worldExtents[axis] += std::abs(matrix[column][axis]) * extents[column];
+		}
+	}
+
+	BOUNDING_BOX worldBox;
+	worldBox.minCorner = worldCenter - worldExtents;
+	worldBox.maxCorner = worldCenter + worldExtents;
+
+	return(worldBox);
+}
+
+/***********************************************************
+ *  Build()
+ *
+ *  This method is used for building the hierarchy over the
+ *  passed in object boxes, replacing the previous one.
+ ***********************************************************/
+void SceneBVH::Build(const std::vector<BOUNDING_BOX>& boxes)
+{
+	std::vector<glm::vec3> centers(boxes.size());
+
+	m_boxes = boxes;
+	m_nodes.clear();
+	m_objectOrder.resize(boxes.size());
+	for (int i = 0; i < (int)boxes.size(); i++)
+	{
+		m_objectOrder[i] = i;
+		centers[i] = 0.5f * (boxes[i].minCorner + boxes[i].maxCorner);
+	}
+
+	if (boxes.empty())
+	{
+		return;
+	}
+
+	// a binary tree has at most two nodes for each object
+	m_nodes.reserve(2 * boxes.size());
+	BuildNode(0, (int)boxes.size(), centers);
+}
+
+/***********************************************************
+ *  BuildNode()
+ *
+ *  This method is used for building the node over a range
+ *  of the object order.  The range is split at the median
+ *  of the object centers along the longest axis of the node
+ *  until it is small enough to be a leaf.
+ ***********************************************************/
+int SceneBVH::BuildNode(int firstObject, int objectCount, const std::vector<glm::vec3>& centers)
+{
+	int nodeIndex = (int)m_nodes.size();
+	BVH_NODE node;
+
+	node.bounds.minCorner = glm::vec3(FLT_MAX);
+	node.bounds.maxCorner = glm::vec3(-FLT_MAX);
+	node.leftChild = -1;
+	node.rightChild = -1;
+	node.firstObject = firstObject;
+	node.objectCount = objectCount;
+	for (int i = firstObject; i < firstObject + objectCount; i++)
+	{
+		const BOUNDING_BOX& box = m_boxes[m_objectOrder[i]];
+		node.bounds.minCorner = glm::min(node.bounds.minCorner, box.minCorner);
+		node.bounds.maxCorner = glm::max(node.bounds.maxCorner, box.maxCorner);
+	}
+	m_nodes.push_back(node);
+
+	if (objectCount <= MAX_LEAF_OBJECTS)
+	{
+		return(nodeIndex);
+	}
+
+	glm::vec3 size = node.bounds.maxCorner - node.bounds.minCorner;
+	int axis = 0;
+	if (size.y > size[axis]) axis = 1;
+	if (size.z > size[axis]) axis = 2;
+
+	int halfCount = objectCount / 2;
+	std::nth_element(
+		m_objectOrder.begin() + firstObject,
+		m_objectOrder.begin() + firstObject + halfCount,
+		m_objectOrder.begin() + firstObject + objectCount,
+		[&centers, axis](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+	// the node is looked up again, building the children can
+	// grow the node list
+	int leftChild = BuildNode(firstObject, halfCount, centers);
+	int rightChild = BuildNode(firstObject + halfCount, objectCount - halfCount, centers);
+	m_nodes[nodeIndex].leftChild = leftChild;
+	m_nodes[nodeIndex].rightChild = rightChild;
+
+	return(nodeIndex);
+}
+
+/***********************************************************
+ *  IsBoxVisible()
+ *
+ *  This method is used for testing a single box against the
+ *  frustum, without the hierarchy.
+ ***********************************************************/
+bool SceneBVH::IsBoxVisible(const FRUSTUM& frustum, const BOUNDING_BOX& box)
+{
+	return(TestBox(frustum, box) != BOX_OUTSIDE);
+}
+
+/***********************************************************
+ *  TestBox()
+ *
+ *  This method is used for testing a box against the planes
+ *  of the frustum.  For each plane, the box corner farthest
+ *  along the plane normal decides if the box is outside and
+ *  the nearest corner decides if it is fully inside.
+ ***********************************************************/
+SceneBVH::FRUSTUM_TEST SceneBVH::TestBox(const FRUSTUM& frustum, const BOUNDING_BOX& box)
+{
+	FRUSTUM_TEST result = BOX_INSIDE;
+
+	for (int i = 0; i < 6; i++)
+	{
+		const glm::vec4& plane = frustum.planes[i];
+		glm::vec3 farCorner;
+		glm::vec3 nearCorner;
+
+		for (int axis = 0; axis < 3; axis++)
+		{
+			bool bPositive = plane[axis] >= 0.0f;
+			farCorner[axis] = bPositive ? box.maxCorner[axis] : box.minCorner[axis];
+			nearCorner[axis] = bPositive ? box.minCorner[axis] : box.maxCorner[axis];
+		}
+
+		if (glm::dot(glm::vec3(plane), farCorner) + plane.w < 0.0f)
+		{
+			return(BOX_OUTSIDE);
+		}
+		if (glm::dot(glm::vec3(plane), nearCorner) + plane.w < 0.0f)
+		{
+			result = BOX_INTERSECTS;
+		}
+	}
+
+	return(result);
+}
+
+/***********************************************************
+ *  Cull()
+ *
+ *  This method is used for marking the objects inside of
+ *  the frustum.  The visible list is sized to the number of
+ *  objects and set to 1 for the visible ones.
+ ***********************************************************/
+SceneBVH::CULL_COUNTERS SceneBVH::Cull(const FRUSTUM& frustum, std::vector<uint8_t>& visible) const
+{
+	CULL_COUNTERS counters = {};
+	int stack[MAX_CULL_STACK];
+	int stackSize = 0;
+
+	visible.assign(m_boxes.size(), 0);
+	if (m_nodes.empty())
+	{
+		return(counters);
+	}
+
+	stack[stackSize++] = 0;
+	while (stackSize > 0)
+	{
+		const BVH_NODE& node = m_nodes[stack[--stackSize]];
+		FRUSTUM_TEST test = TestBox(frustum, node.bounds);
+		counters.nodesVisited++;
+
+		if (BOX_OUTSIDE == test)
+		{
+			continue;
+		}
+
+		// a node fully inside, or a leaf, marks its objects, the
+		// objects of a leaf that only intersects are each tested
+		if ((BOX_INSIDE == test) || (node.leftChild < 0))
+		{
+			for (int i = node.firstObject; i < node.firstObject + node.objectCount; i++)
+			{
+				int object = m_objectOrder[i];
+				if ((BOX_INSIDE == test) || (TestBox(frustum, m_boxes[object]) != BOX_OUTSIDE))
+				{
+					visible[object] = 1;
+					counters.visible++;
+				}
+			}
+			continue;
+		}
+
+		// the median splits keep the tree balanced, so the stack
+		// only has to hold about two nodes for each level
+		if (stackSize + 2 <= MAX_CULL_STACK)
+		{
+			stack[stackSize++] = node.rightChild;
+			stack[stackSize++] = node.leftChild;
+		}
+	}
+
+	counters.culled = (int)m_boxes.size() - counters.visible;
+
+	return(counters);
+}
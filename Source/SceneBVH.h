@@ -0,0 +1,96 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenebvh.h
+// ============
+// bounding volume hierarchy over the scene objects for frustum culling
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/***********************************************************
+ *  SceneBVH
+ *
+ *  This class contains the code for building a bounding
+ *  volume hierarchy over the world space boxes of the scene
+ *  objects, and for finding the objects that are inside of
+ *  the view frustum by walking the hierarchy.  Whole
+ *  subtrees outside of the frustum are skipped with one
+ *  test, and subtrees fully inside are accepted with one.
+ ***********************************************************/
+class SceneBVH
+{
+public:
+	// constructor
+	SceneBVH();
+
+	// axis aligned box in world space
+	struct BOUNDING_BOX
+	{
+		glm::vec3 minCorner;
+		glm::vec3 maxCorner;
+	};
+
+	// planes of the view frustum, the normals point inwards
+	struct FRUSTUM
+	{
+		glm::vec4 planes[6];
+	};
+
+	// number of tests made by the last culling pass
+	struct CULL_COUNTERS
+	{
+		int visible;
+		int culled;
+		int nodesVisited;
+	};
+
+	// get the frustum planes of a projection * view matrix
+	static FRUSTUM ExtractFrustum(const glm::mat4& viewProjection);
+	// get the world space box around a transformed local box
+	static BOUNDING_BOX TransformBox(const BOUNDING_BOX& box, const glm::mat4& matrix);
+	// check if a box is at least partly inside of the frustum
+	static bool IsBoxVisible(const FRUSTUM& frustum, const BOUNDING_BOX& box);
+
+	// build the hierarchy over the passed in object boxes
+	void Build(const std::vector<BOUNDING_BOX>& boxes);
+	// set visible[i] for each object i, by the frustum
+	CULL_COUNTERS Cull(const FRUSTUM& frustum, std::vector<uint8_t>& visible) const;
+
+	// get the number of nodes in the hierarchy
+	int GetNodeCount() const { return (int)m_nodes.size(); }
+
+private:
+	// one node of the hierarchy, the objects of a node are
+	// a contiguous range of the object order
+	struct BVH_NODE
+	{
+		BOUNDING_BOX bounds;
+		int leftChild;		// -1 for a leaf
+		int rightChild;
+		int firstObject;
+		int objectCount;
+	};
+
+	// result of testing a box against the frustum
+	enum FRUSTUM_TEST
+	{
+		BOX_OUTSIDE = 0,
+		BOX_INTERSECTS,
+		BOX_INSIDE
+	};
+
+	std::vector<BVH_NODE> m_nodes;
+	// object indices ordered so that each node covers a range
+	std::vector<int> m_objectOrder;
+	// boxes of the objects the hierarchy was built over
+	std::vector<BOUNDING_BOX> m_boxes;
+
+	// build the node for a range of the object order
+	int BuildNode(int firstObject, int objectCount, const std::vector<glm::vec3>& centers);
+	// test a box against the planes of the frustum
+	static FRUSTUM_TEST TestBox(const FRUSTUM& frustum, const BOUNDING_BOX& box);
+};
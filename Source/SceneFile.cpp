@@ -0,0 +1,819 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.cpp
+// ============
+// scene description file with a memory mapped binary cache
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneFile.h"
+#include "SceneManager.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// declaration of the global variables and defines
+namespace
+{
+	// "SCNC" and the layout version of the binary cache
+	const uint32_t CACHE_MAGIC = 0x434E4353;
+	const uint32_t CACHE_VERSION = 2;
+
+	// mesh names used by the text file, indexed by MESH_TYPE
+	const char* const g_MeshNames[] =
+	{
+		"plane",
+		"box",
+		"cylinder",
+		"tapered_cylinder",
+		"sphere",
+		"half_sphere",
+		"torus",
+		"half_torus"
+	};
+	const int MESH_NAME_COUNT = sizeof(g_MeshNames) / sizeof(g_MeshNames[0]);
+
+	/***********************************************************
+	 *  AlignOffset()
+	 *
+	 *  This function is used for rounding an offset in the
+	 *  cache up to the alignment of the float arrays.
+	 ***********************************************************/
+	uint32_t AlignOffset(size_t offset)
+	{
+		return((uint32_t)((offset + 3) & ~(size_t)3));
+	}
+}
+
+/***********************************************************
+ *  SceneFile()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneFile::SceneFile()
+{
+	m_bLoaded = false;
+	m_textureCount = 0;
+	m_pTextures = NULL;
+	m_materialCount = 0;
+	m_pMaterials = NULL;
+	m_sectionCount = 0;
+	m_pSections = NULL;
+	m_nodeCount = 0;
+	m_pNodes = NULL;
+	m_itemCount = 0;
+	m_pItems = NULL;
+	m_pMapping = NULL;
+	m_mappingSize = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  ~SceneFile()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+SceneFile::~SceneFile()
+{
+	Clear();
+}
+
+/***********************************************************
+ *  Load()
+ *
+ *  This method is used for loading a scene.  The binary
+ *  cache is mapped when it was written from the same text,
+ *  otherwise the text is parsed and the cache written again
+ *  for the next run.
+ ***********************************************************/
+bool SceneFile::Load(const std::string& filename)
+{
+	std::string text;
+	std::string cacheFilename = GetCacheFilename(filename);
+
+	Clear();
+
+	if (false == ReadFile(filename, text))
+	{
+		std::cout << "Could not open scene file:" << filename << std::endl;
+		return(false);
+	}
+
+	uint32_t sourceSize = (uint32_t)text.size();
+	uint32_t sourceHash = HashText(text);
+
+	if (MapCache(cacheFilename, sourceSize, sourceHash))
+	{
+		m_bLoaded = true;
+		std::cout << "INFO: Mapped " << m_itemCount << " scene items from " << cacheFilename << std::endl;
+		return(true);
+	}
+
+	if (false == ParseText(text, filename))
+	{
+		Clear();
+		return(false);
+	}
+
+	UseParsedArrays();
+	m_bLoaded = true;
+	std::cout << "INFO: Loaded " << m_itemCount << " scene items from " << filename << std::endl;
+
+	if (WriteCache(cacheFilename, sourceSize, sourceHash))
+	{
+		std::cout << "INFO: Wrote scene cache:" << cacheFilename << std::endl;
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for freeing the loaded scene.
+ ***********************************************************/
+void SceneFile::Clear()
+{
+	UnmapFile();
+
+	m_textures.clear();
+	m_materials.clear();
+	m_sections.clear();
+	m_nodes.clear();
+	m_items.clear();
+
+	m_textureCount = 0;
+	m_pTextures = NULL;
+	m_materialCount = 0;
+	m_pMaterials = NULL;
+	m_sectionCount = 0;
+	m_pSections = NULL;
+	m_nodeCount = 0;
+	m_pNodes = NULL;
+	m_itemCount = 0;
+	m_pItems = NULL;
+	m_bLoaded = false;
+}
+
+/***********************************************************
+ *  GetCacheFilename()
+ *
+ *  This method is used for getting the name of the binary
+ *  cache, which sits next to the scene file.
+ ***********************************************************/
+std::string SceneFile::GetCacheFilename(const std::string& filename)
+{
+	size_t dot = filename.find_last_of('.');
+	size_t slash = filename.find_last_of("/\\");
+
+	if ((dot == std::string::npos) || ((slash != std::string::npos) && (dot < slash)))
+	{
+		return(filename + ".bin");
+	}
+
+	return(filename.substr(0, dot) + ".bin");
+}
+
+/***********************************************************
+ *  ParseText()
+ *
+ *  This method is used for parsing the entries of the text
+ *  file.  The tags are resolved to indices here, so that the
+ *  items only hold plain values.
+ ***********************************************************/
+bool SceneFile::ParseText(const std::string& text, const std::string& filename)
+{
+	std::istringstream file(text);
+	std::string line;
+	int lineNumber = 0;
+	int currentSection = -1;
+	int currentNode = -1;
+
+	while (std::getline(file, line))
+	{
+		std::istringstream stream(line);
+		std::string keyword;
+
+		lineNumber++;
+		if (!(stream >> keyword) || (keyword[0] == '#'))
+		{
+			continue;
+		}
+
+		bool bValid = false;
+		if (keyword == "texture")
+		{
+			SCENE_TEXTURE texture = {};
+			std::string tag;
+			std::string textureFile;
+
+			bValid = (stream >> tag >> textureFile) &&
+				CopyName(texture.tag, MAX_TAG_LENGTH, tag) &&
+				CopyName(texture.filename, MAX_FILENAME_LENGTH, textureFile);
+			if (bValid)
+			{
+				m_textures.push_back(texture);
+			}
+		}
+		else if (keyword == "material")
+		{
+			SCENE_MATERIAL material = {};
+			std::string tag;
+
+			bValid = (stream >> tag
+				>> material.ambientColor.x >> material.ambientColor.y >> material.ambientColor.z
+				>> material.ambientStrength
+				>> material.diffuseColor.x >> material.diffuseColor.y >> material.diffuseColor.z
+				>> material.specularColor.x >> material.specularColor.y >> material.specularColor.z
+				>> material.shininess) &&
+				CopyName(material.tag, MAX_TAG_LENGTH, tag);
+			if (bValid)
+			{
+				m_materials.push_back(material);
+			}
+		}
+		else if (keyword == "section")
+		{
+			std::string name;
+
+			bValid = (bool)(stream >> name);
+			if (bValid)
+			{
+				currentSection = AddSection(name);
+				bValid = (currentSection >= 0);
+			}
+		}
+		else if (keyword == "node")
+		{
+			SCENE_NODE node = {};
+			std::string name;
+
+			bValid = (stream >> name
+				>> node.scaleXYZ.x >> node.scaleXYZ.y >> node.scaleXYZ.z
+				>> node.rotationDegrees.x >> node.rotationDegrees.y >> node.rotationDegrees.z
+				>> node.positionXYZ.x >> node.positionXYZ.y >> node.positionXYZ.z) &&
+				CopyName(node.name, MAX_TAG_LENGTH, name);
+			if (bValid)
+			{
+				node.parent = currentNode;
+				m_nodes.push_back(node);
+				currentNode = (int)m_nodes.size() - 1;
+			}
+		}
+		else if (keyword == "end")
+		{
+			bValid = (currentNode >= 0);
+			if (bValid)
+			{
+				currentNode = m_nodes[currentNode].parent;
+			}
+		}
+		else if ((keyword == "item") || (keyword == "color"))
+		{
+			SCENE_ITEM item = {};
+			std::string meshName;
+			std::string variantName;
+
+			item.color = glm::vec4(1.0f);
+			item.texture = -1;
+			item.material = -1;
+			item.node = currentNode;
+			item.variant = SceneManager::DRAW_ALL;
+
+			bValid = (stream >> meshName) && ParseMesh(meshName, item.mesh);
+			if (bValid && (keyword == "item"))
+			{
+				std::string textureTag;
+				std::string materialTag;
+
+				bValid = (bool)(stream >> textureTag >> materialTag);
+				if (bValid && (textureTag != "-"))
+				{
+					item.texture = FindTexture(textureTag);
+					bValid = (item.texture >= 0);
+				}
+				if (bValid && (materialTag != "-"))
+				{
+					item.material = FindMaterial(materialTag);
+					bValid = (item.material >= 0);
+				}
+			}
+			else if (bValid)
+			{
+				bValid = (bool)(stream >> item.color.x >> item.color.y >> item.color.z >> item.color.w);
+			}
+
+			bValid = bValid && (stream
+				>> item.uvScale.x >> item.uvScale.y
+				>> item.scaleXYZ.x >> item.scaleXYZ.y >> item.scaleXYZ.z
+				>> item.rotationDegrees.x >> item.rotationDegrees.y >> item.rotationDegrees.z
+				>> item.positionXYZ.x >> item.positionXYZ.y >> item.positionXYZ.z);
+			if (bValid && (stream >> variantName))
+			{
+				bValid = ParseVariant(variantName, item.variant);
+			}
+
+			// items before the first section go into a default one
+			if (bValid && (currentSection < 0))
+			{
+				currentSection = AddSection("scene");
+				bValid = (currentSection >= 0);
+			}
+			if (bValid)
+			{
+				item.section = (uint8_t)currentSection;
+				m_items.push_back(item);
+			}
+		}
+
+		if (false == bValid)
+		{
+			std::cout << "Invalid scene entry in " << filename << " line " << lineNumber << ": " << line << std::endl;
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  UseParsedArrays()
+ *
+ *  This method is used for pointing the arrays in use at
+ *  the vectors filled from the text file.
+ ***********************************************************/
+void SceneFile::UseParsedArrays()
+{
+	m_textureCount = (int)m_textures.size();
+	m_pTextures = m_textures.empty() ? NULL : &m_textures[0];
+	m_materialCount = (int)m_materials.size();
+	m_pMaterials = m_materials.empty() ? NULL : &m_materials[0];
+	m_sectionCount = (int)m_sections.size();
+	m_pSections = m_sections.empty() ? NULL : &m_sections[0];
+	m_nodeCount = (int)m_nodes.size();
+	m_pNodes = m_nodes.empty() ? NULL : &m_nodes[0];
+	m_itemCount = (int)m_items.size();
+	m_pItems = m_items.empty() ? NULL : &m_items[0];
+}
+
+/***********************************************************
+ *  WriteCache()
+ *
+ *  This method is used for writing the parsed arrays into
+ *  the binary cache, each one at an aligned offset after
+ *  the header.
+ ***********************************************************/
+bool SceneFile::WriteCache(const std::string& filename, uint32_t sourceSize, uint32_t sourceHash) const
+{
+	CACHE_HEADER header;
+
+	header.magic = CACHE_MAGIC;
+	header.version = CACHE_VERSION;
+	header.sourceSize = sourceSize;
+	header.sourceHash = sourceHash;
+	header.textureCount = (uint32_t)m_textures.size();
+	header.textureOffset = AlignOffset(sizeof(CACHE_HEADER));
+	header.materialCount = (uint32_t)m_materials.size();
+	header.materialOffset = AlignOffset(header.textureOffset + m_textures.size() * sizeof(SCENE_TEXTURE));
+	header.sectionCount = (uint32_t)m_sections.size();
+	header.sectionOffset = AlignOffset(header.materialOffset + m_materials.size() * sizeof(SCENE_MATERIAL));
+	header.nodeCount = (uint32_t)m_nodes.size();
+	header.nodeOffset = AlignOffset(header.sectionOffset + m_sections.size() * sizeof(SCENE_SECTION));
+	header.itemCount = (uint32_t)m_items.size();
+	header.itemOffset = AlignOffset(header.nodeOffset + m_nodes.size() * sizeof(SCENE_NODE));
+
+	std::vector<unsigned char> data(header.itemOffset + m_items.size() * sizeof(SCENE_ITEM), 0);
+	memcpy(&data[0], &header, sizeof(header));
+	if (!m_textures.empty())
+	{
+		memcpy(&data[header.textureOffset], &m_textures[0], m_textures.size() * sizeof(SCENE_TEXTURE));
+	}
+	if (!m_materials.empty())
+	{
+		memcpy(&data[header.materialOffset], &m_materials[0], m_materials.size() * sizeof(SCENE_MATERIAL));
+	}
+	if (!m_sections.empty())
+	{
+		memcpy(&data[header.sectionOffset], &m_sections[0], m_sections.size() * sizeof(SCENE_SECTION));
+	}
+	if (!m_nodes.empty())
+	{
+		memcpy(&data[header.nodeOffset], &m_nodes[0], m_nodes.size() * sizeof(SCENE_NODE));
+	}
+	if (!m_items.empty())
+	{
+		memcpy(&data[header.itemOffset], &m_items[0], m_items.size() * sizeof(SCENE_ITEM));
+	}
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		std::cout << "Could not open scene cache for writing:" << filename << std::endl;
+		return(false);
+	}
+
+	file.write((const char*)&data[0], (std::streamsize)data.size());
+	file.close();
+	bool bWritten = !file.fail();
+
+	if (false == bWritten)
+	{
+		remove(filename.c_str());
+	}
+
+	return(bWritten);
+}
+
+/***********************************************************
+ *  MapCache()
+ *
+ *  This method is used for mapping the binary cache and
+ *  pointing the arrays in use into the mapped view.  The
+ *  cache is only used when it was written from text of the
+ *  same size and hash, every array fits in the file and
+ *  every index of the arrays is inside the array it refers
+ *  to.  A cache that fails a check is rebuilt from the text.
+ ***********************************************************/
+bool SceneFile::MapCache(const std::string& filename, uint32_t sourceSize, uint32_t sourceHash)
+{
+	if (false == MapFile(filename))
+	{
+		return(false);
+	}
+
+	CACHE_HEADER header;
+	bool bValid = (m_mappingSize >= sizeof(CACHE_HEADER));
+	if (bValid)
+	{
+		memcpy(&header, m_pMapping, sizeof(header));
+		bValid = (header.magic == CACHE_MAGIC) &&
+			(header.version == CACHE_VERSION) &&
+			(header.sourceSize == sourceSize) &&
+			(header.sourceHash == sourceHash) &&
+			(header.textureOffset + (size_t)header.textureCount * sizeof(SCENE_TEXTURE) <= m_mappingSize) &&
+			(header.materialOffset + (size_t)header.materialCount * sizeof(SCENE_MATERIAL) <= m_mappingSize) &&
+			(header.sectionOffset + (size_t)header.sectionCount * sizeof(SCENE_SECTION) <= m_mappingSize) &&
+			(header.nodeOffset + (size_t)header.nodeCount * sizeof(SCENE_NODE) <= m_mappingSize) &&
+			(header.itemOffset + (size_t)header.itemCount * sizeof(SCENE_ITEM) <= m_mappingSize);
+	}
+	if (false == bValid)
+	{
+		UnmapFile();
+		return(false);
+	}
+
+	m_textureCount = (int)header.textureCount;
+	m_pTextures = (const SCENE_TEXTURE*)(m_pMapping + header.textureOffset);
+	m_materialCount = (int)header.materialCount;
+	m_pMaterials = (const SCENE_MATERIAL*)(m_pMapping + header.materialOffset);
+	m_sectionCount = (int)header.sectionCount;
+	m_pSections = (const SCENE_SECTION*)(m_pMapping + header.sectionOffset);
+	m_nodeCount = (int)header.nodeCount;
+	m_pNodes = (const SCENE_NODE*)(m_pMapping + header.nodeOffset);
+	m_itemCount = (int)header.itemCount;
+	m_pItems = (const SCENE_ITEM*)(m_pMapping + header.itemOffset);
+
+	if (false == AreIndicesValid())
+	{
+		std::cout << "Scene cache indices are out of range, rebuilding:" << filename << std::endl;
+		Clear();
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  AreIndicesValid()
+ *
+ *  This method is used for checking that each node parent
+ *  comes before its node, and that the mesh, section,
+ *  texture, material and node of each item are inside the
+ *  arrays in use.
+ ***********************************************************/
+bool SceneFile::AreIndicesValid() const
+{
+	for (int i = 0; i < m_nodeCount; i++)
+	{
+		if ((m_pNodes[i].parent < -1) || (m_pNodes[i].parent >= i))
+		{
+			return(false);
+		}
+	}
+
+	for (int i = 0; i < m_itemCount; i++)
+	{
+		const SCENE_ITEM& item = m_pItems[i];
+
+		if ((item.mesh >= MESH_NAME_COUNT) ||
+			(item.section >= m_sectionCount) ||
+			(item.texture < -1) || (item.texture >= m_textureCount) ||
+			(item.material < -1) || (item.material >= m_materialCount) ||
+			(item.node < -1) || (item.node >= m_nodeCount))
+		{
+			return(false);
+		}
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  MapFile()
+ *
+ *  This method is used for mapping a whole file into memory
+ *  for reading.
+ ***********************************************************/
+bool SceneFile::MapFile(const std::string& filename)
+{
+	UnmapFile();
+
+#ifdef _WIN32
+	HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (INVALID_HANDLE_VALUE == file)
+	{
+		return(false);
+	}
+
+	LARGE_INTEGER size;
+	if ((FALSE == GetFileSizeEx(file, &size)) || (size.QuadPart <= 0))
+	{
+		CloseHandle(file);
+		return(false);
+	}
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (NULL == mapping)
+	{
+		CloseHandle(file);
+		return(false);
+	}
+
+	void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+	if (NULL == view)
+	{
+		CloseHandle(mapping);
+		CloseHandle(file);
+		return(false);
+	}
+
+	m_fileHandle = file;
+	m_mappingHandle = mapping;
+	m_pMapping = (const unsigned char*)view;
+	m_mappingSize = (size_t)size.QuadPart;
+#else
+	int file = open(filename.c_str(), O_RDONLY);
+	if (file < 0)
+	{
+		return(false);
+	}
+
+	struct stat status;
+	if ((0 != fstat(file, &status)) || (status.st_size <= 0))
+	{
+		close(file);
+		return(false);
+	}
+
+	void* view = mmap(NULL, (size_t)status.st_size, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (MAP_FAILED == view)
+	{
+		return(false);
+	}
+
+	m_pMapping = (const unsigned char*)view;
+	m_mappingSize = (size_t)status.st_size;
+#endif
+
+	return(true);
+}
+
+/***********************************************************
+ *  UnmapFile()
+ *
+ *  This method is used for unmapping the mapped file.
+ ***********************************************************/
+void SceneFile::UnmapFile()
+{
+	if (NULL == m_pMapping)
+	{
+		return;
+	}
+
+#ifdef _WIN32
+	UnmapViewOfFile(m_pMapping);
+	CloseHandle((HANDLE)m_mappingHandle);
+	CloseHandle((HANDLE)m_fileHandle);
+#else
+	munmap((void*)m_pMapping, m_mappingSize);
+#endif
+
+	m_pMapping = NULL;
+	m_mappingSize = 0;
+	m_fileHandle = NULL;
+	m_mappingHandle = NULL;
+}
+
+/***********************************************************
+ *  FindTexture()
+ *
+ *  This method is used for finding the index of a parsed
+ *  texture by its tag.
+ ***********************************************************/
+int SceneFile::FindTexture(const std::string& tag) const
+{
+	for (int i = 0; i < (int)m_textures.size(); i++)
+	{
+		if (tag == m_textures[i].tag)
+		{
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  FindMaterial()
+ *
+ *  This method is used for finding the index of a parsed
+ *  material by its tag.
+ ***********************************************************/
+int SceneFile::FindMaterial(const std::string& tag) const
+{
+	for (int i = 0; i < (int)m_materials.size(); i++)
+	{
+		if (tag == m_materials[i].tag)
+		{
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  AddSection()
+ *
+ *  This method is used for getting the index of a section,
+ *  adding it when it is new.  A section can be started
+ *  again later in the file.
+ ***********************************************************/
+int SceneFile::AddSection(const std::string& name)
+{
+	for (int i = 0; i < (int)m_sections.size(); i++)
+	{
+		if (name == m_sections[i].name)
+		{
+			return(i);
+		}
+	}
+
+	// the draw items keep their section in a byte
+	SCENE_SECTION section = {};
+	if ((m_sections.size() > 0xFF) || (false == CopyName(section.name, MAX_TAG_LENGTH, name)))
+	{
+		return(-1);
+	}
+
+	m_sections.push_back(section);
+
+	return((int)m_sections.size() - 1);
+}
+
+/***********************************************************
+ *  ReadFile()
+ *
+ *  This method is used for reading a whole file.
+ ***********************************************************/
+bool SceneFile::ReadFile(const std::string& filename, std::string& contents)
+{
+	std::ifstream file(filename, std::ios::binary);
+	std::stringstream buffer;
+
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	buffer << file.rdbuf();
+	contents = buffer.str();
+
+	return(true);
+}
+
+/***********************************************************
+ *  HashText()
+ *
+ *  This method is used for hashing the text of the scene
+ *  file with 32 bit FNV-1a.
+ ***********************************************************/
+uint32_t SceneFile::HashText(const std::string& text)
+{
+	uint32_t hash = 2166136261u;
+
+	for (size_t i = 0; i < text.size(); i++)
+	{
+		hash ^= (unsigned char)text[i];
+		hash *= 16777619u;
+	}
+
+	return(hash);
+}
+
+/***********************************************************
+ *  CopyName()
+ *
+ *  This method is used for copying a tag or file name into
+ *  a fixed size array, leaving room for the terminator.
+ ***********************************************************/
+bool SceneFile::CopyName(char* destination, int capacity, const std::string& source)
+{
+	if ((int)source.size() >= capacity)
+	{
+		return(false);
+	}
+
+	memcpy(destination, source.c_str(), source.size() + 1);
+
+	return(true);
+}
+
+/***********************************************************
+ *  ParseMesh()
+ *
+ *  This method is used for getting the mesh type of a mesh
+ *  name in the text file.
+ ***********************************************************/
+bool SceneFile::ParseMesh(const std::string& name, uint8_t& mesh)
+{
+	for (int i = 0; i < MESH_NAME_COUNT; i++)
+	{
+		if (name == g_MeshNames[i])
+		{
+			mesh = (uint8_t)i;
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  ParseVariant()
+ *
+ *  This method is used for getting the mesh parts of a
+ *  variant in the text file, either all or the parts joined
+ *  with '+'.
+ ***********************************************************/
+bool SceneFile::ParseVariant(const std::string& name, uint8_t& variant)
+{
+	std::istringstream stream(name);
+	std::string part;
+
+	variant = 0;
+	while (std::getline(stream, part, '+'))
+	{
+		if (part == "all")
+		{
+			variant |= SceneManager::DRAW_ALL;
+		}
+		else if (part == "top")
+		{
+			variant |= SceneManager::DRAW_TOP;
+		}
+		else if (part == "bottom")
+		{
+			variant |= SceneManager::DRAW_BOTTOM;
+		}
+		else if (part == "sides")
+		{
+			variant |= SceneManager::DRAW_SIDES;
+		}
+		else
+		{
+			return(false);
+		}
+	}
+
+	return(0 != variant);
+}
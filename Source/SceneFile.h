@@ -0,0 +1,213 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenefile.h
+// ============
+// scene description file with a memory mapped binary cache
+//
+//  The text file holds one entry per line, blank lines and lines starting
+//  with '#' are skipped:
+//    texture   tag  filename
+//    material  tag  ambientR G B  ambientStrength  diffuseR G B
+//              specularR G B  shininess
+//    section   name
+//    node      name  scaleX Y Z  rotationX Y Z  positionX Y Z
+//    end
+//    item      mesh  textureTag  materialTag  u v  scaleX Y Z
+//              rotationX Y Z  positionX Y Z  [variant]
+//    color     mesh  red green blue alpha  u v  scaleX Y Z
+//              rotationX Y Z  positionX Y Z  [variant]
+//
+//  The meshes are plane, box, cylinder, tapered_cylinder, sphere,
+//  half_sphere, torus and half_torus.  A tag of '-' leaves the texture or
+//  the material unset, and the variant is all, or the mesh parts top,
+//  bottom and sides joined with '+'.  The items belong to the last section.
+//  A node line starts a transform node under the open node, and the items
+//  up to its end line are placed relative to it.
+//
+//  The parsed scene is written next to the text file as flat arrays, which
+//  are used straight from the mapped file on the next run.  The cache holds
+//  the size and hash of the text, and is written again once they differ.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneFile
+ *
+ *  This class contains the code for reading the textures,
+ *  materials and draw items of a scene from a text file,
+ *  and for saving them to and mapping them from the binary
+ *  cache of the file.
+ ***********************************************************/
+class SceneFile
+{
+public:
+	// constructor
+	SceneFile();
+	// destructor
+	~SceneFile();
+
+	// longest tag and file name stored in the flat arrays
+	static const int MAX_TAG_LENGTH = 32;
+	static const int MAX_FILENAME_LENGTH = 128;
+
+	// a texture of the scene, loaded under its tag
+	struct SCENE_TEXTURE
+	{
+		char tag[MAX_TAG_LENGTH];
+		char filename[MAX_FILENAME_LENGTH];
+	};
+
+	// a material of the scene, with the MaterialBlock values
+	struct SCENE_MATERIAL
+	{
+		char tag[MAX_TAG_LENGTH];
+		glm::vec3 ambientColor;
+		float ambientStrength;
+		glm::vec3 diffuseColor;
+		glm::vec3 specularColor;
+		float shininess;
+	};
+
+	// a named section of the scene
+	struct SCENE_SECTION
+	{
+		char name[MAX_TAG_LENGTH];
+	};
+
+	// a transform node of the scene, stored after its parent
+	struct SCENE_NODE
+	{
+		char name[MAX_TAG_LENGTH];
+		glm::vec3 scaleXYZ;
+		glm::vec3 rotationDegrees;
+		glm::vec3 positionXYZ;
+		int32_t parent;			// -1 is placed under the scene root
+	};
+
+	// one draw item, referring to the other arrays by index
+	struct SCENE_ITEM
+	{
+		glm::vec3 scaleXYZ;
+		glm::vec3 rotationDegrees;
+		glm::vec3 positionXYZ;
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		int32_t texture;		// -1 draws with the solid color
+		int32_t material;		// -1 keeps the current material
+		int32_t node;			// -1 is placed under the scene root
+		uint8_t mesh;			// SceneManager::MESH_TYPE
+		uint8_t variant;		// SceneManager::DRAW_VARIANT bits
+		uint8_t section;
+		uint8_t pad0;
+	};
+
+	// read the scene from its binary cache when it is up to date,
+	// otherwise from the text file, writing a new cache
+	bool Load(const std::string& filename);
+	// free the scene and unmap its cache
+	void Clear();
+	// check if a scene has been loaded
+	bool IsLoaded() const { return m_bLoaded; }
+	// check if the scene has been read from the mapped cache
+	bool IsMapped() const { return (NULL != m_pMapping); }
+
+	// get the arrays of the scene, which point into the mapped
+	// cache when the scene was read from it
+	int GetTextureCount() const { return m_textureCount; }
+	const SCENE_TEXTURE* GetTextures() const { return m_pTextures; }
+	int GetMaterialCount() const { return m_materialCount; }
+	const SCENE_MATERIAL* GetMaterials() const { return m_pMaterials; }
+	int GetSectionCount() const { return m_sectionCount; }
+	const SCENE_SECTION* GetSections() const { return m_pSections; }
+	int GetNodeCount() const { return m_nodeCount; }
+	const SCENE_NODE* GetNodes() const { return m_pNodes; }
+	int GetItemCount() const { return m_itemCount; }
+	const SCENE_ITEM* GetItems() const { return m_pItems; }
+
+	// get the name of the binary cache of a scene file
+	static std::string GetCacheFilename(const std::string& filename);
+
+private:
+	// layout of the start of the binary cache, the arrays follow
+	// at the stored offsets in the native byte order
+	struct CACHE_HEADER
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t sourceSize;
+		uint32_t sourceHash;
+		uint32_t textureCount;
+		uint32_t textureOffset;
+		uint32_t materialCount;
+		uint32_t materialOffset;
+		uint32_t sectionCount;
+		uint32_t sectionOffset;
+		uint32_t nodeCount;
+		uint32_t nodeOffset;
+		uint32_t itemCount;
+		uint32_t itemOffset;
+	};
+
+	bool m_bLoaded;
+
+	// arrays read from the text file
+	std::vector<SCENE_TEXTURE> m_textures;
+	std::vector<SCENE_MATERIAL> m_materials;
+	std::vector<SCENE_SECTION> m_sections;
+	std::vector<SCENE_NODE> m_nodes;
+	std::vector<SCENE_ITEM> m_items;
+
+	// arrays in use, in the vectors above or in the mapped cache
+	int m_textureCount;
+	const SCENE_TEXTURE* m_pTextures;
+	int m_materialCount;
+	const SCENE_MATERIAL* m_pMaterials;
+	int m_sectionCount;
+	const SCENE_SECTION* m_pSections;
+	int m_nodeCount;
+	const SCENE_NODE* m_pNodes;
+	int m_itemCount;
+	const SCENE_ITEM* m_pItems;
+
+	// mapped view of the cache file and the handles keeping it open
+	const unsigned char* m_pMapping;
+	size_t m_mappingSize;
+	void* m_fileHandle;
+	void* m_mappingHandle;
+
+	// parse the lines of the text file
+	bool ParseText(const std::string& text, const std::string& filename);
+	// point the arrays in use at the parsed vectors
+	void UseParsedArrays();
+	// write the parsed arrays into the binary cache
+	bool WriteCache(const std::string& filename, uint32_t sourceSize, uint32_t sourceHash) const;
+	// map the binary cache and point the arrays in use into it,
+	// false when the cache is missing or out of date
+	bool MapCache(const std::string& filename, uint32_t sourceSize, uint32_t sourceHash);
+	// check the indices of the arrays in use against their counts
+	bool AreIndicesValid() const;
+	// map and unmap a whole file for reading
+	bool MapFile(const std::string& filename);
+	void UnmapFile();
+
+	// find the index of a tag in the parsed arrays, or add a section
+	int FindTexture(const std::string& tag) const;
+	int FindMaterial(const std::string& tag) const;
+	int AddSection(const std::string& name);
+
+	// read a whole file into a string
+	static bool ReadFile(const std::string& filename, std::string& contents);
+	// FNV-1a hash of the text, to detect a changed file of the same size
+	static uint32_t HashText(const std::string& text);
+	// copy a string into a fixed size array, false when it is too long
+	static bool CopyName(char* destination, int capacity, const std::string& source);
+	// parse the mesh name and the variant of an item
+	static bool ParseMesh(const std::string& name, uint8_t& mesh);
+	static bool ParseVariant(const std::string& name, uint8_t& variant);
+};
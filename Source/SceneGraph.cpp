@@ -0,0 +1,267 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.cpp
+// ============
+// parent and child transform nodes that the draw items are placed under
+///////////////////////////////////////////////////////////////////////////////
+
+#include "SceneGraph.h"
+
+#include <algorithm>
+
+/***********************************************************
+ *  SceneGraph()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+SceneGraph::SceneGraph()
+{
+	m_bMatricesDirty = false;
+	m_bBoundsDirty = false;
+
+	Clear();
+}
+
+/***********************************************************
+ *  Clear()
+ *
+ *  This method is used for removing every node except for
+ *  the root, which is left without any items.
+ ***********************************************************/
+void SceneGraph::Clear()
+{
+	SCENE_NODE root;
+
+	root.name = "scene";
+	root.localMatrix = glm::mat4(1.0f);
+	root.worldMatrix = glm::mat4(1.0f);
+	root.bounds.minCorner = glm::vec3(0.0f);
+	root.bounds.maxCorner = glm::vec3(0.0f);
+	root.parent = -1;
+	root.bMatrixDirty = false;
+	root.bBoundsDirty = false;
+	root.bEmpty = true;
+
+	m_nodes.clear();
+	m_nodes.push_back(root);
+	m_bMatricesDirty = false;
+	m_bBoundsDirty = false;
+}
+
+/***********************************************************
+ *  AddNode()
+ *
+ *  This method is used for adding a node under an existing
+ *  parent.  Its world matrix is computed right away, so the
+ *  items added under it can be placed with it.
+ ***********************************************************/
+int SceneGraph::AddNode(const std::string& name, int parent, const glm::mat4& localMatrix)
+{
+	SCENE_NODE node;
+
+	if ((parent < 0) || (parent >= (int)m_nodes.size()))
+	{
+		parent = ROOT_NODE;
+	}
+
+	node.name = name;
+	node.localMatrix = localMatrix;
+	node.worldMatrix = m_nodes[parent].worldMatrix * localMatrix;
+	node.bounds.minCorner = glm::vec3(0.0f);
+	node.bounds.maxCorner = glm::vec3(0.0f);
+	node.parent = parent;
+	node.bMatrixDirty = false;
+	node.bBoundsDirty = true;
+	node.bEmpty = true;
+
+	m_nodes.push_back(node);
+	m_nodes[parent].children.push_back((int)m_nodes.size() - 1);
+	// the boxes above the new node have to take it in as well
+	SetBoundsDirty((int)m_nodes.size() - 1);
+
+	return((int)m_nodes.size() - 1);
+}
+
+/***********************************************************
+ *  FindNode()
+ *
+ *  This method is used for finding the first node with the
+ *  passed in name.
+ ***********************************************************/
+int SceneGraph::FindNode(const std::string& name) const
+{
+	for (int i = 0; i < (int)m_nodes.size(); i++)
+	{
+		if (m_nodes[i].name == name)
+		{
+			return(i);
+		}
+	}
+
+	return(-1);
+}
+
+/***********************************************************
+ *  AttachItem()
+ *
+ *  This method is used for placing a draw item under a node.
+ ***********************************************************/
+void SceneGraph::AttachItem(int node, int itemIndex)
+{
+	m_nodes[node].items.push_back(itemIndex);
+	SetBoundsDirty(node);
+}
+
+/***********************************************************
+ *  SetLocalMatrix()
+ *
+ *  This method is used for changing the local matrix of a
+ *  node.  Only the node is marked here, the nodes below it
+ *  are found when the world matrices are updated.
+ ***********************************************************/
+void SceneGraph::SetLocalMatrix(int node, const glm::mat4& localMatrix)
+{
+	if ((node <= ROOT_NODE) || (node >= (int)m_nodes.size()))
+	{
+		return;
+	}
+
+	m_nodes[node].localMatrix = localMatrix;
+	m_nodes[node].bMatrixDirty = true;
+	m_bMatricesDirty = true;
+}
+
+/***********************************************************
+ *  SetBoundsDirty()
+ *
+ *  This method is used for marking the box of a node and of
+ *  the nodes above it as changed.  The walk stops at an
+ *  ancestor that is already marked, as its parents are as
+ *  well, but the passed in node itself may be marked before
+ *  its parents are, such as a node that was just added.
+ ***********************************************************/
+void SceneGraph::SetBoundsDirty(int node)
+{
+	m_nodes[node].bBoundsDirty = true;
+	node = m_nodes[node].parent;
+	while ((node >= 0) && (false == m_nodes[node].bBoundsDirty))
+	{
+		m_nodes[node].bBoundsDirty = true;
+		node = m_nodes[node].parent;
+	}
+	m_bBoundsDirty = true;
+}
+
+/***********************************************************
+ *  UpdateWorldMatrices()
+ *
+ *  This method is used for computing the world matrices of
+ *  the changed nodes and of the nodes below them.  Each
+ *  parent is stored before its children, so a single pass
+ *  in order sees the new parent matrix first.
+ ***********************************************************/
+int SceneGraph::UpdateWorldMatrices(std::vector<int>& movedItems)
+{
+	int updatedNodes = 0;
+
+	if (false == m_bMatricesDirty)
+	{
+		return(0);
+	}
+
+	std::vector<uint8_t> moved(m_nodes.size(), 0);
+	for (int i = 1; i < (int)m_nodes.size(); i++)
+	{
+		SCENE_NODE& node = m_nodes[i];
+
+		if (node.bMatrixDirty || (0 != moved[node.parent]))
+		{
+			node.worldMatrix = m_nodes[node.parent].worldMatrix * node.localMatrix;
+			node.bMatrixDirty = false;
+			moved[i] = 1;
+			movedItems.insert(movedItems.end(), node.items.begin(), node.items.end());
+			updatedNodes++;
+		}
+	}
+	m_bMatricesDirty = false;
+
+	return(updatedNodes);
+}
+
+/***********************************************************
+ *  UpdateBounds()
+ *
+ *  This method is used for computing the boxes of the
+ *  changed nodes.  The nodes are visited from the last to
+ *  the first, so the boxes of the children are up to date
+ *  before the box of their parent is built from them.
+ ***********************************************************/
+void SceneGraph::UpdateBounds(const std::vector<SceneBVH::BOUNDING_BOX>& itemBounds)
+{
+	if (false == m_bBoundsDirty)
+	{
+		return;
+	}
+
+	for (int i = (int)m_nodes.size() - 1; i >= 0; i--)
+	{
+		SCENE_NODE& node = m_nodes[i];
+
+		if (false == node.bBoundsDirty)
+		{
+			continue;
+		}
+
+		node.bEmpty = true;
+		for (int itemIndex : node.items)
+		{
+			const SceneBVH::BOUNDING_BOX& box = itemBounds[itemIndex];
+			node.bounds.minCorner = node.bEmpty ? box.minCorner : glm::min(node.bounds.minCorner, box.minCorner);
+			node.bounds.maxCorner = node.bEmpty ? box.maxCorner : glm::max(node.bounds.maxCorner, box.maxCorner);
+			node.bEmpty = false;
+		}
+		for (int child : node.children)
+		{
+			const SCENE_NODE& childNode = m_nodes[child];
+			if (false == childNode.bEmpty)
+			{
+				node.bounds.minCorner = node.bEmpty ? childNode.bounds.minCorner : glm::min(node.bounds.minCorner, childNode.bounds.minCorner);
+				node.bounds.maxCorner = node.bEmpty ? childNode.bounds.maxCorner : glm::max(node.bounds.maxCorner, childNode.bounds.maxCorner);
+				node.bEmpty = false;
+			}
+		}
+		node.bBoundsDirty = false;
+	}
+	m_bBoundsDirty = false;
+}
+
+/***********************************************************
+ *  CullNodes()
+ *
+ *  This method is used for testing the node boxes against
+ *  the frustum from the root down.  A node is visible when
+ *  its parent is visible and its box is at least partly in
+ *  the frustum.  The root holds the whole scene and is not
+ *  tested, so the items placed straight under it are always
+ *  left to their own test.
+ ***********************************************************/
+int SceneGraph::CullNodes(const SceneBVH::FRUSTUM& frustum, std::vector<uint8_t>& nodeVisible) const
+{
+	int testedNodes = 0;
+
+	nodeVisible.assign(m_nodes.size(), 0);
+	nodeVisible[ROOT_NODE] = 1;
+	for (int i = 1; i < (int)m_nodes.size(); i++)
+	{
+		const SCENE_NODE& node = m_nodes[i];
+
+		if ((0 == nodeVisible[node.parent]) || node.bEmpty)
+		{
+			continue;
+		}
+
+		nodeVisible[i] = SceneBVH::IsBoxVisible(frustum, node.bounds) ? 1 : 0;
+		testedNodes++;
+	}
+
+	return(testedNodes);
+}
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+// scenegraph.h
+// ============
+// parent and child transform nodes that the draw items are placed under
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "SceneBVH.h"
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  SceneGraph
+ *
+ *  This class contains the code for a hierarchy of transform
+ *  nodes.  The node world matrices are cached, and only the
+ *  nodes below a changed local matrix are computed again.
+ *  Each node also keeps the box around its items and its
+ *  child nodes, so a whole composite can be culled with one
+ *  test.  The nodes are stored with every parent before its
+ *  children, and node 0 is the root of the scene.
+ ***********************************************************/
+class SceneGraph
+{
+public:
+	// constructor
+	SceneGraph();
+
+	// the node that holds the whole scene
+	static const int ROOT_NODE = 0;
+
+	// remove every node except for the root
+	void Clear();
+	// add a node under an existing parent, returns its index
+	int AddNode(const std::string& name, int parent, const glm::mat4& localMatrix);
+	// find a node by its name, -1 when there is none
+	int FindNode(const std::string& name) const;
+	// place a draw item under a node
+	void AttachItem(int node, int itemIndex);
+
+	// change the local matrix of a node, the world matrices of the
+	// node and the nodes below it are computed on the next update
+	void SetLocalMatrix(int node, const glm::mat4& localMatrix);
+	// mark the box of a node as changed after one of its items moved
+	void SetBoundsDirty(int node);
+
+	// compute the world matrices of the changed nodes and the nodes
+	// below them, the items of those nodes are appended
+	int UpdateWorldMatrices(std::vector<int>& movedItems);
+	// compute the boxes of the changed nodes from the passed in item
+	// boxes and the boxes of their child nodes
+	void UpdateBounds(const std::vector<SceneBVH::BOUNDING_BOX>& itemBounds);
+	// set nodeVisible[i] for each node by the frustum, the nodes
+	// below a node outside of the frustum are not tested - returns
+	// the number of tested nodes
+	int CullNodes(const SceneBVH::FRUSTUM& frustum, std::vector<uint8_t>& nodeVisible) const;
+
+	// get the values of a node
+	int GetNodeCount() const { return (int)m_nodes.size(); }
+	int GetParent(int node) const { return m_nodes[node].parent; }
+	const glm::mat4& GetLocalMatrix(int node) const { return m_nodes[node].localMatrix; }
+	const glm::mat4& GetWorldMatrix(int node) const { return m_nodes[node].worldMatrix; }
+	const SceneBVH::BOUNDING_BOX& GetBounds(int node) const { return m_nodes[node].bounds; }
+
+private:
+	// one transform node with its cached world matrix and box
+	struct SCENE_NODE
+	{
+		std::string name;
+		glm::mat4 localMatrix;
+		glm::mat4 worldMatrix;
+		SceneBVH::BOUNDING_BOX bounds;
+		int parent;			// -1 for the root
+		bool bMatrixDirty;		// the local matrix has changed
+		bool bBoundsDirty;		// an item or a child node has moved
+		bool bEmpty;			// no items below the node
+		std::vector<int> children;
+		std::vector<int> items;
+	};
+
+	std::vector<SCENE_NODE> m_nodes;
+	// set when any node has a changed local matrix
+	bool m_bMatricesDirty;
+	// set when any node has a changed box
+	bool m_bBoundsDirty;
+};
@@ -8,6 +8,7 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include "SceneManager.h"
+#include "GpuResources.h"
 
 #ifndef STB_IMAGE_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -15,15 +16,87 @@
 #endif
 
 #include <glm/gtx/transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <cfloat>
+#include <climits>
+#include <cmath>
+#include <iostream>
 
 // declaration of global variables
 namespace
 {
-	const char* g_ModelName = "model";
-	const char* g_ColorValueName = "objectColor";
-	const char* g_TextureValueName = "objectTexture";
-	const char* g_UseTextureName = "bUseTexture";
-	const char* g_UseLightingName = "bUseLighting";
+	constexpr UniformID g_UseLightingName("bUseLighting");
+	constexpr UniformID g_MaterialBlockName("MaterialBlock");
+	constexpr UniformID g_CameraBlockName("CameraBlock");
+	constexpr UniformID g_ObjectBlockName("ObjectBlock");
+	constexpr UniformID g_DrawDataName("drawData");
+	constexpr UniformID g_MaterialDataName("materialData");
+	constexpr UniformID g_ShadowBlockName("ShadowBlock");
+	constexpr UniformID g_ShadowAtlasName("shadowAtlas");
+	const char* g_CullComputeFile = "shaders/cullCompute.glsl";
+	const char* g_DepthVertexShaderFile = "shaders/depthVertexShader.glsl";
+	const char* g_DepthFragmentShaderFile = "shaders/depthFragmentShader.glsl";
+
+	// fewest repeated draw items that are worth an instanced draw
+	const int MIN_INSTANCE_BATCH = 2;
+
+	// tessellation of the curved meshes at each level of detail
+	const int LOD_SLICES[MeshLibrary::MAX_LOD_LEVELS] = { 36, 18, 10, 6 };
+	const int LOD_STACKS[MeshLibrary::MAX_LOD_LEVELS] = { 18, 9, 5, 3 };
+	const int LOD_TORUS_RINGS[MeshLibrary::MAX_LOD_LEVELS] = { 36, 18, 10, 6 };
+	const int LOD_TORUS_SIDES[MeshLibrary::MAX_LOD_LEVELS] = { 12, 8, 6, 4 };
+	// smallest screen size that an item keeps each level at, as the
+	// part of half of the view height its detail size covers, the
+	// coarsest level has no limit
+	const float LOD_SCREEN_SIZES[MeshLibrary::MAX_LOD_LEVELS - 1] = { 0.25f, 0.08f, 0.02f };
+	// how far past a switch point the screen size has to be before the
+	// level changes, so an item on the edge does not switch every frame
+	const float LOD_HYSTERESIS = 0.2f;
+
+	// distance between the tiles of the stress scene grid, and the
+	// half size of the desk area that is kept free of tiles
+	const float STRESS_TILE_SPACING = 2.0f;
+	const float STRESS_DESK_CLEARANCE = 2.5f;
+
+	// draw items in each chunk of the parallel loops, and the fewest
+	// items that are tested without the hierarchy while they move
+	const int PARALLEL_CHUNK_ITEMS = 256;
+	const int PARALLEL_CULL_MIN_ITEMS = 2048;
+
+	// starting size of each frame of the uniform ring buffer, room
+	// for a few thousand object blocks, it is grown when a frame
+	// needs more
+	const GLsizeiptr UNIFORM_RING_FRAME_SIZE = 1024 * 1024;
+
+	// smallest half size of the box the directional shadow map covers
+	const float SHADOW_MIN_RADIUS = 1.0f;
+	// depth range of the flashlight shadow map, past the far plane the
+	// flashlight has faded out
+	const float FLASHLIGHT_SHADOW_NEAR = 0.05f;
+	const float FLASHLIGHT_SHADOW_FAR = 30.0f;
+	// depth bias of the shadow lookups, in the depth range of each map
+	const float DIRECTIONAL_SHADOW_BIAS = 0.0002f;
+	const float FLASHLIGHT_SHADOW_BIAS = 0.00005f;
+
+	// copy a normal matrix into the three padded columns that the
+	// object block, the instance buffer and the draw data hold
+	void PackNormalMatrix(const glm::mat3& normalMatrix, glm::vec4 columns[3])
+	{
+		for (int column = 0; column < 3; column++)
+		{
+			columns[column] = glm::vec4(normalMatrix[column], 0.0f);
+		}
+	}
+
+	// up vector for looking along a light direction, the y axis unless
+	// the light points almost straight up or down
+	glm::vec3 ShadowUpVector(const glm::vec3& direction)
+	{
+		return((fabsf(direction.y) > 0.99f) ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f));
+	}
 }
 
 /***********************************************************
@@ -31,10 +104,55 @@ namespace
  *
  *  The constructor for the class
  ***********************************************************/
-SceneManager::SceneManager(ShaderManager *pShaderManager)
+SceneManager::SceneManager(ShaderManager *pShaderManager, UniformCache* pUniformCache)
 {
 	m_pShaderManager = pShaderManager;
+	m_pUniformCache = pUniformCache;
+	m_materialBuffer = 0;
+	m_materialStride = 0;
+	m_pUniformRing = new UniformRing();
+	m_objectBlock.model = glm::mat4(1.0f);
+	PackNormalMatrix(glm::mat3(1.0f), m_objectBlock.normalMatrix);
+	m_objectBlock.color = glm::vec4(1.0f);
+	m_objectBlock.params = glm::vec4(1.0f, 1.0f, 0.0f, 0.0f);
+	m_bObjectBlockDirty = false;
+	m_useLightingLocation = -1;
+	m_pStateFilter = new RenderStateFilter(pUniformCache);
+	m_pTextureLoader = new TextureLoader();
+	m_pTextureArrays = new TextureArrays();
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_viewPosition = glm::vec3(0.0f);
+	m_pSceneBVH = new SceneBVH();
+	m_bBoundsDirty = true;
+	m_bBoundsMoved = false;
+	m_pJobSystem = new JobSystem();
+	m_bFrustumCulling = true;
+	m_cullCounters = SceneBVH::CULL_COUNTERS();
+	m_bLodSelection = true;
+	m_pIndirectRenderer = new IndirectRenderer();
+	m_bIndirectDrawing = true;
+	m_bIndirectFrame = false;
+	m_drawDataLocation = -1;
+	m_materialDataLocation = -1;
+	m_pDepthPrepass = new DepthPrepass();
+	m_pShadowAtlas = new ShadowAtlas();
+	m_pLightManager = NULL;
+	m_pSceneFile = new SceneFile();
+	m_depthMode = DEPTH_MODE_STATE_SORT;
+	m_bInstancesDirty = false;
+	m_currentSection = 0;
+	m_pSceneGraph = new SceneGraph();
+	m_currentNode = SceneGraph::ROOT_NODE;
+	m_bNodesDirty = false;
+	m_pProfiler = NULL;
+	m_bProfileSections = false;
+	m_drawCalls = 0;
+	m_stressObjectCount = 0;
+	m_stressRadius = 0.0f;
 	m_basicMeshes = new ShapeMeshes();
+	m_loadedTextures = 0;
+	m_instancedMeshes = new MeshLibrary();
 }
 
 /***********************************************************
@@ -44,112 +162,137 @@ SceneManager::SceneManager(ShaderManager *pShaderManager)
  ***********************************************************/
 SceneManager::~SceneManager()
 {
+	if (0 != m_materialBuffer)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_materialBuffer);
+		glDeleteBuffers(1, &m_materialBuffer);
+		m_materialBuffer = 0;
+	}
 	m_pShaderManager = NULL;
+	m_pUniformCache = NULL;
+	delete m_pStateFilter;
+	m_pStateFilter = NULL;
+	delete m_pUniformRing;
+	m_pUniformRing = NULL;
+	delete m_pTextureLoader;
+	m_pTextureLoader = NULL;
+	DestroyGLTextures();
+	delete m_pTextureArrays;
+	m_pTextureArrays = NULL;
+	delete m_pSceneBVH;
+	m_pSceneBVH = NULL;
+	delete m_pJobSystem;
+	m_pJobSystem = NULL;
+	delete m_pSceneGraph;
+	m_pSceneGraph = NULL;
+	delete m_pIndirectRenderer;
+	m_pIndirectRenderer = NULL;
+	delete m_pDepthPrepass;
+	m_pDepthPrepass = NULL;
+	delete m_pShadowAtlas;
+	m_pShadowAtlas = NULL;
+	m_pLightManager = NULL;
+	delete m_pSceneFile;
+	m_pSceneFile = NULL;
 	delete m_basicMeshes;
 	m_basicMeshes = NULL;
+	delete m_instancedMeshes;
+	m_instancedMeshes = NULL;
 }
 
 /***********************************************************
  *  CreateGLTexture()
  *
- *  This method is used for loading textures from image files,
- *  configuring the texture mapping parameters in OpenGL,
- *  generating the mipmaps, and loading the read texture into
- *  the next available texture slot in memory.
+ *  This method is used for adding a texture from an image
+ *  file to the scene.  Only the image header is read here,
+ *  to reserve a layer in the texture array for the size and
+ *  format of the image.  The image is decoded and uploaded
+ *  in the background once BindGLTextures() is called, and
+ *  a placeholder is drawn until then.  The returned handle
+ *  is used for drawing with the loaded texture.
  ***********************************************************/
-bool SceneManager::CreateGLTexture(const char* filename, std::string tag)
+SceneManager::TextureHandle SceneManager::CreateGLTexture(const char* filename, const std::string& tag)
 {
 	int width = 0;
 	int height = 0;
 	int colorChannels = 0;
-	GLuint textureID = 0;
-
-	// indicate to always flip images vertically when loaded
-	stbi_set_flip_vertically_on_load(true);
-
-	// try to parse the image data from the specified image file
-	unsigned char* image = stbi_load(
-		filename,
-		&width,
-		&height,
-		&colorChannels,
-		0);
-
-	// if the image was successfully read from the image file
-	if (image)
-	{
-		std::cout << "Successfully loaded image:" << filename << ", width:" << width << ", height:" << height << ", channels:" << colorChannels << std::endl;
-
-		glGenTextures(1, &textureID);
-		glBindTexture(GL_TEXTURE_2D, textureID);
-
-		// set the texture wrapping parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// set texture filtering parameters
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		// if the loaded image is in RGB format
-		if (colorChannels == 3)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, width, height, 0, GL_RGB, GL_UNSIGNED_BYTE, image);
-		// if the loaded image is in RGBA format - it supports transparency
-		else if (colorChannels == 4)
-			glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image);
-		else
-		{
-			std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
-			return false;
-		}
-
-		// generate the texture mipmaps for mapping textures to lower resolutions
-		glGenerateMipmap(GL_TEXTURE_2D);
-
-		// free the image data from local memory
-		stbi_image_free(image);
-		glBindTexture(GL_TEXTURE_2D, 0); // Unbind the texture
-
-		// register the loaded texture and associate it with the special tag string
-		m_textureIDs[m_loadedTextures].ID = textureID;
-		m_textureIDs[m_loadedTextures].tag = tag;
-		m_loadedTextures++;
+	TEXTURE_INFO info;
 
-		return true;
+	// the header tells if the image has an alpha channel, which
+	// is needed for sorting the draws before the image is decoded
+	if (0 == stbi_info(filename, &width, &height, &colorChannels))
+	{
+		std::cout << "Could not load image:" << filename << std::endl;
+		return INVALID_HANDLE;
+	}
+	if ((colorChannels != 3) && (colorChannels != 4))
+	{
+		std::cout << "Not implemented to handle image with " << colorChannels << " channels" << std::endl;
+		return INVALID_HANDLE;
 	}
 
-	std::cout << "Could not load image:" << filename << std::endl;
-
-	// Error loading the image
-	return false;
+	TextureArrays::TEXTURE_LOCATION location = m_pTextureArrays->AddTexture(
+		width,
+		height,
+		m_pTextureLoader->GetUploadFormat(colorChannels));
+
+	// register the texture and associate it with the special tag string,
+	// the index of the texture is the handle it is drawn with
+	info.tag = tag;
+	info.filename = filename;
+	info.ID = 0;
+	info.page = location.page;
+	info.layer = location.layer;
+	info.hasAlpha = (colorChannels == 4);
+	info.bLoaded = false;
+	m_textureIDs.push_back(info);
+	m_loadedTextures++;
+
+	return((TextureHandle)m_textureIDs.size() - 1);
 }
 
 /***********************************************************
  *  BindGLTextures()
  *
- *  This method is used for binding the loaded textures to
- *  OpenGL texture memory slots.  There are up to 16 slots.
+ *  This method is used for allocating the texture arrays of
+ *  the added textures, queuing the textures to be loaded
+ *  into their layers, and binding each texture array to its
+ *  own texture unit.
  ***********************************************************/
 void SceneManager::BindGLTextures()
 {
+	m_pTextureArrays->AllocatePages();
+
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
-		// bind textures on corresponding texture units
-		glActiveTexture(GL_TEXTURE0 + i);
-		glBindTexture(GL_TEXTURE_2D, m_textureIDs[i].ID);
+		TEXTURE_INFO& info = m_textureIDs[i];
+
+		if (0 == info.ID)
+		{
+			info.ID = m_pTextureArrays->GetPageTexture(info.page);
+			m_pTextureLoader->QueueTexture(info.filename, info.ID, info.layer, i);
+		}
 	}
+
+	m_pTextureArrays->BindPages();
 }
 
 /***********************************************************
  *  DestroyGLTextures()
  *
  *  This method is used for freeing the memory in all the
- *  used texture memory slots.
+ *  used texture memory slots.  The textures share the
+ *  arrays of their pages, so the pages are deleted once by
+ *  the texture arrays and each texture forgets its array.
  ***********************************************************/
 void SceneManager::DestroyGLTextures()
 {
+	m_pTextureArrays->ReleasePages();
+
 	for (int i = 0; i < m_loadedTextures; i++)
 	{
-		glGenTextures(1, &m_textureIDs[i].ID);
+		m_textureIDs[i].ID = 0;
+		m_textureIDs[i].bLoaded = false;
 	}
 }
 
@@ -159,7 +302,7 @@ void SceneManager::DestroyGLTextures()
  *  This method is used for getting an ID for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureID(std::string tag)
+int SceneManager::FindTextureID(const std::string& tag) const
 {
 	int textureID = -1;
 	int index = 0;
@@ -185,7 +328,7 @@ int SceneManager::FindTextureID(std::string tag)
  *  This method is used for getting a slot index for the previously
  *  loaded texture bitmap associated with the passed in tag.
  ***********************************************************/
-int SceneManager::FindTextureSlot(std::string tag)
+int SceneManager::FindTextureSlot(const std::string& tag) const
 {
 	int textureSlot = -1;
 	int index = 0;
@@ -205,27 +348,145 @@ int SceneManager::FindTextureSlot(std::string tag)
 	return(textureSlot);
 }
 
+/***********************************************************
+ *  FindTextureHandle()
+ *
+ *  This method is used for getting the handle of the previously
+ *  loaded texture associated with the passed in tag.  It is
+ *  meant for resolving tags while the scene is loaded.
+ ***********************************************************/
+SceneManager::TextureHandle SceneManager::FindTextureHandle(const std::string& tag) const
+{
+	return(FindTextureSlot(tag));
+}
+
 /***********************************************************
  *  FindMaterial()
  *
  *  This method is used for getting a material from the previously
  *  defined materials list that is associated with the passed in tag.
  ***********************************************************/
-bool SceneManager::FindMaterial(std::string tag, OBJECT_MATERIAL& material)
+const SceneManager::OBJECT_MATERIAL* SceneManager::FindMaterial(const std::string& tag) const
 {
-	if (m_objectMaterials.empty()) return false;
-	bool bFound = false;
-	for (const auto& m : m_objectMaterials)
+	MaterialHandle material = FindMaterialHandle(tag);
+
+	if (material == INVALID_HANDLE)
+	{
+		return(NULL);
+	}
+
+	return(&m_objectMaterials[material]);
+}
+
+/***********************************************************
+ *  FindMaterialHandle()
+ *
+ *  This method is used for getting the handle of the defined
+ *  material associated with the passed in tag.  It is meant
+ *  for resolving tags while the scene is loaded.
+ ***********************************************************/
+SceneManager::MaterialHandle SceneManager::FindMaterialHandle(const std::string& tag) const
+{
+	for (int index = 0; index < (int)m_objectMaterials.size(); index++)
+	{
+		if (m_objectMaterials[index].tag == tag)
 		{
-			if (m.tag == tag)
-			{
-				material = m;
-				bFound = true;
-				break;
-			}
+			return(index);
 		}
-	return bFound;
+	}
+
+	return(INVALID_HANDLE);
+}
+
+/***********************************************************
+ *  AddObjectMaterial()
+ *
+ *  This method is used for registering a material in the
+ *  defined materials list.  The returned handle stays valid
+ *  for as long as the scene is loaded.
+ ***********************************************************/
+SceneManager::MaterialHandle SceneManager::AddObjectMaterial(const OBJECT_MATERIAL& material)
+{
+	m_objectMaterials.push_back(material);
+
+	return((MaterialHandle)m_objectMaterials.size() - 1);
+}
+
+/***********************************************************
+ *  BuildModelMatrix()
+ *
+ *  This method is used for composing the model matrix from
+ *  the passed in transformation values.  The result is the
+ *  translation * rotationZ * rotationY * rotationX * scale
+ *  product, written out from the sines and cosines of the
+ *  angles rather than multiplying five matrices together.
+ ***********************************************************/
+glm::mat4 SceneManager::BuildModelMatrix(
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	// variables for this method
+	float sinX = std::sin(glm::radians(XrotationDegrees));
+	float cosX = std::cos(glm::radians(XrotationDegrees));
+	float sinY = std::sin(glm::radians(YrotationDegrees));
+	float cosY = std::cos(glm::radians(YrotationDegrees));
+	float sinZ = std::sin(glm::radians(ZrotationDegrees));
+	float cosZ = std::cos(glm::radians(ZrotationDegrees));
+	glm::mat4 model;
+
+	// each column of the rotation is scaled by its axis
+	model[0] = glm::vec4(
+		cosY * cosZ,
+		cosY * sinZ,
+		-sinY,
+		0.0f) * scaleXYZ.x;
+	model[1] = glm::vec4(
+		(cosZ * sinY * sinX) - (sinZ * cosX),
+		(sinZ * sinY * sinX) + (cosZ * cosX),
+		cosY * sinX,
+		0.0f) * scaleXYZ.y;
+	model[2] = glm::vec4(
+		(cosZ * sinY * cosX) + (sinZ * sinX),
+		(sinZ * sinY * cosX) - (cosZ * sinX),
+		cosY * cosX,
+		0.0f) * scaleXYZ.z;
+	model[3] = glm::vec4(positionXYZ, 1.0f);
+
+	return(model);
+}
+
+/***********************************************************
+ *  BuildNormalMatrix()
+ *
+ *  This method is used for getting the matrix that the
+ *  vertex normals are transformed with, the inverse of the
+ *  transposed rotation and scale of the model matrix.  It
+ *  keeps the normals at right angles to the surface of the
+ *  objects that are scaled by a different amount on each
+ *  axis.
+ ***********************************************************/
+glm::mat3 SceneManager::BuildNormalMatrix(const glm::mat4& modelMatrix)
+{
+	return(glm::inverseTranspose(glm::mat3(modelMatrix)));
+}
+
+/***********************************************************
+ *  BuildInstanceTransform()
+ *
+ *  This method is used for getting the values of a draw
+ *  item as they are kept in the per instance buffer.
+ ***********************************************************/
+MeshLibrary::INSTANCE_TRANSFORM SceneManager::BuildInstanceTransform(const DRAW_ITEM& item)
+{
+	MeshLibrary::INSTANCE_TRANSFORM transform;
+
+	transform.modelMatrix = item.modelMatrix;
+	PackNormalMatrix(item.normalMatrix, transform.normalMatrix);
 
+	return(transform);
 }
 
 /***********************************************************
@@ -243,27 +504,17 @@ void SceneManager::SetTransformations(
 {
 	// variables for this method
 	glm::mat4 modelView;
-	glm::mat4 scale;
-	glm::mat4 rotationX;
-	glm::mat4 rotationY;
-	glm::mat4 rotationZ;
-	glm::mat4 translation;
 
-	// set the scale value in the transform buffer
-	scale = glm::scale(scaleXYZ);
-	// set the rotation values in the transform buffer
-	rotationX = glm::rotate(glm::radians(XrotationDegrees), glm::vec3(1.0f, 0.0f, 0.0f));
-	rotationY = glm::rotate(glm::radians(YrotationDegrees), glm::vec3(0.0f, 1.0f, 0.0f));
-	rotationZ = glm::rotate(glm::radians(ZrotationDegrees), glm::vec3(0.0f, 0.0f, 1.0f));
-	// set the translation value in the transform buffer
-	translation = glm::translate(positionXYZ);
-
-	modelView = translation * rotationZ * rotationY * rotationX * scale;
+	modelView = BuildModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ);
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setMat4Value(g_ModelName, modelView);
-	}
+	m_objectBlock.model = modelView;
+	PackNormalMatrix(BuildNormalMatrix(modelView), m_objectBlock.normalMatrix);
+	m_bObjectBlockDirty = true;
 }
 
 /***********************************************************
@@ -286,33 +537,67 @@ void SceneManager::SetShaderColor(
 	currentColor.b = blueColorValue;
 	currentColor.a = alphaValue;
 
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setIntValue(g_UseTextureName, false);
-		m_pShaderManager->setVec4Value(g_ColorValueName, currentColor);
-	}
+	m_pStateFilter->SetUseTexture(false);
+	m_objectBlock.color = currentColor;
+	m_bObjectBlockDirty = true;
 }
 
 /***********************************************************
  *  SetShaderTexture()
  *
  *  This method is used for setting the texture data
- *  associated with the passed in ID into the shader.
+ *  associated with the passed in tag into the shader.
  ***********************************************************/
 void SceneManager::SetShaderTexture(
-	std::string textureTag)
+	const std::string& textureTag)
 {
-	if (NULL != m_pShaderManager)
-	{
-		int textureID = FindTextureSlot(textureTag);
+	SetShaderTexture(FindTextureHandle(textureTag));
+}
 
-		if (textureID < 0) {
-			return;
-		}
+/***********************************************************
+ *  SetShaderTexture()
+ *
+ *  This method is used for setting the texture data
+ *  associated with the passed in handle into the shader.
+ ***********************************************************/
+void SceneManager::SetShaderTexture(
+	TextureHandle texture)
+{
+	if ((texture < 0) || (texture >= m_loadedTextures)) {
+		return;
+	}
+
+	SetTextureState(texture);
+	m_bObjectBlockDirty = true;
+}
+
+/***********************************************************
+ *  SetTextureState()
+ *
+ *  This method is used for selecting the texture array unit
+ *  and the layer of the passed in texture.  The layer is
+ *  kept in the object values of the next draw.
+ ***********************************************************/
+void SceneManager::SetTextureState(
+	TextureHandle texture)
+{
+	if ((texture < 0) || (texture >= m_loadedTextures)) {
+		return;
+	}
 
-		m_pShaderManager->setIntValue(g_UseTextureName, true);
-		m_pShaderManager->setSampler2DValue(g_TextureValueName, textureID);
+	// the texture is selected by the unit of its texture array and
+	// its layer, the placeholder is used until the layer is loaded
+	const TEXTURE_INFO& info = m_textureIDs[texture];
+	TextureArrays::TEXTURE_LOCATION location = m_pTextureArrays->GetPlaceholder();
+	if (info.bLoaded)
+	{
+		location.page = info.page;
+		location.layer = info.layer;
 	}
+
+	m_pStateFilter->SetUseTexture(true);
+	m_pStateFilter->SetTextureSlot((int)m_pTextureArrays->GetPageUnit(location.page));
+	m_objectBlock.params.z = (float)location.layer;
 }
 
 /***********************************************************
@@ -323,756 +608,2934 @@ void SceneManager::SetShaderTexture(
  ***********************************************************/
 void SceneManager::SetTextureUVScale(float u, float v)
 {
-	if (NULL != m_pShaderManager)
-	{
-		m_pShaderManager->setVec2Value("UVscale", glm::vec2(u, v));
-	}
+	m_objectBlock.params.x = u;
+	m_objectBlock.params.y = v;
+	m_bObjectBlockDirty = true;
 }
 
 /***********************************************************
  *  SetShaderMaterial()
  *
  *  This method is used for passing the material values
- *  into the shader.
+ *  associated with the passed in tag into the shader.
  ***********************************************************/
 void SceneManager::SetShaderMaterial(
-	std::string materialTag)
+	const std::string& materialTag)
 {
-	OBJECT_MATERIAL material{};
+	SetShaderMaterial(FindMaterialHandle(materialTag));
+}
 
-	if (!FindMaterial(materialTag, material)) {
+/***********************************************************
+ *  SetShaderMaterial()
+ *
+ *  This method is used for passing the material values
+ *  associated with the passed in handle into the shader.
+ *  The material block is pointed at the material's range
+ *  of the material uniform buffer.
+ ***********************************************************/
+void SceneManager::SetShaderMaterial(
+	MaterialHandle material)
+{
+	if ((material < 0) || (material >= (int)m_objectMaterials.size())) {
 		return;
 	}
-			m_pShaderManager->setVec3Value("material.diffuseColor", material.diffuseColor);
-			m_pShaderManager->setVec3Value("material.specularColor", material.specularColor);
-			m_pShaderManager->setFloatValue("material.shininess", material.shininess);
-			m_pShaderManager->setVec3Value("material.ambientColor", material.ambientColor);
-			m_pShaderManager->setFloatValue("material.ambientStrength", material.ambientStrength);
-		}
+
+	if (0 != m_materialBuffer)
+	{
+		m_pStateFilter->SetMaterial(
+			m_materialBuffer,
+			material,
+			(GLintptr)material * m_materialStride,
+			sizeof(MATERIAL_BLOCK));
 	}
 }
 
-/**************************************************************/
-/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
-/*** preparing and rendering their own 3D replicated scenes.***/
-/*** Please refer to the code in the OpenGL sample project  ***/
-/*** for assistance.                                        ***/
-/**************************************************************/
-
-void SceneManager::LoadSceneTextures()
+/***********************************************************
+ *  LoadUniformLocations()
+ *
+ *  This method is used for looking up, once, the locations
+ *  of the uniforms that are set for every draw.
+ ***********************************************************/
+void SceneManager::LoadUniformLocations()
 {
-	bool bReturn = false;
-
-	bReturn = CreateGLTexture("./Debug/textures/wood_light_seamless.jpg", "wood");
-	bReturn = CreateGLTexture("./Debug/textures/marble_light_seamless.jpg", "marble1");
-	bReturn = CreateGLTexture("./Debug/textures/leather_black_seamless.jpg", "leather1");
-	bReturn = CreateGLTexture("./Debug/textures/paper_textured_seamless.jpg", "paper");
-	bReturn = CreateGLTexture("./Debug/textures/leather_brown_seamless.jpg", "leather2");
-	bReturn = CreateGLTexture("./Debug/textures/paper_brown_seamless.jpg", "paper2");
-	bReturn = CreateGLTexture("./Debug/textures/leather_tan_seamless.jpg", "leather3");
-	bReturn = CreateGLTexture("./Debug/textures/marble_light2_seamless.jpg", "marble2");
-	bReturn = CreateGLTexture("./Debug/textures/ground_textured_seamless.jpg", "ground");
-	bReturn = CreateGLTexture("./Debug/textures/grass_textured1_seamless.jpg", "grass1");
-	bReturn = CreateGLTexture("./Debug/textures/grass_textured2_seamless.jpg", "grass2");
-	bReturn = CreateGLTexture("./Debug/textures/pattern_flowers_seamless.jpg", "pattern");
-	bReturn = CreateGLTexture("./Debug/textures/fabric_textured_seamless.jpg", "fabric");
-	bReturn = CreateGLTexture("./Debug/textures/wood_cherry_seamless.jpg", "wood2");
-	BindGLTextures();
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	m_useLightingLocation = m_pUniformCache->GetLocation(g_UseLightingName);
+	m_pStateFilter->LoadLocations();
+
+	m_pUniformCache->BindUniformBlock(g_MaterialBlockName, UniformCache::MATERIAL_BLOCK_BINDING);
+	m_pUniformCache->BindUniformBlock(g_CameraBlockName, UniformCache::CAMERA_BLOCK_BINDING);
+	m_pUniformCache->BindUniformBlock(g_ObjectBlockName, UniformCache::OBJECT_BLOCK_BINDING);
+	m_pUniformCache->BindUniformBlock(g_ShadowBlockName, UniformCache::SHADOW_BLOCK_BINDING);
+
+	// the buffer texture samplers always point at their own units,
+	// so that they never share a unit with the texture arrays
+	m_drawDataLocation = m_pUniformCache->GetLocation(g_DrawDataName);
+	m_materialDataLocation = m_pUniformCache->GetLocation(g_MaterialDataName);
+	m_pUniformCache->SetInt(m_drawDataLocation, m_pIndirectRenderer->GetDrawDataUnit());
+	m_pUniformCache->SetInt(m_materialDataLocation, m_pIndirectRenderer->GetMaterialDataUnit());
+	m_pUniformCache->SetInt(m_pUniformCache->GetLocation(g_ShadowAtlasName), m_pShadowAtlas->GetTextureUnit());
+
+	// the scene is drawn with the lights from the shader light block
+	m_pUniformCache->SetInt(m_useLightingLocation, true);
 }
 
-void SceneManager::SetupSceneLights()
+/***********************************************************
+ *  UploadMaterialBuffer()
+ *
+ *  This method is used for copying all the defined materials
+ *  into one uniform buffer.  Each material starts on the
+ *  uniform buffer offset alignment, so a material switch is
+ *  a single glBindBufferRange() call.
+ ***********************************************************/
+void SceneManager::UploadMaterialBuffer()
 {
-	glEnable(GL_LIGHTING);
-	glEnable(GL_NORMALIZE);
-	glShadeModel(GL_SMOOTH);
+	GLint alignment = 0;
+	std::vector<unsigned char> data;
 
-	GLfloat light0_position[] = { 0.0f, 5.0f, 5.0f, 0.0f };
-	GLfloat light0_ambient[] = { 0.2f, 0.2f, 0.2f, 1.0f };
-	GLfloat light0_diffuse[] = { 0.7f, 0.7f, 0.7f, 1.0f };
-	GLfloat light0_specular[] = { 1.0f, 1.0f, 1.0f, 1.0f };
+	if (m_objectMaterials.empty())
+	{
+		return;
+	}
 
-	glEnable(GL_LIGHT0);
-	glLightfv(GL_LIGHT0, GL_POSITION, light0_position);
-	glLightfv(GL_LIGHT0, GL_AMBIENT, light0_ambient);
-	glLightfv(GL_LIGHT0, GL_DIFFUSE, light0_diffuse);
-	glLightfv(GL_LIGHT0, GL_SPECULAR, light0_specular);
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment <= 0)
+	{
+		alignment = 256;
+	}
+	m_materialStride = (((GLint)sizeof(MATERIAL_BLOCK) + alignment - 1) / alignment) * alignment;
 
-	GLfloat light1_position[] = { -2.0f, 3.0f, -2.0f, 1.0f };
-	GLfloat light1_ambient[] = { 0.1f, 0.0f, 0.0f, 1.0f };
-	GLfloat light1_diffuse[] = { 0.8f, 0.1f, 0.1f, 1.0f };
-	GLfloat light1_specular[] = { 1.0f, 0.4f, 0.4f, 1.0f };
+	data.resize(m_objectMaterials.size() * m_materialStride, 0);
+	for (size_t i = 0; i < m_objectMaterials.size(); i++)
+	{
+		const OBJECT_MATERIAL& material = m_objectMaterials[i];
+		MATERIAL_BLOCK* block = (MATERIAL_BLOCK*)&data[i * m_materialStride];
+
+		block->diffuseColor = material.diffuseColor;
+		block->specularColor = material.specularColor;
+		block->shininess = material.shininess;
+		block->ambientColor = material.ambientColor;
+		block->ambientStrength = material.ambientStrength;
+	}
 
-	glEnable(GL_LIGHT1);
-	glLightfv(GL_LIGHT1, GL_POSITION, light1_position);
-	glLightfv(GL_LIGHT1, GL_AMBIENT, light1_ambient);
-	glLightfv(GL_LIGHT1, GL_DIFFUSE, light1_diffuse);
-	glLightfv(GL_LIGHT1, GL_SPECULAR, light1_specular);
+	if (0 == m_materialBuffer)
+	{
+		glGenBuffers(1, &m_materialBuffer);
+		GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_materialBuffer, "SceneManager");
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, m_materialBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, data.size(), data.data(), GL_STATIC_DRAW);
+	GpuResources::SetSize(GpuResources::RESOURCE_BUFFER, m_materialBuffer, data.size());
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
 }
 
-void SceneManager::DefineObjectMaterials()
+/***********************************************************
+ *  UploadObjectBlock()
+ *
+ *  This method is used for writing the object values to the
+ *  uniform ring buffer and pointing the object block at
+ *  them, for the next draw.
+ ***********************************************************/
+void SceneManager::UploadObjectBlock()
 {
-	OBJECT_MATERIAL wood;
-	wood.ambientColor = glm::vec3(0.2f, 0.1f, 0.05f);
-	wood.ambientStrength = 0.4f;
-	wood.diffuseColor = glm::vec3(0.5f, 0.25f, 0.1f);
-	wood.specularColor = glm::vec3(0.3f, 0.2f, 0.1f);
-	wood.shininess = 8.0f;
-	wood.tag = "wood";
-	m_objectMaterials.push_back(wood);
+	m_pUniformRing->Bind(
+		UniformCache::OBJECT_BLOCK_BINDING,
+		&m_objectBlock,
+		sizeof(OBJECT_BLOCK));
+	m_bObjectBlockDirty = false;
+}
 
-	OBJECT_MATERIAL marble1;
-	marble1.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	marble1.ambientStrength = 0.5f;
-	marble1.diffuseColor = glm::vec3(0.7f, 0.7f, 0.7f);
-	marble1.specularColor = glm::vec3(0.9f, 0.9f, 0.9f);
-	marble1.shininess = 64.0f;
-	marble1.tag = "marble1";
-	m_objectMaterials.push_back(marble1);
+/***********************************************************
+ *  UploadDirtyObjectBlock()
+ *
+ *  This method is used for writing the object values only
+ *  when one of the shader setters has changed them since
+ *  they were last written.  The setters only mark them, so
+ *  that an object drawn with several setters uses a single
+ *  block of the ring buffer.
+ ***********************************************************/
+void SceneManager::UploadDirtyObjectBlock()
+{
+	if (m_bObjectBlockDirty)
+	{
+		UploadObjectBlock();
+	}
+}
 
-	OBJECT_MATERIAL leather1;
-	leather1.ambientColor = glm::vec3(0.2f, 0.1f, 0.1f);
-	leather1.ambientStrength = 0.3f;
-	leather1.diffuseColor = glm::vec3(0.4f, 0.2f, 0.2f);
-	leather1.specularColor = glm::vec3(0.5f, 0.4f, 0.3f);
-	leather1.shininess = 64.0f;
-	leather1.tag = "leather1";
-	m_objectMaterials.push_back(leather1);
+/***********************************************************
+ *  AddDrawItem()
+ *
+ *  This method is used for adding a textured object to the
+ *  retained draw list.  The texture slot and material are
+ *  looked up here, once, instead of on every frame.
+ ***********************************************************/
+int SceneManager::AddDrawItem(
+	MESH_TYPE mesh,
+	const std::string& textureTag,
+	const std::string& materialTag,
+	glm::vec2 uvScale,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	uint8_t variant)
+{
+	return(AddDrawItemByHandle(
+		mesh,
+		FindTextureHandle(textureTag),
+		FindMaterialHandle(materialTag),
+		uvScale,
+		scaleXYZ,
+		glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees),
+		positionXYZ,
+		variant));
+}
 
-	OBJECT_MATERIAL paper;
-	paper.ambientColor = glm::vec3(0.4f, 0.4f, 0.3f);
-	paper.ambientStrength = 0.3f;
-	paper.diffuseColor = glm::vec3(0.8f, 0.8f, 0.7f);
-	paper.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	paper.shininess = 4.0f;
-	paper.tag = "paper";
-	m_objectMaterials.push_back(paper);
+/***********************************************************
+ *  AddDrawItemByHandle()
+ *
+ *  This method is used for adding an object to the retained
+ *  draw list with its texture and material handles already
+ *  resolved, as the scene file items are.  An item without
+ *  a material is given the material of the item added
+ *  before it, which is the one the scene code had bound, so
+ *  that it does not depend on the draw order or the path.
+ ***********************************************************/
+int SceneManager::AddDrawItemByHandle(
+	MESH_TYPE mesh,
+	TextureHandle texture,
+	MaterialHandle material,
+	glm::vec2 uvScale,
+	glm::vec3 scaleXYZ,
+	glm::vec3 rotationDegrees,
+	glm::vec3 positionXYZ,
+	uint8_t variant)
+{
+	DRAW_ITEM item;
 
-	OBJECT_MATERIAL leather2;
-	leather2.ambientColor = glm::vec3(0.15f, 0.1f, 0.05f);
-	leather2.ambientStrength = 0.3f;
-	leather2.diffuseColor = glm::vec3(0.3f, 0.2f, 0.1f);
-	leather2.specularColor = glm::vec3(0.4f, 0.3f, 0.2f);
-	leather2.shininess = 12.0f;
-	leather2.tag = "leather2";
-	m_objectMaterials.push_back(leather2);
+	item.modelMatrix = BuildModelMatrix(
+		scaleXYZ,
+		rotationDegrees.x,
+		rotationDegrees.y,
+		rotationDegrees.z,
+		positionXYZ);
+	if (m_currentNode != SceneGraph::ROOT_NODE)
+	{
+		item.modelMatrix = m_pSceneGraph->GetWorldMatrix(m_currentNode) * item.modelMatrix;
+	}
+	item.normalMatrix = BuildNormalMatrix(item.modelMatrix);
+	item.color = glm::vec4(1.0f);
+	item.uvScale = uvScale;
+	item.texture = texture;
+	item.material = material;
+	if ((material == INVALID_HANDLE) && (false == m_drawList.empty()))
+	{
+		item.material = m_drawList.back().material;
+	}
+	item.instanceIndex = -1;
+	item.drawIndex = -1;
+	item.mesh = (uint8_t)mesh;
+	item.variant = variant;
+	item.section = m_currentSection;
+	item.lod = 0;
+
+	m_drawList.push_back(item);
+	m_drawScales.push_back(scaleXYZ);
+	m_drawRotations.push_back(rotationDegrees);
+	m_drawPositions.push_back(positionXYZ);
+	m_drawNodes.push_back(m_currentNode);
+	m_pSceneGraph->AttachItem(m_currentNode, (int)m_drawList.size() - 1);
+
+	return((int)m_drawList.size() - 1);
+}
 
-	OBJECT_MATERIAL paper2;
-	paper2.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
-	paper2.ambientStrength = 0.3f;
-	paper2.diffuseColor = glm::vec3(0.9f, 0.9f, 0.8f);
-	paper2.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
-	paper2.shininess = 4.0f;
-	paper2.tag = "paper2";
-	m_objectMaterials.push_back(paper2);
+/***********************************************************
+ *  AddColorDrawItem()
+ *
+ *  This method is used for adding a solid colored object to
+ *  the retained draw list.  The current material is kept.
+ ***********************************************************/
+int SceneManager::AddColorDrawItem(
+	MESH_TYPE mesh,
+	glm::vec4 color,
+	glm::vec2 uvScale,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ,
+	uint8_t variant)
+{
+	int itemIndex = AddDrawItem(
+		mesh,
+		"",
+		"",
+		uvScale,
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ,
+		variant);
 
-	OBJECT_MATERIAL leather3;
-	leather3.ambientColor = glm::vec3(0.1f, 0.05f, 0.05f);
-	leather3.ambientStrength = 0.3f;
-	leather3.diffuseColor = glm::vec3(0.35f, 0.2f, 0.2f);
-	leather3.specularColor = glm::vec3(0.4f, 0.3f, 0.3f);
-	leather3.shininess = 16.0f;
-	leather3.tag = "leather3";
-	m_objectMaterials.push_back(leather3);
+	m_drawList[itemIndex].color = color;
 
-	OBJECT_MATERIAL marble2;
-	marble2.ambientColor = glm::vec3(0.35f, 0.35f, 0.35f);
-	marble2.ambientStrength = 0.5f;
+	return(itemIndex);
+}
+
+/***********************************************************
+ *  SetDrawItemTransform()
+ *
+ *  This method is used for changing the transformation of
+ *  a draw item.  The cached model matrix is rebuilt on the
+ *  next rendered frame.
+ ***********************************************************/
+void SceneManager::SetDrawItemTransform(
+	int itemIndex,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((itemIndex < 0) || (itemIndex >= (int)m_drawList.size()))
+	{
+		return;
+	}
+
+	m_drawScales[itemIndex] = scaleXYZ;
+	m_drawRotations[itemIndex] = glm::vec3(XrotationDegrees, YrotationDegrees, ZrotationDegrees);
+	m_drawPositions[itemIndex] = positionXYZ;
+	m_dirtyDrawItems.push_back(itemIndex);
+}
+
+/***********************************************************
+ *  SetSceneNodeTransform()
+ *
+ *  This method is used for changing the transformation of
+ *  a scene node.  The world matrices of the node and of the
+ *  nodes and items below it are rebuilt on the next frame.
+ ***********************************************************/
+void SceneManager::SetSceneNodeTransform(
+	int node,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	if ((node <= SceneGraph::ROOT_NODE) || (node >= m_pSceneGraph->GetNodeCount()))
+	{
+		return;
+	}
+
+	m_pSceneGraph->SetLocalMatrix(node, BuildModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ));
+	m_bNodesDirty = true;
+}
+
+/***********************************************************
+ *  UpdateDirtyDrawItems()
+ *
+ *  This method is used for rebuilding the cached model
+ *  matrix of only the draw items that have been changed.
+ *  The matrices and boxes of the items do not depend on
+ *  each other, so they are rebuilt in parallel chunks, and
+ *  the shared flags and buffers are updated afterwards.
+ ***********************************************************/
+void SceneManager::UpdateDirtyDrawItems()
+{
+	// the items below the moved nodes are rebuilt with the items
+	// that moved on their own
+	if (m_bNodesDirty)
+	{
+		m_pSceneGraph->UpdateWorldMatrices(m_dirtyDrawItems);
+		m_bNodesDirty = false;
+	}
+	if (m_dirtyDrawItems.empty())
+	{
+		return;
+	}
+
+	// an item changed more than once is only rebuilt once, so that
+	// no two jobs write the same item
+	std::sort(m_dirtyDrawItems.begin(), m_dirtyDrawItems.end());
+	m_dirtyDrawItems.erase(std::unique(m_dirtyDrawItems.begin(), m_dirtyDrawItems.end()), m_dirtyDrawItems.end());
+
+	m_pJobSystem->ParallelFor((int)m_dirtyDrawItems.size(), PARALLEL_CHUNK_ITEMS, [this](int first, int last)
+	{
+		for (int i = first; i < last; i++)
+		{
+			int itemIndex = m_dirtyDrawItems[i];
+			DRAW_ITEM& item = m_drawList[itemIndex];
+
+			item.modelMatrix = BuildModelMatrix(
+				m_drawScales[itemIndex],
+				m_drawRotations[itemIndex].x,
+				m_drawRotations[itemIndex].y,
+				m_drawRotations[itemIndex].z,
+				m_drawPositions[itemIndex]);
+			if (m_drawNodes[itemIndex] != SceneGraph::ROOT_NODE)
+			{
+				item.modelMatrix = m_pSceneGraph->GetWorldMatrix(m_drawNodes[itemIndex]) * item.modelMatrix;
+			}
+			item.normalMatrix = BuildNormalMatrix(item.modelMatrix);
+
+			// instanced items also keep their matrices in the instance
+			// buffer, which is uploaded again with the visible instances
+			if (item.instanceIndex >= 0)
+			{
+				m_instanceTransforms[item.instanceIndex] = BuildInstanceTransform(item);
+			}
+
+			// the moved item needs a new box
+			UpdateDrawBounds(itemIndex);
+		}
+	});
+
+	bool bCasterMoved = false;
+	for (int itemIndex : m_dirtyDrawItems)
+	{
+		const DRAW_ITEM& item = m_drawList[itemIndex];
+
+		m_pSceneGraph->SetBoundsDirty(m_drawNodes[itemIndex]);
+		if (false == IsTransparent(item))
+		{
+			bCasterMoved = true;
+		}
+		if (item.instanceIndex >= 0)
+		{
+			m_bInstancesDirty = true;
+		}
+
+		// the indirect path keeps its own copy of the values and box
+		if (item.drawIndex >= 0)
+		{
+			m_pIndirectRenderer->UpdateObject(item.drawIndex, BuildIndirectObject(item), m_drawBounds[itemIndex]);
+		}
+	}
+
+	// the boxes of the nodes above the moved items are grown or
+	// shrunk to them, and the hierarchy needs a rebuild
+	m_pSceneGraph->UpdateBounds(m_drawBounds);
+	m_bBoundsDirty = true;
+	m_bBoundsMoved = true;
+	m_dirtyDrawItems.clear();
+
+	// the transparent items do not cast shadows
+	if (bCasterMoved)
+	{
+		m_pShadowAtlas->Invalidate();
+	}
+}
+
+/***********************************************************
+ *  BuildInstanceBatches()
+ *
+ *  This method is used for grouping the draw items that use
+ *  the same mesh, texture, material, UV scale and color into
+ *  batches that are drawn with a single instanced call.
+ ***********************************************************/
+void SceneManager::BuildInstanceBatches()
+{
+	std::vector<int> candidates;
+
+	m_instanceBatches.clear();
+	m_instanceTransforms.clear();
+	m_instanceItems.clear();
+
+	// only the complete meshes that exist in the shared mesh
+	// library can be drawn with the instanced path
+	for (int i = 0; i < (int)m_drawList.size(); i++)
+	{
+		m_drawList[i].instanceIndex = -1;
+		if ((m_drawList[i].variant == DRAW_ALL) &&
+			(m_instancedMeshes->HasMesh(m_drawList[i].mesh)) &&
+			(false == IsTransparent(m_drawList[i])))
+		{
+			candidates.push_back(i);
+		}
+	}
+
+	// order the candidates so that the items sharing all their
+	// shader values end up next to each other
+	auto sameState = [this](int a, int b)
+	{
+		const DRAW_ITEM& itemA = m_drawList[a];
+		const DRAW_ITEM& itemB = m_drawList[b];
+		return((itemA.mesh == itemB.mesh) &&
+			(itemA.texture == itemB.texture) &&
+			(itemA.material == itemB.material) &&
+			(itemA.uvScale == itemB.uvScale) &&
+			(itemA.color == itemB.color));
+	};
+	auto lessState = [this](int a, int b)
+	{
+		const DRAW_ITEM& itemA = m_drawList[a];
+		const DRAW_ITEM& itemB = m_drawList[b];
+		if (itemA.mesh != itemB.mesh) return(itemA.mesh < itemB.mesh);
+		if (itemA.texture != itemB.texture) return(itemA.texture < itemB.texture);
+		if (itemA.material != itemB.material) return(itemA.material < itemB.material);
+		for (int c = 0; c < 2; c++)
+		{
+			if (itemA.uvScale[c] != itemB.uvScale[c]) return(itemA.uvScale[c] < itemB.uvScale[c]);
+		}
+		for (int c = 0; c < 4; c++)
+		{
+			if (itemA.color[c] != itemB.color[c]) return(itemA.color[c] < itemB.color[c]);
+		}
+		return(a < b);
+	};
+	std::sort(candidates.begin(), candidates.end(), lessState);
+
+	size_t groupStart = 0;
+	while (groupStart < candidates.size())
+	{
+		size_t groupEnd = groupStart + 1;
+		while ((groupEnd < candidates.size()) &&
+			(sameState(candidates[groupStart], candidates[groupEnd])))
+		{
+			groupEnd++;
+		}
+
+		if ((int)(groupEnd - groupStart) >= MIN_INSTANCE_BATCH)
+		{
+			INSTANCE_BATCH batch;
+			batch.itemIndex = candidates[groupStart];
+			batch.firstInstance = (int)m_instanceTransforms.size();
+			batch.instanceCount = (int)(groupEnd - groupStart);
+			batch.visibleFirst = batch.firstInstance;
+			batch.visibleCount = batch.instanceCount;
+			std::fill(batch.lodCounts, batch.lodCounts + MeshLibrary::MAX_LOD_LEVELS, 0);
+			batch.lodCounts[0] = batch.instanceCount;
+
+			for (size_t i = groupStart; i < groupEnd; i++)
+			{
+				DRAW_ITEM& item = m_drawList[candidates[i]];
+				item.instanceIndex = (int)m_instanceTransforms.size();
+				m_instanceTransforms.push_back(BuildInstanceTransform(item));
+				m_instanceItems.push_back(candidates[i]);
+			}
+			m_instanceBatches.push_back(batch);
+		}
+
+		groupStart = groupEnd;
+	}
+
+	m_instancedMeshes->SetInstanceTransforms(m_instanceTransforms);
+	m_visibleInstanceTransforms = m_instanceTransforms;
+	m_bInstancesDirty = false;
+}
+
+/***********************************************************
+ *  IsTransparent()
+ *
+ *  This method is used for checking if a draw item is see
+ *  through - a solid color with alpha below one, or a
+ *  texture that was loaded with an alpha channel.
+ ***********************************************************/
+bool SceneManager::IsTransparent(const DRAW_ITEM& item) const
+{
+	if (item.texture != INVALID_HANDLE)
+	{
+		return(m_textureIDs[item.texture].hasAlpha);
+	}
+
+	return(item.color.a < 1.0f);
+}
+
+/***********************************************************
+ *  BuildSortKey()
+ *
+ *  This method is used for packing the shader state of a
+ *  draw item into a 64 bit key, most expensive change first:
+ *
+ *    63..56  program
+ *    55      instanced flag
+ *    54..43  texture page and layer, untextured items sort last
+ *    42..27  material, items keeping the material sort last
+ *    26..19  mesh
+ *    18..11  mesh variant
+ ***********************************************************/
+uint64_t SceneManager::BuildSortKey(const DRAW_ITEM& item, bool bInstanced) const
+{
+	uint64_t program = 0;
+	uint64_t texture = 0xFFF;
+	uint64_t material = (item.material != INVALID_HANDLE) ? (uint64_t)item.material : 0xFFFF;
+
+	if (NULL != m_pUniformCache)
+	{
+		program = m_pUniformCache->GetProgram() & 0xFF;
+	}
+	if (item.texture != INVALID_HANDLE)
+	{
+		const TEXTURE_INFO& info = m_textureIDs[item.texture];
+		texture = ((uint64_t)(info.page & 0xF) << 8) | (uint64_t)(info.layer & 0xFF);
+	}
+
+	return((program << 56) |
+		((bInstanced ? 1ull : 0ull) << 55) |
+		((texture & 0xFFF) << 43) |
+		((material & 0xFFFF) << 27) |
+		((uint64_t)item.mesh << 19) |
+		((uint64_t)item.variant << 11));
+}
+
+/***********************************************************
+ *  BuildRenderQueues()
+ *
+ *  This method is used for splitting the draw list and the
+ *  instanced batches into the opaque and transparent render
+ *  queues.  The state of the draws does not change after
+ *  the scene is built, so the opaque queue is sorted once.
+ ***********************************************************/
+void SceneManager::BuildRenderQueues()
+{
+	m_opaqueQueue.clear();
+	m_transparentQueue.clear();
+
+	for (int i = 0; i < (int)m_drawList.size(); i++)
+	{
+		const DRAW_ITEM& item = m_drawList[i];
+
+		// the instanced items are drawn by their batch
+		if (item.instanceIndex >= 0)
+		{
+			continue;
+		}
+
+		RENDER_QUEUE_ENTRY entry;
+		entry.sortKey = BuildSortKey(item, false);
+		entry.viewDepth = 0.0f;
+		entry.itemIndex = i;
+		entry.batchIndex = -1;
+
+		if (IsTransparent(item))
+		{
+			m_transparentQueue.push_back(entry);
+		}
+		else
+		{
+			m_opaqueQueue.push_back(entry);
+		}
+	}
+
+	for (int i = 0; i < (int)m_instanceBatches.size(); i++)
+	{
+		RENDER_QUEUE_ENTRY entry;
+		entry.sortKey = BuildSortKey(m_drawList[m_instanceBatches[i].itemIndex], true);
+		entry.viewDepth = 0.0f;
+		entry.itemIndex = m_instanceBatches[i].itemIndex;
+		entry.batchIndex = i;
+		m_opaqueQueue.push_back(entry);
+	}
+
+	// a stable sort keeps the scene order for identical keys
+	std::stable_sort(m_opaqueQueue.begin(), m_opaqueQueue.end(),
+		[](const RENDER_QUEUE_ENTRY& a, const RENDER_QUEUE_ENTRY& b)
+		{
+			return(a.sortKey < b.sortKey);
+		});
+
+	// the profiling order keeps the state sorting inside of each
+	// section, an instanced batch counts for its first item
+	m_sectionQueue = m_opaqueQueue;
+	std::stable_sort(m_sectionQueue.begin(), m_sectionQueue.end(),
+		[this](const RENDER_QUEUE_ENTRY& a, const RENDER_QUEUE_ENTRY& b)
+		{
+			return(m_drawList[a.itemIndex].section < m_drawList[b.itemIndex].section);
+		});
+}
+
+/***********************************************************
+ *  BeginSection()
+ *
+ *  This method is used for starting a named section of the
+ *  scene.  The draw items added after it belong to the
+ *  section, which the profiler can time on its own.
+ ***********************************************************/
+void SceneManager::BeginSection(const char* name)
+{
+	for (size_t i = 0; i < m_sectionNames.size(); i++)
+	{
+		if (m_sectionNames[i] == name)
+		{
+			m_currentSection = (uint8_t)i;
+			return;
+		}
+	}
+
+	m_sectionNames.push_back(name);
+	m_currentSection = (uint8_t)(m_sectionNames.size() - 1);
+}
+
+/***********************************************************
+ *  BeginNode()
+ *
+ *  This method is used for starting a transform node under
+ *  the current node.  The draw items added after it are
+ *  placed relative to the node, until EndNode() returns to
+ *  its parent.
+ ***********************************************************/
+int SceneManager::BeginNode(
+	const char* name,
+	glm::vec3 scaleXYZ,
+	float XrotationDegrees,
+	float YrotationDegrees,
+	float ZrotationDegrees,
+	glm::vec3 positionXYZ)
+{
+	m_currentNode = m_pSceneGraph->AddNode(name, m_currentNode, BuildModelMatrix(
+		scaleXYZ,
+		XrotationDegrees,
+		YrotationDegrees,
+		ZrotationDegrees,
+		positionXYZ));
+
+	return(m_currentNode);
+}
+
+/***********************************************************
+ *  EndNode()
+ *
+ *  This method is used for returning to the parent of the
+ *  current transform node.
+ ***********************************************************/
+void SceneManager::EndNode()
+{
+	if (m_currentNode != SceneGraph::ROOT_NODE)
+	{
+		m_currentNode = m_pSceneGraph->GetParent(m_currentNode);
+	}
+}
+
+/***********************************************************
+ *  DrawSectionQueue()
+ *
+ *  This method is used for drawing the opaque queue section
+ *  by section, with a profiler scope around each one.
+ ***********************************************************/
+void SceneManager::DrawSectionQueue()
+{
+	int openSection = -1;
+
+	for (const RENDER_QUEUE_ENTRY& entry : m_sectionQueue)
+	{
+		int section = m_drawList[entry.itemIndex].section;
+
+		if (section != openSection)
+		{
+			if (openSection >= 0)
+			{
+				m_pProfiler->EndScope();
+			}
+			m_pProfiler->BeginScope(m_sectionNames[section].c_str());
+			openSection = section;
+		}
+		DrawQueueEntry(entry);
+	}
+
+	if (openSection >= 0)
+	{
+		m_pProfiler->EndScope();
+	}
+}
+
+/***********************************************************
+ *  SetStressObjectCount()
+ *
+ *  This method is used for setting the number of draw items
+ *  that the stress scene is filled up to.  The count is
+ *  limited to MAX_STRESS_OBJECTS.
+ ***********************************************************/
+void SceneManager::SetStressObjectCount(int objectCount)
+{
+	m_stressObjectCount = std::max(0, std::min(objectCount, (int)MAX_STRESS_OBJECTS));
+}
+
+/***********************************************************
+ *  BuildStressScene()
+ *
+ *  This method is used for filling the draw list up to the
+ *  stress object count.  The composites of the desk scene -
+ *  every section except for the desk itself - are copied in
+ *  turn into the cells of a square grid around the desk.
+ *  The copies keep their texture, material and section, so
+ *  they batch, sort and profile like the originals.
+ ***********************************************************/
+void SceneManager::BuildStressScene()
+{
+	std::vector<std::vector<int>> composites(m_sectionNames.size());
+	std::vector<glm::vec3> centers(m_sectionNames.size(), glm::vec3(0.0f));
+	int templateItems = (int)m_drawList.size();
+	int templateNodes = m_pSceneGraph->GetNodeCount();
+	int compositeItems = 0;
+
+	for (int i = 0; i < templateItems; i++)
+	{
+		int section = m_drawList[i].section;
+		if (m_sectionNames[section] != "desk")
+		{
+			// the positions are local to the node of the item, and the
+			// items of one section can be under different nodes
+			composites[section].push_back(i);
+			centers[section] += glm::vec3(m_pSceneGraph->GetWorldMatrix(m_drawNodes[i]) * glm::vec4(m_drawPositions[i], 1.0f));
+			compositeItems++;
+		}
+	}
+
+	// each composite is moved so that its center lands on the
+	// center of the cell, only the floor position is changed
+	std::vector<int> tiledSections;
+	for (int section = 0; section < (int)composites.size(); section++)
+	{
+		if (!composites[section].empty())
+		{
+			centers[section] /= (float)composites[section].size();
+			centers[section].y = 0.0f;
+			tiledSections.push_back(section);
+		}
+	}
+	if (tiledSections.empty() || (m_stressObjectCount <= templateItems))
+	{
+		return;
+	}
+
+	// the grid is sized for the cells needed, with room for the
+	// cells that are skipped over the desk
+	float itemsPerCell = (float)compositeItems / (float)tiledSections.size();
+	int cellsNeeded = (int)std::ceil((float)(m_stressObjectCount - templateItems) / itemsPerCell);
+	int deskCells = (int)std::ceil(2.0f * STRESS_DESK_CLEARANCE / STRESS_TILE_SPACING);
+	int gridSize = (int)std::ceil(std::sqrt((float)cellsNeeded)) + deskCells + 1;
+	float gridOrigin = -0.5f * (float)(gridSize - 1) * STRESS_TILE_SPACING;
+
+	m_drawList.reserve((size_t)m_stressObjectCount + compositeItems);
+	m_drawScales.reserve((size_t)m_stressObjectCount + compositeItems);
+	m_drawRotations.reserve((size_t)m_stressObjectCount + compositeItems);
+	m_drawPositions.reserve((size_t)m_stressObjectCount + compositeItems);
+	m_drawNodes.reserve((size_t)m_stressObjectCount + compositeItems);
+
+	int nextComposite = 0;
+	for (int row = 0; (row < gridSize) && ((int)m_drawList.size() < m_stressObjectCount); row++)
+	{
+		for (int column = 0; (column < gridSize) && ((int)m_drawList.size() < m_stressObjectCount); column++)
+		{
+			glm::vec3 cellCenter(
+				gridOrigin + (float)column * STRESS_TILE_SPACING,
+				0.0f,
+				gridOrigin + (float)row * STRESS_TILE_SPACING);
+
+			if ((std::abs(cellCenter.x) < STRESS_DESK_CLEARANCE) &&
+				(std::abs(cellCenter.z) < STRESS_DESK_CLEARANCE))
+			{
+				continue;
+			}
+
+			int section = tiledSections[nextComposite];
+			glm::vec3 offset = cellCenter - centers[section];
+			nextComposite = (nextComposite + 1) % (int)tiledSections.size();
+
+			// each node of the composite gets a copy in the cell, placed
+			// under the root at the moved world matrix of the original,
+			// so the copied items keep their local transformations
+			std::vector<int> copiedNodes(templateNodes, -1);
+			for (int itemIndex : composites[section])
+			{
+				DRAW_ITEM item = m_drawList[itemIndex];
+				int node = m_drawNodes[itemIndex];
+
+				if (copiedNodes[node] < 0)
+				{
+					copiedNodes[node] = m_pSceneGraph->AddNode(
+						m_sectionNames[section],
+						SceneGraph::ROOT_NODE,
+						glm::translate(offset) * m_pSceneGraph->GetWorldMatrix(node));
+				}
+
+				// the model matrix is scale and rotation followed by the
+				// translation, so the offset is added to the translation
+				item.modelMatrix[3] += glm::vec4(offset, 0.0f);
+
+				m_drawList.push_back(item);
+				m_drawScales.push_back(m_drawScales[itemIndex]);
+				m_drawRotations.push_back(m_drawRotations[itemIndex]);
+				m_drawPositions.push_back(m_drawPositions[itemIndex]);
+				m_drawNodes.push_back(copiedNodes[node]);
+				m_pSceneGraph->AttachItem(copiedNodes[node], (int)m_drawList.size() - 1);
+			}
+		}
+	}
+
+	m_stressRadius = 0.5f * (float)gridSize * STRESS_TILE_SPACING;
+
+	std::cout << "INFO: Stress scene with " << m_drawList.size() << " draw items in a "
+		<< gridSize << "x" << gridSize << " grid" << std::endl;
+}
+
+/***********************************************************
+ *  GetMeshBounds()
+ *
+ *  This method is used for getting the local box around a
+ *  basic shape mesh, following the ShapeMeshes conventions.
+ *  The torus boxes are kept loose enough for any thickness.
+ ***********************************************************/
+SceneBVH::BOUNDING_BOX SceneManager::GetMeshBounds(uint8_t mesh)
+{
+	SceneBVH::BOUNDING_BOX box;
+
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		box.minCorner = glm::vec3(-1.0f, 0.0f, -1.0f);
+		box.maxCorner = glm::vec3(1.0f, 0.0f, 1.0f);
+		break;
+	case MESH_BOX:
+		box.minCorner = glm::vec3(-0.5f);
+		box.maxCorner = glm::vec3(0.5f);
+		break;
+	case MESH_CYLINDER:
+	case MESH_TAPERED_CYLINDER:
+	case MESH_HALF_SPHERE:
+		box.minCorner = glm::vec3(-1.0f, 0.0f, -1.0f);
+		box.maxCorner = glm::vec3(1.0f, 1.0f, 1.0f);
+		break;
+	case MESH_SPHERE:
+		box.minCorner = glm::vec3(-1.0f);
+		box.maxCorner = glm::vec3(1.0f);
+		break;
+	default:
+		box.minCorner = glm::vec3(-1.5f);
+		box.maxCorner = glm::vec3(1.5f);
+		break;
+	}
+
+	return(box);
+}
+
+/***********************************************************
+ *  UpdateDrawBounds()
+ *
+ *  This method is used for rebuilding the world space box
+ *  of a draw item from its mesh box and model matrix.
+ ***********************************************************/
+void SceneManager::UpdateDrawBounds(int itemIndex)
+{
+	const DRAW_ITEM& item = m_drawList[itemIndex];
+
+	m_drawBounds[itemIndex] = SceneBVH::TransformBox(GetMeshBounds(item.mesh), item.modelMatrix);
+}
+
+/***********************************************************
+ *  CullScene()
+ *
+ *  This method is used for finding the draw items inside of
+ *  the view frustum and their level of detail.  The
+ *  hierarchy is rebuilt when items have moved, and the
+ *  instance buffer is only uploaded again when the visible
+ *  instances or their levels have changed.
+ ***********************************************************/
+void SceneManager::CullScene()
+{
+	if (m_bFrustumCulling)
+	{
+		SceneBVH::FRUSTUM frustum = SceneBVH::ExtractFrustum(m_projectionMatrix * m_viewMatrix);
+
+		// while many items keep moving, testing every box on all of
+		// the threads is cheaper than rebuilding the hierarchy each
+		// frame, which is then only rebuilt once they have stopped
+		if (m_bBoundsMoved &&
+			((int)m_drawList.size() >= PARALLEL_CULL_MIN_ITEMS) &&
+			(m_pJobSystem->GetThreadCount() > 1))
+		{
+			m_cullCounters = CullDrawBounds(frustum, m_visibleItems);
+		}
+		else
+		{
+			if (m_bBoundsDirty)
+			{
+				m_pSceneBVH->Build(m_drawBounds);
+				m_bBoundsDirty = false;
+			}
+			m_cullCounters = m_pSceneBVH->Cull(frustum, m_visibleItems);
+		}
+	}
+	else
+	{
+		m_visibleItems.assign(m_drawList.size(), 1);
+		m_cullCounters = SceneBVH::CULL_COUNTERS();
+		m_cullCounters.visible = (int)m_drawList.size();
+	}
+	m_bBoundsMoved = false;
+
+	// a change of level of detail of an instanced item also needs
+	// the instances to be packed again
+	SelectLods();
+
+	if (m_bInstancesDirty || (m_visibleItems != m_lastVisibleItems))
+	{
+		UploadVisibleInstances();
+		m_lastVisibleItems = m_visibleItems;
+		m_bInstancesDirty = false;
+	}
+}
+
+/***********************************************************
+ *  CullDrawBounds()
+ *
+ *  This method is used for testing the scene nodes against
+ *  the frustum, and then the box of each draw item below a
+ *  visible node in parallel chunks, into the passed in
+ *  visibility of the items.  The items of a node
+ *  outside of the frustum are culled without a test.  Each
+ *  item only writes its own visibility byte, and each chunk
+ *  adds its count of visible items once.
+ ***********************************************************/
+SceneBVH::CULL_COUNTERS SceneManager::CullDrawBounds(const SceneBVH::FRUSTUM& frustum, std::vector<uint8_t>& visibleItems)
+{
+	SceneBVH::CULL_COUNTERS counters = SceneBVH::CULL_COUNTERS();
+	std::atomic<int> visibleCount(0);
+	int itemCount = (int)m_drawList.size();
+
+	counters.nodesVisited = m_pSceneGraph->CullNodes(frustum, m_visibleNodes);
+
+	visibleItems.resize(itemCount);
+	m_pJobSystem->ParallelFor(itemCount, PARALLEL_CHUNK_ITEMS, [this, &frustum, &visibleItems, &visibleCount](int first, int last)
+	{
+		int visible = 0;
+
+		for (int i = first; i < last; i++)
+		{
+			visibleItems[i] = ((0 != m_visibleNodes[m_drawNodes[i]]) &&
+				SceneBVH::IsBoxVisible(frustum, m_drawBounds[i])) ? 1 : 0;
+			visible += visibleItems[i];
+		}
+		visibleCount += visible;
+	});
+
+	counters.visible = visibleCount;
+	counters.culled = itemCount - counters.visible;
+
+	return(counters);
+}
+
+/***********************************************************
+ *  UploadVisibleInstances()
+ *
+ *  This method is used for packing the matrices of the
+ *  visible instances of each batch next to each other, in
+ *  order of their level of detail, and copying them into
+ *  the instance buffer.
+ ***********************************************************/
+void SceneManager::UploadVisibleInstances()
+{
+	m_visibleInstanceTransforms.clear();
+
+	for (INSTANCE_BATCH& batch : m_instanceBatches)
+	{
+		batch.visibleFirst = (int)m_visibleInstanceTransforms.size();
+		for (int lod = 0; lod < MeshLibrary::MAX_LOD_LEVELS; lod++)
+		{
+			int lodFirst = (int)m_visibleInstanceTransforms.size();
+			for (int i = batch.firstInstance; i < batch.firstInstance + batch.instanceCount; i++)
+			{
+				int itemIndex = m_instanceItems[i];
+				if ((0 != m_visibleItems[itemIndex]) && (m_drawList[itemIndex].lod == lod))
+				{
+					m_visibleInstanceTransforms.push_back(m_instanceTransforms[i]);
+				}
+			}
+			batch.lodCounts[lod] = (int)m_visibleInstanceTransforms.size() - lodFirst;
+		}
+		batch.visibleCount = (int)m_visibleInstanceTransforms.size() - batch.visibleFirst;
+	}
+
+	if (false == m_visibleInstanceTransforms.empty())
+	{
+		m_instancedMeshes->SetInstanceTransforms(m_visibleInstanceTransforms);
+	}
+}
+
+/***********************************************************
+ *  SelectLods()
+ *
+ *  This method is used for picking the level of detail of
+ *  the visible draw items by their size on the screen.  The
+ *  curved shapes need their tessellation for the width of
+ *  their cross-section rather than for their length, so the
+ *  size is the middle extent of the world space box, which
+ *  keeps thin objects such as grass blades coarse.  Hidden
+ *  items keep the level they were last drawn at.
+ ***********************************************************/
+void SceneManager::SelectLods()
+{
+	for (int i = 0; i < (int)m_drawList.size(); i++)
+	{
+		DRAW_ITEM& item = m_drawList[i];
+		int lodCount = m_instancedMeshes->GetLodCount(item.mesh);
+		uint8_t lod = 0;
+
+		if (0 == m_visibleItems[i])
+		{
+			continue;
+		}
+
+		if (m_bLodSelection && (lodCount > 1))
+		{
+			const SceneBVH::BOUNDING_BOX& box = m_drawBounds[i];
+			glm::vec3 extents = box.maxCorner - box.minCorner;
+			float middleExtent = std::max(std::min(extents.x, extents.y),
+				std::min(std::max(extents.x, extents.y), extents.z));
+			glm::vec4 viewCenter = m_viewMatrix * glm::vec4(0.5f * (box.minCorner + box.maxCorner), 1.0f);
+
+			// the clip space w is the view distance for a perspective
+			// projection and one for an orthographic projection
+			float clipW = (m_projectionMatrix[2][3] * viewCenter.z) + m_projectionMatrix[3][3];
+			float screenSize = 0.5f * middleExtent * m_projectionMatrix[1][1] / std::max(clipW, 0.1f);
+
+			lod = SelectLod(screenSize, item.lod, lodCount);
+		}
+
+		if (lod != item.lod)
+		{
+			item.lod = lod;
+			if (item.instanceIndex >= 0)
+			{
+				m_bInstancesDirty = true;
+			}
+			if (item.drawIndex >= 0)
+			{
+				m_pIndirectRenderer->SetCommandRange(item.drawIndex, m_instancedMeshes->GetMeshRange(item.mesh, lod));
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  SelectLod()
+ *
+ *  This method is used for getting the level of detail for
+ *  a screen size.  The level only moves when the size is
+ *  past the switch point of the current level by the
+ *  hysteresis, so an item does not switch back and forth.
+ ***********************************************************/
+uint8_t SceneManager::SelectLod(float screenSize, uint8_t currentLod, int lodCount)
+{
+	int lod = std::min((int)currentLod, lodCount - 1);
+
+	while ((lod > 0) && (screenSize > LOD_SCREEN_SIZES[lod - 1] * (1.0f + LOD_HYSTERESIS)))
+	{
+		lod--;
+	}
+	while ((lod < lodCount - 1) && (screenSize < LOD_SCREEN_SIZES[lod] * (1.0f - LOD_HYSTERESIS)))
+	{
+		lod++;
+	}
+
+	return((uint8_t)lod);
+}
+
+/***********************************************************
+ *  BuildIndirectDraws()
+ *
+ *  This method is used for giving the static opaque items
+ *  that have a mesh in the shared mesh library to the GPU
+ *  driven path.  Each item gets one indirect command, and
+ *  the commands are ordered so that the items using the
+ *  same texture array are next to each other and can be
+ *  drawn with one multi draw call.
+ ***********************************************************/
+void SceneManager::BuildIndirectDraws()
+{
+	std::vector<int> items;
+	std::vector<IndirectRenderer::INDIRECT_OBJECT> objects;
+	std::vector<MeshLibrary::DRAW_COMMAND> commands;
+	std::vector<SceneBVH::BOUNDING_BOX> bounds;
+	std::vector<IndirectRenderer::INDIRECT_MATERIAL> materials;
+
+	m_indirectGroups.clear();
+	for (int i = 0; i < (int)m_drawList.size(); i++)
+	{
+		m_drawList[i].drawIndex = -1;
+		if ((m_drawList[i].variant == DRAW_ALL) &&
+			(m_instancedMeshes->HasMesh(m_drawList[i].mesh)) &&
+			(false == IsTransparent(m_drawList[i])))
+		{
+			items.push_back(i);
+		}
+	}
+	if (items.empty())
+	{
+		return;
+	}
+
+	// the untextured items sort after all of the texture pages
+	auto pageOf = [this](int i)
+	{
+		TextureHandle texture = m_drawList[i].texture;
+		return((texture != INVALID_HANDLE) ? m_textureIDs[texture].page : INT_MAX);
+	};
+	std::stable_sort(items.begin(), items.end(), [this, &pageOf](int a, int b)
+	{
+		if (pageOf(a) != pageOf(b)) return(pageOf(a) < pageOf(b));
+		if (m_drawList[a].mesh != m_drawList[b].mesh) return(m_drawList[a].mesh < m_drawList[b].mesh);
+		return(m_drawList[a].material < m_drawList[b].material);
+	});
+
+	int groupPage = 0;
+	for (int itemIndex : items)
+	{
+		DRAW_ITEM& item = m_drawList[itemIndex];
+		const MeshLibrary::MESH_RANGE& range = m_instancedMeshes->GetMeshRange(item.mesh, item.lod);
+		MeshLibrary::DRAW_COMMAND command;
+		int drawIndex = (int)commands.size();
+
+		// the base instance is the draw index the shader reads
+		command.count = (GLuint)range.indexCount;
+		command.instanceCount = 1;
+		command.firstIndex = range.firstIndex;
+		command.baseVertex = range.baseVertex;
+		command.baseInstance = (GLuint)drawIndex;
+
+		// a new group starts with each texture page
+		int page = pageOf(itemIndex);
+		if (m_indirectGroups.empty() || (page != groupPage))
+		{
+			INDIRECT_GROUP group;
+			group.firstCommand = drawIndex;
+			group.commandCount = 0;
+			group.texture = item.texture;
+			m_indirectGroups.push_back(group);
+			groupPage = page;
+		}
+		m_indirectGroups.back().commandCount++;
+
+		item.drawIndex = drawIndex;
+		objects.push_back(BuildIndirectObject(item));
+		commands.push_back(command);
+		bounds.push_back(m_drawBounds[itemIndex]);
+	}
+
+	for (const OBJECT_MATERIAL& material : m_objectMaterials)
+	{
+		IndirectRenderer::INDIRECT_MATERIAL data;
+		data.diffuseColor = material.diffuseColor;
+		data.shininess = material.shininess;
+		data.specularColor = material.specularColor;
+		data.ambientStrength = material.ambientStrength;
+		data.ambientColor = material.ambientColor;
+		data.pad0 = 0.0f;
+		materials.push_back(data);
+	}
+	m_pIndirectRenderer->SetMaterials(materials);
+
+	// the items stay on the CPU path when they do not fit
+	if (false == m_pIndirectRenderer->SetObjects(objects, commands, bounds))
+	{
+		for (int itemIndex : items)
+		{
+			m_drawList[itemIndex].drawIndex = -1;
+		}
+		m_indirectGroups.clear();
+		return;
+	}
+	m_instancedMeshes->SetDrawIndexCount((int)commands.size());
+
+	std::cout << "INFO: " << commands.size() << " draw items in "
+		<< m_indirectGroups.size() << " multi draw indirect groups" << std::endl;
+}
+
+/***********************************************************
+ *  BuildIndirectObject()
+ *
+ *  This method is used for getting the per draw values of
+ *  an item on the indirect path.  The items that keep the
+ *  current material are drawn with the first material.
+ ***********************************************************/
+IndirectRenderer::INDIRECT_OBJECT SceneManager::BuildIndirectObject(const DRAW_ITEM& item) const
+{
+	IndirectRenderer::INDIRECT_OBJECT object;
+
+	object.modelMatrix = item.modelMatrix;
+	PackNormalMatrix(item.normalMatrix, object.normalMatrix);
+	object.color = item.color;
+	object.uvScale = item.uvScale;
+	object.textureLayer = 0.0f;
+	object.materialIndex = 0.0f;
+	if (item.texture != INVALID_HANDLE)
+	{
+		object.textureLayer = (float)m_textureIDs[item.texture].layer;
+	}
+	if (item.material != INVALID_HANDLE)
+	{
+		object.materialIndex = (float)item.material;
+	}
+
+	return(object);
+}
+
+/***********************************************************
+ *  IsIndirectActive()
+ *
+ *  This method is used for checking if the indirect path
+ *  draws its items this frame.  The per draw data holds the
+ *  final texture layers, so the path waits for all of the
+ *  textures, and it is left out while the sections are
+ *  timed one by one.
+ ***********************************************************/
+bool SceneManager::IsIndirectActive() const
+{
+	if ((false == m_bIndirectDrawing) || m_indirectGroups.empty())
+	{
+		return(false);
+	}
+	if ((NULL != m_pProfiler) && (m_bProfileSections))
+	{
+		return(false);
+	}
+
+	return(AreTexturesLoaded());
+}
+
+/***********************************************************
+ *  CullIndirectObjects()
+ *
+ *  This method is used for culling the indirect commands
+ *  against the view frustum on the GPU.  The culled commands
+ *  draw zero instances, in the depth pre-pass as well as in
+ *  the shading pass.
+ ***********************************************************/
+void SceneManager::CullIndirectObjects()
+{
+	SceneBVH::FRUSTUM frustum = SceneBVH::ExtractFrustum(m_projectionMatrix * m_viewMatrix);
+	GLuint program = (NULL != m_pUniformCache) ? m_pUniformCache->GetProgram() : 0;
+
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginScope("GpuCull");
+	}
+	m_pIndirectRenderer->CullObjects(frustum, m_bFrustumCulling, program);
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndScope();
+	}
+}
+
+/***********************************************************
+ *  DrawIndirectGroups()
+ *
+ *  This method is used for drawing the culled indirect
+ *  commands with one multi draw call for each group that
+ *  shares a texture array.
+ ***********************************************************/
+void SceneManager::DrawIndirectGroups()
+{
+	m_pStateFilter->SetUseInstancing(false);
+	m_pStateFilter->SetUseDrawData(true);
+	for (const INDIRECT_GROUP& group : m_indirectGroups)
+	{
+		// the layer of each draw comes from the draw data, so
+		// only the texture array unit is selected here
+		if (group.texture != INVALID_HANDLE)
+		{
+			SetTextureState(group.texture);
+		}
+		else
+		{
+			m_pStateFilter->SetUseTexture(false);
+		}
+
+		m_instancedMeshes->DrawIndirect(
+			m_pIndirectRenderer->GetCommandBuffer(),
+			group.firstCommand,
+			group.commandCount);
+		m_drawCalls++;
+	}
+	m_pStateFilter->SetUseDrawData(false);
+}
+
+/***********************************************************
+ *  SortTransparentQueue()
+ *
+ *  This method is used for sorting the transparent draws by
+ *  the view depth of their origin, farthest first, so that
+ *  they blend correctly over each other.
+ ***********************************************************/
+void SceneManager::SortTransparentQueue()
+{
+	for (RENDER_QUEUE_ENTRY& entry : m_transparentQueue)
+	{
+		glm::vec4 viewPosition = m_viewMatrix * m_drawList[entry.itemIndex].modelMatrix[3];
+
+		// the camera looks down the negative Z axis
+		entry.viewDepth = -viewPosition.z;
+	}
+
+	std::sort(m_transparentQueue.begin(), m_transparentQueue.end(),
+		[](const RENDER_QUEUE_ENTRY& a, const RENDER_QUEUE_ENTRY& b)
+		{
+			return(a.viewDepth > b.viewDepth);
+		});
+}
+
+/***********************************************************
+ *  SortFrontToBack()
+ *
+ *  This method is used for ordering a copy of the opaque
+ *  queue by the view depth of the draws, nearest first, so
+ *  that the hidden surfaces fail the depth test before they
+ *  are shaded.  A batch sorts by its nearest visible instance.
+ ***********************************************************/
+void SceneManager::SortFrontToBack()
+{
+	m_depthSortedQueue = m_opaqueQueue;
+	for (RENDER_QUEUE_ENTRY& entry : m_depthSortedQueue)
+	{
+		// the camera looks down the negative Z axis
+		if (entry.batchIndex < 0)
+		{
+			entry.viewDepth = -(m_viewMatrix * m_drawList[entry.itemIndex].modelMatrix[3]).z;
+			continue;
+		}
+
+		const INSTANCE_BATCH& batch = m_instanceBatches[entry.batchIndex];
+		entry.viewDepth = FLT_MAX;
+		for (int i = batch.firstInstance; i < batch.firstInstance + batch.instanceCount; i++)
+		{
+			int itemIndex = m_instanceItems[i];
+			if (0 != m_visibleItems[itemIndex])
+			{
+				float depth = -(m_viewMatrix * m_drawList[itemIndex].modelMatrix[3]).z;
+				entry.viewDepth = std::min(entry.viewDepth, depth);
+			}
+		}
+	}
+
+	std::sort(m_depthSortedQueue.begin(), m_depthSortedQueue.end(),
+		[](const RENDER_QUEUE_ENTRY& a, const RENDER_QUEUE_ENTRY& b)
+		{
+			return(a.viewDepth < b.viewDepth);
+		});
+}
+
+/***********************************************************
+ *  DrawDepthPrepass()
+ *
+ *  This method is used for drawing the depth of the opaque
+ *  scene with the position only program.  The indirect
+ *  commands are all drawn with one call, since the depth
+ *  does not depend on the texture array.
+ ***********************************************************/
+void SceneManager::DrawDepthPrepass()
+{
+	m_pStateFilter->UseProgram(m_pDepthPrepass->GetProgram());
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+
+	if (m_bIndirectFrame)
+	{
+		m_pDepthPrepass->SetUseInstancing(false);
+		m_pDepthPrepass->SetUseDrawData(true);
+		m_instancedMeshes->DrawIndirect(
+			m_pIndirectRenderer->GetCommandBuffer(),
+			0,
+			m_pIndirectRenderer->GetObjectCount());
+		m_drawCalls++;
+		m_pDepthPrepass->SetUseDrawData(false);
+	}
+
+	for (const RENDER_QUEUE_ENTRY& entry : m_opaqueQueue)
+	{
+		DrawDepthEntry(entry);
+	}
+
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+	if (NULL != m_pUniformCache)
+	{
+		m_pStateFilter->UseProgram(m_pUniformCache->GetProgram());
+	}
+}
+
+/***********************************************************
+ *  DrawDepthEntry()
+ *
+ *  This method is used for drawing the depth of one opaque
+ *  queue entry, with the same meshes and levels of detail
+ *  as the shading pass so that their depths are equal.
+ ***********************************************************/
+void SceneManager::DrawDepthEntry(const RENDER_QUEUE_ENTRY& entry)
+{
+	const DRAW_ITEM& item = m_drawList[entry.itemIndex];
+
+	if (false == IsEntryDrawn(entry))
+	{
+		return;
+	}
+
+	if (entry.batchIndex < 0)
+	{
+		m_pDepthPrepass->SetUseInstancing(false);
+		DrawItemDepth(item, item.lod);
+		return;
+	}
+
+	const INSTANCE_BATCH& batch = m_instanceBatches[entry.batchIndex];
+	m_pDepthPrepass->SetUseInstancing(true);
+	int lodFirst = batch.visibleFirst;
+	for (int lod = 0; lod < MeshLibrary::MAX_LOD_LEVELS; lod++)
+	{
+		if (batch.lodCounts[lod] > 0)
+		{
+			m_instancedMeshes->DrawInstanced(item.mesh, lod, lodFirst, batch.lodCounts[lod]);
+			m_drawCalls++;
+		}
+		lodFirst += batch.lodCounts[lod];
+	}
+}
+
+/***********************************************************
+ *  DrawItemDepth()
+ *
+ *  This method is used for drawing the depth of a single
+ *  draw item, with the depth only program current.
+ ***********************************************************/
+void SceneManager::DrawItemDepth(const DRAW_ITEM& item, int lod)
+{
+	m_objectBlock.model = item.modelMatrix;
+	UploadObjectBlock();
+	if ((item.variant == DRAW_ALL) && (m_instancedMeshes->HasMesh(item.mesh)))
+	{
+		m_instancedMeshes->Draw(item.mesh, lod);
+		m_drawCalls++;
+		return;
+	}
+	DrawMesh(item.mesh, item.variant);
+}
+
+/***********************************************************
+ *  UpdateShadowMaps()
+ *
+ *  This method is used for fitting the atlas tiles to the
+ *  directional light and the flashlight, and for drawing
+ *  the maps that are out of date.  A map is kept for as
+ *  long as its light matrix stays the same and no shadow
+ *  caster has moved, so most frames draw nothing here.
+ ***********************************************************/
+void SceneManager::UpdateShadowMaps()
+{
+	bool bDrawn = false;
+	bool bInstancesReplaced = false;
+
+	if ((NULL == m_pLightManager) ||
+		(false == m_pShadowAtlas->IsReady()) ||
+		(false == m_pDepthPrepass->IsReady()))
+	{
+		return;
+	}
+
+	// the directional map covers the box of the whole scene, so it
+	// only changes when the scene does
+	const SceneBVH::BOUNDING_BOX& sceneBox = m_pSceneGraph->GetBounds(SceneGraph::ROOT_NODE);
+	glm::vec3 center = 0.5f * (sceneBox.minCorner + sceneBox.maxCorner);
+	float radius = std::max(0.5f * glm::length(sceneBox.maxCorner - sceneBox.minCorner), SHADOW_MIN_RADIUS);
+	glm::vec3 direction = glm::normalize(m_pLightManager->GetDirectionalLightDirection());
+	glm::mat4 lightView = glm::lookAt(center - direction * radius, center, ShadowUpVector(direction));
+	glm::mat4 lightProjection = glm::ortho(-radius, radius, -radius, radius, 0.0f, 2.0f * radius);
+	m_pShadowAtlas->SetTileLight(
+		ShadowAtlas::TILE_DIRECTIONAL,
+		lightProjection * lightView,
+		2.0f * radius / (float)ShadowAtlas::TILE_SIZE,
+		DIRECTIONAL_SHADOW_BIAS,
+		m_pLightManager->IsDirectionalLightActive());
+
+	// the flashlight map covers its cone, and follows the camera
+	glm::vec3 position = m_pLightManager->GetFlashlightPosition();
+	float fieldOfView = glm::radians(2.0f * m_pLightManager->GetFlashlightConeAngle());
+	direction = glm::normalize(m_pLightManager->GetFlashlightDirection());
+	lightView = glm::lookAt(position, position + direction, ShadowUpVector(direction));
+	lightProjection = glm::perspective(fieldOfView, 1.0f, FLASHLIGHT_SHADOW_NEAR, FLASHLIGHT_SHADOW_FAR);
+	m_pShadowAtlas->SetTileLight(
+		ShadowAtlas::TILE_FLASHLIGHT,
+		lightProjection * lightView,
+		2.0f * tanf(0.5f * fieldOfView) / (float)ShadowAtlas::TILE_SIZE,
+		FLASHLIGHT_SHADOW_BIAS,
+		m_pLightManager->IsFlashlightActive());
+
+	for (int tile = 0; tile < ShadowAtlas::TILE_COUNT; tile++)
+	{
+		if (false == m_pShadowAtlas->IsTileDirty(tile))
+		{
+			continue;
+		}
+
+		if (false == bDrawn)
+		{
+			if (NULL != m_pProfiler)
+			{
+				m_pProfiler->BeginScope("ShadowMaps");
+			}
+			m_pStateFilter->UseProgram(m_pDepthPrepass->GetProgram());
+			m_pDepthPrepass->SetUseInstancing(false);
+			m_pDepthPrepass->SetUseDrawData(false);
+			bDrawn = true;
+		}
+		if (DrawShadowTile(tile))
+		{
+			bInstancesReplaced = true;
+		}
+	}
+
+	if (bDrawn)
+	{
+		// the camera of the frame is bound again in place of the tiles,
+		// and the instances visible to the camera are uploaded again
+		m_pUniformRing->EndPass();
+		if (bInstancesReplaced && (false == m_visibleInstanceTransforms.empty()))
+		{
+			m_instancedMeshes->SetInstanceTransforms(m_visibleInstanceTransforms);
+		}
+		if (NULL != m_pUniformCache)
+		{
+			m_pStateFilter->UseProgram(m_pUniformCache->GetProgram());
+		}
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->EndScope();
+		}
+	}
+	m_pShadowAtlas->UploadShadowBlock();
+}
+
+/***********************************************************
+ *  CullShadowCasters()
+ *
+ *  This method is used for finding the draw items inside the
+ *  frustum of a light with the same hierarchy the camera is
+ *  culled with.  While items keep moving the hierarchy is
+ *  left out of date, and the boxes are tested on all of the
+ *  threads instead, as the camera culling does.
+ ***********************************************************/
+void SceneManager::CullShadowCasters(const SceneBVH::FRUSTUM& frustum)
+{
+	if (m_bBoundsDirty &&
+		((int)m_drawList.size() >= PARALLEL_CULL_MIN_ITEMS) &&
+		(m_pJobSystem->GetThreadCount() > 1))
+	{
+		CullDrawBounds(frustum, m_shadowCasters);
+		return;
+	}
+
+	if (m_bBoundsDirty)
+	{
+		m_pSceneBVH->Build(m_drawBounds);
+		m_bBoundsDirty = false;
+	}
+	m_pSceneBVH->Cull(frustum, m_shadowCasters);
+}
+
+/***********************************************************
+ *  DrawShadowTile()
+ *
+ *  This method is used for drawing the depth of the opaque
+ *  items inside the light frustum of a tile.  The items of
+ *  the indirect path are drawn with one multi draw call,
+ *  the instanced batches with one call for each batch, and
+ *  only the rest one by one.  Every caster is drawn at the
+ *  finest level of detail, so that the map does not depend
+ *  on the levels picked for the camera.
+ ***********************************************************/
+bool SceneManager::DrawShadowTile(int tile)
+{
+	CAMERA_BLOCK camera;
+	const glm::mat4& viewProjection = m_pShadowAtlas->GetTileMatrix(tile);
+	SceneBVH::FRUSTUM frustum = SceneBVH::ExtractFrustum(viewProjection);
+
+	// only the view projection matrix is read by the depth program
+	camera.view = glm::mat4(1.0f);
+	camera.viewProjection = viewProjection;
+	camera.viewPosition = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+	// the block stays bound while the object blocks of the casters are
+	// written, also when they fill the region and it starts over
+	m_pUniformRing->BindPassBlock(UniformCache::CAMERA_BLOCK_BINDING, &camera, sizeof(CAMERA_BLOCK));
+
+	CullShadowCasters(frustum);
+
+	// the casters of the indirect path read their model matrix from
+	// the draw data, by the object index in their base instance
+	m_shadowCommands.clear();
+	if (m_bIndirectFrame)
+	{
+		for (int i = 0; i < (int)m_drawList.size(); i++)
+		{
+			const DRAW_ITEM& item = m_drawList[i];
+
+			if ((0 == m_shadowCasters[i]) || (item.drawIndex < 0) || IsTransparent(item))
+			{
+				continue;
+			}
+
+			const MeshLibrary::MESH_RANGE& range = m_instancedMeshes->GetMeshRange(item.mesh, 0);
+			MeshLibrary::DRAW_COMMAND command;
+			command.count = (GLuint)range.indexCount;
+			command.instanceCount = 1;
+			command.firstIndex = range.firstIndex;
+			command.baseVertex = range.baseVertex;
+			command.baseInstance = (GLuint)item.drawIndex;
+			m_shadowCommands.push_back(command);
+		}
+		m_pIndirectRenderer->SetCasterCommands(m_shadowCommands);
+	}
+
+	// the casters of each instanced batch are packed next to each
+	// other, in place of the instances visible to the camera
+	m_shadowBatches.clear();
+	m_shadowInstanceTransforms.clear();
+	for (const INSTANCE_BATCH& batch : m_instanceBatches)
+	{
+		SHADOW_BATCH shadowBatch;
+
+		if (IsTransparent(m_drawList[batch.itemIndex]))
+		{
+			continue;
+		}
+
+		shadowBatch.mesh = m_drawList[batch.itemIndex].mesh;
+		shadowBatch.firstInstance = (int)m_shadowInstanceTransforms.size();
+		for (int i = batch.firstInstance; i < batch.firstInstance + batch.instanceCount; i++)
+		{
+			int itemIndex = m_instanceItems[i];
+			if ((0 != m_shadowCasters[itemIndex]) &&
+				((false == m_bIndirectFrame) || (m_drawList[itemIndex].drawIndex < 0)))
+			{
+				m_shadowInstanceTransforms.push_back(m_instanceTransforms[i]);
+			}
+		}
+		shadowBatch.instanceCount = (int)m_shadowInstanceTransforms.size() - shadowBatch.firstInstance;
+		if (shadowBatch.instanceCount > 0)
+		{
+			m_shadowBatches.push_back(shadowBatch);
+		}
+	}
+	if (false == m_shadowInstanceTransforms.empty())
+	{
+		m_instancedMeshes->SetInstanceTransforms(m_shadowInstanceTransforms);
+	}
+
+	m_pShadowAtlas->BeginTile(tile);
+	if (false == m_shadowCommands.empty())
+	{
+		m_pDepthPrepass->SetUseDrawData(true);
+		m_instancedMeshes->DrawIndirect(
+			m_pIndirectRenderer->GetCasterCommandBuffer(),
+			0,
+			(int)m_shadowCommands.size());
+		m_drawCalls++;
+		m_pDepthPrepass->SetUseDrawData(false);
+	}
+	if (false == m_shadowBatches.empty())
+	{
+		m_pDepthPrepass->SetUseInstancing(true);
+		for (const SHADOW_BATCH& shadowBatch : m_shadowBatches)
+		{
+			m_instancedMeshes->DrawInstanced(shadowBatch.mesh, 0, shadowBatch.firstInstance, shadowBatch.instanceCount);
+			m_drawCalls++;
+		}
+		m_pDepthPrepass->SetUseInstancing(false);
+	}
+	for (int i = 0; i < (int)m_drawList.size(); i++)
+	{
+		const DRAW_ITEM& item = m_drawList[i];
+
+		if ((0 == m_shadowCasters[i]) || (item.instanceIndex >= 0) ||
+			(m_bIndirectFrame && (item.drawIndex >= 0)) || IsTransparent(item))
+		{
+			continue;
+		}
+		DrawItemDepth(item, 0);
+	}
+	m_pShadowAtlas->EndTile(tile);
+
+	return(false == m_shadowInstanceTransforms.empty());
+}
+
+/***********************************************************
+ *  IsEntryDrawn()
+ *
+ *  This method is used for checking if a render queue entry
+ *  is visible and is not drawn by the indirect path.
+ ***********************************************************/
+bool SceneManager::IsEntryDrawn(const RENDER_QUEUE_ENTRY& entry) const
+{
+	// the items of the indirect path, which include all of the
+	// instanced ones, are drawn by DrawIndirectGroups()
+	if (m_bIndirectFrame && (m_drawList[entry.itemIndex].drawIndex >= 0))
+	{
+		return(false);
+	}
+
+	if (entry.batchIndex < 0)
+	{
+		return(0 != m_visibleItems[entry.itemIndex]);
+	}
+
+	return(m_instanceBatches[entry.batchIndex].visibleCount > 0);
+}
+
+/***********************************************************
+ *  DrawQueueEntry()
+ *
+ *  This method is used for drawing one render queue entry,
+ *  either as a single draw item or as an instanced batch.
+ ***********************************************************/
+void SceneManager::DrawQueueEntry(const RENDER_QUEUE_ENTRY& entry)
+{
+	const DRAW_ITEM& item = m_drawList[entry.itemIndex];
+
+	if (false == IsEntryDrawn(entry))
+	{
+		return;
+	}
+
+	if (entry.batchIndex < 0)
+	{
+		m_pStateFilter->SetUseInstancing(false);
+		DrawItem(item);
+		return;
+	}
+
+	// the repeated objects only differ by their model matrix, so
+	// each batch is drawn with one call for its visible instances
+	const INSTANCE_BATCH& batch = m_instanceBatches[entry.batchIndex];
+
+	// one instanced call is made for each level of detail in use
+	m_pStateFilter->SetUseInstancing(true);
+	SetDrawItemState(item);
+	UploadObjectBlock();
+	int lodFirst = batch.visibleFirst;
+	for (int lod = 0; lod < MeshLibrary::MAX_LOD_LEVELS; lod++)
+	{
+		if (batch.lodCounts[lod] > 0)
+		{
+			m_instancedMeshes->DrawInstanced(item.mesh, lod, lodFirst, batch.lodCounts[lod]);
+			m_drawCalls++;
+		}
+		lodFirst += batch.lodCounts[lod];
+	}
+}
+
+/***********************************************************
+ *  SetDrawItemState()
+ *
+ *  This method is used for setting the pre-resolved shader
+ *  values of a draw item, except for its model matrix.  The
+ *  object values are only copied to the ring buffer once
+ *  they are all set, by the caller.
+ ***********************************************************/
+void SceneManager::SetDrawItemState(const DRAW_ITEM& item)
+{
+	if (item.texture != INVALID_HANDLE)
+	{
+		SetTextureState(item.texture);
+	}
+	else
+	{
+		m_pStateFilter->SetUseTexture(false);
+		m_objectBlock.color = item.color;
+	}
+
+	if (item.material != INVALID_HANDLE)
+	{
+		SetShaderMaterial(item.material);
+	}
+
+	m_objectBlock.params.x = item.uvScale.x;
+	m_objectBlock.params.y = item.uvScale.y;
+}
+
+/***********************************************************
+ *  DrawItem()
+ *
+ *  This method is used for setting the pre-resolved shader
+ *  values of a draw item and drawing its mesh.
+ ***********************************************************/
+void SceneManager::DrawItem(const DRAW_ITEM& item)
+{
+	if (NULL == m_pUniformCache)
+	{
+		return;
+	}
+
+	SetDrawItemState(item);
+	m_objectBlock.model = item.modelMatrix;
+	PackNormalMatrix(item.normalMatrix, m_objectBlock.normalMatrix);
+	UploadObjectBlock();
+
+	// the complete meshes are drawn from the shared mesh library so
+	// that they can use their level of detail
+	if ((item.variant == DRAW_ALL) && (m_instancedMeshes->HasMesh(item.mesh)))
+	{
+		m_instancedMeshes->Draw(item.mesh, item.lod);
+		m_drawCalls++;
+		return;
+	}
+
+	DrawMesh(item.mesh, item.variant);
+}
+
+/***********************************************************
+ *  DrawMesh()
+ *
+ *  This method is used for drawing the basic shape mesh
+ *  that is referenced by a draw item.
+ ***********************************************************/
+void SceneManager::DrawMesh(uint8_t mesh, uint8_t variant)
+{
+	bool bDrawTop = (variant & DRAW_TOP) != 0;
+	bool bDrawBottom = (variant & DRAW_BOTTOM) != 0;
+	bool bDrawSides = (variant & DRAW_SIDES) != 0;
+
+	UploadDirtyObjectBlock();
+	m_drawCalls++;
+	switch (mesh)
+	{
+	case MESH_PLANE:
+		m_basicMeshes->DrawPlaneMesh();
+		break;
+	case MESH_BOX:
+		m_basicMeshes->DrawBoxMesh();
+		break;
+	case MESH_CYLINDER:
+		m_basicMeshes->DrawCylinderMesh(bDrawTop, bDrawBottom, bDrawSides);
+		break;
+	case MESH_TAPERED_CYLINDER:
+		m_basicMeshes->DrawTaperedCylinderMesh(bDrawTop, bDrawBottom, bDrawSides);
+		break;
+	case MESH_SPHERE:
+		m_basicMeshes->DrawSphereMesh();
+		break;
+	case MESH_HALF_SPHERE:
+		m_basicMeshes->DrawHalfSphereMesh();
+		break;
+	case MESH_TORUS:
+		m_basicMeshes->DrawTorusMesh();
+		break;
+	case MESH_HALF_TORUS:
+		m_basicMeshes->DrawHalfTorusMesh();
+		break;
+	}
+}
+
+/**************************************************************/
+/*** STUDENTS CAN MODIFY the code in the methods BELOW for  ***/
+/*** preparing and rendering their own 3D replicated scenes.***/
+/*** Please refer to the code in the OpenGL sample project  ***/
+/*** for assistance.                                        ***/
+/**************************************************************/
+
+void SceneManager::LoadSceneTextures()
+{
+	// the scene file lists its own textures
+	if (m_pSceneFile->IsLoaded())
+	{
+		const SceneFile::SCENE_TEXTURE* textures = m_pSceneFile->GetTextures();
+		for (int i = 0; i < m_pSceneFile->GetTextureCount(); i++)
+		{
+			CreateGLTexture(textures[i].filename, textures[i].tag);
+		}
+		BindGLTextures();
+		return;
+	}
+
+	CreateGLTexture("./Debug/textures/wood_light_seamless.jpg", "wood");
+	CreateGLTexture("./Debug/textures/marble_light_seamless.jpg", "marble1");
+	CreateGLTexture("./Debug/textures/leather_black_seamless.jpg", "leather1");
+	CreateGLTexture("./Debug/textures/paper_textured_seamless.jpg", "paper");
+	CreateGLTexture("./Debug/textures/leather_brown_seamless.jpg", "leather2");
+	CreateGLTexture("./Debug/textures/paper_brown_seamless.jpg", "paper2");
+	CreateGLTexture("./Debug/textures/leather_tan_seamless.jpg", "leather3");
+	CreateGLTexture("./Debug/textures/marble_light2_seamless.jpg", "marble2");
+	CreateGLTexture("./Debug/textures/ground_textured_seamless.jpg", "ground");
+	CreateGLTexture("./Debug/textures/grass_textured1_seamless.jpg", "grass1");
+	CreateGLTexture("./Debug/textures/grass_textured2_seamless.jpg", "grass2");
+	CreateGLTexture("./Debug/textures/pattern_flowers_seamless.jpg", "pattern");
+	CreateGLTexture("./Debug/textures/fabric_textured_seamless.jpg", "fabric");
+	CreateGLTexture("./Debug/textures/wood_cherry_seamless.jpg", "wood2");
+	BindGLTextures();
+}
+
+/***********************************************************
+ *  SetupSceneLights()
+ *
+ *  This method is used for adding the lights of the scene to
+ *  the light manager.  The shader reads them from its light
+ *  block, so they are only uploaded after they change.
+ ***********************************************************/
+void SceneManager::SetupSceneLights(LightManager* pLightManager)
+{
+	if (NULL == pLightManager)
+	{
+		return;
+	}
+	m_pLightManager = pLightManager;
+
+	// the sun shining down on the desk
+	pLightManager->SetDirectionalLight(glm::vec3(-0.2f, -1.0f, -0.3f), 1.0f);
+	pLightManager->SetDirectionalLightActive(true);
+
+	// the four white desk lights reach the whole scene
+	pLightManager->ClearPointLights();
+	pLightManager->AddPointLight(glm::vec3(1.5f, 2.0f, 1.5f), glm::vec3(1.0f), 1.0f, 0.0f);
+	pLightManager->AddPointLight(glm::vec3(-1.5f, 2.0f, 1.5f), glm::vec3(1.0f), 1.0f, 0.0f);
+	pLightManager->AddPointLight(glm::vec3(1.5f, 2.0f, -1.5f), glm::vec3(1.0f), 1.0f, 0.0f);
+	pLightManager->AddPointLight(glm::vec3(-1.5f, 2.0f, -1.5f), glm::vec3(1.0f), 1.0f, 0.0f);
+
+	// the flashlight starts off
+	pLightManager->SetFlashlightIntensity(1.0f);
+	pLightManager->SetFlashlightActive(false);
+}
+
+void SceneManager::DefineObjectMaterials()
+{
+	OBJECT_MATERIAL wood;
+	wood.ambientColor = glm::vec3(0.2f, 0.1f, 0.05f);
+	wood.ambientStrength = 0.4f;
+	wood.diffuseColor = glm::vec3(0.5f, 0.25f, 0.1f);
+	wood.specularColor = glm::vec3(0.3f, 0.2f, 0.1f);
+	wood.shininess = 8.0f;
+	wood.tag = "wood";
+	AddObjectMaterial(wood);
+
+	OBJECT_MATERIAL marble1;
+	marble1.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	marble1.ambientStrength = 0.5f;
+	marble1.diffuseColor = glm::vec3(0.7f, 0.7f, 0.7f);
+	marble1.specularColor = glm::vec3(0.9f, 0.9f, 0.9f);
+	marble1.shininess = 64.0f;
+	marble1.tag = "marble1";
+	AddObjectMaterial(marble1);
+
+	OBJECT_MATERIAL leather1;
+	leather1.ambientColor = glm::vec3(0.2f, 0.1f, 0.1f);
+	leather1.ambientStrength = 0.3f;
+	leather1.diffuseColor = glm::vec3(0.4f, 0.2f, 0.2f);
+	leather1.specularColor = glm::vec3(0.5f, 0.4f, 0.3f);
+	leather1.shininess = 64.0f;
+	leather1.tag = "leather1";
+	AddObjectMaterial(leather1);
+
+	OBJECT_MATERIAL paper;
+	paper.ambientColor = glm::vec3(0.4f, 0.4f, 0.3f);
+	paper.ambientStrength = 0.3f;
+	paper.diffuseColor = glm::vec3(0.8f, 0.8f, 0.7f);
+	paper.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	paper.shininess = 4.0f;
+	paper.tag = "paper";
+	AddObjectMaterial(paper);
+
+	OBJECT_MATERIAL leather2;
+	leather2.ambientColor = glm::vec3(0.15f, 0.1f, 0.05f);
+	leather2.ambientStrength = 0.3f;
+	leather2.diffuseColor = glm::vec3(0.3f, 0.2f, 0.1f);
+	leather2.specularColor = glm::vec3(0.4f, 0.3f, 0.2f);
+	leather2.shininess = 12.0f;
+	leather2.tag = "leather2";
+	AddObjectMaterial(leather2);
+
+	OBJECT_MATERIAL paper2;
+	paper2.ambientColor = glm::vec3(0.4f, 0.4f, 0.4f);
+	paper2.ambientStrength = 0.3f;
+	paper2.diffuseColor = glm::vec3(0.9f, 0.9f, 0.8f);
+	paper2.specularColor = glm::vec3(0.1f, 0.1f, 0.1f);
+	paper2.shininess = 4.0f;
+	paper2.tag = "paper2";
+	AddObjectMaterial(paper2);
+
+	OBJECT_MATERIAL leather3;
+	leather3.ambientColor = glm::vec3(0.1f, 0.05f, 0.05f);
+	leather3.ambientStrength = 0.3f;
+	leather3.diffuseColor = glm::vec3(0.35f, 0.2f, 0.2f);
+	leather3.specularColor = glm::vec3(0.4f, 0.3f, 0.3f);
+	leather3.shininess = 16.0f;
+	leather3.tag = "leather3";
+	AddObjectMaterial(leather3);
+
+	OBJECT_MATERIAL marble2;
+	marble2.ambientColor = glm::vec3(0.35f, 0.35f, 0.35f);
+	marble2.ambientStrength = 0.5f;
 	marble2.diffuseColor = glm::vec3(0.8f, 0.8f, 0.8f);
 	marble2.specularColor = glm::vec3(1.0f, 1.0f, 1.0f);
 	marble2.shininess = 64.0f;
 	marble2.tag = "marble2";
-	m_objectMaterials.push_back(marble2);
+	AddObjectMaterial(marble2);
+
+	OBJECT_MATERIAL ground;
+	ground.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
+	ground.ambientStrength = 0.4f;
+	ground.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	ground.specularColor = glm::vec3(0.2f, 0.4f, 0.2f);
+	ground.shininess = 8.0f;
+	ground.tag = "ground";
+	AddObjectMaterial(ground);
+
+	OBJECT_MATERIAL grass1;
+	grass1.ambientColor = glm::vec3(0.1f, 0.3f, 0.1f);
+	grass1.ambientStrength = 0.4f;
+	grass1.diffuseColor = glm::vec3(0.2f, 0.5f, 0.2f);
+	grass1.specularColor = glm::vec3(0.2f, 0.4f, 0.2f);
+	grass1.shininess = 8.0f;
+	grass1.tag = "grass1";
+	AddObjectMaterial(grass1);
+
+	OBJECT_MATERIAL grass2;
+	grass2.ambientColor = glm::vec3(0.15f, 0.35f, 0.15f);
+	grass2.ambientStrength = 0.4f;
+	grass2.diffuseColor = glm::vec3(0.25f, 0.55f, 0.25f);
+	grass2.specularColor = glm::vec3(0.25f, 0.45f, 0.25f);
+	grass2.shininess = 10.0f;
+	grass2.tag = "grass2";
+	AddObjectMaterial(grass2);
+
+
+	OBJECT_MATERIAL pattern;
+	pattern.ambientColor = glm::vec3(0.3f, 0.2f, 0.2f);
+	pattern.ambientStrength = 0.4f;
+	pattern.diffuseColor = glm::vec3(0.6f, 0.3f, 0.3f);
+	pattern.specularColor = glm::vec3(0.4f, 0.2f, 0.2f);
+	pattern.shininess = 20.0f;
+	pattern.tag = "pattern";
+	AddObjectMaterial(pattern);
+
+
+	OBJECT_MATERIAL fabric;
+	fabric.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	fabric.ambientStrength = 0.4f;
+	fabric.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	fabric.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
+	fabric.shininess = 16.0f;
+	fabric.tag = "fabric";
+	AddObjectMaterial(fabric);
+
+	OBJECT_MATERIAL wood2;
+	wood2.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
+	wood2.ambientStrength = 0.4f;
+	wood2.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
+	wood2.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
+	wood2.shininess = 16.0f;
+	wood2.tag = "wood2";
+	AddObjectMaterial(wood2);
+}
+/***********************************************************
+ *  PrepareScene()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void SceneManager::PrepareScene()
+{
+	// the uniform locations are looked up once, here
+	LoadUniformLocations();
+
+	// only one instance of a particular mesh needs to be
+	// loaded in memory no matter how many times it is drawn
+	// in the rendered 3D scene
+
+	m_basicMeshes->LoadPlaneMesh();
+	m_basicMeshes->LoadCylinderMesh();
+	m_basicMeshes->LoadTorusMesh();
+	m_basicMeshes->LoadSphereMesh();
+	m_basicMeshes->LoadTaperedCylinderMesh();
+	m_basicMeshes->LoadBoxMesh();
+
+	// the shapes are also generated into the shared mesh library,
+	// at several levels of detail, so that they can be drawn
+	// instanced and picked by their size on the screen
+	m_instancedMeshes->AddPlaneMesh(MESH_PLANE);
+	m_instancedMeshes->AddBoxMesh(MESH_BOX);
+	for (int lod = 0; lod < MeshLibrary::MAX_LOD_LEVELS; lod++)
+	{
+		// each level of the curved shapes is coarser than the last
+		m_instancedMeshes->AddCylinderMesh(MESH_CYLINDER, lod, LOD_SLICES[lod]);
+		m_instancedMeshes->AddTaperedCylinderMesh(MESH_TAPERED_CYLINDER, lod, LOD_SLICES[lod]);
+		m_instancedMeshes->AddSphereMesh(MESH_SPHERE, lod, LOD_SLICES[lod], LOD_STACKS[lod]);
+		m_instancedMeshes->AddHalfSphereMesh(MESH_HALF_SPHERE, lod, LOD_SLICES[lod], std::max(2, LOD_STACKS[lod] / 2));
+		m_instancedMeshes->AddTorusMesh(MESH_TORUS, lod, 0.1f, LOD_TORUS_RINGS[lod], LOD_TORUS_SIDES[lod]);
+		m_instancedMeshes->AddHalfTorusMesh(MESH_HALF_TORUS, lod, 0.1f, std::max(3, LOD_TORUS_RINGS[lod] / 2), LOD_TORUS_SIDES[lod]);
+	}
+	m_instancedMeshes->UploadMeshes();
+
+	// define the materials and build the draw list once, all
+	// of the tag lookups are resolved here instead of per frame
+	if (m_pSceneFile->IsLoaded())
+	{
+		DefineSceneFileMaterials();
+		UploadMaterialBuffer();
+		BuildSceneFileDrawList();
+	}
+	else
+	{
+		DefineObjectMaterials();
+		UploadMaterialBuffer();
+		BuildSceneDrawList();
+	}
+
+	// the static opaque items are also given to the GPU driven path
+	m_pIndirectRenderer->Initialize(g_CullComputeFile);
+	BuildDrawState();
+
+	// the camera and object values of the frames in flight are
+	// written to their own parts of one mapped buffer
+	m_pUniformRing->Initialize(UNIFORM_RING_FRAME_SIZE);
+
+	// the shadow maps are drawn with the depth only program, once the
+	// lights are known
+	m_pShadowAtlas->Initialize();
+
+	// the depth only program reads the same draw data
+	m_pDepthPrepass->Initialize(
+		g_DepthVertexShaderFile,
+		g_DepthFragmentShaderFile,
+		m_pIndirectRenderer->GetDrawDataUnit());
+}
+
+/***********************************************************
+ *  LoadSceneFile()
+ *
+ *  This method is used for reading the scene from a scene
+ *  file.  The built in scene is used when it cannot be read.
+ ***********************************************************/
+bool SceneManager::LoadSceneFile(const std::string& filename)
+{
+	m_sceneFilename = filename;
+
+	return(m_pSceneFile->Load(filename));
+}
+
+/***********************************************************
+ *  BuildDrawState()
+ *
+ *  This method is used for building everything that is
+ *  drawn from the draw list - the stress scene copies, the
+ *  instanced batches, the render queues, the item boxes and
+ *  the indirect commands.  It is called again after the
+ *  draw list was rebuilt from a changed scene file.
+ ***********************************************************/
+void SceneManager::BuildDrawState()
+{
+	if (m_stressObjectCount > 0)
+	{
+		BuildStressScene();
+	}
+	BuildInstanceBatches();
+	BuildRenderQueues();
+
+	// every item gets its world space box for the culling
+	m_drawBounds.resize(m_drawList.size());
+	m_pJobSystem->ParallelFor((int)m_drawList.size(), PARALLEL_CHUNK_ITEMS, [this](int first, int last)
+	{
+		for (int i = first; i < last; i++)
+		{
+			UpdateDrawBounds(i);
+		}
+	});
+	m_pSceneGraph->UpdateBounds(m_drawBounds);
+	m_bBoundsDirty = true;
+	m_lastVisibleItems.assign(m_drawList.size(), 1);
+	m_pShadowAtlas->Invalidate();
+
+	if (m_pIndirectRenderer->IsSupported())
+	{
+		BuildIndirectDraws();
+	}
+}
+
+/***********************************************************
+ *  WatchFiles()
+ *
+ *  This method is used for adding the files that the scene
+ *  is built from to a file watcher, so that they can be
+ *  reloaded while the scene is running.
+ ***********************************************************/
+void SceneManager::WatchFiles(FileWatcher* pWatcher)
+{
+	pWatcher->AddFile(g_DepthVertexShaderFile, WATCH_DEPTH_SHADERS);
+	pWatcher->AddFile(g_DepthFragmentShaderFile, WATCH_DEPTH_SHADERS);
+	pWatcher->AddFile(g_CullComputeFile, WATCH_CULL_SHADER);
+	if (!m_sceneFilename.empty())
+	{
+		pWatcher->AddFile(m_sceneFilename, WATCH_SCENE_FILE);
+	}
+	for (int i = 0; i < (int)m_textureIDs.size(); i++)
+	{
+		pWatcher->AddFile(m_textureIDs[i].filename, WATCH_TEXTURES + i);
+	}
+}
+
+/***********************************************************
+ *  ReloadFile()
+ *
+ *  This method is used for reloading a watched file that
+ *  has changed.  A file that does not load keeps the last
+ *  working version in use.
+ ***********************************************************/
+bool SceneManager::ReloadFile(int watchID)
+{
+	bool bReloaded = false;
 
-	OBJECT_MATERIAL ground;
-	ground.ambientColor = glm::vec3(0.2f, 0.2f, 0.2f);
-	ground.ambientStrength = 0.4f;
-	ground.diffuseColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	ground.specularColor = glm::vec3(0.2f, 0.4f, 0.2f);
-	ground.shininess = 8.0f;
-	ground.tag = "ground";
-	m_objectMaterials.push_back(ground);
+	if (WATCH_DEPTH_SHADERS == watchID)
+	{
+		bReloaded = m_pDepthPrepass->Initialize(
+			g_DepthVertexShaderFile,
+			g_DepthFragmentShaderFile,
+			m_pIndirectRenderer->GetDrawDataUnit());
+		if (bReloaded)
+		{
+			m_pShadowAtlas->Invalidate();
+		}
+	}
+	else if (WATCH_CULL_SHADER == watchID)
+	{
+		bReloaded = m_pIndirectRenderer->ReloadCullProgram(g_CullComputeFile);
+	}
+	else if (WATCH_SCENE_FILE == watchID)
+	{
+		bReloaded = ReloadSceneFile();
+	}
+	else if (watchID >= WATCH_TEXTURES)
+	{
+		bReloaded = ReloadTexture(watchID - WATCH_TEXTURES);
+	}
 
-	OBJECT_MATERIAL grass1;
-	grass1.ambientColor = glm::vec3(0.1f, 0.3f, 0.1f);
-	grass1.ambientStrength = 0.4f;
-	grass1.diffuseColor = glm::vec3(0.2f, 0.5f, 0.2f);
-	grass1.specularColor = glm::vec3(0.2f, 0.4f, 0.2f);
-	grass1.shininess = 8.0f;
-	grass1.tag = "grass1";
-	m_objectMaterials.push_back(grass1);
+	return(bReloaded);
+}
 
-	OBJECT_MATERIAL grass2;
-	grass2.ambientColor = glm::vec3(0.15f, 0.35f, 0.15f);
-	grass2.ambientStrength = 0.4f;
-	grass2.diffuseColor = glm::vec3(0.25f, 0.55f, 0.25f);
-	grass2.specularColor = glm::vec3(0.25f, 0.45f, 0.25f);
-	grass2.shininess = 10.0f;
-	grass2.tag = "grass2";
-	m_objectMaterials.push_back(grass2);
+/***********************************************************
+ *  ReloadUniformLocations()
+ *
+ *  This method is used for looking up the uniform locations
+ *  in the current program again, after it was replaced by
+ *  reloaded shaders.  The remembered state is dropped, so
+ *  every value is sent to the new program.
+ ***********************************************************/
+void SceneManager::ReloadUniformLocations()
+{
+	LoadUniformLocations();
+}
 
+/***********************************************************
+ *  ReloadTexture()
+ *
+ *  This method is used for loading a changed image again
+ *  into the layer that the texture already has.  The old
+ *  image is drawn until the new one is uploaded.  An image
+ *  that changed its size or format no longer fits its page,
+ *  and is only loaded on the next start.
+ ***********************************************************/
+bool SceneManager::ReloadTexture(TextureHandle texture)
+{
+	int width = 0;
+	int height = 0;
+	int colorChannels = 0;
 
-	OBJECT_MATERIAL pattern;
-	pattern.ambientColor = glm::vec3(0.3f, 0.2f, 0.2f);
-	pattern.ambientStrength = 0.4f;
-	pattern.diffuseColor = glm::vec3(0.6f, 0.3f, 0.3f);
-	pattern.specularColor = glm::vec3(0.4f, 0.2f, 0.2f);
-	pattern.shininess = 20.0f;
-	pattern.tag = "pattern";
-	m_objectMaterials.push_back(pattern);
+	if ((texture < 0) || (texture >= (int)m_textureIDs.size()) || (0 == m_textureIDs[texture].ID))
+	{
+		return(false);
+	}
 
+	TEXTURE_INFO& info = m_textureIDs[texture];
+	if ((0 == stbi_info(info.filename.c_str(), &width, &height, &colorChannels)) ||
+		((colorChannels != 3) && (colorChannels != 4)) ||
+		(false == m_pTextureArrays->FitsPage(info.page, width, height, m_pTextureLoader->GetUploadFormat(colorChannels))))
+	{
+		std::cout << "Texture size or format changed, restart to load:" << info.filename << std::endl;
+		return(false);
+	}
 
-	OBJECT_MATERIAL fabric;
-	fabric.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	fabric.ambientStrength = 0.4f;
-	fabric.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	fabric.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
-	fabric.shininess = 16.0f;
-	fabric.tag = "fabric";
-	m_objectMaterials.push_back(fabric);
+	m_pTextureLoader->QueueTexture(info.filename, info.ID, info.layer, texture);
 
-	OBJECT_MATERIAL wood2;
-	wood2.ambientColor = glm::vec3(0.3f, 0.3f, 0.3f);
-	wood2.ambientStrength = 0.4f;
-	wood2.diffuseColor = glm::vec3(0.5f, 0.5f, 0.5f);
-	wood2.specularColor = glm::vec3(0.6f, 0.6f, 0.6f);
-	wood2.shininess = 16.0f;
-	wood2.tag = "wood2";
-	m_objectMaterials.push_back(wood2);
+	return(true);
 }
+
 /***********************************************************
- *  PrepareScene()
+ *  ReloadSceneFile()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for reading the changed scene file
+ *  and rebuilding the materials and the draw list from it.
+ *  The texture arrays are allocated once, so the scene can
+ *  only use the textures that were loaded at the start.
  ***********************************************************/
-void SceneManager::PrepareScene()
+bool SceneManager::ReloadSceneFile()
 {
-	// only one instance of a particular mesh needs to be
-	// loaded in memory no matter how many times it is drawn
-	// in the rendered 3D scene
+	if (m_sceneFilename.empty() || (false == m_pSceneFile->Load(m_sceneFilename)))
+	{
+		return(false);
+	}
 
-	m_basicMeshes->LoadPlaneMesh();
-	m_basicMeshes->LoadCylinderMesh();
-	m_basicMeshes->LoadTorusMesh();
-	m_basicMeshes->LoadSphereMesh();
-	m_basicMeshes->LoadTaperedCylinderMesh();
-	m_basicMeshes->LoadBoxMesh();
-	
+	const SceneFile::SCENE_TEXTURE* textures = m_pSceneFile->GetTextures();
+	for (int i = 0; i < m_pSceneFile->GetTextureCount(); i++)
+	{
+		if (INVALID_HANDLE == FindTextureHandle(textures[i].tag))
+		{
+			std::cout << "New scene texture, restart to load:" << textures[i].filename << std::endl;
+		}
+	}
+
+	m_objectMaterials.clear();
+	DefineSceneFileMaterials();
+	UploadMaterialBuffer();
+	BuildSceneFileDrawList();
+	BuildDrawState();
+
+	// the state filter may hold a material binding of the old buffer
+	m_pStateFilter->Invalidate();
+
+	return(true);
 }
 
-void SceneManager::ApplyAndDraw(const std::string& texTag,
-                                const std::string& matTag,
-                                const glm::vec2& uv,
-                                const glm::vec3& scale,
-                                float rx, float ry, float rz,
-                                const glm::vec3& pos,
-                                const std::function<void()>& drawCall)
+/***********************************************************
+ *  DefineSceneFileMaterials()
+ *
+ *  This method is used for defining the materials listed in
+ *  the scene file.
+ ***********************************************************/
+void SceneManager::DefineSceneFileMaterials()
 {
+	const SceneFile::SCENE_MATERIAL* materials = m_pSceneFile->GetMaterials();
 
-   SetShaderTexture(texTag);
-   SetShaderMaterial(matTag);
-   SetTextureUVScale(uv.x, uv.y);
-   SetTransformations(scale, rx, ry, rz, pos);
-   drawCall();
+	for (int i = 0; i < m_pSceneFile->GetMaterialCount(); i++)
+	{
+		OBJECT_MATERIAL material;
+		material.ambientColor = materials[i].ambientColor;
+		material.ambientStrength = materials[i].ambientStrength;
+		material.diffuseColor = materials[i].diffuseColor;
+		material.specularColor = materials[i].specularColor;
+		material.shininess = materials[i].shininess;
+		material.tag = materials[i].tag;
+		AddObjectMaterial(material);
+	}
 }
+
 /***********************************************************
- *  RenderScene()
+ *  BuildSceneFileDrawList()
  *
- *  This method is used for rendering the 3D scene by 
- *  transforming and drawing the basic 3D shapes
+ *  This method is used for building the retained draw list
+ *  from the items of the scene file.  The texture and the
+ *  material tags are resolved to handles once for the whole
+ *  file, and the items are read straight from its arrays.
  ***********************************************************/
-void SceneManager::RenderScene()
+void SceneManager::BuildSceneFileDrawList()
 {
-	// declare the variables for the transformations
-	glm::vec3 scaleXYZ;
-	float XrotationDegrees = 0.0f;
-	float YrotationDegrees = 0.0f;
-	float ZrotationDegrees = 0.0f;
-	glm::vec3 positionXYZ;
+	const SceneFile::SCENE_TEXTURE* textures = m_pSceneFile->GetTextures();
+	const SceneFile::SCENE_MATERIAL* materials = m_pSceneFile->GetMaterials();
+	const SceneFile::SCENE_SECTION* sections = m_pSceneFile->GetSections();
+	const SceneFile::SCENE_NODE* nodes = m_pSceneFile->GetNodes();
+	const SceneFile::SCENE_ITEM* items = m_pSceneFile->GetItems();
+	std::vector<TextureHandle> textureHandles(m_pSceneFile->GetTextureCount());
+	std::vector<MaterialHandle> materialHandles(m_pSceneFile->GetMaterialCount());
+	int itemCount = m_pSceneFile->GetItemCount();
+
+	ClearDrawList(itemCount);
+
+	for (int i = 0; i < (int)textureHandles.size(); i++)
+	{
+		textureHandles[i] = FindTextureHandle(textures[i].tag);
+	}
+	for (int i = 0; i < (int)materialHandles.size(); i++)
+	{
+		materialHandles[i] = FindMaterialHandle(materials[i].tag);
+	}
+
+	// the file stores each parent node before its children
+	std::vector<int> nodeHandles(m_pSceneFile->GetNodeCount());
+	for (int i = 0; i < (int)nodeHandles.size(); i++)
+	{
+		const SceneFile::SCENE_NODE& node = nodes[i];
+		int parent = ((node.parent >= 0) && (node.parent < i)) ? nodeHandles[node.parent] : SceneGraph::ROOT_NODE;
+
+		nodeHandles[i] = m_pSceneGraph->AddNode(node.name, parent, BuildModelMatrix(
+			node.scaleXYZ,
+			node.rotationDegrees.x,
+			node.rotationDegrees.y,
+			node.rotationDegrees.z,
+			node.positionXYZ));
+	}
 
-	glm::vec3 scale, position;
-	float xRot = 0.0f, yRot = 0.0f, zRot = 0.0f;
+	int openSection = -1;
+	for (int i = 0; i < itemCount; i++)
+	{
+		const SceneFile::SCENE_ITEM& item = items[i];
 
-	
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		if (item.section != openSection)
+		{
+			BeginSection((item.section < m_pSceneFile->GetSectionCount()) ? sections[item.section].name : "scene");
+			openSection = item.section;
+		}
 
-	//Table top surface using plane shape 
-	SetShaderTexture("wood");
-	SetShaderMaterial("wood");
-	SetTextureUVScale(1.0f, 1.0f);
-	SetTransformations(glm::vec3(2.0f, 1.0f, 2.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.2f));
-	m_basicMeshes->DrawPlaneMesh();
+		// the cache is trusted no further than the text it came from
+		if ((item.mesh > MESH_HALF_TORUS) ||
+			(item.texture >= (int)textureHandles.size()) ||
+			(item.material >= (int)materialHandles.size()) ||
+			(item.node >= (int)nodeHandles.size()))
+		{
+			continue;
+		}
 
-	//Saucer base plate
-	SetShaderTexture("marble1");
-	SetShaderMaterial("marble1");
-	SetTextureUVScale(1.0f, 1.0f);
-	SetTransformations(glm::vec3(0.3f, 0.015f, 0.3f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.01f, 0.0f));
-	m_basicMeshes->DrawCylinderMesh();
+		m_currentNode = (item.node >= 0) ? nodeHandles[item.node] : SceneGraph::ROOT_NODE;
+		int itemIndex = AddDrawItemByHandle(
+			(MESH_TYPE)item.mesh,
+			(item.texture >= 0) ? textureHandles[item.texture] : INVALID_HANDLE,
+			(item.material >= 0) ? materialHandles[item.material] : INVALID_HANDLE,
+			item.uvScale,
+			item.scaleXYZ,
+			item.rotationDegrees,
+			item.positionXYZ,
+			item.variant);
+		m_drawList[itemIndex].color = item.color;
+	}
+	m_currentNode = SceneGraph::ROOT_NODE;
+}
 
-	//Half Sphere shape used for the centered middle of the saucer plate
-	SetShaderTexture("marble1");
-	SetShaderMaterial("marble1");
-	SetTextureUVScale(1.0f, 1.0f);
-	SetTransformations(glm::vec3(0.12f, 0.008f, 0.12f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.035f, 0.0f));
-	m_basicMeshes->DrawHalfSphereMesh();
+/***********************************************************
+ *  ClearDrawList()
+ *
+ *  This method is used for emptying the draw list and the
+ *  transformation arrays before it is built again, with
+ *  room for the passed in number of items.
+ ***********************************************************/
+void SceneManager::ClearDrawList(size_t reserveCount)
+{
+	m_drawList.clear();
+	m_drawScales.clear();
+	m_drawRotations.clear();
+	m_drawPositions.clear();
+	m_drawNodes.clear();
+	m_dirtyDrawItems.clear();
+	m_sectionNames.clear();
+	m_pSceneGraph->Clear();
+	m_currentNode = SceneGraph::ROOT_NODE;
+	m_bNodesDirty = false;
+
+	m_drawList.reserve(reserveCount);
+	m_drawScales.reserve(reserveCount);
+	m_drawRotations.reserve(reserveCount);
+	m_drawPositions.reserve(reserveCount);
+	m_drawNodes.reserve(reserveCount);
+}
+
+/***********************************************************
+ *  BuildSceneDrawList()
+ *
+ *  This method is used for building the retained draw list
+ *  of the 3D scene.  Every object is added once, with its
+ *  transformations, texture and material, and is then drawn
+ *  from the list on every rendered frame.
+ ***********************************************************/
+void SceneManager::BuildSceneDrawList()
+{
+	ClearDrawList(0);
+
+	BeginSection("desk");
+	//Table top surface using plane shape
+	AddDrawItem(MESH_PLANE, "wood", "wood", glm::vec2(1.0f, 1.0f),
+		glm::vec3(2.0f, 1.0f, 2.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.2f));
 
-	
+	BeginSection("cup");
+	BeginNode("cup", glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+	//Saucer base plate
+	AddDrawItem(MESH_CYLINDER, "marble1", "marble1", glm::vec2(1.0f, 1.0f),
+		glm::vec3(0.3f, 0.015f, 0.3f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.01f, 0.0f));
 
-	//Using the upside down Cylinder for the cups body 
-	SetShaderTexture("marble1");
-	SetShaderMaterial("marble1");
-	SetTextureUVScale(1.0f, 1.0f);
-	SetTransformations(glm::vec3(0.18f, 0.27f, 0.18f), 180.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.30f, 0.0f));
-	m_basicMeshes->DrawTaperedCylinderMesh(true, true, true);
+	//Half Sphere shape used for the centered middle of the saucer plate
+	AddDrawItem(MESH_HALF_SPHERE, "marble1", "marble1", glm::vec2(1.0f, 1.0f),
+		glm::vec3(0.12f, 0.008f, 0.12f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.035f, 0.0f));
 
-	
-	
+	//Using the upside down Cylinder for the cups body
+	AddDrawItem(MESH_TAPERED_CYLINDER, "marble1", "marble1", glm::vec2(1.0f, 1.0f),
+		glm::vec3(0.18f, 0.27f, 0.18f), 180.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.30f, 0.0f));
 
 	//Cup surface liquid using flattened cylinder shape
-	SetShaderColor(0.1f, 0.05f, 0.01f, 1.0f);
-	SetTransformations(glm::vec3(0.16f, 0.005f, 0.16f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.30f, 0.0f));
-	m_basicMeshes->DrawCylinderMesh();
+	AddColorDrawItem(MESH_CYLINDER, glm::vec4(0.1f, 0.05f, 0.01f, 1.0f), glm::vec2(1.0f, 1.0f),
+		glm::vec3(0.16f, 0.005f, 0.16f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.30f, 0.0f));
 
-	
-	
 	//First half of the handle using half torus shape
-	SetShaderTexture("marble1");
-	SetShaderMaterial("marble1");
-	SetTextureUVScale(1.0f, 1.0f);
-	SetTransformations(glm::vec3(0.06f, 0.06f, 0.025f), 0.0f, 0.0f, 90.0f, glm::vec3(-0.20f, 0.215f, 0.0f));
-	m_basicMeshes->DrawHalfTorusMesh();
+	AddDrawItem(MESH_HALF_TORUS, "marble1", "marble1", glm::vec2(1.0f, 1.0f),
+		glm::vec3(0.06f, 0.06f, 0.025f), 0.0f, 0.0f, 90.0f, glm::vec3(-0.20f, 0.215f, 0.0f));
 
 	//second half of handle
-	SetShaderTexture("marble1");
-	SetShaderMaterial("marble1");
-	SetTextureUVScale(1.0f, 1.0f);
-	SetTransformations(glm::vec3(0.06f, 0.06f, 0.025f), 180.0f, 0.0f, 90.0f, glm::vec3(-0.20f, 0.215f, 0.0f));
-	m_basicMeshes->DrawHalfTorusMesh();
+	AddDrawItem(MESH_HALF_TORUS, "marble1", "marble1", glm::vec2(1.0f, 1.0f),
+		glm::vec3(0.06f, 0.06f, 0.025f), 180.0f, 0.0f, 90.0f, glm::vec3(-0.20f, 0.215f, 0.0f));
+	EndNode();
+
 ////////////////////////////////////////////////////////////////Book Design //////////////////////////////////////////////////////
+	BeginSection("books");
+	//The book stack is placed as one node, the books and pages relative to it
+	BeginNode("book_stack", glm::vec3(1.0f, 1.0f, 1.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.52f, 0.0f, 0.09f));
 	//First Book
-	SetShaderTexture("leather1");
-	SetShaderMaterial("leather1");
-	SetTextureUVScale(4.0f, 2.0f);
-	SetTransformations(glm::vec3(0.5f, 0.07f, 0.4f), 0.0f, 90.0f, 0.0f, glm::vec3(0.52f, 0.035f, 0.09f));
-	m_basicMeshes->DrawBoxMesh();
+	AddDrawItem(MESH_BOX, "leather1", "leather1", glm::vec2(4.0f, 2.0f),
+		glm::vec3(0.5f, 0.07f, 0.4f), 0.0f, 90.0f, 0.0f, glm::vec3(0.0f, 0.035f, 0.0f));
 
 	//Paper texture for the first book
-	SetShaderTexture("paper");
-	SetShaderMaterial("paper");
-	SetTextureUVScale(4.0f, 2.0f);
-	SetTransformations(glm::vec3(0.27f, 0.001f, 0.16f), 0.0f, 90.0f, 0.0f, glm::vec3(0.47f, 0.035f, 0.08f));
-	m_basicMeshes->DrawPlaneMesh();
+	AddDrawItem(MESH_PLANE, "paper", "paper", glm::vec2(4.0f, 2.0f),
+		glm::vec3(0.27f, 0.001f, 0.16f), 0.0f, 90.0f, 0.0f, glm::vec3(-0.05f, 0.035f, -0.01f));
 
 	//Second Book
-	SetShaderTexture("leather2");
-	SetShaderMaterial("leather2");
-	SetTextureUVScale(4.0f, 2.0f);
-	SetTransformations(glm::vec3(0.5f, 0.09f, 0.4f), 0.0f, 90.0f, 0.0f, glm::vec3(0.52f, 0.12f, 0.09f));
-	m_basicMeshes->DrawBoxMesh();
+	AddDrawItem(MESH_BOX, "leather2", "leather2", glm::vec2(4.0f, 2.0f),
+		glm::vec3(0.5f, 0.09f, 0.4f), 0.0f, 90.0f, 0.0f, glm::vec3(0.0f, 0.12f, 0.0f));
 
 	//Paper texture for the second book
-	SetShaderTexture("paper2");
-	SetShaderMaterial("paper2");
-	SetTextureUVScale(4.0f, 2.0f);
-	SetTransformations(glm::vec3(0.26f, 0.014f, 0.21f), 0.0f, 90.0f, 0.0f, glm::vec3(0.52f, 0.12f, 0.09f));
-	m_basicMeshes->DrawPlaneMesh();
-
-	//Third Book 
-	SetShaderTexture("leather3");
-	SetShaderMaterial("leather3");
-	SetTextureUVScale(4.0f, 2.0f);
-	SetTransformations(glm::vec3(0.4f, 0.04f, 0.3f), 0.0f, 90.0f, 0.0f, glm::vec3(0.52f, 0.17f, 0.09f));
-	m_basicMeshes->DrawBoxMesh();
+	AddDrawItem(MESH_PLANE, "paper2", "paper2", glm::vec2(4.0f, 2.0f),
+		glm::vec3(0.26f, 0.014f, 0.21f), 0.0f, 90.0f, 0.0f, glm::vec3(0.0f, 0.12f, 0.0f));
+
+	//Third Book
+	AddDrawItem(MESH_BOX, "leather3", "leather3", glm::vec2(4.0f, 2.0f),
+		glm::vec3(0.4f, 0.04f, 0.3f), 0.0f, 90.0f, 0.0f, glm::vec3(0.0f, 0.17f, 0.0f));
+	EndNode();
 
 /////////////////////////////////////////////////////Picture Frame Design////////////////////////////////////////////////////////
-	//Picture frame 
-	SetShaderTexture("paper");
-	SetShaderMaterial("paper");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.25f, 0.01f, 0.89f), 90.0f, -45.0f, 0.0f, glm::vec3(0.52f, 0.46f, 0.09f));
-	m_basicMeshes->DrawBoxMesh();
-
-	//Wooden frame 
-	SetShaderTexture("wood");
-	SetShaderMaterial("wood");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.27f, 0.01f, 0.92f), 90.0f, -45.0f, 0.0f, glm::vec3(0.53f, 0.48f, 0.09f));
-	m_basicMeshes->DrawBoxMesh();
+	BeginSection("frame");
+	//Picture frame
+	AddDrawItem(MESH_BOX, "paper", "paper", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.25f, 0.01f, 0.89f), 90.0f, -45.0f, 0.0f, glm::vec3(0.52f, 0.46f, 0.09f));
+
+	//Wooden frame
+	AddDrawItem(MESH_BOX, "wood", "wood", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.27f, 0.01f, 0.92f), 90.0f, -45.0f, 0.0f, glm::vec3(0.53f, 0.48f, 0.09f));
 
 	//Additional box added for wooden frame
-	SetShaderTexture("wood");
-	SetShaderMaterial("wood");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.27f, 0.01f, 0.92f), 90.0f, -45.0f, 0.0f, glm::vec3(0.53f, 0.48f, 0.09f));
-	m_basicMeshes->DrawBoxMesh();
+	AddDrawItem(MESH_BOX, "wood", "wood", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.27f, 0.01f, 0.92f), 90.0f, -45.0f, 0.0f, glm::vec3(0.53f, 0.48f, 0.09f));
 
 	//Adding in final wooden texture for wooden picture frame
-	SetShaderTexture("wood");
-	SetShaderMaterial("wood");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.27f, 0.01f, 0.90f), 90.0f, -45.0f, 0.0f, glm::vec3(0.53, 0.48f, 0.09f));
-	m_basicMeshes->DrawBoxMesh();
-
-	
+	AddDrawItem(MESH_BOX, "wood", "wood", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.27f, 0.01f, 0.90f), 90.0f, -45.0f, 0.0f, glm::vec3(0.53, 0.48f, 0.09f));
 
 //////////////////////////////////////////////////Plant Vase Design////////////////////////////////////////////////////////////
+	BeginSection("plant");
 	/** Set shape figures for plant vase design.   ***/
+	AddDrawItem(MESH_TAPERED_CYLINDER, "marble1", "marble1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.3f, 0.65f, 0.3f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.01f, -0.70f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.21f, 0.19f, -0.70f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.19f, -0.49f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.63f, 0.19f, -0.70f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.19f, -0.91f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.31f, 0.19f, -0.59f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.53f, 0.19f, -0.59f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.31f, 0.19f, -0.81f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.53f, 0.19f, -0.81f));
+
+	AddColorDrawItem(MESH_CYLINDER, glm::vec4(0.0f, 0.0f, 0.0f, 1.0f), glm::vec2(1.0f, 1.0f),
+		glm::vec3(0.26f, 0.008f, 0.26f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.625f, -0.70f));
+
+	AddDrawItem(MESH_CYLINDER, "marble1", "marble1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.26f, 0.008f, 0.26f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.635f, -0.70f));
+
+	AddDrawItem(MESH_CYLINDER, "marble2", "marble2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.24f, 0.10f, 0.24f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.645f, -0.70f));
+
+	AddDrawItem(MESH_HALF_SPHERE, "ground", "ground", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.22f, 0.10f, 0.22f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.755f, -0.70f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.82f, -0.70f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.05f, 0.08f, 0.05), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 1.54f, -0.70f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), -15.0f, 0.0f, 30.0f, glm::vec3(-0.36f, 0.82f, -0.67f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), -10.0f, 0.0f, 5.0f, glm::vec3(-0.38f, 0.82f, -0.72f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), 0.0f, 0.0f, -25.0f, glm::vec3(-0.45f, 0.82f, -0.68f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), 10.0f, 0.0f, 20.0f, glm::vec3(-0.39f, 0.82f, -0.66f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), -11.0f, 0.0f, -27.7f, glm::vec3(-0.37f, 0.82f, -0.70f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), -12.0f, 0.0f, -27.7f, glm::vec3(-0.39f, 0.82f, -0.66f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), -10.8f, 0.0f, -6.9f, glm::vec3(-0.44f, 0.82f, -0.66f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), 8.3f, 0.0f, 21.7f, glm::vec3(-0.47f, 0.82f, -0.70f));
 
-	SetShaderTexture("marble1");
-	SetShaderMaterial("marble1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.3f, 0.65f, 0.3f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.01f, -0.70f));
-	m_basicMeshes->DrawTaperedCylinderMesh(true, true, true);
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.21f, 0.19f, -0.70f));
-	m_basicMeshes->DrawCylinderMesh(true, true);
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.19f, -0.49f));
-	m_basicMeshes->DrawCylinderMesh(true, true);
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.63f, 0.19f, -0.70f));
-	m_basicMeshes->DrawCylinderMesh(true, true);
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.19f, -0.91f));
-	m_basicMeshes->DrawCylinderMesh(true, true);
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.31f, 0.19f, -0.59f));
-	m_basicMeshes->DrawCylinderMesh(true, true);
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.53f, 0.19f, -0.59f));
-	m_basicMeshes->DrawCylinderMesh(true, true);
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.31f, 0.19f, -0.81f));
-	m_basicMeshes->DrawCylinderMesh(true, true);
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.06f, 0.45f, 0.06f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.53f, 0.19f, -0.81f));
-	m_basicMeshes->DrawCylinderMesh(true, true);
-
-	SetShaderColor(0.0f, 0.0f, 0.0f, 1.0f);
-	SetTextureUVScale(1.0f, 1.0f);
-	SetTransformations(glm::vec3(0.26f, 0.008f, 0.26f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.625f, -0.70f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("marble1");
-	SetShaderMaterial("marble1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.26f, 0.008f, 0.26f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.635f, -0.70f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("marble2");
-	SetShaderMaterial("marble2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.24f, 0.10f, 0.24f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.645f, -0.70f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("ground");
-	SetShaderMaterial("ground");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.22f, 0.10f, 0.22f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.755f, -0.70f));
-	m_basicMeshes->DrawHalfSphereMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 0.82f, -0.70f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass2"); 
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.05f, 0.08f, 0.05), 0.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 1.54f, -0.70f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), -15.0f, 0.0f, 30.0f, glm::vec3(-0.36f, 0.82f, -0.67f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), -10.0f, 0.0f, 5.0f, glm::vec3(-0.38f, 0.82f, -0.72f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), 0.0f, 0.0f, -25.0f, glm::vec3(-0.45f, 0.82f, -0.68f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), 10.0f, 0.0f, 20.0f, glm::vec3(-0.39f, 0.82f, -0.66f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), -11.0f, 0.0f, -27.7f, glm::vec3(-0.37f, 0.82f, -0.70f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), -12.0f, 0.0f, -27.7f, glm::vec3(-0.39f, 0.82f, -0.66f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), -10.8f, 0.0f, -6.9f, glm::vec3(-0.44f, 0.82f, -0.66f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), 8.3f, 0.0f, 21.7f, glm::vec3(-0.47f, 0.82f, -0.70f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), -12.4f, 0.0f, 4.0f, glm::vec3(-0.45f, 0.82f, -0.74f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), 5.7f, 0.0f, 25.1f, glm::vec3(-0.39f, 0.82f, -0.74f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), -12.0f, 0.0f, -35.1f, glm::vec3(-0.35f, 0.82f, -0.68f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), 14.0f, 0.0f, 32.1f, glm::vec3(-0.49f, 0.82f, -0.73f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass1");
-	SetShaderMaterial("grass1");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), -8.0f, 0.0f, 40.0f, glm::vec3(-0.38f, 0.82f, -0.77f));
-	m_basicMeshes->DrawCylinderMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), -12.0f, 0.0f, -35.0f, glm::vec3(-0.60f, 1.36f, -0.84f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 15.0f, 0.0f, 20.0f, glm::vec3(-0.30f, 1.36f, -0.56f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), -8.0f, 0.0f, 40.0f, glm::vec3(-0.20f, 1.36f, -0.92f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), -10.0f, 0.0f, 20.0f, glm::vec3(-0.72f, 1.36f, -0.82f));
-	m_basicMeshes->DrawSphereMesh();
-	
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, 40.0f, glm::vec3(-0.42f, 1.36f, -0.50f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 8.0f, 0.0f, 30.0f, glm::vec3(-0.10f, 1.36f, -0.75f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), -5.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 1.36f, -0.92f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 5.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 1.36f, -0.45f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, -15.0f, glm::vec3(-0.82f, 1.36f, -0.70f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, 15.0f, glm::vec3(-0.02f, 1.36f, -0.70f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), -8.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 1.28f, -0.82f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, -10.0f, glm::vec3(-0.72f, 1.36f, -0.90f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, 10.0f, glm::vec3(-0.12f, 1.36f, -0.50f));
-	m_basicMeshes->DrawSphereMesh();
-
-	SetShaderTexture("grass2");
-	SetShaderMaterial("grass2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, -20.0f, glm::vec3(-0.82f, 1.36f, -0.48f));
-	m_basicMeshes->DrawSphereMesh();
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), -12.4f, 0.0f, 4.0f, glm::vec3(-0.45f, 0.82f, -0.74f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), 5.7f, 0.0f, 25.1f, glm::vec3(-0.39f, 0.82f, -0.74f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), -12.0f, 0.0f, -35.1f, glm::vec3(-0.35f, 0.82f, -0.68f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), 14.0f, 0.0f, 32.1f, glm::vec3(-0.49f, 0.82f, -0.73f));
+
+	AddDrawItem(MESH_CYLINDER, "grass1", "grass1", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), -8.0f, 0.0f, 40.0f, glm::vec3(-0.38f, 0.82f, -0.77f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), -12.0f, 0.0f, -35.0f, glm::vec3(-0.60f, 1.36f, -0.84f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 15.0f, 0.0f, 20.0f, glm::vec3(-0.30f, 1.36f, -0.56f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), -8.0f, 0.0f, 40.0f, glm::vec3(-0.20f, 1.36f, -0.92f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), -10.0f, 0.0f, 20.0f, glm::vec3(-0.72f, 1.36f, -0.82f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, 40.0f, glm::vec3(-0.42f, 1.36f, -0.50f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 8.0f, 0.0f, 30.0f, glm::vec3(-0.10f, 1.36f, -0.75f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), -5.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 1.36f, -0.92f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 5.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 1.36f, -0.45f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, -15.0f, glm::vec3(-0.82f, 1.36f, -0.70f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, 15.0f, glm::vec3(-0.02f, 1.36f, -0.70f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), -8.0f, 0.0f, 0.0f, glm::vec3(-0.42f, 1.28f, -0.82f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, -10.0f, glm::vec3(-0.72f, 1.36f, -0.90f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, 10.0f, glm::vec3(-0.12f, 1.36f, -0.50f));
+
+	AddDrawItem(MESH_SPHERE, "grass2", "grass2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.07f, 0.07f, 0.07f), 0.0f, 0.0f, -20.0f, glm::vec3(-0.82f, 1.36f, -0.48f));
 
 /////////////////////////////////////////////////////Stacked Books//////////////////////////////////////////////////////
+	BeginSection("books");
+	AddDrawItem(MESH_BOX, "leather3", "leather3", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.45f, 0.05f, 0.65f), 0.0f, 100.0f, 0.0f, glm::vec3(-0.75f, 0.01f, -0.15f));
 
-	SetShaderTexture("leather3");
-	SetShaderMaterial("leather3");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.45f, 0.05f, 0.65f), 0.0f, 100.0f, 0.0f, glm::vec3(-0.75f, 0.01f, -0.15f));
-	m_basicMeshes->DrawBoxMesh();
-
-	SetShaderTexture("paper");
-	SetShaderMaterial("paper");
-	SetTextureUVScale(1.0f, 1.0f);
-	SetTransformations(glm::vec3(0.35f, 0.002f, 0.20f), 0.0f, 10.0f, 0.0f, glm::vec3(-0.75f, 0.01f, -0.15f));
-	m_basicMeshes->DrawPlaneMesh();
-
-	SetShaderTexture("pattern");
-	SetShaderMaterial("pattern");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.32f, 0.045f, 0.62f), 0.0f, 100.0f, 0.0f, glm::vec3(-0.75f, 0.065f, -0.15f));
-	m_basicMeshes->DrawBoxMesh();
-
-	SetShaderTexture("fabric");
-	SetShaderMaterial("fabric");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.30f, 0.04f, 0.60f), 0.0f, 100.0f, 0.0f, glm::vec3(-0.75f, 0.12f, -0.15f));
-	m_basicMeshes->DrawBoxMesh();
-
-	SetShaderTexture("paper2");
-	SetShaderMaterial("paper2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.14f, 0.004f, 0.32f), 0.0f, 100.0f, 0.0f, glm::vec3(-0.75f, 0.125f, -0.15f));
-	m_basicMeshes->DrawPlaneMesh();
-
-	SetShaderTexture("wood2");
-	SetShaderMaterial("wood2");
-	SetTextureUVScale(2.0f, 2.0f);
-	SetTransformations(glm::vec3(0.005f, 0.68f, 0.005f), 90.0f, 100.0f, 0.0f, glm::vec3(-1.05f, 0.16f, 0.02f));
-	m_basicMeshes->DrawCylinderMesh();
-	/*** Set needed transformations before drawing the basic mesh.  ***/
-	/*** This same ordering of code should be used for transforming ***/
-	/*** and drawing all the basic 3D shapes.						***/
-	/******************************************************************/
-	// set the XYZ scale for the mesh
-	scaleXYZ = glm::vec3(20.0f, 1.0f, 10.0f);
-
-	// set the XYZ rotation for the mesh
-	XrotationDegrees = 0.0f;
-	YrotationDegrees = 0.0f;
-	ZrotationDegrees = 0.0f;
-
-	// set the XYZ position for the mesh
-	positionXYZ = glm::vec3(0.0f, 0.0f, 0.0f);
-
-	// set the transformations into memory to be used on the drawn meshes
-	SetTransformations(
-		scaleXYZ,
-		XrotationDegrees,
-		YrotationDegrees,
-		ZrotationDegrees,
-		positionXYZ);
+	AddDrawItem(MESH_PLANE, "paper", "paper", glm::vec2(1.0f, 1.0f),
+		glm::vec3(0.35f, 0.002f, 0.20f), 0.0f, 10.0f, 0.0f, glm::vec3(-0.75f, 0.01f, -0.15f));
+
+	AddDrawItem(MESH_BOX, "pattern", "pattern", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.32f, 0.045f, 0.62f), 0.0f, 100.0f, 0.0f, glm::vec3(-0.75f, 0.065f, -0.15f));
+
+	AddDrawItem(MESH_BOX, "fabric", "fabric", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.30f, 0.04f, 0.60f), 0.0f, 100.0f, 0.0f, glm::vec3(-0.75f, 0.12f, -0.15f));
+
+	AddDrawItem(MESH_PLANE, "paper2", "paper2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.14f, 0.004f, 0.32f), 0.0f, 100.0f, 0.0f, glm::vec3(-0.75f, 0.125f, -0.15f));
+
+	AddDrawItem(MESH_CYLINDER, "wood2", "wood2", glm::vec2(2.0f, 2.0f),
+		glm::vec3(0.005f, 0.68f, 0.005f), 90.0f, 100.0f, 0.0f, glm::vec3(-1.05f, 0.16f, 0.02f));
+
+	// background surface underneath the desk
+	BeginSection("desk");
+	AddColorDrawItem(MESH_PLANE, glm::vec4(1.0f, 1.0f, 1.0f, 1.0f), glm::vec2(2.0f, 2.0f),
+		glm::vec3(20.0f, 1.0f, 10.0f), 0.0f, 0.0f, 0.0f, glm::vec3(0.0f, 0.0f, 0.0f));
+}
+
+/***********************************************************
+ *  RenderScene()
+ *
+ *  This method is used for rendering the 3D scene by 
+ *  walking the retained draw list built in PrepareScene()
+ ***********************************************************/
+void SceneManager::RenderScene()
+{
+	// the state changes and draw calls are counted for each frame
+	m_pStateFilter->BeginFrame();
+	m_drawCalls = 0;
+	if (NULL != m_pUniformCache)
+	{
+		m_pStateFilter->UseProgram(m_pUniformCache->GetProgram());
+	}
+
+	// the blocks of this frame go to the part of the ring buffer
+	// the GPU is done reading
+	m_pUniformRing->BeginFrame();
+
+	// copy the textures decoded since the last frame to OpenGL,
+	// the finished textures replace their placeholder from now on
+	std::vector<int> finishedTextures;
+	m_pTextureLoader->ProcessUploads(finishedTextures);
+	for (int texture : finishedTextures)
+	{
+		m_textureIDs[texture].bLoaded = true;
+	}
+
+	// only the objects that were changed since the last
+	// frame need their model matrix to be rebuilt
+	UpdateDirtyDrawItems();
+
+	// the objects outside of the view frustum are skipped
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->BeginScope("FrustumCull", false);
+	}
+	CullScene();
+	if (NULL != m_pProfiler)
+	{
+		m_pProfiler->EndScope();
+	}
+
+	// the static opaque items are culled on the GPU
+	m_bIndirectFrame = IsIndirectActive();
+	if (m_bIndirectFrame)
+	{
+		CullIndirectObjects();
+	}
+
+	// the camera values are written once for both programs, before
+	// any of the per draw blocks so that they stay in place
+	CAMERA_BLOCK camera;
+	camera.view = m_viewMatrix;
+	camera.viewProjection = m_projectionMatrix * m_viewMatrix;
+	camera.viewPosition = glm::vec4(m_viewPosition, 1.0f);
+	m_pUniformRing->BindFrameBlock(UniformCache::CAMERA_BLOCK_BINDING, &camera, sizeof(CAMERA_BLOCK));
+
+	// the shadow maps are only drawn again after a light or a shadow
+	// caster has changed, with their own camera blocks
+	UpdateShadowMaps();
+
+	// the object block is bound before the indirect draws that do
+	// not write their own
+	UploadObjectBlock();
+
+	// with the depth pre-pass the opaque draws only shade the
+	// pixels whose depth they wrote, and leave the depth as it is
+	bool bDepthPrepass = (DEPTH_MODE_PREPASS == m_depthMode) && m_pDepthPrepass->IsReady();
+	if (bDepthPrepass)
+	{
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->BeginScope("DepthPrepass");
+		}
+		DrawDepthPrepass();
+		if (NULL != m_pProfiler)
+		{
+			m_pProfiler->EndScope();
+		}
+		glDepthFunc(GL_EQUAL);
+		glDepthMask(GL_FALSE);
+	}
+
+	// the culled static opaque items are drawn with one multi
+	// draw call for each texture array
+	if (m_bIndirectFrame)
+	{
+		DrawIndirectGroups();
+	}
+
+	// the opaque draws were sorted by their state once, so
+	// the draws sharing a texture and material are adjacent,
+	// or they are drawn from the nearest to the farthest
+	if ((NULL != m_pProfiler) && (m_bProfileSections))
+	{
+		DrawSectionQueue();
+	}
+	else if (DEPTH_MODE_FRONT_TO_BACK == m_depthMode)
+	{
+		SortFrontToBack();
+		for (const RENDER_QUEUE_ENTRY& entry : m_depthSortedQueue)
+		{
+			DrawQueueEntry(entry);
+		}
+	}
+	else
+	{
+		for (const RENDER_QUEUE_ENTRY& entry : m_opaqueQueue)
+		{
+			DrawQueueEntry(entry);
+		}
+	}
+
+	if (bDepthPrepass)
+	{
+		glDepthFunc(GL_LESS);
+		glDepthMask(GL_TRUE);
+	}
+
+	// the transparent draws are blended over the opaque scene
+	// from back to front, without writing to the depth buffer
+	if (false == m_transparentQueue.empty())
+	{
+		SortTransparentQueue();
+
+		glDepthMask(GL_FALSE);
+		for (const RENDER_QUEUE_ENTRY& entry : m_transparentQueue)
+		{
+			DrawQueueEntry(entry);
+		}
+		glDepthMask(GL_TRUE);
+	}
+
+	// the part of the ring buffer written this frame is fenced
+	// after its last draw
+	m_pUniformRing->EndFrame();
+}
+
+/***********************************************************
+ *  GetStateCounters()
+ *
+ *  This method is used for getting the number of state
+ *  changes that were issued and dropped in the last frame.
+ ***********************************************************/
+RenderStateFilter::STATE_COUNTERS SceneManager::GetStateCounters() const
+{
+	return(m_pStateFilter->GetFrameCounters());
+}
 
-	SetShaderColor(1, 1, 1, 1);
-
-	// draw the mesh with transformation values
-	m_basicMeshes->DrawPlaneMesh();
-	/****************************************************************/
-}
-
-void SceneManager::UploadInteractiveUniforms() {                                               
-
-	GLint program = 0;                                                                          
-    glGetIntegerv(GL_CURRENT_PROGRAM, &program);                                                
-    if (program == 0) return;                                                                   
-
-    auto UL = [&](const char* name)->GLint { return glGetUniformLocation(program, name); };     
-    auto SetBool   = [&](const char* n, bool v){ GLint loc=UL(n); if(loc>=0) glUniform1i(loc, v?1:0); };   
-    auto SetFloat  = [&](const char* n, float v){ GLint loc=UL(n); if(loc>=0) glUniform1f(loc, v); };      
-    auto SetVec3   = [&](const char* n, const glm::vec3& v){ GLint loc=UL(n); if(loc>=0) glUniform3fv(loc,1,&v[0]); }; 
-
-    SetBool ("dirLight.bActive",   m_dirLightOn);                                               
-    
-    SetFloat("dirLight.intensity", m_dirIntensity);                                             
-    
-    SetVec3 ("dirLight.direction", glm::normalize(m_dirLightDir));                               
-
-    
-    const int kNumPoint = 4;                                                                     
-    for (int i = 0; i < kNumPoint; ++i) {                                                        
-        std::string base = "pointLights[" + std::to_string(i) + "]";                             
-        
-        SetBool ((base + ".bActive").c_str(),   m_pointLightOn[i]);                             
-        
-        SetFloat((base + ".intensity").c_str(), m_pointIntensity[i]);                            
-       
-        SetVec3 ((base + ".position").c_str(),  m_pointLightPos[i]);                             
-    }                                                                                            
-
-    
-    
-    SetBool ("spotLight.bActive",   m_flashlightOn);                                            
-    SetFloat("spotLight.intensity", m_spotIntensity);                                            
-    SetBool ("flashlight",          m_flashlightOn);                                             
-
-   
-    SetFloat("uAmbientBoost", m_ambientBoost);                                                   
+/***********************************************************
+ *  GetDepthModeName()
+ *
+ *  This method is used for getting the name of a depth mode
+ *  as it is shown in the output and the benchmark report.
+ ***********************************************************/
+const char* SceneManager::GetDepthModeName(DEPTH_MODE mode)
+{
+	switch (mode)
+	{
+	case DEPTH_MODE_FRONT_TO_BACK:
+		return("front_to_back");
+	case DEPTH_MODE_PREPASS:
+		return("prepass");
+	default:
+		return("state_sort");
+	}
 }
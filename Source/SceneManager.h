@@ -10,7 +10,23 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "UniformCache.h"
+#include "RenderStateFilter.h"
+#include "TextureLoader.h"
+#include "TextureArrays.h"
+#include "FrameProfiler.h"
+#include "SceneBVH.h"
 #include "ShapeMeshes.h"
+#include "MeshLibrary.h"
+#include "IndirectRenderer.h"
+#include "DepthPrepass.h"
+#include "LightManager.h"
+#include "SceneFile.h"
+#include "FileWatcher.h"
+#include "JobSystem.h"
+#include "SceneGraph.h"
+#include "UniformRing.h"
+#include "ShadowAtlas.h"
 
 #include <string>
 #include <vector>
@@ -25,14 +41,25 @@ class SceneManager
 {
 public:
 	// constructor
-	SceneManager(ShaderManager *pShaderManager);
+	SceneManager(ShaderManager *pShaderManager, UniformCache* pUniformCache);
 	// destructor
 	~SceneManager();
 
+	// stable integer handles returned when textures and materials
+	// are registered, used in place of the tag strings when drawing
+	typedef int TextureHandle;
+	typedef int MaterialHandle;
+	static const int INVALID_HANDLE = -1;
+
 	struct TEXTURE_INFO
 	{
 		std::string tag;
-		uint32_t ID;
+		std::string filename;
+		uint32_t ID;		// texture array holding the layer, 0 until queued
+		int page;
+		int layer;
+		bool hasAlpha;
+		bool bLoaded;		// the placeholder is drawn until it is set
 	};
 
 	struct OBJECT_MATERIAL
@@ -45,30 +72,342 @@ public:
 		std::string tag;
 	};
 
+	// basic shape meshes that can be referenced by a draw item
+	enum MESH_TYPE
+	{
+		MESH_PLANE = 0,
+		MESH_BOX,
+		MESH_CYLINDER,
+		MESH_TAPERED_CYLINDER,
+		MESH_SPHERE,
+		MESH_HALF_SPHERE,
+		MESH_TORUS,
+		MESH_HALF_TORUS
+	};
+
+	// mesh parts drawn for the cylinder style meshes
+	enum DRAW_VARIANT
+	{
+		DRAW_TOP = 0x01,
+		DRAW_BOTTOM = 0x02,
+		DRAW_SIDES = 0x04,
+		DRAW_ALL = DRAW_TOP | DRAW_BOTTOM | DRAW_SIDES
+	};
+
+	// one object in the retained draw list - every lookup is
+	// resolved and the model matrix is cached when it is built
+	struct DRAW_ITEM
+	{
+		glm::mat4 modelMatrix;
+		glm::mat3 normalMatrix;		// cached with the model matrix
+		glm::vec4 color;
+		glm::vec2 uvScale;
+		TextureHandle texture;		// INVALID_HANDLE draws with the solid color
+		MaterialHandle material;	// the material of the item before when unset
+		int instanceIndex;		// -1 is drawn on its own
+		int drawIndex;			// -1 when not drawn by the indirect path
+		uint8_t mesh;			// MESH_TYPE
+		uint8_t variant;		// DRAW_VARIANT bits
+		uint8_t section;		// scene section the item was added in
+		uint8_t lod;			// level of detail the item is drawn at
+	};
+
+	// how the opaque draws avoid shading hidden surfaces
+	enum DEPTH_MODE
+	{
+		DEPTH_MODE_STATE_SORT = 0,	// sorted by state only
+		DEPTH_MODE_FRONT_TO_BACK,	// sorted by view depth every frame
+		DEPTH_MODE_PREPASS,		// depth only pass, then shaded with GL_EQUAL
+		DEPTH_MODE_COUNT
+	};
+
+	// a group of draw items that only differ by their model
+	// matrix and are drawn together with one instanced call
+	struct INSTANCE_BATCH
+	{
+		int itemIndex;			// draw item the shader values come from
+		int firstInstance;
+		int instanceCount;
+		int visibleFirst;		// range of the visible instances in the
+		int visibleCount;		// instance buffer after culling
+		// visible instances at each level of detail, packed in order
+		// of the level from visibleFirst on
+		int lodCounts[MeshLibrary::MAX_LOD_LEVELS];
+	};
+
+	// instances of a batch that cast a shadow into a tile, packed
+	// next to each other in the instance buffer
+	struct SHADOW_BATCH
+	{
+		uint8_t mesh;			// MESH_TYPE
+		int firstInstance;
+		int instanceCount;
+	};
+
+	// one entry of the render queues - either a single draw item
+	// or an instanced batch, ordered by its sort key
+	struct RENDER_QUEUE_ENTRY
+	{
+		uint64_t sortKey;		// packed program, texture, material, mesh
+		float viewDepth;		// distance along the view direction
+		int itemIndex;			// draw item the shader values come from
+		int batchIndex;			// -1 when the item is drawn on its own
+	};
+
+	// a range of the indirect commands that share the texture
+	// array, drawn together with one multi draw call
+	struct INDIRECT_GROUP
+	{
+		int firstCommand;
+		int commandCount;
+		TextureHandle texture;		// any texture of the page, or INVALID_HANDLE
+	};
+
+	// change the transformation of a draw item, only the changed
+	// items have their model matrix rebuilt on the next frame
+	void SetDrawItemTransform(
+		int itemIndex,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
+	// find a transform node of the scene by its name, -1 when the
+	// scene has none
+	int FindSceneNode(const std::string& name) const { return m_pSceneGraph->FindNode(name); }
+	// change the transformation of a node, the items below it are
+	// moved with it on the next frame
+	void SetSceneNodeTransform(
+		int node,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to the cached shader uniform locations
+	UniformCache* m_pUniformCache;
 	// pointer to basic shapes object
 	ShapeMeshes* m_basicMeshes;
+	// pointer to the shared shapes used for instanced drawing
+	MeshLibrary* m_instancedMeshes;
 	// total number of loaded textures
 	int m_loadedTextures;
-	// loaded textures info
-	TEXTURE_INFO m_textureIDs[16];
+	// loaded textures info, indexed by texture handle
+	std::vector<TEXTURE_INFO> m_textureIDs;
 	// defined object materials
 	std::vector<OBJECT_MATERIAL> m_objectMaterials;
 
+	// std140 layout of the Material struct in the shader MaterialBlock
+	struct MATERIAL_BLOCK
+	{
+		glm::vec3 diffuseColor; float pad0;
+		glm::vec3 specularColor; float shininess;
+		glm::vec3 ambientColor; float ambientStrength;
+	};
+	// uniform buffer holding every defined material, one per stride
+	GLuint m_materialBuffer;
+	GLint m_materialStride;
+
+	// std140 layout of the shader CameraBlock, written once per frame
+	struct CAMERA_BLOCK
+	{
+		glm::mat4 view;
+		glm::mat4 viewProjection;
+		glm::vec4 viewPosition;
+	};
+	// std140 layout of the shader ObjectBlock, written for each draw
+	struct OBJECT_BLOCK
+	{
+		glm::mat4 model;
+		// std140 mat3, each column padded to four floats
+		glm::vec4 normalMatrix[3];
+		glm::vec4 color;
+		// uv scale in xy and the texture layer in z
+		glm::vec4 params;
+	};
+	// ring buffer the camera and object blocks are written to, and
+	// the object values of the next draw
+	UniformRing* m_pUniformRing;
+	OBJECT_BLOCK m_objectBlock;
+	// set by the shader setters until the object values are written
+	bool m_bObjectBlockDirty;
+
+	// cached uniform locations used for every draw
+	GLint m_useLightingLocation;
+	// drops the state changes that would set the current value
+	RenderStateFilter* m_pStateFilter;
+	// decodes and uploads the scene textures in the background
+	TextureLoader* m_pTextureLoader;
+	// texture arrays that the scene textures are layers of
+	TextureArrays* m_pTextureArrays;
+	// retained draw list built once in PrepareScene()
+	std::vector<DRAW_ITEM> m_drawList;
+	// transformation values for each entry in the draw list, kept
+	// as one array per value so that the jobs rebuilding the model
+	// matrices read each of them in order
+	std::vector<glm::vec3> m_drawScales;
+	std::vector<glm::vec3> m_drawRotations;
+	std::vector<glm::vec3> m_drawPositions;
+	// draw items whose model matrix needs to be rebuilt
+	std::vector<int> m_dirtyDrawItems;
+	// instanced batches built from the draw list
+	std::vector<INSTANCE_BATCH> m_instanceBatches;
+	// model and normal matrices of all the instanced draw items, and
+	// the draw item of each instance
+	std::vector<MeshLibrary::INSTANCE_TRANSFORM> m_instanceTransforms;
+	std::vector<int> m_instanceItems;
+	// model and normal matrices of the visible instances, as uploaded
+	std::vector<MeshLibrary::INSTANCE_TRANSFORM> m_visibleInstanceTransforms;
+	bool m_bInstancesDirty;
+	// opaque draws sorted by state and transparent draws that are
+	// sorted back-to-front every frame
+	std::vector<RENDER_QUEUE_ENTRY> m_opaqueQueue;
+	std::vector<RENDER_QUEUE_ENTRY> m_transparentQueue;
+	// view matrix used for sorting the transparent draws, and the
+	// projection matrix the view frustum is culled with
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	// camera position of the frame, for the camera block
+	glm::vec3 m_viewPosition;
+
+	// world space box of each draw item and the hierarchy built
+	// over them, rebuilt only after items have moved
+	std::vector<SceneBVH::BOUNDING_BOX> m_drawBounds;
+	SceneBVH* m_pSceneBVH;
+	bool m_bBoundsDirty;
+	// set when items moved since the last culled frame
+	bool m_bBoundsMoved;
+	// runs the loops over the draw items on the worker threads
+	JobSystem* m_pJobSystem;
+	// visibility of each draw item this frame and the last
+	std::vector<uint8_t> m_visibleItems;
+	std::vector<uint8_t> m_lastVisibleItems;
+	bool m_bFrustumCulling;
+	SceneBVH::CULL_COUNTERS m_cullCounters;
+	// pick the level of detail of each visible item by its size on
+	// the screen, level 0 for every item when it is not set
+	bool m_bLodSelection;
+
+	// GPU culled multi draw indirect path for the static opaque
+	// items, and the command ranges it is drawn with
+	IndirectRenderer* m_pIndirectRenderer;
+	std::vector<INDIRECT_GROUP> m_indirectGroups;
+	bool m_bIndirectDrawing;
+	// set while the indirect path draws the current frame
+	bool m_bIndirectFrame;
+	GLint m_drawDataLocation;
+	GLint m_materialDataLocation;
+
+	// depth pre-pass program and the opaque ordering in use
+	DepthPrepass* m_pDepthPrepass;
+	DEPTH_MODE m_depthMode;
+	// the opaque queue ordered by view depth, for the front to back mode
+	std::vector<RENDER_QUEUE_ENTRY> m_depthSortedQueue;
+	// cached shadow maps of the directional light and the flashlight,
+	// and the lights they are drawn for
+	ShadowAtlas* m_pShadowAtlas;
+	LightManager* m_pLightManager;
+	// draw items inside the light frustum of the tile being drawn, and
+	// the indirect commands and instances the casters are drawn with
+	std::vector<uint8_t> m_shadowCasters;
+	std::vector<MeshLibrary::DRAW_COMMAND> m_shadowCommands;
+	std::vector<SHADOW_BATCH> m_shadowBatches;
+	std::vector<MeshLibrary::INSTANCE_TRANSFORM> m_shadowInstanceTransforms;
+
+	// names of the scene sections, indexed by DRAW_ITEM::section
+	std::vector<std::string> m_sectionNames;
+	// section that the added draw items belong to
+	uint8_t m_currentSection;
+	// transform nodes the draw items are placed under, the node of
+	// each draw item, and the node the added draw items go under
+	SceneGraph* m_pSceneGraph;
+	std::vector<int> m_drawNodes;
+	int m_currentNode;
+	// set when a node has moved since the last frame
+	bool m_bNodesDirty;
+	// visibility of each node by the frustum this frame
+	std::vector<uint8_t> m_visibleNodes;
+	// the opaque queue ordered by section, used for profiling
+	std::vector<RENDER_QUEUE_ENTRY> m_sectionQueue;
+	// optional profiler the scene sections are timed with
+	FrameProfiler* m_pProfiler;
+	bool m_bProfileSections;
+	// number of draw calls issued in the current frame
+	int m_drawCalls;
+	// scene description read from a file, used in place of the
+	// built in scene once it is loaded, and the name it is read from
+	SceneFile* m_pSceneFile;
+	std::string m_sceneFilename;
+	// number of draw items the stress scene is filled up to, 0 for
+	// the desk scene only, and the radius of the tiled grid
+	int m_stressObjectCount;
+	float m_stressRadius;
+
 	// load texture images and convert to OpenGL texture data
-	bool CreateGLTexture(const char* filename, std::string tag);
-	// bind loaded OpenGL textures to slots in memory
+	TextureHandle CreateGLTexture(const char* filename, const std::string& tag);
+	// allocate the texture arrays, queue the textures for loading
+	// and bind the arrays to their texture units
 	void BindGLTextures();
 	// free the loaded OpenGL textures
 	void DestroyGLTextures();
-	// find a loaded texture by tag
-	int FindTextureID(std::string tag);
-	int FindTextureSlot(std::string tag);
-	// find a defined material by tag
-	bool FindMaterial(std::string tag, OBJECT_MATERIAL& material);
+	// find a loaded texture by tag - used when loading the scene
+	int FindTextureID(const std::string& tag) const;
+	int FindTextureSlot(const std::string& tag) const;
+	TextureHandle FindTextureHandle(const std::string& tag) const;
+	// find a defined material by tag - used when loading the scene
+	const OBJECT_MATERIAL* FindMaterial(const std::string& tag) const;
+	MaterialHandle FindMaterialHandle(const std::string& tag) const;
+	// register a material and get the handle it is drawn with
+	MaterialHandle AddObjectMaterial(const OBJECT_MATERIAL& material);
+	// define the materials and build the draw list of the scene file
+	void DefineSceneFileMaterials();
+	void BuildSceneFileDrawList();
+	// build the batches, queues, boxes and indirect commands of the
+	// draw list
+	void BuildDrawState();
+	// load a changed texture image or scene file again
+	bool ReloadTexture(TextureHandle texture);
+	bool ReloadSceneFile();
+	// add an object with its texture and material already resolved
+	int AddDrawItemByHandle(
+		MESH_TYPE mesh,
+		TextureHandle texture,
+		MaterialHandle material,
+		glm::vec2 uvScale,
+		glm::vec3 scaleXYZ,
+		glm::vec3 rotationDegrees,
+		glm::vec3 positionXYZ,
+		uint8_t variant);
 	
+	// build the model matrix from the transformation values
+	static glm::mat4 BuildModelMatrix(
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	// build the matrix that the normals are transformed with
+	static glm::mat3 BuildNormalMatrix(const glm::mat4& modelMatrix);
+	// get the matrices of a draw item for the instance buffer
+	static MeshLibrary::INSTANCE_TRANSFORM BuildInstanceTransform(const DRAW_ITEM& item);
+
+	// look up the uniform locations that are used for drawing
+	void LoadUniformLocations();
+	// copy the defined materials into the material uniform buffer
+	void UploadMaterialBuffer();
+	// write the object values to the ring buffer for the next draw
+	void UploadObjectBlock();
+	// write the object values if a shader setter has changed them
+	void UploadDirtyObjectBlock();
+	// select the texture array and layer of a texture, without
+	// writing the object values
+	void SetTextureState(TextureHandle texture);
+
 	// set the transformation values 
 	// into the transform buffer
 	void SetTransformations(
@@ -87,7 +426,9 @@ private:
 
 	// set the texture data into the shader
 	void SetShaderTexture(
-		std::string textureTag);
+		const std::string& textureTag);
+	void SetShaderTexture(
+		TextureHandle texture);
 
 	// set the UV scale for the texture mapping
 	void SetTextureUVScale(
@@ -95,24 +436,217 @@ private:
 
 	// set the object material into the shader
 	void SetShaderMaterial(
-		std::string materialTag);
+		const std::string& materialTag);
+	void SetShaderMaterial(
+		MaterialHandle material);
+
+	// add a textured object to the retained draw list
+	int AddDrawItem(
+		MESH_TYPE mesh,
+		const std::string& textureTag,
+		const std::string& materialTag,
+		glm::vec2 uvScale,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		uint8_t variant = DRAW_ALL);
+
+	// add a solid colored object to the retained draw list
+	int AddColorDrawItem(
+		MESH_TYPE mesh,
+		glm::vec4 color,
+		glm::vec2 uvScale,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ,
+		uint8_t variant = DRAW_ALL);
+
+	// rebuild the model matrices of the changed draw items
+	void UpdateDirtyDrawItems();
+	// group the repeated draw items into instanced batches
+	void BuildInstanceBatches();
+	// set the shader values of a draw item, the object values are
+	// written by the caller
+	void SetDrawItemState(const DRAW_ITEM& item);
+	// start a named section of the scene for the profiler
+	void BeginSection(const char* name);
+	// start a transform node under the current node, the draw items
+	// added until the matching EndNode() are placed relative to it
+	int BeginNode(
+		const char* name,
+		glm::vec3 scaleXYZ,
+		float XrotationDegrees,
+		float YrotationDegrees,
+		float ZrotationDegrees,
+		glm::vec3 positionXYZ);
+	void EndNode();
+	// draw the opaque queue section by section, with a profiler
+	// scope around each section
+	void DrawSectionQueue();
+	// tile copies of the scene composites around the desk
+	void BuildStressScene();
+
+	// get the local box of a basic shape mesh
+	static SceneBVH::BOUNDING_BOX GetMeshBounds(uint8_t mesh);
+	// rebuild the world space box of a draw item
+	void UpdateDrawBounds(int itemIndex);
+	// find the draw items inside of the view frustum
+	void CullScene();
+	// test the scene nodes and then the draw item boxes below the
+	// visible nodes in parallel, without the hierarchy
+	SceneBVH::CULL_COUNTERS CullDrawBounds(const SceneBVH::FRUSTUM& frustum, std::vector<uint8_t>& visibleItems);
+	// empty the draw list and its transformations
+	void ClearDrawList(size_t reserveCount);
+	// copy the matrices of the visible instances to the instance buffer
+	void UploadVisibleInstances();
+	// pick the level of detail of the visible draw items
+	void SelectLods();
+	// get the level of detail for a screen size, keeping the current
+	// level until the size is past the switch point by the hysteresis
+	static uint8_t SelectLod(float screenSize, uint8_t currentLod, int lodCount);
+
+	// move the static opaque items to the indirect path
+	void BuildIndirectDraws();
+	// get the per draw values of an item on the indirect path
+	IndirectRenderer::INDIRECT_OBJECT BuildIndirectObject(const DRAW_ITEM& item) const;
+	// check if the indirect path draws its items this frame
+	bool IsIndirectActive() const;
+	// cull the indirect commands on the GPU
+	void CullIndirectObjects();
+	// draw the culled indirect commands group by group
+	void DrawIndirectGroups();
 
-    void ApplyAndDraw(const std::string& texTag,
-                      const std::string& matTag,
-                      const glm::vec2& uv, 
-                      const glm::vec3& scale,
-                      float rx, float ry, float rz,
-                      const glm::vec3& pos,
-                      const std::function<void()>& drawCall);
+	// fill the depth buffer with the opaque draws
+	void DrawDepthPrepass();
+	// draw the depth of one entry of the opaque queue
+	void DrawDepthEntry(const RENDER_QUEUE_ENTRY& entry);
+	// draw the depth of a single draw item at a level of detail
+	void DrawItemDepth(const DRAW_ITEM& item, int lod);
+	// fit the shadow atlas tiles to their lights, and draw the maps
+	// that are out of date
+	void UpdateShadowMaps();
+	// find the draw items inside the frustum of a light
+	void CullShadowCasters(const SceneBVH::FRUSTUM& frustum);
+	// draw the opaque items inside the light frustum of a tile, true
+	// when the instance buffer was filled with the casters
+	bool DrawShadowTile(int tile);
+	// sort a copy of the opaque queue from the nearest to the farthest
+	void SortFrontToBack();
+	// check if a draw item needs to be blended with the scene
+	bool IsTransparent(const DRAW_ITEM& item) const;
+	// pack the shader state of a draw item into a sort key
+	uint64_t BuildSortKey(const DRAW_ITEM& item, bool bInstanced) const;
+	// build the opaque and transparent render queues
+	void BuildRenderQueues();
+	// sort the transparent draws from the farthest to the nearest
+	void SortTransparentQueue();
+	// check if a render queue entry has anything to draw this frame
+	bool IsEntryDrawn(const RENDER_QUEUE_ENTRY& entry) const;
+	// draw one entry of a render queue
+	void DrawQueueEntry(const RENDER_QUEUE_ENTRY& entry);
+
+	// set the shader values for a draw item and draw its mesh
+	void DrawItem(const DRAW_ITEM& item);
+	// draw the basic shape mesh referenced by a draw item
+	void DrawMesh(uint8_t mesh, uint8_t variant);
 
 public:
 
 	// The following methods are for the students to 
 	// customize for their own 3D scene
 	void PrepareScene();
+	void BuildSceneDrawList();
 	void RenderScene();
 	void LoadSceneTextures();
-	void SetupSceneLights();
+	void SetupSceneLights(LightManager* pLightManager);
 	void DefineObjectMaterials();
 
+	// get the state change counters of the last rendered frame
+	RenderStateFilter::STATE_COUNTERS GetStateCounters() const;
+
+	// check if all of the scene textures have been uploaded
+	bool AreTexturesLoaded() const { return m_pTextureLoader->IsIdle(); }
+	// check if the next frame differs from the last one because an
+	// item moved or a texture is still replacing its placeholder
+	bool IsRedrawNeeded() const { return (false == m_dirtyDrawItems.empty()) || m_bNodesDirty || (false == AreTexturesLoaded()); }
+
+	// set the profiler that the scene is timed with
+	void SetProfiler(FrameProfiler* pProfiler) { m_pProfiler = pProfiler; }
+	// draw the scene section by section so that each can be timed,
+	// this gives up part of the state sorting while it is set
+	void SetSectionProfiling(bool bEnabled) { m_bProfileSections = bEnabled; }
+	bool IsSectionProfiling() const { return m_bProfileSections; }
+	// get the number of draw calls of the last rendered frame
+	int GetDrawCallCount() const { return m_drawCalls; }
+
+	// most draw items the stress scene can be filled up to
+	static const int MAX_STRESS_OBJECTS = 100000;
+	// fill the scene up to the passed in number of draw items by
+	// tiling the composites, must be set before PrepareScene()
+	void SetStressObjectCount(int objectCount);
+	// get the number of items in the draw list
+	int GetDrawItemCount() const { return (int)m_drawList.size(); }
+	// get the radius of the stress scene grid, 0 without one
+	float GetStressRadius() const { return m_stressRadius; }
+
+	// read the textures, materials and draw items from a scene file
+	// instead of the built in scene, must be called before the
+	// textures are loaded
+	bool LoadSceneFile(const std::string& filename);
+	// check if the scene comes from a scene file
+	bool IsSceneFileLoaded() const { return m_pSceneFile->IsLoaded(); }
+
+	// IDs that the scene files are watched with, the textures are
+	// watched from WATCH_TEXTURES on by their handle
+	enum WATCH_ID
+	{
+		WATCH_DEPTH_SHADERS = 100,
+		WATCH_CULL_SHADER,
+		WATCH_SCENE_FILE,
+		WATCH_TEXTURES = 1000
+	};
+	// add the shader, texture and scene files of the scene to a watcher
+	void WatchFiles(FileWatcher* pWatcher);
+	// reload a watched file after it changed, false when it failed
+	// and the last working version is kept
+	bool ReloadFile(int watchID);
+	// look up the uniform locations again after the scene program
+	// was replaced
+	void ReloadUniformLocations();
+
+	// set the view matrix that the transparent draws are sorted with
+	void SetViewMatrix(const glm::mat4& view) { m_viewMatrix = view; }
+	// set the projection matrix that the scene is culled with
+	void SetProjectionMatrix(const glm::mat4& projection) { m_projectionMatrix = projection; }
+	// set the camera position that the scene is lit from
+	void SetViewPosition(const glm::vec3& position) { m_viewPosition = position; }
+
+	// turn the view frustum culling on or off
+	void SetFrustumCulling(bool bEnabled) { m_bFrustumCulling = bEnabled; }
+	bool IsFrustumCulling() const { return m_bFrustumCulling; }
+	// get the visible and culled counts of the last rendered frame
+	SceneBVH::CULL_COUNTERS GetCullCounters() const { return m_cullCounters; }
+
+	// turn the screen size level of detail selection on or off
+	void SetLodSelection(bool bEnabled) { m_bLodSelection = bEnabled; }
+	bool IsLodSelection() const { return m_bLodSelection; }
+
+	// draw the static opaque items with multi draw indirect, once
+	// all of the textures are loaded and when section profiling is off
+	void SetIndirectDrawing(bool bEnabled) { m_bIndirectDrawing = bEnabled; }
+	bool IsIndirectDrawing() const { return m_bIndirectDrawing; }
+	// check if the GPU supports the indirect path
+	bool IsIndirectSupported() const { return m_pIndirectRenderer->GetObjectCount() > 0; }
+
+	// pick how the opaque draws avoid shading hidden surfaces, the
+	// pre-pass falls back to the state order without its program
+	void SetDepthMode(DEPTH_MODE mode) { m_depthMode = mode; }
+	DEPTH_MODE GetDepthMode() const { return m_depthMode; }
+	// get the name of a depth mode for the output
+	static const char* GetDepthModeName(DEPTH_MODE mode);
+
 };
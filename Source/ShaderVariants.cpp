@@ -0,0 +1,284 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariants.cpp
+// ============
+// build specialized versions of the scene shader program
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShaderVariants.h"
+#include "GpuResources.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+/***********************************************************
+ *  ShaderVariants()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShaderVariants::ShaderVariants()
+{
+}
+
+/***********************************************************
+ *  ~ShaderVariants()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShaderVariants::~ShaderVariants()
+{
+	std::map<int, GLuint>::iterator it;
+	for (it = m_programs.begin(); it != m_programs.end(); ++it)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_PROGRAM, it->second);
+		glDeleteProgram(it->second);
+	}
+	m_programs.clear();
+}
+
+/***********************************************************
+ *  LoadSources()
+ *
+ *  This method is used for reading the vertex and fragment
+ *  shader sources that every variant is built from.
+ ***********************************************************/
+bool ShaderVariants::LoadSources(const char* vertexFile, const char* fragmentFile)
+{
+	m_vertexFile = vertexFile;
+	m_fragmentFile = fragmentFile;
+
+	if ((false == ReadFile(vertexFile, m_vertexSource)) ||
+		(false == ReadFile(fragmentFile, m_fragmentSource)))
+	{
+		return(false);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  GetProgram()
+ *
+ *  This method is used for getting the program specialized
+ *  for the passed in number of point lights.  The program
+ *  is compiled and linked the first time it is requested.
+ ***********************************************************/
+GLuint ShaderVariants::GetProgram(int pointLightCount)
+{
+	std::map<int, GLuint>::iterator found = m_programs.find(pointLightCount);
+	if (found != m_programs.end())
+	{
+		return(found->second);
+	}
+
+	if (m_vertexSource.empty() || m_fragmentSource.empty())
+	{
+		return(0);
+	}
+
+	std::ostringstream defines;
+	defines << "#define NUM_POINT_LIGHTS " << pointLightCount << "\n";
+
+	GLuint program = BuildProgram(
+		AddDefines(m_vertexSource, defines.str()),
+		AddDefines(m_fragmentSource, defines.str()),
+		m_vertexFile.c_str());
+	if (0 == program)
+	{
+		std::cout << "ERROR: shader variant failed, point lights:" << pointLightCount << std::endl;
+		return(0);
+	}
+
+	m_programs[pointLightCount] = program;
+
+	return(program);
+}
+
+/***********************************************************
+ *  ReloadSources()
+ *
+ *  This method is used for reading the shader files again
+ *  and rebuilding every variant that has been requested.
+ *  The new programs only replace the old ones once all of
+ *  them have been built, so a shader with an error keeps
+ *  the last working programs in use.
+ ***********************************************************/
+bool ShaderVariants::ReloadSources()
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+	std::map<int, GLuint> programs;
+	std::map<int, GLuint>::iterator it;
+
+	if ((false == ReadFile(m_vertexFile.c_str(), vertexSource)) ||
+		(false == ReadFile(m_fragmentFile.c_str(), fragmentSource)))
+	{
+		return(false);
+	}
+
+	for (it = m_programs.begin(); it != m_programs.end(); ++it)
+	{
+		std::ostringstream defines;
+		defines << "#define NUM_POINT_LIGHTS " << it->first << "\n";
+
+		GLuint program = BuildProgram(
+			AddDefines(vertexSource, defines.str()),
+			AddDefines(fragmentSource, defines.str()),
+			m_vertexFile.c_str());
+		if (0 == program)
+		{
+			std::cout << "ERROR: shader reload failed, point lights:" << it->first << std::endl;
+			for (it = programs.begin(); it != programs.end(); ++it)
+			{
+				GpuResources::Remove(GpuResources::RESOURCE_PROGRAM, it->second);
+				glDeleteProgram(it->second);
+			}
+			return(false);
+		}
+		programs[it->first] = program;
+	}
+
+	for (it = m_programs.begin(); it != m_programs.end(); ++it)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_PROGRAM, it->second);
+		glDeleteProgram(it->second);
+	}
+	m_programs = programs;
+	m_vertexSource = vertexSource;
+	m_fragmentSource = fragmentSource;
+
+	return(true);
+}
+
+/***********************************************************
+ *  LoadProgram()
+ *
+ *  This method is used for building a program from a pair
+ *  of shader files as they are, without any defines.  The
+ *  caller owns the returned program.
+ ***********************************************************/
+GLuint ShaderVariants::LoadProgram(const char* vertexFile, const char* fragmentFile)
+{
+	std::string vertexSource;
+	std::string fragmentSource;
+
+	if ((false == ReadFile(vertexFile, vertexSource)) ||
+		(false == ReadFile(fragmentFile, fragmentSource)))
+	{
+		return(0);
+	}
+
+	return(BuildProgram(vertexSource, fragmentSource, vertexFile));
+}
+
+/***********************************************************
+ *  BuildProgram()
+ *
+ *  This method is used for compiling the two shader stages
+ *  and linking them.  Zero is returned when either stage
+ *  does not compile or the program does not link.
+ ***********************************************************/
+GLuint ShaderVariants::BuildProgram(const std::string& vertexSource, const std::string& fragmentSource, const char* owner)
+{
+	GLint success = 0;
+	GLchar infoLog[512];
+
+	GLuint vertexShader = CompileShader(GL_VERTEX_SHADER, vertexSource);
+	GLuint fragmentShader = CompileShader(GL_FRAGMENT_SHADER, fragmentSource);
+	if ((0 == vertexShader) || (0 == fragmentShader))
+	{
+		glDeleteShader(vertexShader);
+		glDeleteShader(fragmentShader);
+		return(0);
+	}
+
+	GLuint program = glCreateProgram();
+	glAttachShader(program, vertexShader);
+	glAttachShader(program, fragmentShader);
+	glLinkProgram(program);
+	glDeleteShader(vertexShader);
+	glDeleteShader(fragmentShader);
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	if (!success)
+	{
+		glGetProgramInfoLog(program, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR: shader program linking failed\n" << infoLog << std::endl;
+		glDeleteProgram(program);
+		return(0);
+	}
+	GpuResources::Add(GpuResources::RESOURCE_PROGRAM, program, owner);
+
+	return(program);
+}
+
+/***********************************************************
+ *  AddDefines()
+ *
+ *  This method is used for inserting the define lines right
+ *  after the #version line, which has to stay the first
+ *  line of a GLSL source.
+ ***********************************************************/
+std::string ShaderVariants::AddDefines(const std::string& source, const std::string& defines)
+{
+	size_t versionLine = source.find("#version");
+	if (std::string::npos == versionLine)
+	{
+		return(defines + source);
+	}
+
+	size_t lineEnd = source.find('\n', versionLine);
+	if (std::string::npos == lineEnd)
+	{
+		return(source + "\n" + defines);
+	}
+
+	return(source.substr(0, lineEnd + 1) + defines + source.substr(lineEnd + 1));
+}
+
+/***********************************************************
+ *  CompileShader()
+ *
+ *  This method is used for compiling one shader stage.  Zero
+ *  is returned when the source does not compile.
+ ***********************************************************/
+GLuint ShaderVariants::CompileShader(GLenum type, const std::string& source)
+{
+	GLint success = 0;
+	GLchar infoLog[512];
+
+	const GLchar* codeText = source.c_str();
+	GLuint shader = glCreateShader(type);
+	glShaderSource(shader, 1, &codeText, NULL);
+	glCompileShader(shader);
+	glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
+	if (!success)
+	{
+		glGetShaderInfoLog(shader, sizeof(infoLog), NULL, infoLog);
+		std::cout << "ERROR: shader compilation failed\n" << infoLog << std::endl;
+		glDeleteShader(shader);
+		return(0);
+	}
+
+	return(shader);
+}
+
+/***********************************************************
+ *  ReadFile()
+ *
+ *  This method is used for reading a whole text file.
+ ***********************************************************/
+bool ShaderVariants::ReadFile(const char* filename, std::string& contents)
+{
+	std::ifstream file(filename);
+	std::stringstream source;
+
+	if (!file.is_open())
+	{
+		std::cout << "Could not open shader file:" << filename << std::endl;
+		return(false);
+	}
+	source << file.rdbuf();
+	contents = source.str();
+
+	return(true);
+}
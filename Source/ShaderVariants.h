@@ -0,0 +1,64 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadervariants.h
+// ============
+// build specialized versions of the scene shader program
+//
+//  The shader sources are compiled with #define lines added after their
+//  #version line, so that values like the number of lights become constants
+//  that the shader compiler can unroll and drop dead code for.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <map>
+#include <string>
+
+/***********************************************************
+ *  ShaderVariants
+ *
+ *  This class contains the code for reading the vertex and
+ *  fragment shader sources once and for linking a program
+ *  for each requested number of point lights.  The linked
+ *  programs are kept until the object is destroyed.
+ ***********************************************************/
+class ShaderVariants
+{
+public:
+	// constructor
+	ShaderVariants();
+	// destructor
+	~ShaderVariants();
+
+	// read the shader sources the variants are built from
+	bool LoadSources(const char* vertexFile, const char* fragmentFile);
+	// get the program for the passed in number of point lights, it is
+	// built on the first request, zero when it cannot be built
+	GLuint GetProgram(int pointLightCount);
+	// read the shader files again and rebuild every built variant,
+	// the old programs are kept when any of them fails to build
+	bool ReloadSources();
+
+	// build a program from a pair of shader files without defines
+	static GLuint LoadProgram(const char* vertexFile, const char* fragmentFile);
+
+private:
+	// shader files and the sources as read from them
+	std::string m_vertexFile;
+	std::string m_fragmentFile;
+	std::string m_vertexSource;
+	std::string m_fragmentSource;
+	// linked programs by their number of point lights
+	std::map<int, GLuint> m_programs;
+
+	// add the passed in defines after the #version line of a source
+	static std::string AddDefines(const std::string& source, const std::string& defines);
+	// compile and link the two shader stages, zero when it fails - the
+	// owner names the program in the resource registry
+	static GLuint BuildProgram(const std::string& vertexSource, const std::string& fragmentSource, const char* owner);
+	// compile one shader stage, zero when it fails
+	static GLuint CompileShader(GLenum type, const std::string& source);
+	// read a whole text file into a string
+	static bool ReadFile(const char* filename, std::string& contents);
+};
@@ -0,0 +1,297 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowatlas.cpp
+// ============
+// cached depth maps of the shadow casting lights, packed into one texture
+///////////////////////////////////////////////////////////////////////////////
+
+#include "ShadowAtlas.h"
+#include "GpuResources.h"
+#include "UniformCache.h"
+
+#include <glm/gtx/transform.hpp>
+
+#include <algorithm>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// depth offset of the drawn casters, by the slope of the polygon
+	// and by the smallest depth step, so that a lit surface does not
+	// shadow itself
+	const float CASTER_SLOPE_OFFSET = 2.0f;
+	const float CASTER_UNITS_OFFSET = 4.0f;
+}
+
+/***********************************************************
+ *  ShadowAtlas()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+ShadowAtlas::ShadowAtlas()
+{
+	GLint maxUnits = 0;
+
+	m_texture = 0;
+	m_framebuffer = 0;
+	m_shadowBuffer = 0;
+	m_bBlockDirty = true;
+	m_tileDrawCount = 0;
+	for (int i = 0; i < 4; i++)
+	{
+		m_frameViewport[i] = 0;
+	}
+	for (int tile = 0; tile < TILE_COUNT; tile++)
+	{
+		m_tiles[tile].viewProjection = glm::mat4(1.0f);
+		m_tiles[tile].texelSize = 0.0f;
+		m_tiles[tile].depthBias = 0.0f;
+		m_tiles[tile].bActive = false;
+		m_tiles[tile].bValid = false;
+	}
+
+	// the unit below the ones of the light clusters
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &maxUnits);
+	m_textureUnit = std::max(0, maxUnits - 7);
+}
+
+/***********************************************************
+ *  ~ShadowAtlas()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+ShadowAtlas::~ShadowAtlas()
+{
+	Release();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the depth texture of
+ *  the atlas, the framebuffer the tiles are drawn through
+ *  and the shadow block.  The block is created first, so
+ *  that the scene is drawn without shadows when the
+ *  framebuffer cannot be used.
+ ***********************************************************/
+bool ShadowAtlas::Initialize()
+{
+	Release();
+
+	glGenBuffers(1, &m_shadowBuffer);
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_shadowBuffer, "ShadowAtlas", sizeof(SHADOW_BLOCK));
+	glBindBuffer(GL_UNIFORM_BUFFER, m_shadowBuffer);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(SHADOW_BLOCK), NULL, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, UniformCache::SHADOW_BLOCK_BINDING, m_shadowBuffer);
+	m_bBlockDirty = true;
+
+	// the texture compares the depth on lookup, and the linear filter
+	// blends the results of the four nearest texels
+	glGenTextures(1, &m_texture);
+	glActiveTexture(GL_TEXTURE0 + m_textureUnit);
+	glBindTexture(GL_TEXTURE_2D, m_texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT24, TILE_SIZE * TILE_COUNT, TILE_SIZE, 0,
+		GL_DEPTH_COMPONENT, GL_FLOAT, NULL);
+	GpuResources::Add(GpuResources::RESOURCE_TEXTURE, m_texture, "ShadowAtlas",
+		(size_t)TILE_SIZE * TILE_COUNT * TILE_SIZE * GpuResources::GetTexelSize(GL_DEPTH_COMPONENT24));
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_MODE, GL_COMPARE_REF_TO_TEXTURE);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_COMPARE_FUNC, GL_LEQUAL);
+	glActiveTexture(GL_TEXTURE0);
+
+	glGenFramebuffers(1, &m_framebuffer);
+	GpuResources::Add(GpuResources::RESOURCE_FRAMEBUFFER, m_framebuffer, "ShadowAtlas");
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glFramebufferTexture2D(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_TEXTURE_2D, m_texture, 0);
+	glDrawBuffer(GL_NONE);
+	glReadBuffer(GL_NONE);
+	GLenum status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+	if (GL_FRAMEBUFFER_COMPLETE != status)
+	{
+		std::cout << "INFO: The shadow atlas framebuffer is not complete, shadows are disabled" << std::endl;
+		GpuResources::Remove(GpuResources::RESOURCE_FRAMEBUFFER, m_framebuffer);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+		UploadShadowBlock();
+		return(false);
+	}
+
+	Invalidate();
+	UploadShadowBlock();
+
+	return(true);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for deleting the texture, the
+ *  framebuffer and the shadow block.
+ ***********************************************************/
+void ShadowAtlas::Release()
+{
+	if (0 != m_framebuffer)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_FRAMEBUFFER, m_framebuffer);
+		glDeleteFramebuffers(1, &m_framebuffer);
+		m_framebuffer = 0;
+	}
+	if (0 != m_texture)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_TEXTURE, m_texture);
+		glDeleteTextures(1, &m_texture);
+		m_texture = 0;
+	}
+	if (0 != m_shadowBuffer)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_shadowBuffer);
+		glDeleteBuffers(1, &m_shadowBuffer);
+		m_shadowBuffer = 0;
+	}
+}
+
+/***********************************************************
+ *  SetTileLight()
+ *
+ *  This method is used for setting the light of a tile.  A
+ *  changed matrix needs the map to be drawn again, while a
+ *  light that is turned off and on keeps its map.
+ ***********************************************************/
+void ShadowAtlas::SetTileLight(int tile, const glm::mat4& viewProjection, float texelSize, float depthBias, bool bActive)
+{
+	TILE& light = m_tiles[tile];
+
+	if (viewProjection != light.viewProjection)
+	{
+		light.viewProjection = viewProjection;
+		light.bValid = false;
+		m_bBlockDirty = true;
+	}
+	if ((texelSize != light.texelSize) || (depthBias != light.depthBias) || (bActive != light.bActive))
+	{
+		light.texelSize = texelSize;
+		light.depthBias = depthBias;
+		light.bActive = bActive;
+		m_bBlockDirty = true;
+	}
+}
+
+/***********************************************************
+ *  Invalidate()
+ *
+ *  This method is used for marking the map of every tile as
+ *  out of date.  The tiles of the lights that are off are
+ *  drawn once their light is turned on again.
+ ***********************************************************/
+void ShadowAtlas::Invalidate()
+{
+	for (int tile = 0; tile < TILE_COUNT; tile++)
+	{
+		if (m_tiles[tile].bValid)
+		{
+			m_tiles[tile].bValid = false;
+			m_bBlockDirty = true;
+		}
+	}
+}
+
+/***********************************************************
+ *  BeginTile()
+ *
+ *  This method is used for drawing into a tile of the atlas.
+ *  The viewport covers the tile, and only its part of the
+ *  depth is cleared so the other tiles keep their maps.
+ ***********************************************************/
+void ShadowAtlas::BeginTile(int tile)
+{
+	glGetIntegerv(GL_VIEWPORT, m_frameViewport);
+
+	glBindFramebuffer(GL_FRAMEBUFFER, m_framebuffer);
+	glViewport(tile * TILE_SIZE, 0, TILE_SIZE, TILE_SIZE);
+	glEnable(GL_SCISSOR_TEST);
+	glScissor(tile * TILE_SIZE, 0, TILE_SIZE, TILE_SIZE);
+	glClear(GL_DEPTH_BUFFER_BIT);
+	glDisable(GL_SCISSOR_TEST);
+
+	glEnable(GL_POLYGON_OFFSET_FILL);
+	glPolygonOffset(CASTER_SLOPE_OFFSET, CASTER_UNITS_OFFSET);
+}
+
+/***********************************************************
+ *  EndTile()
+ *
+ *  This method is used for marking the map of a tile as
+ *  drawn, and for going back to the framebuffer and the
+ *  viewport of the frame.
+ ***********************************************************/
+void ShadowAtlas::EndTile(int tile)
+{
+	glDisable(GL_POLYGON_OFFSET_FILL);
+	glBindFramebuffer(GL_FRAMEBUFFER, 0);
+	glViewport(m_frameViewport[0], m_frameViewport[1], m_frameViewport[2], m_frameViewport[3]);
+
+	m_tiles[tile].bValid = true;
+	m_bBlockDirty = true;
+	m_tileDrawCount++;
+}
+
+/***********************************************************
+ *  UploadShadowBlock()
+ *
+ *  This method is used for writing the tile matrices and
+ *  settings into the shadow block, only after a change.
+ *  A tile without a drawn map tells the shader to leave its
+ *  light unshadowed.
+ ***********************************************************/
+void ShadowAtlas::UploadShadowBlock()
+{
+	SHADOW_BLOCK shadows = {};
+
+	if ((false == m_bBlockDirty) || (0 == m_shadowBuffer))
+	{
+		return;
+	}
+
+	for (int tile = 0; tile < TILE_COUNT; tile++)
+	{
+		const TILE& light = m_tiles[tile];
+		bool bShadowed = (0 != m_framebuffer) && light.bActive && light.bValid;
+
+		shadows.matrices[tile] = BuildTileMatrix(tile) * light.viewProjection;
+		shadows.rects[tile] = glm::vec4(
+			(float)tile / (float)TILE_COUNT, 0.0f,
+			(float)(tile + 1) / (float)TILE_COUNT, 1.0f);
+		shadows.params[tile] = glm::vec4(bShadowed ? 1.0f : 0.0f, light.texelSize, light.depthBias, 0.0f);
+	}
+	shadows.texelSize = glm::vec4(
+		1.0f / (float)(TILE_SIZE * TILE_COUNT),
+		1.0f / (float)TILE_SIZE,
+		0.0f, 0.0f);
+
+	glBindBuffer(GL_UNIFORM_BUFFER, m_shadowBuffer);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(SHADOW_BLOCK), &shadows);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	m_bBlockDirty = false;
+}
+
+/***********************************************************
+ *  BuildTileMatrix()
+ *
+ *  This method is used for building the matrix that moves
+ *  the light clip space of a tile, from -1 to 1 on each
+ *  axis, onto the texture coordinates of the tile and the
+ *  stored depth range from 0 to 1.
+ ***********************************************************/
+glm::mat4 ShadowAtlas::BuildTileMatrix(int tile)
+{
+	float tileWidth = 1.0f / (float)TILE_COUNT;
+
+	return(glm::translate(glm::vec3(((float)tile + 0.5f) * tileWidth, 0.5f, 0.5f)) *
+		glm::scale(glm::vec3(0.5f * tileWidth, 0.5f, 0.5f)));
+}
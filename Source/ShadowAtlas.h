@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+// shadowatlas.h
+// ============
+// cached depth maps of the shadow casting lights, packed into one texture
+//
+//  Each light that casts shadows owns a tile of the atlas.  A tile is only
+//  drawn again when the matrix of its light changes or a shadow caster has
+//  moved, so a still scene is shadowed by the texture lookups alone.
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+/***********************************************************
+ *  ShadowAtlas
+ *
+ *  This class contains the code for the depth texture of the
+ *  shadow maps, the framebuffer the tiles are drawn through,
+ *  and the ShadowBlock uniform buffer that tells the shader
+ *  where each light finds its tile.  The texture compares
+ *  the depth on lookup, so each filtered tap of the shader
+ *  already blends four texels.
+ ***********************************************************/
+class ShadowAtlas
+{
+public:
+	// constructor
+	ShadowAtlas();
+	// destructor
+	~ShadowAtlas();
+
+	// tiles of the atlas, one for each light that casts shadows
+	enum SHADOW_TILE
+	{
+		TILE_DIRECTIONAL = 0,
+		TILE_FLASHLIGHT,
+		TILE_COUNT
+	};
+	// size of each square tile in texels, the tiles are placed side
+	// by side in the atlas
+	static const int TILE_SIZE = 2048;
+
+	// create the depth texture, its framebuffer and the shadow block,
+	// false when the framebuffer cannot be drawn to
+	bool Initialize();
+	// check if the shadow maps can be drawn
+	bool IsReady() const { return 0 != m_framebuffer; }
+	// get the texture unit the atlas stays bound to
+	GLint GetTextureUnit() const { return m_textureUnit; }
+
+	// set the view projection matrix of the light of a tile, the size
+	// of a texel one unit away from the light and the depth bias - the
+	// map is drawn again when the matrix differs from the last one
+	void SetTileLight(int tile, const glm::mat4& viewProjection, float texelSize, float depthBias, bool bActive);
+	// mark every map as out of date, after a shadow caster has moved
+	void Invalidate();
+	// check if an active tile needs its map drawn again
+	bool IsTileDirty(int tile) const { return m_tiles[tile].bActive && (false == m_tiles[tile].bValid); }
+	// get the view projection matrix the map of a tile is drawn with
+	const glm::mat4& GetTileMatrix(int tile) const { return m_tiles[tile].viewProjection; }
+	// get the number of tile maps drawn since the start
+	int GetTileDrawCount() const { return m_tileDrawCount; }
+
+	// bind the framebuffer and clear the depth of a tile, and restore
+	// the framebuffer and viewport of the frame after its casters
+	void BeginTile(int tile);
+	void EndTile(int tile);
+	// write the shadow block after a tile was changed
+	void UploadShadowBlock();
+
+private:
+	// one tile with the light matrix its map was drawn with
+	struct TILE
+	{
+		glm::mat4 viewProjection;
+		float texelSize;
+		float depthBias;
+		bool bActive;		// the light of the tile is on
+		bool bValid;		// the map matches the matrix and casters
+	};
+
+	// std140 layout of the shader ShadowBlock
+	struct SHADOW_BLOCK
+	{
+		// world space to the atlas coordinates and depth of each tile
+		glm::mat4 matrices[TILE_COUNT];
+		// lower corner of each tile in xy and the upper corner in zw
+		glm::vec4 rects[TILE_COUNT];
+		// 1 in x when the tile holds a map, the texel size one unit
+		// away from the light in y and the depth bias in z
+		glm::vec4 params[TILE_COUNT];
+		// size of one atlas texel in xy
+		glm::vec4 texelSize;
+	};
+
+	GLuint m_texture;
+	GLuint m_framebuffer;
+	GLuint m_shadowBuffer;
+	GLint m_textureUnit;
+	TILE m_tiles[TILE_COUNT];
+	// set when the shadow block differs from the tiles
+	bool m_bBlockDirty;
+	int m_tileDrawCount;
+	// viewport of the frame, restored after a tile was drawn
+	GLint m_frameViewport[4];
+
+	// get the matrix from the light clip space of a tile to the atlas
+	static glm::mat4 BuildTileMatrix(int tile);
+	// delete the OpenGL objects
+	void Release();
+};
@@ -0,0 +1,291 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.cpp
+// ============
+// pack the scene textures into layers of 2D texture arrays
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureArrays.h"
+#include "GpuResources.h"
+
+#include <algorithm>
+#include <iostream>
+
+/***********************************************************
+ *  TextureArrays()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+TextureArrays::TextureArrays()
+{
+	m_maxLayers = 0;
+	m_placeholderTexture = 0;
+
+	glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &m_maxLayers);
+	if (m_maxLayers <= 0)
+	{
+		// the smallest limit the OpenGL 3.3 specification allows
+		m_maxLayers = 256;
+	}
+
+	CreatePlaceholder();
+}
+
+/***********************************************************
+ *  ~TextureArrays()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureArrays::~TextureArrays()
+{
+	ReleasePages();
+
+	if (0 != m_placeholderTexture)
+	{
+		GpuResources::Remove(GpuResources::RESOURCE_TEXTURE, m_placeholderTexture);
+		glDeleteTextures(1, &m_placeholderTexture);
+		m_placeholderTexture = 0;
+	}
+}
+
+/***********************************************************
+ *  CreatePlaceholder()
+ *
+ *  This method is used for creating the small grey texture
+ *  that is drawn while the real texture is loading.
+ ***********************************************************/
+void TextureArrays::CreatePlaceholder()
+{
+	const unsigned char pixels[2 * 2 * 3] =
+	{
+		160, 160, 160,   128, 128, 128,
+		128, 128, 128,   160, 160, 160
+	};
+
+	glGenTextures(1, &m_placeholderTexture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_placeholderTexture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, 0);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_RGB8, 2, 2, 1, 0, GL_RGB, GL_UNSIGNED_BYTE, pixels);
+	GpuResources::Add(GpuResources::RESOURCE_TEXTURE, m_placeholderTexture, "TextureArrays",
+		2 * 2 * GpuResources::GetTexelSize(GL_RGB8));
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+/***********************************************************
+ *  AddTexture()
+ *
+ *  This method is used for reserving a layer for a texture.
+ *  A page with the same size and format that has no storage
+ *  yet is reused, otherwise a new page is started.
+ ***********************************************************/
+TextureArrays::TEXTURE_LOCATION TextureArrays::AddTexture(int width, int height, GLenum internalFormat)
+{
+	TEXTURE_LOCATION location;
+
+	for (int i = 0; i < (int)m_pages.size(); i++)
+	{
+		TEXTURE_PAGE& page = m_pages[i];
+
+		if ((false == page.bAllocated) &&
+			(page.width == width) &&
+			(page.height == height) &&
+			(page.internalFormat == internalFormat) &&
+			(page.layerCount < m_maxLayers))
+		{
+			location.page = i;
+			location.layer = page.layerCount;
+			page.layerCount++;
+			return(location);
+		}
+	}
+
+	TEXTURE_PAGE page;
+	page.textureID = 0;
+	page.width = width;
+	page.height = height;
+	page.internalFormat = internalFormat;
+	page.levels = 1;
+	while ((width > 1) || (height > 1))
+	{
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+		page.levels++;
+	}
+	page.layerCount = 1;
+	page.bAllocated = false;
+	m_pages.push_back(page);
+
+	location.page = (int)m_pages.size() - 1;
+	location.layer = 0;
+
+	return(location);
+}
+
+/***********************************************************
+ *  AllocatePages()
+ *
+ *  This method is used for allocating the storage of every
+ *  mipmap level of the pages that do not have it yet.
+ ***********************************************************/
+void TextureArrays::AllocatePages()
+{
+	for (TEXTURE_PAGE& page : m_pages)
+	{
+		if (page.bAllocated)
+		{
+			continue;
+		}
+
+		bool bCompressed = (page.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ||
+			(page.internalFormat == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT);
+		GLsizei blockBytes = (page.internalFormat == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ? 8 : 16;
+		GLenum format = (page.internalFormat == GL_RGBA8) ? GL_RGBA : GL_RGB;
+		size_t pageBytes = 0;
+
+		glGenTextures(1, &page.textureID);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, page.textureID);
+
+		int width = page.width;
+		int height = page.height;
+		for (int level = 0; level < page.levels; level++)
+		{
+			if (bCompressed)
+			{
+				GLsizei size = ((width + 3) / 4) * ((height + 3) / 4) * blockBytes * page.layerCount;
+				glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, page.internalFormat,
+					width, height, page.layerCount, 0, size, NULL);
+				pageBytes += (size_t)size;
+			}
+			else
+			{
+				glTexImage3D(GL_TEXTURE_2D_ARRAY, level, page.internalFormat,
+					width, height, page.layerCount, 0, format, GL_UNSIGNED_BYTE, NULL);
+				pageBytes += (size_t)width * height * page.layerCount * GpuResources::GetTexelSize(page.internalFormat);
+			}
+			width = std::max(1, width / 2);
+			height = std::max(1, height / 2);
+		}
+
+		// set the texture wrapping parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+		// set texture filtering parameters
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, page.levels - 1);
+		glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+		GpuResources::Add(GpuResources::RESOURCE_TEXTURE, page.textureID, "TextureArrays", pageBytes);
+		page.bAllocated = true;
+		std::cout << "INFO: Texture page " << page.width << "x" << page.height
+			<< " with " << page.layerCount << " layers" << std::endl;
+	}
+}
+
+/***********************************************************
+ *  ReleasePages()
+ *
+ *  This method is used for deleting the texture array of
+ *  every page.  The layers that were handed out are no
+ *  longer valid after this, textures have to be added and
+ *  the pages allocated again.
+ ***********************************************************/
+void TextureArrays::ReleasePages()
+{
+	for (TEXTURE_PAGE& page : m_pages)
+	{
+		if (0 != page.textureID)
+		{
+			GpuResources::Remove(GpuResources::RESOURCE_TEXTURE, page.textureID);
+			glDeleteTextures(1, &page.textureID);
+			page.textureID = 0;
+		}
+	}
+	m_pages.clear();
+}
+
+/***********************************************************
+ *  BindPages()
+ *
+ *  This method is used for binding the placeholder and each
+ *  page to its own texture unit.  The units stay bound, so
+ *  drawing only has to select the unit and the layer.
+ ***********************************************************/
+void TextureArrays::BindPages() const
+{
+	GLint maxUnits = 0;
+
+	glGetIntegerv(GL_MAX_TEXTURE_IMAGE_UNITS, &maxUnits);
+
+	glActiveTexture(GL_TEXTURE0 + PLACEHOLDER_UNIT);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, m_placeholderTexture);
+	for (int i = 0; i < (int)m_pages.size(); i++)
+	{
+		if ((GLint)GetPageUnit(i) >= maxUnits)
+		{
+			std::cout << "No texture unit available for texture page " << i << std::endl;
+			break;
+		}
+		glActiveTexture(GL_TEXTURE0 + GetPageUnit(i));
+		glBindTexture(GL_TEXTURE_2D_ARRAY, m_pages[i].textureID);
+	}
+}
+
+/***********************************************************
+ *  GetPageTexture()
+ *
+ *  This method is used for getting the texture array of a
+ *  page, which the texture loader writes the layers into.
+ ***********************************************************/
+GLuint TextureArrays::GetPageTexture(int page) const
+{
+	if ((page < 0) || (page >= (int)m_pages.size()))
+	{
+		return(0);
+	}
+
+	return(m_pages[page].textureID);
+}
+
+/***********************************************************
+ *  FitsPage()
+ *
+ *  This method is used for checking if an image can be
+ *  written into a layer of a page, for when a texture is
+ *  loaded again into the layer it already has.
+ ***********************************************************/
+bool TextureArrays::FitsPage(int page, int width, int height, GLenum internalFormat) const
+{
+	if ((page < 0) || (page >= (int)m_pages.size()))
+	{
+		return(false);
+	}
+
+	const TEXTURE_PAGE& texturePage = m_pages[page];
+
+	return((texturePage.width == width) &&
+		(texturePage.height == height) &&
+		(texturePage.internalFormat == internalFormat));
+}
+
+/***********************************************************
+ *  GetPlaceholder()
+ *
+ *  This method is used for getting the location of the grey
+ *  texture that is drawn while the real texture is loading.
+ *  The placeholder uses page -1, on its own texture unit.
+ ***********************************************************/
+TextureArrays::TEXTURE_LOCATION TextureArrays::GetPlaceholder() const
+{
+	TEXTURE_LOCATION location;
+
+	location.page = -1;
+	location.layer = 0;
+
+	return(location);
+}
@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturearrays.h
+// ============
+// pack the scene textures into layers of 2D texture arrays
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <vector>
+
+/***********************************************************
+ *  TextureArrays
+ *
+ *  This class contains the code for packing the textures of
+ *  the same size and format into the layers of one texture
+ *  array, called a page.  Each page uses one texture unit,
+ *  so the number of textures is limited by the number of
+ *  layers of a page instead of by the texture units.
+ ***********************************************************/
+class TextureArrays
+{
+public:
+	// constructor
+	TextureArrays();
+	// destructor
+	~TextureArrays();
+
+	// texture unit of the placeholder, the pages follow it
+	static const GLuint PLACEHOLDER_UNIT = 0;
+
+	// page and layer that a texture is stored in
+	struct TEXTURE_LOCATION
+	{
+		int page;
+		int layer;
+	};
+
+	// reserve a layer for a texture of the passed in size and
+	// format, the layer can be written once the page is allocated
+	TEXTURE_LOCATION AddTexture(int width, int height, GLenum internalFormat);
+	// allocate the storage of the pages that were added to
+	void AllocatePages();
+	// delete every page, the placeholder is kept for the draws
+	void ReleasePages();
+
+	// bind the placeholder and all the pages to their units
+	void BindPages() const;
+
+	// get the texture array and the texture unit of a page
+	GLuint GetPageTexture(int page) const;
+	GLuint GetPageUnit(int page) const { return PLACEHOLDER_UNIT + 1 + (GLuint)page; }
+	// get the number of pages
+	int GetPageCount() const { return (int)m_pages.size(); }
+	// check if an image of the passed in size and format can be
+	// written into the layers of a page
+	bool FitsPage(int page, int width, int height, GLenum internalFormat) const;
+
+	// get the location of the grey texture shown while loading
+	TEXTURE_LOCATION GetPlaceholder() const;
+
+private:
+	// one texture array holding textures of the same size and format
+	struct TEXTURE_PAGE
+	{
+		GLuint textureID;
+		int width;
+		int height;
+		GLenum internalFormat;
+		int levels;
+		int layerCount;
+		// a page gets no more layers once it has its storage
+		bool bAllocated;
+	};
+	std::vector<TEXTURE_PAGE> m_pages;
+
+	// most layers a texture array can have
+	GLint m_maxLayers;
+	// single layer array holding the placeholder texture
+	GLuint m_placeholderTexture;
+
+	// create the placeholder texture array
+	void CreatePlaceholder();
+};
@@ -0,0 +1,527 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturebaker.cpp
+// ============
+// bake textures into block compressed DDS files with precomputed mipmaps
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureBaker.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// DDS file layout values
+	const uint32_t DDS_MAGIC = 0x20534444;		// "DDS "
+	const uint32_t DDS_HEADER_SIZE = 124;
+	const uint32_t DDS_PIXELFORMAT_SIZE = 32;
+	const uint32_t DDSD_CAPS = 0x1;
+	const uint32_t DDSD_HEIGHT = 0x2;
+	const uint32_t DDSD_WIDTH = 0x4;
+	const uint32_t DDSD_PIXELFORMAT = 0x1000;
+	const uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	const uint32_t DDSD_LINEARSIZE = 0x80000;
+	const uint32_t DDPF_FOURCC = 0x4;
+	const uint32_t DDSCAPS_COMPLEX = 0x8;
+	const uint32_t DDSCAPS_TEXTURE = 0x1000;
+	const uint32_t DDSCAPS_MIPMAP = 0x400000;
+	const uint32_t FOURCC_DXT1 = 0x31545844;	// "DXT1"
+	const uint32_t FOURCC_DXT5 = 0x35545844;	// "DXT5"
+	// marks the files baked by this class in the reserved header words
+	const uint32_t BAKED_MARKER = 0x454b4142;	// "BAKE"
+
+	// number of 32 bit words in the DDS header, after the magic
+	const int DDS_HEADER_WORDS = DDS_HEADER_SIZE / 4;
+	// word positions of the header fields
+	const int HEADER_SIZE = 0;
+	const int HEADER_FLAGS = 1;
+	const int HEADER_HEIGHT = 2;
+	const int HEADER_WIDTH = 3;
+	const int HEADER_LINEAR_SIZE = 4;
+	const int HEADER_MIPMAP_COUNT = 6;
+	const int HEADER_RESERVED = 7;
+	const int HEADER_PF_SIZE = 18;
+	const int HEADER_PF_FLAGS = 19;
+	const int HEADER_PF_FOURCC = 20;
+	const int HEADER_CAPS = 26;
+
+	// bytes per 4x4 block of the compressed formats
+	size_t BlockBytes(GLenum format)
+	{
+		return((format == GL_COMPRESSED_RGB_S3TC_DXT1_EXT) ? 8 : 16);
+	}
+
+	// pack an 8 bit per channel color into 5:6:5 bits
+	uint16_t PackColor565(const unsigned char* color)
+	{
+		return((uint16_t)(((color[0] >> 3) << 11) | ((color[1] >> 2) << 5) | (color[2] >> 3)));
+	}
+
+	// expand a 5:6:5 color back to 8 bits per channel
+	void UnpackColor565(uint16_t packed, int* color)
+	{
+		int r = (packed >> 11) & 0x1F;
+		int g = (packed >> 5) & 0x3F;
+		int b = packed & 0x1F;
+
+		color[0] = (r << 3) | (r >> 2);
+		color[1] = (g << 2) | (g >> 4);
+		color[2] = (b << 3) | (b >> 2);
+	}
+}
+
+/***********************************************************
+ *  GetBakedFilename()
+ *
+ *  This method is used for getting the name of the baked
+ *  DDS file, which sits next to the source image file.
+ ***********************************************************/
+std::string TextureBaker::GetBakedFilename(const std::string& filename)
+{
+	size_t dot = filename.find_last_of('.');
+	size_t slash = filename.find_last_of("/\\");
+
+	if ((dot == std::string::npos) || ((slash != std::string::npos) && (dot < slash)))
+	{
+		return(filename + ".dds");
+	}
+
+	return(filename.substr(0, dot) + ".dds");
+}
+
+/***********************************************************
+ *  GetFileSize()
+ *
+ *  This method is used for getting the size of a file, which
+ *  is stored in the baked file to detect a changed source.
+ ***********************************************************/
+unsigned int TextureBaker::GetFileSize(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary | std::ios::ate);
+
+	if (!file.is_open())
+	{
+		return(0);
+	}
+
+	std::streamoff size = file.tellg();
+
+	return((size > 0) ? (unsigned int)size : 0);
+}
+
+/***********************************************************
+ *  HashFile()
+ *
+ *  This method is used for hashing the contents of a file
+ *  with 32 bit FNV-1a.  The hash is stored in the baked file
+ *  next to the size, so a source that is edited without
+ *  changing its size is still baked again.
+ ***********************************************************/
+unsigned int TextureBaker::HashFile(const std::string& filename)
+{
+	std::ifstream file(filename, std::ios::binary);
+	char buffer[4096];
+	uint32_t hash = 2166136261u;
+
+	if (!file.is_open())
+	{
+		return(0);
+	}
+
+	while (file.read(buffer, sizeof(buffer)) || (file.gcount() > 0))
+	{
+		std::streamsize count = file.gcount();
+		for (std::streamsize i = 0; i < count; i++)
+		{
+			hash ^= (unsigned char)buffer[i];
+			hash *= 16777619u;
+		}
+	}
+
+	return(hash);
+}
+
+/***********************************************************
+ *  CompressColorBlock()
+ *
+ *  This method is used for compressing the colors of a 4x4
+ *  RGBA block into a BC1 block.  The end points are taken
+ *  from the bounding box of the colors, slightly inset.
+ ***********************************************************/
+void TextureBaker::CompressColorBlock(const unsigned char block[64], unsigned char output[8])
+{
+	unsigned char minColor[3] = { 255, 255, 255 };
+	unsigned char maxColor[3] = { 0, 0, 0 };
+
+	for (int i = 0; i < 16; i++)
+	{
+		for (int c = 0; c < 3; c++)
+		{
+			minColor[c] = std::min(minColor[c], block[i * 4 + c]);
+			maxColor[c] = std::max(maxColor[c], block[i * 4 + c]);
+		}
+	}
+	for (int c = 0; c < 3; c++)
+	{
+		int inset = (maxColor[c] - minColor[c]) >> 4;
+		minColor[c] = (unsigned char)std::min(255, minColor[c] + inset);
+		maxColor[c] = (unsigned char)std::max(0, maxColor[c] - inset);
+	}
+
+	uint16_t color0 = PackColor565(maxColor);
+	uint16_t color1 = PackColor565(minColor);
+
+	// the first end point has to be the larger one for the four
+	// color mode of the block
+	if (color0 < color1)
+	{
+		std::swap(color0, color1);
+	}
+
+	int palette[4][3];
+	UnpackColor565(color0, palette[0]);
+	UnpackColor565(color1, palette[1]);
+	for (int c = 0; c < 3; c++)
+	{
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+
+	uint32_t indices = 0;
+	if (color0 != color1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = INT32_MAX;
+
+			for (int p = 0; p < 4; p++)
+			{
+				int distance = 0;
+				for (int c = 0; c < 3; c++)
+				{
+					int delta = block[i * 4 + c] - palette[p][c];
+					distance += delta * delta;
+				}
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+			indices |= (uint32_t)bestIndex << (i * 2);
+		}
+	}
+
+	output[0] = (unsigned char)(color0 & 0xFF);
+	output[1] = (unsigned char)(color0 >> 8);
+	output[2] = (unsigned char)(color1 & 0xFF);
+	output[3] = (unsigned char)(color1 >> 8);
+	for (int b = 0; b < 4; b++)
+	{
+		output[4 + b] = (unsigned char)((indices >> (b * 8)) & 0xFF);
+	}
+}
+
+/***********************************************************
+ *  CompressAlphaBlock()
+ *
+ *  This method is used for compressing the alpha values of
+ *  a 4x4 RGBA block into the alpha half of a BC3 block.
+ ***********************************************************/
+void TextureBaker::CompressAlphaBlock(const unsigned char block[64], unsigned char output[8])
+{
+	int alpha0 = 0;
+	int alpha1 = 255;
+
+	for (int i = 0; i < 16; i++)
+	{
+		alpha0 = std::max(alpha0, (int)block[i * 4 + 3]);
+		alpha1 = std::min(alpha1, (int)block[i * 4 + 3]);
+	}
+
+	// the eight value mode is used, which needs alpha0 > alpha1
+	int palette[8];
+	palette[0] = alpha0;
+	palette[1] = alpha1;
+	for (int p = 1; p <= 6; p++)
+	{
+		palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+	}
+
+	uint64_t indices = 0;
+	if (alpha0 != alpha1)
+	{
+		for (int i = 0; i < 16; i++)
+		{
+			int bestIndex = 0;
+			int bestDistance = INT32_MAX;
+
+			for (int p = 0; p < 8; p++)
+			{
+				int distance = std::abs(block[i * 4 + 3] - palette[p]);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestIndex = p;
+				}
+			}
+			indices |= (uint64_t)bestIndex << (i * 3);
+		}
+	}
+
+	output[0] = (unsigned char)alpha0;
+	output[1] = (unsigned char)alpha1;
+	for (int b = 0; b < 6; b++)
+	{
+		output[2 + b] = (unsigned char)((indices >> (b * 8)) & 0xFF);
+	}
+}
+
+/***********************************************************
+ *  DownsampleImage()
+ *
+ *  This method is used for building the next mipmap level
+ *  of an RGBA image by averaging each 2x2 group of pixels.
+ ***********************************************************/
+void TextureBaker::DownsampleImage(
+	const std::vector<unsigned char>& source,
+	int width,
+	int height,
+	std::vector<unsigned char>& result)
+{
+	int newWidth = std::max(1, width / 2);
+	int newHeight = std::max(1, height / 2);
+
+	result.resize((size_t)newWidth * newHeight * 4);
+	for (int y = 0; y < newHeight; y++)
+	{
+		int y0 = std::min(y * 2, height - 1);
+		int y1 = std::min(y * 2 + 1, height - 1);
+
+		for (int x = 0; x < newWidth; x++)
+		{
+			int x0 = std::min(x * 2, width - 1);
+			int x1 = std::min(x * 2 + 1, width - 1);
+
+			for (int c = 0; c < 4; c++)
+			{
+				int sum = source[((size_t)y0 * width + x0) * 4 + c] +
+					source[((size_t)y0 * width + x1) * 4 + c] +
+					source[((size_t)y1 * width + x0) * 4 + c] +
+					source[((size_t)y1 * width + x1) * 4 + c];
+				result[((size_t)y * newWidth + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+/***********************************************************
+ *  Bake()
+ *
+ *  This method is used for compressing a decoded image and
+ *  all of its mipmap levels, down to 1x1, into one block of
+ *  compressed data.
+ ***********************************************************/
+bool TextureBaker::Bake(
+	const unsigned char* pixels,
+	int width,
+	int height,
+	int colorChannels,
+	COMPRESSED_IMAGE& image)
+{
+	std::vector<unsigned char> level;
+	std::vector<unsigned char> nextLevel;
+
+	if ((NULL == pixels) || (width <= 0) || (height <= 0) ||
+		((colorChannels != 3) && (colorChannels != 4)))
+	{
+		return(false);
+	}
+
+	image.format = (colorChannels == 4) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	image.levels.clear();
+	image.data.clear();
+
+	// the levels are built from RGBA pixels
+	level.resize((size_t)width * height * 4);
+	for (size_t i = 0; i < (size_t)width * height; i++)
+	{
+		level[i * 4 + 0] = pixels[i * colorChannels + 0];
+		level[i * 4 + 1] = pixels[i * colorChannels + 1];
+		level[i * 4 + 2] = pixels[i * colorChannels + 2];
+		level[i * 4 + 3] = (colorChannels == 4) ? pixels[i * colorChannels + 3] : 255;
+	}
+
+	size_t blockBytes = BlockBytes(image.format);
+	while (true)
+	{
+		int blocksX = (width + 3) / 4;
+		int blocksY = (height + 3) / 4;
+		MIP_LEVEL mip;
+
+		mip.width = width;
+		mip.height = height;
+		mip.offset = image.data.size();
+		mip.size = (size_t)blocksX * blocksY * blockBytes;
+		image.data.resize(mip.offset + mip.size);
+
+		unsigned char* output = &image.data[mip.offset];
+		for (int by = 0; by < blocksY; by++)
+		{
+			for (int bx = 0; bx < blocksX; bx++)
+			{
+				unsigned char block[64];
+
+				// the edge blocks repeat the last row and column
+				for (int y = 0; y < 4; y++)
+				{
+					int py = std::min(by * 4 + y, height - 1);
+					for (int x = 0; x < 4; x++)
+					{
+						int px = std::min(bx * 4 + x, width - 1);
+						std::memcpy(&block[(y * 4 + x) * 4], &level[((size_t)py * width + px) * 4], 4);
+					}
+				}
+
+				if (image.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+				{
+					CompressAlphaBlock(block, output);
+					output += 8;
+				}
+				CompressColorBlock(block, output);
+				output += 8;
+			}
+		}
+		image.levels.push_back(mip);
+
+		if ((width == 1) && (height == 1))
+		{
+			break;
+		}
+		DownsampleImage(level, width, height, nextLevel);
+		level.swap(nextLevel);
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	return(true);
+}
+
+/***********************************************************
+ *  WriteDDS()
+ *
+ *  This method is used for saving a compressed texture into
+ *  a DDS file.  The size of the source image is kept in the
+ *  reserved header words.
+ ***********************************************************/
+bool TextureBaker::WriteDDS(const std::string& filename, const COMPRESSED_IMAGE& image)
+{
+	uint32_t header[DDS_HEADER_WORDS] = {};
+	uint32_t magic = DDS_MAGIC;
+
+	if (image.levels.empty())
+	{
+		return(false);
+	}
+
+	header[HEADER_SIZE] = DDS_HEADER_SIZE;
+	header[HEADER_FLAGS] = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT | DDSD_LINEARSIZE;
+	header[HEADER_HEIGHT] = (uint32_t)image.levels[0].height;
+	header[HEADER_WIDTH] = (uint32_t)image.levels[0].width;
+	header[HEADER_LINEAR_SIZE] = (uint32_t)image.levels[0].size;
+	header[HEADER_MIPMAP_COUNT] = (uint32_t)image.levels.size();
+	header[HEADER_RESERVED] = BAKED_MARKER;
+	header[HEADER_RESERVED + 1] = image.sourceSize;
+	header[HEADER_RESERVED + 2] = image.sourceHash;
+	header[HEADER_PF_SIZE] = DDS_PIXELFORMAT_SIZE;
+	header[HEADER_PF_FLAGS] = DDPF_FOURCC;
+	header[HEADER_PF_FOURCC] = (image.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? FOURCC_DXT5 : FOURCC_DXT1;
+	header[HEADER_CAPS] = DDSCAPS_TEXTURE | DDSCAPS_MIPMAP | DDSCAPS_COMPLEX;
+
+	std::ofstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	file.write((const char*)&magic, sizeof(magic));
+	file.write((const char*)header, sizeof(header));
+	file.write((const char*)image.data.data(), (std::streamsize)image.data.size());
+	file.close();
+	bool bWritten = !file.fail();
+
+	// a partly written file would be read as a broken texture
+	if (!bWritten)
+	{
+		remove(filename.c_str());
+	}
+
+	return(bWritten);
+}
+
+/***********************************************************
+ *  ReadDDS()
+ *
+ *  This method is used for loading a compressed texture from
+ *  a DDS file that was written by WriteDDS().  The data is
+ *  read as it is, there is nothing to decode.
+ ***********************************************************/
+bool TextureBaker::ReadDDS(const std::string& filename, COMPRESSED_IMAGE& image)
+{
+	uint32_t header[DDS_HEADER_WORDS] = {};
+	uint32_t magic = 0;
+
+	std::ifstream file(filename, std::ios::binary);
+	if (!file.is_open())
+	{
+		return(false);
+	}
+
+	file.read((char*)&magic, sizeof(magic));
+	file.read((char*)header, sizeof(header));
+	if (file.fail() ||
+		(magic != DDS_MAGIC) ||
+		(header[HEADER_SIZE] != DDS_HEADER_SIZE) ||
+		(header[HEADER_RESERVED] != BAKED_MARKER) ||
+		((header[HEADER_PF_FOURCC] != FOURCC_DXT1) && (header[HEADER_PF_FOURCC] != FOURCC_DXT5)))
+	{
+		return(false);
+	}
+
+	image.format = (header[HEADER_PF_FOURCC] == FOURCC_DXT5) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	image.sourceSize = header[HEADER_RESERVED + 1];
+	image.sourceHash = header[HEADER_RESERVED + 2];
+	image.levels.clear();
+	image.data.clear();
+
+	// the level sizes follow from the size of the first level
+	int width = (int)header[HEADER_WIDTH];
+	int height = (int)header[HEADER_HEIGHT];
+	size_t dataSize = 0;
+	for (uint32_t i = 0; (i < header[HEADER_MIPMAP_COUNT]) && (width > 0) && (height > 0); i++)
+	{
+		MIP_LEVEL mip;
+
+		mip.width = width;
+		mip.height = height;
+		mip.offset = dataSize;
+		mip.size = (size_t)((width + 3) / 4) * ((height + 3) / 4) * BlockBytes(image.format);
+		dataSize += mip.size;
+		image.levels.push_back(mip);
+
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+
+	image.data.resize(dataSize);
+	file.read((char*)image.data.data(), (std::streamsize)dataSize);
+	bool bRead = (false == image.levels.empty()) && !file.fail();
+
+	return(bRead);
+}
@@ -0,0 +1,77 @@
+///////////////////////////////////////////////////////////////////////////////
+// texturebaker.h
+// ============
+// bake textures into block compressed DDS files with precomputed mipmaps
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  TextureBaker
+ *
+ *  This class contains the code for converting a decoded
+ *  image into a block compressed texture with all of its
+ *  mipmaps, and for saving and loading it as a DDS file.
+ *  RGB images are stored as BC1 (DXT1), and images with an
+ *  alpha channel as BC3 (DXT5).
+ ***********************************************************/
+class TextureBaker
+{
+public:
+	// one mipmap level inside the compressed data
+	struct MIP_LEVEL
+	{
+		int width;
+		int height;
+		size_t offset;
+		size_t size;
+	};
+
+	// a block compressed texture with its full mipmap chain
+	struct COMPRESSED_IMAGE
+	{
+		GLenum format;		// GL_COMPRESSED_*_S3TC_DXT*_EXT
+		std::vector<MIP_LEVEL> levels;
+		std::vector<unsigned char> data;
+		// size and content hash of the source image file the texture
+		// was baked from
+		unsigned int sourceSize;
+		unsigned int sourceHash;
+	};
+
+	// get the name of the baked file for a source image file
+	static std::string GetBakedFilename(const std::string& filename);
+	// get the size of a file, zero if it cannot be opened
+	static unsigned int GetFileSize(const std::string& filename);
+	// get the FNV-1a hash of the contents of a file, zero if it
+	// cannot be opened
+	static unsigned int HashFile(const std::string& filename);
+
+	// compress a decoded RGB or RGBA image and its mipmaps
+	static bool Bake(
+		const unsigned char* pixels,
+		int width,
+		int height,
+		int colorChannels,
+		COMPRESSED_IMAGE& image);
+
+	// save and load the compressed texture as a DDS file
+	static bool WriteDDS(const std::string& filename, const COMPRESSED_IMAGE& image);
+	static bool ReadDDS(const std::string& filename, COMPRESSED_IMAGE& image);
+
+private:
+	// compress one 4x4 block of RGBA pixels
+	static void CompressColorBlock(const unsigned char block[64], unsigned char output[8]);
+	static void CompressAlphaBlock(const unsigned char block[64], unsigned char output[8]);
+	// halve an RGBA image with a box filter
+	static void DownsampleImage(
+		const std::vector<unsigned char>& source,
+		int width,
+		int height,
+		std::vector<unsigned char>& result);
+};
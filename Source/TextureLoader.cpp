@@ -0,0 +1,473 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.cpp
+// ============
+// decode texture images on worker threads and stream them to OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#include "TextureLoader.h"
+#include "GpuResources.h"
+
+#include "stb_image.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+// declaration of the global variables and defines
+namespace
+{
+	// starting size of the pixel unpack buffer, it grows when
+	// a single image does not fit
+	const GLsizeiptr INITIAL_PIXEL_BUFFER_SIZE = 16 * 1024 * 1024;
+	// rows of the uploaded images start on this alignment
+	const GLsizeiptr PIXEL_BUFFER_ALIGNMENT = 4;
+}
+
+/***********************************************************
+ *  TextureLoader()
+ *
+ *  The constructor for the class.  The worker threads are
+ *  started here and wait for images to be queued.
+ ***********************************************************/
+TextureLoader::TextureLoader(int threadCount)
+{
+	m_bStopping = false;
+	m_pendingJobs = 0;
+	m_pixelBuffer = 0;
+	m_pixelBufferSize = 0;
+	m_pMappedPixels = NULL;
+	m_uploadFence = 0;
+	m_uploadUnit = 0;
+
+	glGetIntegerv(GL_MAX_COMBINED_TEXTURE_IMAGE_UNITS, &m_uploadUnit);
+	m_uploadUnit = std::max(0, m_uploadUnit - 1);
+
+	// the workers read this setting, so it is set before they start
+	m_bUseCompression = (GLEW_EXT_texture_compression_s3tc == GL_TRUE);
+
+	// the flip setting is shared by all the threads, so it is
+	// set once before any of them is started
+	stbi_set_flip_vertically_on_load(true);
+
+	if (threadCount <= 0)
+	{
+		// leave one hardware thread for the GL thread
+		threadCount = std::max(1, (int)std::thread::hardware_concurrency() - 1);
+	}
+	for (int i = 0; i < threadCount; i++)
+	{
+		m_workers.push_back(std::thread(&TextureLoader::WorkerThread, this));
+	}
+}
+
+/***********************************************************
+ *  ~TextureLoader()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+TextureLoader::~TextureLoader()
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_bStopping = true;
+	}
+	m_condition.notify_all();
+	for (std::thread& worker : m_workers)
+	{
+		worker.join();
+	}
+
+	// free the images that were decoded but never uploaded
+	for (TEXTURE_JOB& job : m_uploadQueue)
+	{
+		stbi_image_free(job.image);
+	}
+	m_uploadQueue.clear();
+
+	if (0 != m_uploadFence)
+	{
+		glDeleteSync(m_uploadFence);
+		m_uploadFence = 0;
+	}
+	if (0 != m_pixelBuffer)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_pixelBuffer);
+		glDeleteBuffers(1, &m_pixelBuffer);
+		m_pixelBuffer = 0;
+		m_pMappedPixels = NULL;
+	}
+}
+
+/***********************************************************
+ *  GetUploadFormat()
+ *
+ *  This method is used for getting the internal format that
+ *  an image with the passed in channels is uploaded with.
+ ***********************************************************/
+GLenum TextureLoader::GetUploadFormat(int colorChannels) const
+{
+	if (m_bUseCompression)
+	{
+		return((colorChannels == 4) ? GL_COMPRESSED_RGBA_S3TC_DXT5_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT);
+	}
+
+	return((colorChannels == 4) ? GL_RGBA8 : GL_RGB8);
+}
+
+/***********************************************************
+ *  QueueTexture()
+ *
+ *  This method is used for queuing an image file to be
+ *  decoded by the worker threads.
+ ***********************************************************/
+void TextureLoader::QueueTexture(
+	const std::string& filename,
+	GLuint arrayTexture,
+	int layer,
+	int textureHandle)
+{
+	TEXTURE_JOB job;
+
+	job.filename = filename;
+	job.arrayTexture = arrayTexture;
+	job.layer = layer;
+	job.textureHandle = textureHandle;
+	job.width = 0;
+	job.height = 0;
+	job.colorChannels = 0;
+	job.image = NULL;
+	job.bCompressed = false;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_decodeQueue.push_back(job);
+		m_pendingJobs++;
+	}
+	m_condition.notify_one();
+}
+
+/***********************************************************
+ *  IsIdle()
+ *
+ *  This method is used for checking if all of the queued
+ *  textures have been uploaded.
+ ***********************************************************/
+bool TextureLoader::IsIdle() const
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+
+	return(0 == m_pendingJobs);
+}
+
+/***********************************************************
+ *  WorkerThread()
+ *
+ *  This method is run by each worker thread.  It decodes
+ *  the queued images and passes them to the upload queue.
+ ***********************************************************/
+void TextureLoader::WorkerThread()
+{
+	while (true)
+	{
+		TEXTURE_JOB job;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex);
+			m_condition.wait(lock, [this]()
+				{
+					return(m_bStopping || (false == m_decodeQueue.empty()));
+				});
+			if (m_bStopping)
+			{
+				return;
+			}
+			job = std::move(m_decodeQueue.front());
+			m_decodeQueue.pop_front();
+		}
+
+		// the decode is the slow part and runs without the lock
+		LoadJob(job);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_uploadQueue.push_back(std::move(job));
+	}
+}
+
+/***********************************************************
+ *  LoadJob()
+ *
+ *  This method is used for loading the image of a job on a
+ *  worker thread.  An up to date baked file is read as it
+ *  is; otherwise the image is decoded, and baked for the
+ *  next run when block compression is supported.
+ ***********************************************************/
+void TextureLoader::LoadJob(TEXTURE_JOB& job)
+{
+	std::string bakedFilename = TextureBaker::GetBakedFilename(job.filename);
+	unsigned int sourceSize = TextureBaker::GetFileSize(job.filename);
+	unsigned int sourceHash = TextureBaker::HashFile(job.filename);
+
+	// the baked file is only used while its source is unchanged, the
+	// size alone misses an edit that keeps the size of the image
+	if (m_bUseCompression &&
+		TextureBaker::ReadDDS(bakedFilename, job.compressed) &&
+		(job.compressed.sourceSize == sourceSize) &&
+		(job.compressed.sourceHash == sourceHash))
+	{
+		job.width = job.compressed.levels[0].width;
+		job.height = job.compressed.levels[0].height;
+		job.colorChannels = (job.compressed.format == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT) ? 4 : 3;
+		job.bCompressed = true;
+		return;
+	}
+
+	job.image = stbi_load(
+		job.filename.c_str(),
+		&job.width,
+		&job.height,
+		&job.colorChannels,
+		0);
+
+	if (m_bUseCompression && (NULL != job.image) &&
+		TextureBaker::Bake(job.image, job.width, job.height, job.colorChannels, job.compressed))
+	{
+		job.compressed.sourceSize = sourceSize;
+		job.compressed.sourceHash = sourceHash;
+		if (TextureBaker::WriteDDS(bakedFilename, job.compressed))
+		{
+			std::cout << "INFO: Baked compressed texture:" << bakedFilename << std::endl;
+		}
+
+		// the baked data is uploaded instead of the decoded image
+		stbi_image_free(job.image);
+		job.image = NULL;
+		job.bCompressed = true;
+	}
+}
+
+/***********************************************************
+ *  GetUploadSize()
+ *
+ *  This method is used for getting the number of bytes that
+ *  a job copies into the pixel buffer.
+ ***********************************************************/
+GLsizeiptr TextureLoader::GetUploadSize(const TEXTURE_JOB& job)
+{
+	if (job.bCompressed)
+	{
+		return((GLsizeiptr)job.compressed.data.size());
+	}
+
+	return((GLsizeiptr)job.width * job.height * job.colorChannels);
+}
+
+/***********************************************************
+ *  ReservePixelBuffer()
+ *
+ *  This method is used for making sure that the persistent
+ *  mapped pixel buffer can hold the passed in size.  Without
+ *  buffer storage support no pixel buffer is used.
+ ***********************************************************/
+bool TextureLoader::ReservePixelBuffer(GLsizeiptr size)
+{
+	if (!GLEW_ARB_buffer_storage)
+	{
+		return(false);
+	}
+
+	if ((0 != m_pixelBuffer) && (size <= m_pixelBufferSize))
+	{
+		return(true);
+	}
+
+	// the uploads of the last frame are complete at this point,
+	// so the old buffer can be replaced with a larger one
+	if (0 != m_pixelBuffer)
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_pixelBuffer);
+		glDeleteBuffers(1, &m_pixelBuffer);
+		m_pixelBuffer = 0;
+	}
+
+	GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+	m_pixelBufferSize = std::max(size, INITIAL_PIXEL_BUFFER_SIZE);
+	glGenBuffers(1, &m_pixelBuffer);
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_pixelBuffer, "TextureLoader", (size_t)m_pixelBufferSize);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, m_pixelBufferSize, NULL, flags);
+	m_pMappedPixels = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, m_pixelBufferSize, flags);
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	return(NULL != m_pMappedPixels);
+}
+
+/***********************************************************
+ *  ProcessUploads()
+ *
+ *  This method is used for uploading the decoded images on
+ *  the GL thread.  The images of one frame are staged in the
+ *  pixel buffer, so before it is written again the uploads
+ *  of the last frame have to be complete.  The mipmaps of
+ *  the arrays that got uncompressed layers are generated
+ *  once, after all of the layers of the frame are written.
+ ***********************************************************/
+int TextureLoader::ProcessUploads(std::vector<int>& finishedHandles)
+{
+	std::vector<TEXTURE_JOB> jobs;
+	GLsizeiptr frameBytes = 0;
+	GLsizeiptr bufferOffset = 0;
+
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (m_uploadQueue.empty())
+		{
+			return(0);
+		}
+
+		// take as many images as fit into the pixel buffer, but
+		// always at least one so a large image still gets done
+		GLsizeiptr budget = std::max(m_pixelBufferSize, INITIAL_PIXEL_BUFFER_SIZE);
+		while (false == m_uploadQueue.empty())
+		{
+			GLsizeiptr imageBytes = GetUploadSize(m_uploadQueue.front());
+
+			if ((false == jobs.empty()) && (frameBytes + imageBytes > budget))
+			{
+				break;
+			}
+			frameBytes += ((imageBytes + PIXEL_BUFFER_ALIGNMENT - 1) / PIXEL_BUFFER_ALIGNMENT) * PIXEL_BUFFER_ALIGNMENT;
+			jobs.push_back(std::move(m_uploadQueue.front()));
+			m_uploadQueue.pop_front();
+		}
+	}
+
+	if (0 != m_uploadFence)
+	{
+		glClientWaitSync(m_uploadFence, GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+		glDeleteSync(m_uploadFence);
+		m_uploadFence = 0;
+	}
+	ReservePixelBuffer(frameBytes);
+	glActiveTexture(GL_TEXTURE0 + m_uploadUnit);
+
+	std::vector<GLuint> mipmapArrays;
+	for (const TEXTURE_JOB& job : jobs)
+	{
+		if (UploadTexture(job, bufferOffset))
+		{
+			finishedHandles.push_back(job.textureHandle);
+			if ((false == job.bCompressed) &&
+				(std::find(mipmapArrays.begin(), mipmapArrays.end(), job.arrayTexture) == mipmapArrays.end()))
+			{
+				mipmapArrays.push_back(job.arrayTexture);
+			}
+		}
+		stbi_image_free(job.image);
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	// generate the texture mipmaps for mapping textures to lower resolutions
+	for (GLuint arrayTexture : mipmapArrays)
+	{
+		glBindTexture(GL_TEXTURE_2D_ARRAY, arrayTexture);
+		glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+	}
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+	if ((0 != m_pixelBuffer) && (bufferOffset > 0))
+	{
+		m_uploadFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+
+	bool bFinished = false;
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_pendingJobs -= (int)jobs.size();
+		bFinished = (0 == m_pendingJobs);
+	}
+	if (bFinished)
+	{
+		std::cout << "INFO: All queued textures are uploaded" << std::endl;
+	}
+
+	return((int)jobs.size());
+}
+
+/***********************************************************
+ *  UploadTexture()
+ *
+ *  This method is used for copying one decoded image into
+ *  its texture array layer.  The image goes through the
+ *  pixel buffer when one is mapped.
+ ***********************************************************/
+bool TextureLoader::UploadTexture(const TEXTURE_JOB& job, GLsizeiptr& bufferOffset)
+{
+	GLenum format = GL_RGB;
+
+	if ((NULL == job.image) && (false == job.bCompressed))
+	{
+		std::cout << "Could not load image:" << job.filename << std::endl;
+		return(false);
+	}
+
+	std::cout << "Successfully loaded image:" << job.filename << ", width:" << job.width << ", height:" << job.height << ", channels:" << job.colorChannels << std::endl;
+
+	// if the loaded image is in RGBA format - it supports transparency
+	if (job.colorChannels == 4)
+	{
+		format = GL_RGBA;
+	}
+	else if (job.colorChannels != 3)
+	{
+		std::cout << "Not implemented to handle image with " << job.colorChannels << " channels" << std::endl;
+		return(false);
+	}
+
+	GLsizeiptr imageBytes = GetUploadSize(job);
+	const unsigned char* source = job.bCompressed ? job.compressed.data.data() : job.image;
+	const unsigned char* pixels = source;
+
+	// stage the image in the pixel buffer, the texture copy then
+	// reads from the buffer instead of from client memory
+	if ((NULL != m_pMappedPixels) && (bufferOffset + imageBytes <= m_pixelBufferSize))
+	{
+		std::memcpy(m_pMappedPixels + bufferOffset, source, imageBytes);
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBuffer);
+		pixels = (const unsigned char*)(uintptr_t)bufferOffset;
+		bufferOffset += ((imageBytes + PIXEL_BUFFER_ALIGNMENT - 1) / PIXEL_BUFFER_ALIGNMENT) * PIXEL_BUFFER_ALIGNMENT;
+	}
+	else
+	{
+		glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	}
+
+	glBindTexture(GL_TEXTURE_2D_ARRAY, job.arrayTexture);
+
+	if (job.bCompressed)
+	{
+		// every mipmap level was baked, nothing is generated here
+		for (size_t i = 0; i < job.compressed.levels.size(); i++)
+		{
+			const TextureBaker::MIP_LEVEL& mip = job.compressed.levels[i];
+
+			glCompressedTexSubImage3D(GL_TEXTURE_2D_ARRAY, (GLint)i, 0, 0, job.layer,
+				mip.width, mip.height, 1, job.compressed.format, (GLsizei)mip.size, pixels + mip.offset);
+		}
+	}
+	else
+	{
+		// RGB rows are not always a multiple of four bytes
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+		glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, job.layer,
+			job.width, job.height, 1, format, GL_UNSIGNED_BYTE, pixels);
+		glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	}
+
+	return(true);
+}
@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// textureloader.h
+// ============
+// decode texture images on worker threads and stream them to OpenGL
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include "TextureBaker.h"
+
+#include <GL/glew.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/***********************************************************
+ *  TextureLoader
+ *
+ *  This class contains the code for loading the texture
+ *  images in the background.  The images are decoded by a
+ *  pool of worker threads, then copied to OpenGL on the GL
+ *  thread through a persistent mapped pixel buffer, into a
+ *  layer of a texture array.  When block compression is
+ *  supported, each image is baked once into a compressed
+ *  DDS file with its mipmaps, which is loaded instead of
+ *  the image on the following runs.
+ ***********************************************************/
+class TextureLoader
+{
+public:
+	// constructor - zero worker threads uses the hardware count
+	TextureLoader(int threadCount = 0);
+	// destructor
+	~TextureLoader();
+
+	// get the internal format the images are uploaded with, the
+	// texture array layers have to be allocated with this format
+	GLenum GetUploadFormat(int colorChannels) const;
+
+	// queue an image to be decoded into a layer of the passed in
+	// texture array, the texture handle is reported once it is done
+	void QueueTexture(
+		const std::string& filename,
+		GLuint arrayTexture,
+		int layer,
+		int textureHandle);
+
+	// copy the decoded images into their layers, called once per
+	// frame on the GL thread - the finished handles are appended
+	int ProcessUploads(std::vector<int>& finishedHandles);
+
+	// check if every queued texture has been uploaded
+	bool IsIdle() const;
+
+private:
+	// an image to decode and the texture it is uploaded into
+	struct TEXTURE_JOB
+	{
+		std::string filename;
+		GLuint arrayTexture;
+		int layer;
+		int textureHandle;
+		int width;
+		int height;
+		int colorChannels;
+		unsigned char* image;
+		// set when the texture comes from the baked data
+		bool bCompressed;
+		TextureBaker::COMPRESSED_IMAGE compressed;
+	};
+
+	// worker threads and the jobs shared with them
+	std::vector<std::thread> m_workers;
+	std::deque<TEXTURE_JOB> m_decodeQueue;
+	std::deque<TEXTURE_JOB> m_uploadQueue;
+	mutable std::mutex m_mutex;
+	std::condition_variable m_condition;
+	bool m_bStopping;
+	// number of queued jobs that are not uploaded yet
+	int m_pendingJobs;
+	// set when the baked compressed textures can be used
+	bool m_bUseCompression;
+
+	// persistent mapped pixel unpack buffer for the uploads
+	GLuint m_pixelBuffer;
+	GLsizeiptr m_pixelBufferSize;
+	unsigned char* m_pMappedPixels;
+	// signaled when the uploads of the last frame are complete
+	GLsync m_uploadFence;
+	// spare texture unit used for binding the written arrays, so
+	// the units that the arrays are drawn from are not changed
+	GLint m_uploadUnit;
+
+	// decode the queued images until the loader is stopped
+	void WorkerThread();
+	// load the baked texture of a job, or decode and bake it
+	void LoadJob(TEXTURE_JOB& job);
+	// get the number of bytes a job stages in the pixel buffer
+	static GLsizeiptr GetUploadSize(const TEXTURE_JOB& job);
+	// make sure the pixel buffer can hold the passed in size
+	bool ReservePixelBuffer(GLsizeiptr size);
+	// copy a decoded image into its texture array layer, returns
+	// false if the image could not be uploaded
+	bool UploadTexture(const TEXTURE_JOB& job, GLsizeiptr& bufferOffset);
+};
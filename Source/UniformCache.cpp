@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.cpp
+// ============
+// cache the shader uniform locations so they are only queried once
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformCache.h"
+
+#include <algorithm>
+#include <iostream>
+
+// the name hashes are worked out by the compiler, with the reference
+// FNV-1a values
+static_assert(UniformID("").GetHash() == 0x811C9DC5u, "FNV-1a offset basis");
+static_assert(UniformID("a").GetHash() == 0xE40C292Cu, "FNV-1a hash of a name");
+
+/***********************************************************
+ *  UniformCache()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformCache::UniformCache()
+{
+	m_programID = 0;
+}
+
+/***********************************************************
+ *  LoadLocations()
+ *
+ *  This method is used for reading the locations of all the
+ *  active uniforms of the passed in program.  It should be
+ *  called once after the shaders have been loaded.
+ ***********************************************************/
+void UniformCache::LoadLocations(GLuint programID)
+{
+	GLint uniformCount = 0;
+	GLint maxNameLength = 0;
+
+	m_programID = programID;
+	m_locations.clear();
+
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORMS, &uniformCount);
+	glGetProgramiv(programID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxNameLength);
+
+	std::vector<GLchar> nameBuffer(maxNameLength + 1);
+	for (GLint i = 0; i < uniformCount; i++)
+	{
+		GLsizei nameLength = 0;
+		GLint arraySize = 0;
+		GLenum type = 0;
+
+		glGetActiveUniform(programID, (GLuint)i, (GLsizei)nameBuffer.size(),
+			&nameLength, &arraySize, &type, nameBuffer.data());
+
+		std::string name(nameBuffer.data(), nameLength);
+		GLint location = glGetUniformLocation(programID, name.c_str());
+
+		// uniforms that live inside a uniform block have no location
+		if (location < 0)
+		{
+			continue;
+		}
+
+		// arrays are reported as "name[0]", every element is cached
+		// so that "name[i]" can be found as well as "name"
+		size_t bracket = name.find("[0]");
+		if ((bracket != std::string::npos) && (bracket + 3 == name.size()))
+		{
+			std::string baseName = name.substr(0, bracket);
+			AddLocation(baseName, location);
+			for (GLint element = 1; element < arraySize; element++)
+			{
+				std::string elementName = baseName + "[" + std::to_string(element) + "]";
+				AddLocation(elementName, glGetUniformLocation(programID, elementName.c_str()));
+			}
+		}
+		AddLocation(name, location);
+	}
+
+	// the table is searched by hash, so two names of the program
+	// with the same hash could not be told apart
+	std::sort(m_locations.begin(), m_locations.end(), [](const LOCATION_ENTRY& a, const LOCATION_ENTRY& b)
+		{
+			return(a.hash < b.hash);
+		});
+	for (size_t i = 1; i < m_locations.size(); i++)
+	{
+		if (m_locations[i].hash == m_locations[i - 1].hash)
+		{
+			std::cout << "Uniform names with the same hash in program " << programID << std::endl;
+		}
+	}
+
+	std::cout << "INFO: Cached " << m_locations.size() << " uniform locations" << std::endl;
+}
+
+/***********************************************************
+ *  GetLocation()
+ *
+ *  This method is used for getting the cached location of
+ *  the uniform with the passed in ID or name.  The ID holds
+ *  the hash of a constant name, so only the table search is
+ *  left to be done here.
+ ***********************************************************/
+GLint UniformCache::GetLocation(const UniformID& id) const
+{
+	return(FindLocation(id.GetHash()));
+}
+
+GLint UniformCache::GetLocation(const std::string& name) const
+{
+	return(FindLocation(UniformID::HashName(name.c_str())));
+}
+
+/***********************************************************
+ *  AddLocation()
+ *
+ *  This method is used for adding the location of a uniform
+ *  name to the table.  The table is sorted once all of the
+ *  uniforms of the program are added.
+ ***********************************************************/
+void UniformCache::AddLocation(const std::string& name, GLint location)
+{
+	LOCATION_ENTRY entry;
+
+	entry.hash = UniformID::HashName(name.c_str());
+	entry.location = location;
+	m_locations.push_back(entry);
+}
+
+/***********************************************************
+ *  FindLocation()
+ *
+ *  This method is used for finding the location under a
+ *  name hash, by a binary search of the sorted table.
+ ***********************************************************/
+GLint UniformCache::FindLocation(uint32_t hash) const
+{
+	auto found = std::lower_bound(m_locations.begin(), m_locations.end(), hash,
+		[](const LOCATION_ENTRY& entry, uint32_t value)
+		{
+			return(entry.hash < value);
+		});
+
+	if ((found == m_locations.end()) || (found->hash != hash))
+	{
+		return(-1);
+	}
+
+	return(found->location);
+}
+
+/***********************************************************
+ *  BindUniformBlock()
+ *
+ *  This method is used for connecting the named uniform
+ *  block of the program to the passed in binding point.
+ ***********************************************************/
+bool UniformCache::BindUniformBlock(const char* blockName, GLuint binding) const
+{
+	GLuint blockIndex = glGetUniformBlockIndex(m_programID, blockName);
+
+	if (blockIndex == GL_INVALID_INDEX)
+	{
+		std::cout << "Uniform block not found in shader:" << blockName << std::endl;
+		return(false);
+	}
+
+	glUniformBlockBinding(m_programID, blockIndex, binding);
+
+	return(true);
+}
+
+/***********************************************************
+ *  SetInt() ... SetMat4()
+ *
+ *  These methods are used for setting a uniform value by
+ *  its cached location.  Inactive uniforms are skipped.
+ ***********************************************************/
+void UniformCache::SetInt(GLint location, int value) const
+{
+	if (location >= 0)
+	{
+		glUniform1i(location, value);
+	}
+}
+
+void UniformCache::SetFloat(GLint location, float value) const
+{
+	if (location >= 0)
+	{
+		glUniform1f(location, value);
+	}
+}
+
+void UniformCache::SetVec2(GLint location, const glm::vec2& value) const
+{
+	if (location >= 0)
+	{
+		glUniform2fv(location, 1, &value[0]);
+	}
+}
+
+void UniformCache::SetVec3(GLint location, const glm::vec3& value) const
+{
+	if (location >= 0)
+	{
+		glUniform3fv(location, 1, &value[0]);
+	}
+}
+
+void UniformCache::SetVec4(GLint location, const glm::vec4& value) const
+{
+	if (location >= 0)
+	{
+		glUniform4fv(location, 1, &value[0]);
+	}
+}
+
+void UniformCache::SetMat4(GLint location, const glm::mat4& value) const
+{
+	if (location >= 0)
+	{
+		glUniformMatrix4fv(location, 1, GL_FALSE, &value[0][0]);
+	}
+}
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformcache.h
+// ============
+// cache the shader uniform locations so they are only queried once
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/***********************************************************
+ *  UniformID
+ *
+ *  This class contains the FNV-1a hash of a uniform name,
+ *  worked out by the compiler when the name is a constant,
+ *  so that looking up the location of the uniform does no
+ *  work on the string at run time.
+ ***********************************************************/
+class UniformID
+{
+public:
+	// constructor - the name has to outlive the ID
+	constexpr UniformID(const char* name) : m_hash(HashName(name)), m_name(name) {}
+
+	// get the hash of the name
+	constexpr uint32_t GetHash() const { return m_hash; }
+	// get the name, for the messages about a missing uniform
+	constexpr const char* GetName() const { return m_name; }
+
+	// get the hash of a name, also usable on names made at run time
+	static constexpr uint32_t HashName(const char* name) { return Hash(name, 2166136261u); }
+
+private:
+	// hash a name one character at a time, written as a single
+	// return so it is a constant expression for C++11 compilers
+	static constexpr uint32_t Hash(const char* name, uint32_t hash)
+	{
+		return((*name == 0) ? hash : Hash(name + 1, (hash ^ (uint32_t)(unsigned char)*name) * 16777619u));
+	}
+
+	uint32_t m_hash;
+	const char* m_name;
+};
+
+/***********************************************************
+ *  UniformCache
+ *
+ *  This class contains the code for reading the locations
+ *  of all the active uniforms of a linked shader program
+ *  once, right after the shaders are loaded, and for setting
+ *  uniform values by their cached location.
+ ***********************************************************/
+class UniformCache
+{
+public:
+	// constructor
+	UniformCache();
+
+	// binding points of the uniform blocks in the shaders
+	enum UNIFORM_BLOCK_BINDING
+	{
+		MATERIAL_BLOCK_BINDING = 0,
+		LIGHT_BLOCK_BINDING = 1,
+		CAMERA_BLOCK_BINDING = 2,
+		OBJECT_BLOCK_BINDING = 3,
+		SHADOW_BLOCK_BINDING = 4
+	};
+
+	// read the locations of all the active uniforms of the program
+	void LoadLocations(GLuint programID);
+	// get the cached location of a uniform, -1 if it is not active -
+	// the ID is hashed at compile time, the string when it is called
+	GLint GetLocation(const UniformID& id) const;
+	GLint GetLocation(const std::string& name) const;
+	// get the program that the locations were read from
+	GLuint GetProgram() const { return m_programID; }
+
+	// connect a uniform block of the program to a binding point
+	bool BindUniformBlock(const char* blockName, GLuint binding) const;
+	bool BindUniformBlock(const UniformID& blockID, GLuint binding) const { return BindUniformBlock(blockID.GetName(), binding); }
+
+	// set uniform values by their cached location
+	void SetInt(GLint location, int value) const;
+	void SetFloat(GLint location, float value) const;
+	void SetVec2(GLint location, const glm::vec2& value) const;
+	void SetVec3(GLint location, const glm::vec3& value) const;
+	void SetVec4(GLint location, const glm::vec4& value) const;
+	void SetMat4(GLint location, const glm::mat4& value) const;
+
+private:
+	// program that the locations were read from
+	GLuint m_programID;
+	// the location of an active uniform under the hash of its name
+	struct LOCATION_ENTRY
+	{
+		uint32_t hash;
+		GLint location;
+	};
+
+	// locations of the active uniforms, sorted by the name hash
+	std::vector<LOCATION_ENTRY> m_locations;
+
+	// add the location of a uniform name to the table
+	void AddLocation(const std::string& name, GLint location);
+	// find the location under a name hash in the sorted table
+	GLint FindLocation(uint32_t hash) const;
+};
@@ -0,0 +1,392 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformring.cpp
+// ============
+// mapped uniform buffer that the per frame and per draw blocks are written to
+///////////////////////////////////////////////////////////////////////////////
+
+#include "UniformRing.h"
+#include "GpuResources.h"
+
+#include <cstring>
+#include <iostream>
+
+/***********************************************************
+ *  UniformRing()
+ *
+ *  The constructor for the class
+ ***********************************************************/
+UniformRing::UniformRing()
+{
+	m_buffer = 0;
+	m_pMappedData = NULL;
+	m_frameSize = 0;
+	m_alignment = 256;
+	m_frame = 0;
+	m_offset = 0;
+	m_frameBlockEnd = 0;
+	m_bOverflow = false;
+	for (int i = 0; i < FRAME_COUNT; i++)
+	{
+		m_fences[i] = 0;
+	}
+}
+
+/***********************************************************
+ *  ~UniformRing()
+ *
+ *  The destructor for the class
+ ***********************************************************/
+UniformRing::~UniformRing()
+{
+	Release();
+}
+
+/***********************************************************
+ *  Initialize()
+ *
+ *  This method is used for creating the buffer with one
+ *  region of the passed in size for each frame in flight.
+ *  The buffer stays mapped for as long as it exists.
+ ***********************************************************/
+bool UniformRing::Initialize(GLsizeiptr frameSize)
+{
+	GLint alignment = 0;
+
+	Release();
+
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	if (alignment > 0)
+	{
+		m_alignment = alignment;
+	}
+	m_frameSize = ((frameSize + m_alignment - 1) / m_alignment) * m_alignment;
+
+	glGenBuffers(1, &m_buffer);
+	GpuResources::Add(GpuResources::RESOURCE_BUFFER, m_buffer, "UniformRing", (size_t)(m_frameSize * FRAME_COUNT));
+	glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+	if (GLEW_ARB_buffer_storage)
+	{
+		GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+		glBufferStorage(GL_UNIFORM_BUFFER, m_frameSize * FRAME_COUNT, NULL, flags);
+		m_pMappedData = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, m_frameSize * FRAME_COUNT, flags);
+	}
+	else
+	{
+		glBufferData(GL_UNIFORM_BUFFER, m_frameSize * FRAME_COUNT, NULL, GL_DYNAMIC_DRAW);
+	}
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+	if (GLEW_ARB_buffer_storage && (NULL == m_pMappedData))
+	{
+		std::cout << "Could not map the uniform ring buffer" << std::endl;
+		Release();
+		return(false);
+	}
+
+	m_frame = 0;
+	m_offset = 0;
+	m_frameBlockEnd = 0;
+	m_bOverflow = false;
+
+	return(true);
+}
+
+/***********************************************************
+ *  Release()
+ *
+ *  This method is used for deleting the buffer and the
+ *  fences of its regions.
+ ***********************************************************/
+void UniformRing::Release()
+{
+	for (int i = 0; i < FRAME_COUNT; i++)
+	{
+		if (0 != m_fences[i])
+		{
+			glDeleteSync(m_fences[i]);
+			m_fences[i] = 0;
+		}
+	}
+
+	if (0 != m_buffer)
+	{
+		if (NULL != m_pMappedData)
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+			glUnmapBuffer(GL_UNIFORM_BUFFER);
+			glBindBuffer(GL_UNIFORM_BUFFER, 0);
+			m_pMappedData = NULL;
+		}
+		GpuResources::Remove(GpuResources::RESOURCE_BUFFER, m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+		m_buffer = 0;
+	}
+}
+
+/***********************************************************
+ *  BeginFrame()
+ *
+ *  This method is used for moving on to the region of the
+ *  next frame.  It was last written FRAME_COUNT frames ago,
+ *  so the wait is normally over at once.  When the last
+ *  frame did not fit in a region, every region is made
+ *  twice as large first.
+ ***********************************************************/
+void UniformRing::BeginFrame()
+{
+	if (0 == m_buffer)
+	{
+		return;
+	}
+
+	if (m_bOverflow)
+	{
+		for (int i = 0; i < FRAME_COUNT; i++)
+		{
+			WaitForFrame(i);
+		}
+		std::cout << "Uniform ring buffer grown to " << (m_frameSize * 2) << " bytes per frame" << std::endl;
+		Initialize(m_frameSize * 2);
+		if (0 == m_buffer)
+		{
+			return;
+		}
+	}
+
+	m_frame = (m_frame + 1) % FRAME_COUNT;
+	m_offset = 0;
+	m_frameBlockEnd = 0;
+	m_frameBlocks.clear();
+	m_passBlocks.clear();
+	WaitForFrame(m_frame);
+}
+
+/***********************************************************
+ *  EndFrame()
+ *
+ *  This method is used for placing the fence after the last
+ *  draw that reads the region of this frame.
+ ***********************************************************/
+void UniformRing::EndFrame()
+{
+	if (NULL == m_pMappedData)
+	{
+		return;
+	}
+
+	if (0 != m_fences[m_frame])
+	{
+		glDeleteSync(m_fences[m_frame]);
+	}
+	m_fences[m_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+/***********************************************************
+ *  Bind()
+ *
+ *  This method is used for writing a per draw block, which
+ *  is bound until the next block of its binding point.
+ ***********************************************************/
+bool UniformRing::Bind(GLuint binding, const void* pData, GLsizeiptr size)
+{
+	GLintptr offset = 0;
+
+	return(WriteBlock(binding, pData, size, offset));
+}
+
+/***********************************************************
+ *  BindFrameBlock()
+ *
+ *  This method is used for writing a block that the draws
+ *  of the whole frame read, such as the camera values.  It
+ *  is not written over when a full region starts again.
+ ***********************************************************/
+bool UniformRing::BindFrameBlock(GLuint binding, const void* pData, GLsizeiptr size)
+{
+	BOUND_BLOCK block;
+
+	if (false == WriteBlock(binding, pData, size, block.offset))
+	{
+		return(false);
+	}
+	m_frameBlockEnd = m_offset;
+
+	block.binding = binding;
+	block.size = size;
+	m_frameBlocks.push_back(block);
+
+	return(true);
+}
+
+/***********************************************************
+ *  BindPassBlock()
+ *
+ *  This method is used for writing a block that the draws
+ *  of one pass read, after the per draw blocks of the frame
+ *  were already written.  It takes the place of the pass
+ *  block of the same binding, and when the region is full
+ *  it is written again before the blocks that follow.
+ ***********************************************************/
+bool UniformRing::BindPassBlock(GLuint binding, const void* pData, GLsizeiptr size)
+{
+	PASS_BLOCK block;
+
+	for (size_t i = 0; i < m_passBlocks.size(); i++)
+	{
+		if (m_passBlocks[i].range.binding == binding)
+		{
+			m_passBlocks.erase(m_passBlocks.begin() + i);
+			break;
+		}
+	}
+
+	if (false == WriteBlock(binding, pData, size, block.range.offset))
+	{
+		return(false);
+	}
+
+	block.range.binding = binding;
+	block.range.size = size;
+	block.data.assign((const unsigned char*)pData, (const unsigned char*)pData + size);
+	m_passBlocks.push_back(block);
+
+	return(true);
+}
+
+/***********************************************************
+ *  EndPass()
+ *
+ *  This method is used for forgetting the pass blocks and
+ *  binding the frame blocks again, which are kept in place
+ *  for the whole frame.
+ ***********************************************************/
+void UniformRing::EndPass()
+{
+	m_passBlocks.clear();
+
+	for (const BOUND_BLOCK& block : m_frameBlocks)
+	{
+		glBindBufferRange(GL_UNIFORM_BUFFER, block.binding, m_buffer, block.offset, block.size);
+	}
+}
+
+/***********************************************************
+ *  WriteBlock()
+ *
+ *  This method is used for copying a block to the next free
+ *  offset of the region of this frame and binding its range
+ *  to the block binding point.  When the region is full the
+ *  draws of this frame are waited for, so that the region
+ *  can be written again after the frame blocks, and the
+ *  pass blocks are written there first.  A block is never
+ *  written over one that is still bound.
+ ***********************************************************/
+bool UniformRing::WriteBlock(GLuint binding, const void* pData, GLsizeiptr size, GLintptr& offset)
+{
+	GLsizeiptr passSize = 0;
+
+	for (const PASS_BLOCK& block : m_passBlocks)
+	{
+		passSize += ((block.range.size + m_alignment - 1) / m_alignment) * m_alignment;
+	}
+	if ((0 == m_buffer) || (m_frameBlockEnd + passSize + size > m_frameSize))
+	{
+		return(false);
+	}
+
+	if (m_offset + size > m_frameSize)
+	{
+		m_bOverflow = true;
+		EndFrame();
+		WaitForFrame(m_frame);
+		m_offset = m_frameBlockEnd;
+
+		for (PASS_BLOCK& block : m_passBlocks)
+		{
+			block.range.offset = CopyBlock(block.range.binding, block.data.data(), block.range.size);
+		}
+	}
+
+	offset = (GLintptr)m_frame * m_frameSize + m_offset;
+	if (OverlapsBoundBlock(offset, size))
+	{
+		std::cout << "ERROR: uniform ring block at offset " << offset << " would overwrite a bound block" << std::endl;
+		return(false);
+	}
+	CopyBlock(binding, pData, size);
+
+	return(true);
+}
+
+/***********************************************************
+ *  CopyBlock()
+ *
+ *  This method is used for copying a block to the next free
+ *  offset, which the caller has checked to have room, and
+ *  binding its range.  The offset from the start of the
+ *  buffer is returned.
+ ***********************************************************/
+GLintptr UniformRing::CopyBlock(GLuint binding, const void* pData, GLsizeiptr size)
+{
+	GLintptr offset = (GLintptr)m_frame * m_frameSize + m_offset;
+
+	if (NULL != m_pMappedData)
+	{
+		memcpy(m_pMappedData + offset, pData, size);
+	}
+	else
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, m_buffer);
+		glBufferSubData(GL_UNIFORM_BUFFER, offset, size, pData);
+	}
+	glBindBufferRange(GL_UNIFORM_BUFFER, binding, m_buffer, offset, size);
+
+	m_offset += ((size + m_alignment - 1) / m_alignment) * m_alignment;
+
+	return(offset);
+}
+
+/***********************************************************
+ *  OverlapsBoundBlock()
+ *
+ *  This method is used for checking if a range of the buffer
+ *  holds a frame block or a pass block.
+ ***********************************************************/
+bool UniformRing::OverlapsBoundBlock(GLintptr offset, GLsizeiptr size) const
+{
+	for (const BOUND_BLOCK& block : m_frameBlocks)
+	{
+		if ((offset < block.offset + block.size) && (block.offset < offset + size))
+		{
+			return(true);
+		}
+	}
+	for (const PASS_BLOCK& block : m_passBlocks)
+	{
+		if ((offset < block.range.offset + block.range.size) && (block.range.offset < offset + size))
+		{
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+/***********************************************************
+ *  WaitForFrame()
+ *
+ *  This method is used for waiting until the GPU has read
+ *  the region of the passed in frame.
+ ***********************************************************/
+void UniformRing::WaitForFrame(int frame)
+{
+	if (0 == m_fences[frame])
+	{
+		return;
+	}
+
+	glClientWaitSync(m_fences[frame], GL_SYNC_FLUSH_COMMANDS_BIT, GL_TIMEOUT_IGNORED);
+	glDeleteSync(m_fences[frame]);
+	m_fences[frame] = 0;
+}
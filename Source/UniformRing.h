@@ -0,0 +1,109 @@
+///////////////////////////////////////////////////////////////////////////////
+// uniformring.h
+// ============
+// mapped uniform buffer that the per frame and per draw blocks are written to
+///////////////////////////////////////////////////////////////////////////////
+
+#pragma once
+
+#include <GL/glew.h>
+
+#include <cstddef>
+#include <vector>
+
+/***********************************************************
+ *  UniformRing
+ *
+ *  This class contains the code for a uniform buffer split
+ *  into one region for each frame in flight.  The blocks of
+ *  a frame are copied one after the other into the mapped
+ *  memory of its region and bound by their offset, and a
+ *  fence placed at the end of the frame tells when the GPU
+ *  is done reading the region, so that it is only written
+ *  again after that.  Without ARB_buffer_storage the blocks
+ *  are copied with glBufferSubData instead.  The blocks that
+ *  stay bound while other blocks are written after them are
+ *  kept out of the way when a full region starts over.
+ ***********************************************************/
+class UniformRing
+{
+public:
+	// number of frames that can be in flight at the same time
+	static const int FRAME_COUNT = 3;
+
+	// constructor
+	UniformRing();
+	// destructor
+	~UniformRing();
+
+	// create the buffer with the passed in size for each frame
+	bool Initialize(GLsizeiptr frameSize);
+	// check if the buffer was created
+	bool IsReady() const { return 0 != m_buffer; }
+	// check if the blocks are written to mapped memory
+	bool IsPersistent() const { return NULL != m_pMappedData; }
+
+	// start writing the region of the next frame, waiting for the
+	// GPU to finish reading it first
+	void BeginFrame();
+	// place the fence of the region written this frame
+	void EndFrame();
+	// copy a block into the region of this frame and bind its range
+	// to the passed in uniform block binding point
+	bool Bind(GLuint binding, const void* pData, GLsizeiptr size);
+	// the same for a block that stays bound for the whole frame, it
+	// is written before any of the per draw blocks
+	bool BindFrameBlock(GLuint binding, const void* pData, GLsizeiptr size);
+	// the same for a block that stays bound for the per draw blocks of
+	// one pass, such as the camera of a shadow map - it is written again
+	// when a full region starts over, until EndPass() binds the frame
+	// blocks it took the place of again
+	bool BindPassBlock(GLuint binding, const void* pData, GLsizeiptr size);
+	void EndPass();
+
+private:
+	GLuint m_buffer;
+	unsigned char* m_pMappedData;
+	// size of each region, and the start of the block ranges
+	GLsizeiptr m_frameSize;
+	GLint m_alignment;
+
+	// region of this frame, the next free byte in it, and the end of
+	// the blocks that stay bound for the whole frame
+	int m_frame;
+	GLsizeiptr m_offset;
+	GLsizeiptr m_frameBlockEnd;
+	// fence for the draws that read each region
+	GLsync m_fences[FRAME_COUNT];
+	// set when a frame needed more than one region, the regions
+	// are made larger before the next frame
+	bool m_bOverflow;
+
+	// range of a block that stays bound, from the start of the buffer
+	struct BOUND_BLOCK
+	{
+		GLuint binding;
+		GLintptr offset;
+		GLsizeiptr size;
+	};
+	// a pass block and the copy of its values it is written again from
+	struct PASS_BLOCK
+	{
+		BOUND_BLOCK range;
+		std::vector<unsigned char> data;
+	};
+	std::vector<BOUND_BLOCK> m_frameBlocks;
+	std::vector<PASS_BLOCK> m_passBlocks;
+
+	// delete the buffer and its fences
+	void Release();
+	// wait for the GPU to finish reading a region
+	void WaitForFrame(int frame);
+	// copy a block to the next free offset and bind it, starting the
+	// region over when it is full
+	bool WriteBlock(GLuint binding, const void* pData, GLsizeiptr size, GLintptr& offset);
+	// copy a block to the next free offset without starting over
+	GLintptr CopyBlock(GLuint binding, const void* pData, GLsizeiptr size);
+	// check if a range holds a block that is still bound
+	bool OverlapsBoundBlock(GLintptr offset, GLsizeiptr size) const;
+};
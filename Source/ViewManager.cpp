@@ -22,8 +22,11 @@ namespace
 	// Variables for window width and height
 	const int WINDOW_WIDTH = 1000;
 	const int WINDOW_HEIGHT = 800;
-	const char* g_ViewName = "view";
-	const char* g_ProjectionName = "projection";
+
+	// clip planes of the projection, also used for the depth slices
+	// of the light clusters
+	const float NEAR_PLANE = 0.1f;
+	const float FAR_PLANE = 100.0f;
 
 	// camera object used for viewing and interacting with
 	// the 3D scene
@@ -34,9 +37,14 @@ namespace
 	float gLastY = WINDOW_HEIGHT / 2.0f;
 	bool gFirstMouse = true;
 
-	// time between current frame and last frame
-	float gDeltaTime = 0.0f; 
-	float gLastFrame = 0.0f;
+	// speed of the selected point light in units per second
+	const float LIGHT_MOVE_SPEED = 3.0f;
+	// change of the point light intensity per second while the
+	// keypad keys are held, and per press of the other keys
+	const float LIGHT_INTENSITY_RATE = 3.0f;
+	const float LIGHT_INTENSITY_STEP = 0.05f;
+	// change of the ambient boost per second
+	const float AMBIENT_BOOST_RATE = 0.06f;
 
 	// the following variable is false when orthographic projection
 	// is off and true when it is on
@@ -49,11 +57,26 @@ namespace
  *  The constructor for the class
  ***********************************************************/
 ViewManager::ViewManager(
-	ShaderManager *pShaderManager)
+	ShaderManager *pShaderManager,
+	UniformCache* pUniformCache)
 {
 	// initialize the member variables
 	m_pShaderManager = pShaderManager;
+	m_pUniformCache = pUniformCache;
 	m_pWindow = NULL;
+	m_viewMatrix = glm::mat4(1.0f);
+	m_projectionMatrix = glm::mat4(1.0f);
+	m_bViewChanged = true;
+	m_bViewUpdated = false;
+	m_viewPosition = glm::vec3(0.0f);
+	m_selectedPointLight = 0;
+	m_moveSpeedScale = 1.0f;
+	m_pLightManager = new LightManager(pUniformCache);
+	for (int key = 0; key <= GLFW_KEY_LAST; key++)
+	{
+		m_keyOnce[key] = false;
+	}
+
 	g_pCamera = new Camera();
 	// default camera view parameters
 	g_pCamera->Position = glm::vec3(0.0f, 5.0f, 12.0f);
@@ -61,6 +84,7 @@ ViewManager::ViewManager(
 	g_pCamera->Up = glm::vec3(0.0f, 1.0f, 0.0f);
 	g_pCamera->Zoom = 80;
 	g_pCamera->MovementSpeed = 20;
+	m_previousPosition = g_pCamera->Position;
 }
 
 /***********************************************************
@@ -71,7 +95,13 @@ ViewManager::ViewManager(
 ViewManager::~ViewManager()
 {
 	// free up allocated memory
+	if (NULL != m_pLightManager)
+	{
+		delete m_pLightManager;
+		m_pLightManager = NULL;
+	}
 	m_pShaderManager = NULL;
+	m_pUniformCache = NULL;
 	m_pWindow = NULL;
 	if (NULL != g_pCamera)
 	{
@@ -111,7 +141,7 @@ GLFWwindow* ViewManager::CreateDisplayWindow(const char* windowTitle)
 	glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
 	// Enabling sticky keys 
-	glfwSetInputMode(m_window, GLFW_STICKY_KEYS, GLFW_TRUE);
+	glfwSetInputMode(window, GLFW_STICKY_KEYS, GLFW_TRUE);
 
 	// this callback is used to receive mouse moving events
 	glfwSetCursorPosCallback(window, &ViewManager::Mouse_Position_Callback);
@@ -172,10 +202,11 @@ void ViewManager::Scroll_Callback(GLFWwindow* window, double xOffset, double yOf
 /***********************************************************
  *  ProcessKeyboardEvents()
  *
- *  This method is called to process any keyboard events
- *  that may be waiting in the event queue.
+ *  This method is called to move the camera by the keys
+ *  that are held down, for the length of one input step.
+ *  The projection switch is taken once per key press.
  ***********************************************************/
-void ViewManager::ProcessKeyboardEvents()
+void ViewManager::ProcessKeyboardEvents(float stepSeconds)
 {
 	// close the window if the escape key has been pressed
 	if (glfwGetKey(m_pWindow, GLFW_KEY_ESCAPE) == GLFW_PRESS)
@@ -183,95 +214,152 @@ void ViewManager::ProcessKeyboardEvents()
 		glfwSetWindowShouldClose(m_pWindow, true);
 	}
 
+	// the speed scale and the shift key change how far the
+	// camera moves in a step
+	float moveSeconds = stepSeconds * m_moveSpeedScale;
+	if (glfwGetKey(m_pWindow, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+	{
+		moveSeconds *= 2.0f;
+	}
+
 	// process camera zooming in and out
 	if (glfwGetKey(m_pWindow, GLFW_KEY_W) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(FORWARD, gDeltaTime);
+		g_pCamera->ProcessKeyboard(FORWARD, moveSeconds);
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_S) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(BACKWARD, gDeltaTime);
+		g_pCamera->ProcessKeyboard(BACKWARD, moveSeconds);
 	}
 
 	// process camera panning left and right
 	if (glfwGetKey(m_pWindow, GLFW_KEY_A) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(LEFT, gDeltaTime);
+		g_pCamera->ProcessKeyboard(LEFT, moveSeconds);
 	}
 	if (glfwGetKey(m_pWindow, GLFW_KEY_D) == GLFW_PRESS)
 	{
-		g_pCamera->ProcessKeyboard(RIGHT, gDeltaTime);
+		g_pCamera->ProcessKeyboard(RIGHT, moveSeconds);
 	}
-		//process camera panning up and down
-		if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
-		{
-			g_pCamera->ProcessKeyboard(UP, gDeltaTime);
-		}
-		if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
-		{
-			g_pCamera->ProcessKeyboard(DOWN, gDeltaTime);
 
-		}
+	// process camera panning up and down
+	if (glfwGetKey(m_pWindow, GLFW_KEY_Q) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(UP, moveSeconds);
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_E) == GLFW_PRESS)
+	{
+		g_pCamera->ProcessKeyboard(DOWN, moveSeconds);
+	}
 
-		if (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
-		{
-			bOrthographicProjection = !bOrthographicProjection;
-			std::cout << (bOrthographicProjection ? "Orthographic" : "Perspective") << " projection enabled." << std::endl;
+	// the projection is switched once for each press, the frames
+	// keep being drawn while the key is held
+	if (KeyPressedOnce(GLFW_KEY_P))
+	{
+		bOrthographicProjection = !bOrthographicProjection;
+		std::cout << (bOrthographicProjection ? "Orthographic" : "Perspective") << " projection enabled." << std::endl;
+	}
+}
 
-			while (glfwGetKey(m_pWindow, GLFW_KEY_P) == GLFW_PRESS)
-			{
-				glfwPollEvents();
-			}
-		}
-		
+/***********************************************************
+ *  KeyPressedOnce()
+ *
+ *  This method is used for checking if a key went down
+ *  since the last check, so that a held key counts once.
+ ***********************************************************/
+bool ViewManager::KeyPressedOnce(int key)
+{
+	int state = glfwGetKey(m_pWindow, key);
+
+	if ((state == GLFW_PRESS) && (false == m_keyOnce[key]))
+	{
+		m_keyOnce[key] = true;
+		return(true);
+	}
+	if (state == GLFW_RELEASE)
+	{
+		m_keyOnce[key] = false;
 	}
 
+	return(false);
+}
 
+/***********************************************************
+ *  SetWindowTitleWithSelection()
+ *
+ *  This method is used for showing the selected point light
+ *  and the movement speed scale in the window title.
+ ***********************************************************/
+void ViewManager::SetWindowTitleWithSelection()
+{
+	std::ostringstream oss;
 
-////////////////////////////////////////////////////
-bool ViewManager::KeyPressedOnce(int key) {
-    int state = glfwGetKey(m_window, key);
-    if (state == GLFW_PRESS && !m_keyOnce[key]) {
-        m_keyOnce[key] = true;
-        return true;
-    }
-    if (state == GLFW_RELEASE) {
-        m_keyOnce[key] = false;
-    }
-    return false;
+	oss << "Graphics Project  |  Selected Light: "
+		<< (m_selectedPointLight + 1)
+		<< "  |  Move speed x" << m_moveSpeedScale;
+	glfwSetWindowTitle(m_pWindow, oss.str().c_str());
 }
 
-// Updates the window title to show the selected light and move speed scale
-void ViewManager::SetWindowTitleWithSelection() {
-    std::ostringstream oss;
-    oss << "Graphics Project  |  Selected Light: "
-        << (m_selectedPointLight + 1)
-        << "  |  Move speed x" << m_moveSpeedScale;
-    glfwSetWindowTitle(m_window, oss.str().c_str());
+/***********************************************************
+ *  SetCameraPose()
+ *
+ *  This method is used for placing the camera at a position
+ *  looking at a target, for replaying a scripted camera path.
+ ***********************************************************/
+void ViewManager::SetCameraPose(const glm::vec3& position, const glm::vec3& target, float zoom)
+{
+	g_pCamera->Position = position;
+	g_pCamera->Front = glm::normalize(target - position);
+	g_pCamera->Zoom = zoom;
+	m_previousPosition = position;
 }
+
 /***********************************************************
- *  PrepareSceneView()
+ *  ReloadUniformLocations()
  *
- *  This method is used for preparing the 3D scene by loading
- *  the shapes, textures in memory to support the 3D scene 
- *  rendering
+ *  This method is used for looking up the uniform locations
+ *  again on the next frame, after the program was replaced.
  ***********************************************************/
-void ViewManager::PrepareSceneView()
+void ViewManager::ReloadUniformLocations()
 {
-	glm::mat4 view;
-	glm::mat4 projection;
+	m_pLightManager->ReloadLocations();
+}
 
-	// per-frame timing
-	float currentFrame = glfwGetTime();
-	gDeltaTime = currentFrame - gLastFrame;
-	gLastFrame = currentFrame;
+/***********************************************************
+ *  StepInput()
+ *
+ *  This method is used for advancing the camera and the
+ *  interactive lights by one fixed step of the input.  The
+ *  render loop runs as many steps as the time that passed
+ *  since the last frame holds, so the movement is the same
+ *  at any frame rate.
+ ***********************************************************/
+void ViewManager::StepInput(float stepSeconds)
+{
+	m_previousPosition = g_pCamera->Position;
 
-	// process any keyboard events that may be waiting in the 
-	// event queue
-	ProcessKeyboardEvents();
+	ProcessKeyboardEvents(stepSeconds);
+	HandleInteractiveShortcuts(stepSeconds);
+}
+
+/***********************************************************
+ *  UpdateView()
+ *
+ *  This method is used for building the view and projection
+ *  matrices of the next frame.  The on demand render loop
+ *  calls it before deciding if the frame needs to be drawn
+ *  at all.  The camera is placed between its positions
+ *  before and after the last input step, by the part of the
+ *  next step that has already passed.
+ ***********************************************************/
+void ViewManager::UpdateView(float stepBlend)
+{
+	glm::mat4 view;
+	glm::mat4 projection;
 
 	// get the current view matrix from the camera
-	view = g_pCamera->GetViewMatrix();
+	glm::vec3 position = glm::mix(m_previousPosition, g_pCamera->Position, stepBlend);
+	view = glm::lookAt(position, position + g_pCamera->Front, g_pCamera->Up);
 
 	// define the current projection matrix
 	if (bOrthographicProjection)
@@ -280,78 +368,195 @@ void ViewManager::PrepareSceneView()
 		float aspectRatio = (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT;
 		projection = glm::ortho(-orthoSize * aspectRatio, orthoSize * aspectRatio,
 			-orthoSize, orthoSize,
-			0.1f, 100.0f);
+			NEAR_PLANE, FAR_PLANE);
 	}
 	else
 	{
 		projection = glm::perspective(glm::radians(g_pCamera->Zoom),
 			(GLfloat)WINDOW_WIDTH / (GLfloat)WINDOW_HEIGHT,
-			0.1f, 100.0f);
+			NEAR_PLANE, FAR_PLANE);
+	}
+
+	m_bViewChanged = (view != m_viewMatrix) || (projection != m_projectionMatrix);
+	m_viewMatrix = view;
+	m_projectionMatrix = projection;
+	m_viewPosition = position;
+
+	// the flashlight follows the camera
+	m_pLightManager->SetFlashlightPose(position, g_pCamera->Front);
+	m_bViewUpdated = true;
+}
+
+/***********************************************************
+ *  PrepareSceneView()
+ *
+ *  This method is used for preparing the 3D scene by loading
+ *  the shapes, textures in memory to support the 3D scene 
+ *  rendering
+ ***********************************************************/
+void ViewManager::PrepareSceneView()
+{
+	// the on demand render loop has already updated the view
+	// of this frame to decide if it is drawn
+	if (false == m_bViewUpdated)
+	{
+		UpdateView();
 	}
-	// if the shader manager object is valid
-	if (NULL != m_pShaderManager)
+	m_bViewUpdated = false;
+
+	// the view, projection and camera position are written to the
+	// camera block by the scene manager, only the changed light
+	// settings are sent to the shader here
+	if (NULL != m_pUniformCache)
 	{
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ViewName, view);
-		// set the view matrix into the shader for proper rendering
-		m_pShaderManager->setMat4Value(g_ProjectionName, projection);
-		// set the view position of the camera into the shader for proper rendering
-		m_pShaderManager->setVec3Value("viewPosition", g_pCamera->Position);
+		UploadInteractiveUniforms();
 	}
 
 }
 
-void ViewManager::HandleInteractiveShortcuts(GLFWwindow* window) {                          
-    //                                                  
-    float dt = 0.016f;                                                                       
-    float base = 3.0f;                                                                       
-    float speed = base * m_moveSpeedScale * dt;                                              
-    if (glfwGetKey(window, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS) speed *= 2.0f;                
-
-    //Camera                                                            
-    if (glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS) m_camera.MoveForward(speed);           
-    if (glfwGetKey(window, GLFW_KEY_S) == GLFW_PRESS) m_camera.MoveBackward(speed);          
-    if (glfwGetKey(window, GLFW_KEY_A) == GLFW_PRESS) m_camera.MoveLeft(speed);              
-    if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) m_camera.MoveRight(speed);             
-    if (glfwGetKey(window, GLFW_KEY_Q) == GLFW_PRESS) m_camera.MoveDown(speed);              
-    if (glfwGetKey(window, GLFW_KEY_E) == GLFW_PRESS) m_camera.MoveUp(speed);               
-
-    //Speed scale                                              
-    if (KeyPressedOnce(GLFW_KEY_Z)) {                                                       
-        m_moveSpeedScale = std::max(0.25f, m_moveSpeedScale * 0.5f);                         
-        SetWindowTitleWithSelection();                                                       
-    }                                                                                        
-    if (KeyPressedOnce(GLFW_KEY_X)) {                                                       
-        m_moveSpeedScale = std::min(8.0f,  m_moveSpeedScale * 2.0f);                         
-        SetWindowTitleWithSelection();                                                      
-    }                                                                                        
-
-                                      
-    if (KeyPressedOnce(GLFW_KEY_1)) { m_selectedPointLight = 0; SetWindowTitleWithSelection(); } 
-    if (KeyPressedOnce(GLFW_KEY_2)) { m_selectedPointLight = 1; SetWindowTitleWithSelection(); } 
- if (KeyPressedOnce(GLFW_KEY_3)) { m_selectedPointLight = 2; SetWindowTitleWithSelection(); } 
-    if (KeyPressedOnce(GLFW_KEY_4)) { m_selectedPointLight = 3; SetWindowTitleWithSelection(); } 
-
-    if (glfwGetKey(window, GLFW_KEY_LEFT)  == GLFW_PRESS)  m_pointLightPos[m_selectedPointLight].x -= speed; 
-    if (glfwGetKey(window, GLFW_KEY_RIGHT) == GLFW_PRESS)  m_pointLightPos[m_selectedPointLight].x += speed; 
-    if (glfwGetKey(window, GLFW_KEY_UP)    == GLFW_PRESS)  m_pointLightPos[m_selectedPointLight].z -= speed; 
-    if (glfwGetKey(window, GLFW_KEY_DOWN)  == GLFW_PRESS)  m_pointLightPos[m_selectedPointLight].z += speed; 
-    if (glfwGetKey(window, GLFW_KEY_PAGE_UP)   == GLFW_PRESS) m_pointLightPos[m_selectedPointLight].y += speed; 
-    if (glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS) m_pointLightPos[m_selectedPointLight].y -= speed; 
-
-    if (KeyPressedOnce(GLFW_KEY_L)) { m_dirLightOn     = !m_dirLightOn; }                    
-    if (KeyPressedOnce(GLFW_KEY_F)) { m_flashlightOn   = !m_flashlightOn; }                  
-    if (KeyPressedOnce(GLFW_KEY_T)) { m_pointLightOn[m_selectedPointLight] = !m_pointLightOn[m_selectedPointLight]; } 
-
-if (glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS || KeyPressedOnce(GLFW_KEY_EQUAL)) {          
-        m_pointIntensity[m_selectedPointLight] = std::min(3.0f, m_pointIntensity[m_selectedPointLight] + 0.05f); 
-    }                                                                                                     
-    if (glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS || KeyPressedOnce(GLFW_KEY_MINUS)) {       
-        m_pointIntensity[m_selectedPointLight] = std::max(0.0f, m_pointIntensity[m_selectedPointLight] - 0.05f); 
-    }                                                                                                     
-
-    if (glfwGetKey(window, GLFW_KEY_SEMICOLON) == GLFW_PRESS)  m_ambientBoost = std::max(0.0f, m_ambientBoost - 0.001f); 
-    if (glfwGetKey(window, GLFW_KEY_APOSTROPHE) == GLFW_PRESS) m_ambientBoost = std::min(0.3f,  m_ambientBoost + 0.001f); 
-
-    UploadInteractiveUniforms();                                                            
-}                                                                                             
+/***********************************************************
+ *  HandleInteractiveShortcuts()
+ *
+ *  This method is used for changing the interactive light
+ *  settings from the keyboard, for the length of one input
+ *  step.  The held keys change a setting by a rate per
+ *  second, the toggles are taken once per key press.
+ ***********************************************************/
+void ViewManager::HandleInteractiveShortcuts(float stepSeconds)
+{
+	LightManager* lights = m_pLightManager;
+
+	// the light moves with the same speed scale as the camera
+	float moveDistance = LIGHT_MOVE_SPEED * m_moveSpeedScale * stepSeconds;
+	if (glfwGetKey(m_pWindow, GLFW_KEY_LEFT_SHIFT) == GLFW_PRESS)
+	{
+		moveDistance *= 2.0f;
+	}
+
+	// change the movement speed scale
+	if (KeyPressedOnce(GLFW_KEY_Z))
+	{
+		m_moveSpeedScale = std::max(0.25f, m_moveSpeedScale * 0.5f);
+		SetWindowTitleWithSelection();
+	}
+	if (KeyPressedOnce(GLFW_KEY_X))
+	{
+		m_moveSpeedScale = std::min(8.0f, m_moveSpeedScale * 2.0f);
+		SetWindowTitleWithSelection();
+	}
+
+	// select the point light that the keys below change
+	for (int i = 0; i < 4; i++)
+	{
+		if (KeyPressedOnce(GLFW_KEY_1 + i))
+		{
+			m_selectedPointLight = i;
+			SetWindowTitleWithSelection();
+		}
+	}
+
+	// the selected light may be missing from a shorter light list
+	if (m_selectedPointLight < lights->GetPointLightCount())
+	{
+		glm::vec3 lightPos = lights->GetPointLight(m_selectedPointLight).position;
+		float intensity = lights->GetPointLight(m_selectedPointLight).intensity;
+
+		if (glfwGetKey(m_pWindow, GLFW_KEY_LEFT) == GLFW_PRESS)
+		{
+			lightPos.x -= moveDistance;
+		}
+		if (glfwGetKey(m_pWindow, GLFW_KEY_RIGHT) == GLFW_PRESS)
+		{
+			lightPos.x += moveDistance;
+		}
+		if (glfwGetKey(m_pWindow, GLFW_KEY_UP) == GLFW_PRESS)
+		{
+			lightPos.z -= moveDistance;
+		}
+		if (glfwGetKey(m_pWindow, GLFW_KEY_DOWN) == GLFW_PRESS)
+		{
+			lightPos.z += moveDistance;
+		}
+		if (glfwGetKey(m_pWindow, GLFW_KEY_PAGE_UP) == GLFW_PRESS)
+		{
+			lightPos.y += moveDistance;
+		}
+		if (glfwGetKey(m_pWindow, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS)
+		{
+			lightPos.y -= moveDistance;
+		}
+		lights->SetPointLightPosition(m_selectedPointLight, lightPos);
+
+		if (KeyPressedOnce(GLFW_KEY_T))
+		{
+			lights->SetPointLightActive(m_selectedPointLight, !lights->GetPointLight(m_selectedPointLight).bActive);
+		}
+
+		// the keypad keys change the intensity while held, the other
+		// keys step it once per press
+		if (glfwGetKey(m_pWindow, GLFW_KEY_KP_ADD) == GLFW_PRESS)
+		{
+			intensity += LIGHT_INTENSITY_RATE * stepSeconds;
+		}
+		if (glfwGetKey(m_pWindow, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS)
+		{
+			intensity -= LIGHT_INTENSITY_RATE * stepSeconds;
+		}
+		if (KeyPressedOnce(GLFW_KEY_EQUAL))
+		{
+			intensity += LIGHT_INTENSITY_STEP;
+		}
+		if (KeyPressedOnce(GLFW_KEY_MINUS))
+		{
+			intensity -= LIGHT_INTENSITY_STEP;
+		}
+		lights->SetPointLightIntensity(m_selectedPointLight, glm::clamp(intensity, 0.0f, 3.0f));
+	}
+
+	if (KeyPressedOnce(GLFW_KEY_L))
+	{
+		lights->SetDirectionalLightActive(!lights->IsDirectionalLightActive());
+	}
+	if (KeyPressedOnce(GLFW_KEY_F))
+	{
+		lights->SetFlashlightActive(!lights->IsFlashlightActive());
+	}
+
+	float ambientBoost = lights->GetAmbientBoost();
+	if (glfwGetKey(m_pWindow, GLFW_KEY_SEMICOLON) == GLFW_PRESS)
+	{
+		ambientBoost -= AMBIENT_BOOST_RATE * stepSeconds;
+	}
+	if (glfwGetKey(m_pWindow, GLFW_KEY_APOSTROPHE) == GLFW_PRESS)
+	{
+		ambientBoost += AMBIENT_BOOST_RATE * stepSeconds;
+	}
+	lights->SetAmbientBoost(glm::clamp(ambientBoost, 0.0f, 0.3f));
+}
+
+/***********************************************************
+ *  UploadInteractiveUniforms()
+ *
+ *  This method is used for sending the interactive light
+ *  settings to the shader.  The flashlight follows the
+ *  camera, and the light manager only uploads the lights
+ *  when a setting or the view has changed.
+ ***********************************************************/
+void ViewManager::UploadInteractiveUniforms()
+{
+	int width = WINDOW_WIDTH;
+	int height = WINDOW_HEIGHT;
+
+	if (NULL != m_pWindow)
+	{
+		glfwGetFramebufferSize(m_pWindow, &width, &height);
+	}
+
+	m_pLightManager->UploadLights(
+		m_viewMatrix,
+		m_projectionMatrix,
+		NEAR_PLANE,
+		FAR_PLANE,
+		width,
+		height);
+}
@@ -10,6 +10,8 @@
 #pragma once
 
 #include "ShaderManager.h"
+#include "UniformCache.h"
+#include "LightManager.h"
 #include "camera.h"
 
 // GLFW library
@@ -20,7 +22,8 @@ class ViewManager
 public:
 	// constructor
 	ViewManager(
-		ShaderManager* pShaderManager);
+		ShaderManager* pShaderManager,
+		UniformCache* pUniformCache);
 	// destructor
 	~ViewManager();
 
@@ -32,18 +35,44 @@ public:
 private:
 	// pointer to shader manager object
 	ShaderManager* m_pShaderManager;
+	// pointer to the cached shader uniform locations
+	UniformCache* m_pUniformCache;
 	// active OpenGL display window
 	GLFWwindow* m_pWindow;
 
-	// process keyboard events for interaction with the 3D scene
-	void ProcessKeyboardEvents();
+	// view and projection matrices and the camera position of the
+	// last prepared frame
+	glm::mat4 m_viewMatrix;
+	glm::mat4 m_projectionMatrix;
+	glm::vec3 m_viewPosition;
+	// camera position before the last input step, the frames drawn
+	// between two steps are placed between the two positions
+	glm::vec3 m_previousPosition;
 
-int m_selectedPointLight = 0;
+	// set when the last view update moved the camera or changed
+	// the projection, and when the view of this frame has already
+	// been updated before it is prepared
+	bool m_bViewChanged;
+	bool m_bViewUpdated;
 
-float m_moveSpeedScale = 1.0f;
+	// scene lights, uploaded when the shortcuts change them
+	LightManager* m_pLightManager;
+	// point light moved by the shortcuts, and the scale of the
+	// camera and light movement speed
+	int m_selectedPointLight;
+	float m_moveSpeedScale;
 
-bool KeyPressedOnce(int key);
-void SetWindowTitleWithSelection();
+	// key states used for detecting a single key press
+	bool m_keyOnce[GLFW_KEY_LAST + 1];
+
+	// process the camera keys for one input step
+	void ProcessKeyboardEvents(float stepSeconds);
+	// process the light and speed shortcuts for one input step
+	void HandleInteractiveShortcuts(float stepSeconds);
+	// show the selected light and the speed scale in the title
+	void SetWindowTitleWithSelection();
+	// send the changed light settings to the shader
+	void UploadInteractiveUniforms();
 
 public:
 	// create the initial OpenGL display window
@@ -51,8 +80,29 @@ public:
 	
 	// prepare the conversion from 3D object display to 2D scene display
 	void PrepareSceneView();
+	// advance the camera and the lights by one fixed input step
+	void StepInput(float stepSeconds);
+	// build the view and projection matrices of the next frame,
+	// without sending them to the shader - the part of the input
+	// step that has passed places the camera between its last two
+	// positions
+	void UpdateView(float stepBlend = 1.0f);
+	// check if the last view update changed the camera or the lights
+	bool IsViewDirty() const { return m_bViewChanged || m_pLightManager->IsDirty(); }
+	// check if a key went down since the last check
+	bool KeyPressedOnce(int key);
+	// place the camera for a scripted view, used by the benchmark
+	void SetCameraPose(const glm::vec3& position, const glm::vec3& target, float zoom);
+	// get the view matrix of the last prepared frame
+	const glm::mat4& GetViewMatrix() const { return m_viewMatrix; }
+	// get the projection matrix of the last prepared frame
+	const glm::mat4& GetProjectionMatrix() const { return m_projectionMatrix; }
+	// get the camera position of the last prepared frame
+	const glm::vec3& GetViewPosition() const { return m_viewPosition; }
 
-    void HandleInteractiveShortcuts(GLFWwindow* window);
-    void UploadInteractiveUniforms();
-
+	// get the scene lights
+	LightManager* GetLightManager() const { return m_pLightManager; }
+	// look up the uniform locations in the program again, after
+	// the shaders were reloaded
+	void ReloadUniformLocations();
 };
@@ -0,0 +1,59 @@
+#version 430 core
+// one invocation culls one object, same as CULL_GROUP_SIZE
+layout (local_size_x = 64) in;
+
+// same layout as the commands read by glMultiDrawElementsIndirect()
+struct DrawCommand {
+    uint count;
+    uint instanceCount;
+    uint firstIndex;
+    int baseVertex;
+    uint baseInstance;
+};
+
+struct Bounds {
+    vec4 minCorner;
+    vec4 maxCorner;
+};
+
+layout(std430, binding = 0) buffer CommandBuffer
+{
+    DrawCommand commands[];
+};
+layout(std430, binding = 1) readonly buffer BoundsBuffer
+{
+    Bounds bounds[];
+};
+
+// planes of the view frustum, the normals point inwards
+uniform vec4 frustumPlanes[6];
+uniform int objectCount = 0;
+uniform bool bCullObjects = true;
+
+void main()
+{
+    uint object = gl_GlobalInvocationID.x;
+    if(object >= uint(objectCount))
+    {
+        return;
+    }
+
+    bool bVisible = true;
+    if(bCullObjects == true)
+    {
+        vec3 minCorner = bounds[object].minCorner.xyz;
+        vec3 maxCorner = bounds[object].maxCorner.xyz;
+        for(int i = 0; i < 6; i++)
+        {
+            // the box corner farthest along the plane normal
+            vec3 farCorner = mix(minCorner, maxCorner, step(vec3(0.0), frustumPlanes[i].xyz));
+            if(dot(frustumPlanes[i].xyz, farCorner) + frustumPlanes[i].w < 0.0)
+            {
+                bVisible = false;
+                break;
+            }
+        }
+    }
+
+    commands[object].instanceCount = bVisible ? 1u : 0u;
+}
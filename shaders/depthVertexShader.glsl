@@ -0,0 +1,51 @@
+#version 330 core
+layout (location = 0) in vec3 inVertexPosition;
+// per instance model matrix, uses locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+// index of the indirect draw, each command starts its instance here
+layout (location = 7) in int inDrawIndex;
+
+// the position has to match the shading pass exactly so that its
+// depth test can use GL_EQUAL
+invariant gl_Position;
+
+uniform bool bUseInstancing = false;
+uniform bool bUseDrawData = false;
+// the camera values are written once per frame and the values of
+// a single draw for each draw, both into the uniform ring buffer
+layout(std140) uniform CameraBlock
+{
+   mat4 view;
+   mat4 viewProjection;
+   vec4 viewPosition;
+};
+layout(std140) uniform ObjectBlock
+{
+   mat4 model;
+   // the inverse transpose of the model rotation and scale
+   mat3 normalMatrix;
+   vec4 objectColor;
+   // the uv scale in xy and the texture layer in z
+   vec4 objectParams;
+};
+// nine texels per draw, the first four are the model matrix
+uniform samplerBuffer drawData;
+
+void main()
+{
+   mat4 objectModel = bUseInstancing ? inInstanceModel : model;
+
+   if (bUseDrawData)
+   {
+      int draw = inDrawIndex * 9;
+      objectModel = mat4(
+         texelFetch(drawData, draw),
+         texelFetch(drawData, draw + 1),
+         texelFetch(drawData, draw + 2),
+         texelFetch(drawData, draw + 3));
+   }
+
+   // the same expression as the shading pass
+   vec4 worldPosition = objectModel * vec4(inVertexPosition, 1.0f);
+   gl_Position = viewProjection * worldPosition;
+}
@@ -4,11 +4,19 @@ out vec4 fragmentColor;
 in vec3 fragmentPosition;
 in vec3 fragmentVertexNormal;
 in vec2 fragmentTextureCoordinate;
+// values of the indirect draw, used when bUseDrawData is set
+flat in vec4 fragmentDrawColor;
+flat in vec4 fragmentDrawParams;
+flat in vec4 fragmentMaterialDiffuse;
+flat in vec4 fragmentMaterialSpecular;
+flat in vec4 fragmentMaterialAmbient;
 
 struct Material {
     vec3 diffuseColor;
     vec3 specularColor;
     float shininess;
+    vec3 ambientColor;
+    float ambientStrength;
 }; 
 
 struct DirectionalLight {
@@ -49,31 +57,131 @@ struct SpotLight {
 };
 
 #define TOTAL_POINT_LIGHTS 5
+// tiles of the shadow atlas, the directional light and the flashlight
+#define SHADOW_TILES 2
+#define DIRECTIONAL_SHADOW_TILE 0
+#define FLASHLIGHT_SHADOW_TILE 1
+// how far the lookup position is moved along the normal, in texels
+// of the shadow map
+#define SHADOW_NORMAL_OFFSET 1.5
+// number of point lights the program evaluates, the program is built
+// with the number of lights the application drives
+#ifndef NUM_POINT_LIGHTS
+#define NUM_POINT_LIGHTS TOTAL_POINT_LIGHTS
+#endif
 
 uniform bool bUseTexture=false;
 uniform bool bUseLighting=false;
-uniform vec4 objectColor = vec4(1.0f);
-uniform vec3 viewPosition;
-uniform DirectionalLight directionalLight;
-uniform PointLight pointLights[TOTAL_POINT_LIGHTS];
-uniform SpotLight spotLight;
-uniform Material material;
-uniform sampler2D objectTexture;
-uniform vec2 UVscale = vec2(1.0f, 1.0f);
+// the camera values are written once per frame and the values of
+// a single draw for each draw, both into the uniform ring buffer
+layout(std140) uniform CameraBlock
+{
+    mat4 view;
+    mat4 viewProjection;
+    vec4 viewPosition;
+};
+layout(std140) uniform ObjectBlock
+{
+    mat4 model;
+    // the inverse transpose of the model rotation and scale
+    mat3 normalMatrix;
+    vec4 objectColor;
+    // the uv scale in xy and the texture layer in z
+    vec4 objectParams;
+};
+// every material lives in one buffer, a draw binds its range
+layout(std140) uniform MaterialBlock
+{
+    Material material;
+};
+// the lights are uploaded once per frame
+layout(std140) uniform LightBlock
+{
+    DirectionalLight directionalLight;
+    PointLight pointLights[TOTAL_POINT_LIGHTS];
+    SpotLight spotLight;
+};
+// the shadow maps of the lights are tiles of one depth texture, it
+// is only drawn again when a light or a shadow caster changes
+layout(std140) uniform ShadowBlock
+{
+    // world space to the atlas coordinates and depth of each tile
+    mat4 shadowMatrices[SHADOW_TILES];
+    // lower corner of each tile in xy and the upper corner in zw
+    vec4 shadowRects[SHADOW_TILES];
+    // 1 in x when the tile holds a map, the texel size one unit away
+    // from the light in y and the depth bias in z
+    vec4 shadowParams[SHADOW_TILES];
+    // size of one atlas texel in xy
+    vec4 shadowAtlasTexel;
+};
+uniform sampler2DShadow shadowAtlas;
+// the textures are layers of texture arrays
+uniform sampler2DArray objectTexture;
+uniform bool bUseDrawData = false;
+// clustered point lights, used when the light list is longer than
+// the light block - four texels per light, an offset and count of
+// the light indices per cluster, and the light indices
+uniform bool bUseLightClusters = false;
+uniform samplerBuffer pointLightData;
+uniform usamplerBuffer lightClusterData;
+uniform usamplerBuffer lightIndexData;
+// screen tiles per pixel, the cluster grid size and the values that
+// turn log(view depth) into a depth slice
+uniform vec2 clusterTileScale;
+uniform vec3 clusterGrid;
+uniform vec2 clusterDepthParams;
+
+// values of the drawn object, from the uniforms or from the
+// data of the indirect draw
+Material activeMaterial;
+vec4 activeColor;
+float activeLayer;
+vec2 activeUVScale;
+// surface color of the fragment, the texture is only sampled once
+vec4 albedo;
 
 // function prototypes
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir);
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, float shadow);
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir);
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow);
+vec3 CalcClusteredPointLights(vec3 normal, vec3 fragPos, vec3 viewDir);
+float CalcShadow(int tile, vec3 fragPos, vec3 normal, float lightDistance);
 
 void main()
 {    
+    if(bUseDrawData == true)
+    {
+        activeMaterial.diffuseColor = fragmentMaterialDiffuse.rgb;
+        activeMaterial.shininess = fragmentMaterialDiffuse.a;
+        activeMaterial.specularColor = fragmentMaterialSpecular.rgb;
+        activeMaterial.ambientStrength = fragmentMaterialSpecular.a;
+        activeMaterial.ambientColor = fragmentMaterialAmbient.rgb;
+        activeColor = fragmentDrawColor;
+        activeUVScale = fragmentDrawParams.xy;
+        activeLayer = fragmentDrawParams.z;
+    }
+    else
+    {
+        activeMaterial = material;
+        activeColor = objectColor;
+        activeUVScale = objectParams.xy;
+        activeLayer = objectParams.z;
+    }
+
+    // the texture is tiled by the UV scale of the item on both paths
+    albedo = activeColor;
+    if(bUseTexture == true)
+    {
+        albedo = texture(objectTexture, vec3(fragmentTextureCoordinate * activeUVScale, activeLayer));
+    }
+
     if(bUseLighting == true)
     {
         vec3 phongResult = vec3(0.0f);
         // properties
         vec3 norm = normalize(fragmentVertexNormal);
-        vec3 viewDir = normalize(viewPosition - fragmentPosition);
+        vec3 viewDir = normalize(viewPosition.xyz - fragmentPosition);
     
         // == =====================================================
         // Our lighting is set up in 3 phases: directional, point lights and an optional flashlight
@@ -84,119 +192,86 @@ void main()
         // phase 1: directional lighting
         if(directionalLight.bActive == true)
         {
-            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir);
+            float shadow = CalcShadow(DIRECTIONAL_SHADOW_TILE, fragmentPosition, norm, 1.0);
+            phongResult += CalcDirectionalLight(directionalLight, norm, viewDir, shadow);
         }
         // phase 2: point lights
-        for(int i = 0; i < TOTAL_POINT_LIGHTS; i++)
+        if(bUseLightClusters == true)
         {
-	    if(pointLights[i].bActive == true)
+            phongResult += CalcClusteredPointLights(norm, fragmentPosition, viewDir);
+        }
+        else
+        {
+            for(int i = 0; i < NUM_POINT_LIGHTS; i++)
             {
-                phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
-            }
-        } 
+                if(pointLights[i].bActive == true)
+                {
+                    phongResult += CalcPointLight(pointLights[i], norm, fragmentPosition, viewDir);   
+                }
+            } 
+        }
         // phase 3: spot light
         if(spotLight.bActive == true)
         {
-            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir);    
+            float shadow = CalcShadow(FLASHLIGHT_SHADOW_TILE, fragmentPosition, norm, distance(spotLight.position, fragmentPosition));
+            phongResult += CalcSpotLight(spotLight, norm, fragmentPosition, viewDir, shadow);
         }
     
-        if(bUseTexture == true)
-        {
-            fragmentColor = vec4(phongResult, (texture(objectTexture, fragmentTextureCoordinate)).a);
-        }
-        else
-        {
-            fragmentColor = vec4(phongResult, objectColor.a);
-        }
+        fragmentColor = vec4(phongResult, albedo.a);
     }
     else
     {
-        if(bUseTexture == true)
-        {
-            fragmentColor = texture(objectTexture, fragmentTextureCoordinate * UVscale);
-        }
-        else
-        {
-            fragmentColor = objectColor;
-        }
+        fragmentColor = albedo;
     }
 }
 
-// calculates the color when using a directional light.
-vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir)
+// calculates the color when using a directional light, the shadow
+// only takes away the diffuse and specular light.
+vec3 CalcDirectionalLight(DirectionalLight light, vec3 normal, vec3 viewDir, float shadow)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
     vec3 lightDirection = normalize(-light.direction);
     // diffuse shading
     float diff = max(dot(normal, lightDirection), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDirection, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), activeMaterial.shininess);
     // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
-    }
+    vec3 ambient = light.ambient * albedo.rgb;
+    vec3 diffuse = light.diffuse * diff * activeMaterial.diffuseColor * albedo.rgb;
+    vec3 specular = light.specular * spec * activeMaterial.specularColor * albedo.rgb;
     
-    return (ambient + diffuse + specular);
+    return (ambient + (diffuse + specular) * shadow);
 }
 
 // calculates the color when using a point light.
 vec3 CalcPointLight(PointLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular= vec3(0.0f);
-
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
     // Calculate specular component
-    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float specularComponent = pow(max(dot(viewDir, reflectDir), 0.0), activeMaterial.shininess);
    
-    // combine results
-    if(bUseTexture == true)
-    {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        specular = light.specular * specularComponent * material.specularColor;
-    }
-    else
-    {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * specularComponent * material.specularColor;
-    }
+    // combine results, the point light highlights are not tinted
+    vec3 ambient = light.ambient * albedo.rgb;
+    vec3 diffuse = light.diffuse * diff * activeMaterial.diffuseColor * albedo.rgb;
+    vec3 specular = light.specular * specularComponent * activeMaterial.specularColor;
     
     return (ambient + diffuse + specular);
 }
 
-// calculates the color when using a spot light.
-vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
+// calculates the color when using a spot light, the shadow only
+// takes away the diffuse and specular light.
+vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir, float shadow)
 {
-    vec3 ambient = vec3(0.0f);
-    vec3 diffuse = vec3(0.0f);
-    vec3 specular = vec3(0.0f);
-
     vec3 lightDir = normalize(light.position - fragPos);
     // diffuse shading
     float diff = max(dot(normal, lightDir), 0.0);
     // specular shading
     vec3 reflectDir = reflect(-lightDir, normal);
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), activeMaterial.shininess);
     // attenuation
     float distance = length(light.position - fragPos);
     float attenuation = 1.0 / (light.constant + light.linear * distance + light.quadratic * (distance * distance));    
@@ -205,21 +280,95 @@ vec3 CalcSpotLight(SpotLight light, vec3 normal, vec3 fragPos, vec3 viewDir)
     float epsilon = light.cutOff - light.outerCutOff;
     float intensity = clamp((theta - light.outerCutOff) / epsilon, 0.0, 1.0);
     // combine results
-    if(bUseTexture == true)
+    vec3 ambient = light.ambient * albedo.rgb;
+    vec3 diffuse = light.diffuse * diff * activeMaterial.diffuseColor * albedo.rgb;
+    vec3 specular = light.specular * spec * activeMaterial.specularColor * albedo.rgb;
+    
+    ambient *= attenuation * intensity;
+    diffuse *= attenuation * intensity * shadow;
+    specular *= attenuation * intensity * shadow;
+    return (ambient + diffuse + specular);
+}
+
+// calculates the color of the point lights that reach the cluster
+// of the fragment, the lights with a radius fade out towards it.
+vec3 CalcClusteredPointLights(vec3 normal, vec3 fragPos, vec3 viewDir)
+{
+    vec3 result = vec3(0.0f);
+
+    // find the cluster from the screen tile and the view depth
+    ivec3 grid = ivec3(clusterGrid);
+    float viewDepth = max(-(view * vec4(fragPos, 1.0)).z, 0.0001);
+    ivec2 tile = clamp(ivec2(gl_FragCoord.xy * clusterTileScale), ivec2(0), grid.xy - 1);
+    int slice = clamp(int(log(viewDepth) * clusterDepthParams.x + clusterDepthParams.y), 0, grid.z - 1);
+    int cluster = (slice * grid.y + tile.y) * grid.x + tile.x;
+    uvec2 range = texelFetch(lightClusterData, cluster).xy;
+
+    for(uint i = 0u; i < range.y; i++)
+    {
+        int lightTexel = int(texelFetch(lightIndexData, int(range.x + i)).r) * 4;
+        vec4 positionRadius = texelFetch(pointLightData, lightTexel);
+
+        PointLight light;
+        light.position = positionRadius.xyz;
+        light.ambient = texelFetch(pointLightData, lightTexel + 1).rgb;
+        light.diffuse = texelFetch(pointLightData, lightTexel + 2).rgb;
+        light.specular = texelFetch(pointLightData, lightTexel + 3).rgb;
+        light.bActive = true;
+
+        float attenuation = 1.0;
+        if(positionRadius.w > 0.0)
+        {
+            float falloff = clamp(1.0 - distance(light.position, fragPos) / positionRadius.w, 0.0, 1.0);
+            attenuation = falloff * falloff;
+        }
+        result += CalcPointLight(light, normal, fragPos, viewDir) * attenuation;
+    }
+
+    return result;
+}
+
+// calculates how much of the light of a shadow atlas tile reaches the
+// fragment, 1 when it is not shadowed.  The lookup position is moved
+// along the normal by about a texel of the map, and each of the nine
+// filtered taps blends the comparisons of four texels.
+float CalcShadow(int tile, vec3 fragPos, vec3 normal, float lightDistance)
+{
+    if(shadowParams[tile].x < 0.5)
     {
-        ambient = light.ambient * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
-        specular = light.specular * spec * material.specularColor * vec3(texture(objectTexture, fragmentTextureCoordinate));
+        return 1.0;
     }
-    else
+
+    vec3 offsetPosition = fragPos + normal * (SHADOW_NORMAL_OFFSET * shadowParams[tile].y * lightDistance);
+    vec4 shadowPosition = shadowMatrices[tile] * vec4(offsetPosition, 1.0);
+    if(shadowPosition.w <= 0.0)
     {
-        ambient = light.ambient * vec3(objectColor);
-        diffuse = light.diffuse * diff * material.diffuseColor * vec3(objectColor);
-        specular = light.specular * spec * material.specularColor * vec3(objectColor);
+        return 1.0;
     }
-    
-    ambient *= attenuation * intensity;
-    diffuse *= attenuation * intensity;
-    specular *= attenuation * intensity;
-    return (ambient + diffuse + specular);
+
+    // outside of the map the light is not shadowed
+    vec3 coords = shadowPosition.xyz / shadowPosition.w;
+    vec4 rect = shadowRects[tile];
+    if(any(lessThan(coords.xy, rect.xy)) || any(greaterThan(coords.xy, rect.zw)) || (coords.z > 1.0))
+    {
+        return 1.0;
+    }
+
+    // the taps are kept inside of the tile, so that they never read
+    // the map of the next one
+    vec2 texel = shadowAtlasTexel.xy;
+    vec2 minCoords = rect.xy + 1.5 * texel;
+    vec2 maxCoords = rect.zw - 1.5 * texel;
+    float depth = coords.z - shadowParams[tile].z;
+    float lit = 0.0;
+    for(int y = -1; y <= 1; y++)
+    {
+        for(int x = -1; x <= 1; x++)
+        {
+            vec2 tapCoords = clamp(coords.xy + vec2(x, y) * texel, minCoords, maxCoords);
+            lit += texture(shadowAtlas, vec3(tapCoords, depth));
+        }
+    }
+
+    return lit / 9.0;
 }
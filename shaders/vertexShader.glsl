@@ -2,19 +2,88 @@
 layout (location = 0) in vec3 inVertexPosition;
 layout (location = 1) in vec3 inVertexNormal;
 layout (location = 2) in vec2 inTextureCoordinate;
+// per instance model matrix, uses locations 3 to 6
+layout (location = 3) in mat4 inInstanceModel;
+// index of the indirect draw, each command starts its instance here
+layout (location = 7) in int inDrawIndex;
+// per instance normal matrix, uses locations 8 to 10
+layout (location = 8) in mat3 inInstanceNormal;
 
 out vec3 fragmentPosition;
 out vec3 fragmentVertexNormal;
 out vec2 fragmentTextureCoordinate;
+// values of the indirect draw, read once per vertex
+flat out vec4 fragmentDrawColor;
+flat out vec4 fragmentDrawParams;
+flat out vec4 fragmentMaterialDiffuse;
+flat out vec4 fragmentMaterialSpecular;
+flat out vec4 fragmentMaterialAmbient;
 
-uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+// the depth pre-pass computes the same position, so that the depth
+// test of this pass can use GL_EQUAL
+invariant gl_Position;
+
+uniform bool bUseInstancing = false;
+uniform bool bUseDrawData = false;
+// the camera values are written once per frame and the values of
+// a single draw for each draw, both into the uniform ring buffer
+layout(std140) uniform CameraBlock
+{
+   mat4 view;
+   mat4 viewProjection;
+   vec4 viewPosition;
+};
+layout(std140) uniform ObjectBlock
+{
+   mat4 model;
+   // the inverse transpose of the model rotation and scale
+   mat3 normalMatrix;
+   vec4 objectColor;
+   // the uv scale in xy and the texture layer in z
+   vec4 objectParams;
+};
+// nine texels per draw - model matrix, color, the uv scale,
+// texture layer and material index, and the normal matrix - and
+// three per material
+uniform samplerBuffer drawData;
+uniform samplerBuffer materialData;
 
 void main()
 {
-   fragmentPosition = vec3(model * vec4(inVertexPosition, 1.0));
-   gl_Position = projection * view * model * vec4(inVertexPosition, 1.0f);
-   fragmentVertexNormal = inVertexNormal;
+   mat4 objectModel = bUseInstancing ? inInstanceModel : model;
+   mat3 objectNormal = bUseInstancing ? inInstanceNormal : normalMatrix;
+
+   fragmentDrawColor = vec4(1.0);
+   fragmentDrawParams = vec4(1.0, 1.0, 0.0, 0.0);
+   fragmentMaterialDiffuse = vec4(0.0);
+   fragmentMaterialSpecular = vec4(0.0);
+   fragmentMaterialAmbient = vec4(0.0);
+   if (bUseDrawData)
+   {
+      int draw = inDrawIndex * 9;
+      objectModel = mat4(
+         texelFetch(drawData, draw),
+         texelFetch(drawData, draw + 1),
+         texelFetch(drawData, draw + 2),
+         texelFetch(drawData, draw + 3));
+      fragmentDrawColor = texelFetch(drawData, draw + 4);
+      fragmentDrawParams = texelFetch(drawData, draw + 5);
+      objectNormal = mat3(
+         texelFetch(drawData, draw + 6).xyz,
+         texelFetch(drawData, draw + 7).xyz,
+         texelFetch(drawData, draw + 8).xyz);
+
+      int material = int(fragmentDrawParams.w) * 3;
+      fragmentMaterialDiffuse = texelFetch(materialData, material);
+      fragmentMaterialSpecular = texelFetch(materialData, material + 1);
+      fragmentMaterialAmbient = texelFetch(materialData, material + 2);
+   }
+
+   // the world position is used for the lighting as well, so the
+   // clip position needs only one more matrix times vector
+   vec4 worldPosition = objectModel * vec4(inVertexPosition, 1.0f);
+   fragmentPosition = vec3(worldPosition);
+   gl_Position = viewProjection * worldPosition;
+   fragmentVertexNormal = objectNormal * inVertexNormal;
    fragmentTextureCoordinate = inTextureCoordinate;
 }
\ No newline at end of file